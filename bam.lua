@@ -293,12 +293,17 @@ if ScriptArgs["test_filter"] then
 	cs_test_args = " -run=" .. ScriptArgs["test_filter"]
 end
 
+-- tests of instances of several GB, not run by "test" since they need as much address-space and disk.
+local large_test_args = " --gtest_filter=DLLarge.* --dl_large_tests"
+
 if family == "windows" then
 	AddJob( "test",          "unittest c",        string.gsub( dl_tests, "/", "\\" ) .. test_args, dl_tests,    "local/generated/unittest.bin" )
+	AddJob( "test_large",    "unittest large",    string.gsub( dl_tests, "/", "\\" ) .. large_test_args, dl_tests, "local/generated/unittest.bin" )
 else
 	local valgrind_flags = " -v --leak-check=full --track-origins=yes "
 
 	AddJob( "test",          "unittest c",        dl_tests .. test_args,                                 dl_tests,    "local/generated/unittest.bin" )
+	AddJob( "test_large",    "unittest large",    dl_tests .. large_test_args,                           dl_tests,    "local/generated/unittest.bin" )
 	AddJob( "test_valgrind", "unittest valgrind", "valgrind" .. valgrind_flags .. dl_tests .. test_args, dl_tests,    "local/generated/unittest.bin" )
 	AddJob( "test_gdb",      "unittest gdb",      "gdb --args " .. dl_tests .. test_args,                dl_tests,    "local/generated/unittest.bin" )
 end
@@ -1,12 +1,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <dl/dl.h>
 #include <dl/dl_txt.h>
 #include <dl/dl_typelib.h>
+#include <dl/dl_reflect.h>
+#include <dl/dl_convert.h>
 
 #include <vector>
+#include <string>
 
 #define STRINGIFY( ... ) #__VA_ARGS__
 #define DL_ARRAY_LENGTH(Array) (uint32_t)(sizeof(Array)/sizeof(Array[0]))
@@ -86,9 +90,9 @@ static char* dlbench_pack_instance_to_txt( dl_ctx_t ctx, uint32_t type, void* in
 	unsigned char* packed_instance = (unsigned char*)malloc( pack_size );
 	err = dl_instance_store( ctx, type, inst, packed_instance, pack_size, 0x0 );
 
-	err = dl_txt_unpack( ctx, type, packed_instance, pack_size, 0x0, 0, &txt_size );
-	char* txt_instance = (char*)malloc( txt_size );
-	err = dl_txt_unpack( ctx, type, packed_instance, pack_size, txt_instance, txt_size, 0x0 );
+	// ... ctx uses the default allocator so txt_instance is freed with free() ...
+	char* txt_instance = 0x0;
+	err = dl_txt_unpack_alloc( ctx, type, packed_instance, pack_size, 0x0, 0x0, &txt_instance, &txt_size );
 
 	free( packed_instance );
 
@@ -121,6 +125,25 @@ static char* dlbench_pack_instance_to_txt( dl_ctx_t ctx, uint32_t type, void* in
 			"  - max %f ms\n" , CURRENT_FUNCTION_STRING, _iters, cpu_ticks_to_ms( total ), cpu_ticks_to_ms( total ) / (double)_iters, cpu_ticks_to_ms( min_time ), cpu_ticks_to_ms( max_time ) ); \
 }
 
+/**
+ * Same as DLBENCH_RUN_END but also report throughput of processing bytes each iteration.
+ */
+#define DLBENCH_RUN_END_BYTES( bytes ) \
+		uint64_t end = cpu_tick(); \
+		uint64_t it_time = end - start; \
+		min_time = it_time > min_time ? min_time : it_time; \
+		max_time = it_time < max_time ? max_time : it_time; \
+		total += it_time; \
+	} \
+	double _avg_ms = cpu_ticks_to_ms( total ) / (double)_iters; \
+	printf("%s - %d iterations in %f ms\n" \
+			"  - avg %f ms\n" \
+			"  - min %f ms\n" \
+			"  - max %f ms\n" \
+			"  - %f MB/s\n", CURRENT_FUNCTION_STRING, _iters, cpu_ticks_to_ms( total ), _avg_ms, cpu_ticks_to_ms( min_time ), cpu_ticks_to_ms( max_time ), \
+			( (double)(bytes) / ( 1024.0 * 1024.0 ) ) / ( _avg_ms / 1000.0 ) ); \
+}
+
 struct dlbench_txt_pack_bench
 {
 	dlbench_txt_pack_bench( uint32_t type, void* inst )
@@ -175,6 +198,185 @@ static void dlbench_txt_pack_big_array_fp32()
 	DLBENCH_RUN_END
 }
 
+static void dlbench_txt_pack_1m_fp32()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_pack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+	size_t txt_size = strlen( _b.txt_instance );
+
+	DLBENCH_RUN_START( 10 )
+		dl_txt_pack( _b.ctx, _b.txt_instance, _b.pack_buffer, _b.pack_buffer_size, 0x0 );
+	DLBENCH_RUN_END_BYTES( txt_size )
+}
+
+static void dlbench_txt_pack_1m_fp64()
+{
+	std::vector<double>data( 1000000 );
+	fp64_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (double)rand() / (double)RAND_MAX * 1000.0;
+
+	dlbench_txt_pack_bench _b( fp64_array_TYPE_ID, (void*)&inst );
+	size_t txt_size = strlen( _b.txt_instance );
+
+	DLBENCH_RUN_START( 10 )
+		dl_txt_pack( _b.ctx, _b.txt_instance, _b.pack_buffer, _b.pack_buffer_size, 0x0 );
+	DLBENCH_RUN_END_BYTES( txt_size )
+}
+
+/**
+ * Pack 1M floats the way it had to be done before dl_txt_pack_alloc(), calculate the size, allocate and pack.
+ */
+static void dlbench_txt_pack_1m_fp32_two_pass()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_pack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+	size_t txt_size = strlen( _b.txt_instance );
+
+	DLBENCH_RUN_START( 10 )
+		size_t packed_size;
+		dl_txt_pack_calc_size( _b.ctx, _b.txt_instance, &packed_size );
+		unsigned char* packed = (unsigned char*)malloc( packed_size );
+		dl_txt_pack( _b.ctx, _b.txt_instance, packed, packed_size, 0x0 );
+		free( packed );
+	DLBENCH_RUN_END_BYTES( txt_size )
+}
+
+/**
+ * Same as dlbench_txt_pack_1m_fp32_two_pass() but in one pass with dl_txt_pack_alloc().
+ */
+static void dlbench_txt_pack_1m_fp32_alloc()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_pack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+	size_t txt_size = strlen( _b.txt_instance );
+
+	DLBENCH_RUN_START( 10 )
+		unsigned char* packed;
+		dl_txt_pack_alloc( _b.ctx, _b.txt_instance, 0x0, 0x0, &packed, 0x0 );
+		free( packed );
+	DLBENCH_RUN_END_BYTES( txt_size )
+}
+
+struct dlbench_txt_unpack_bench
+{
+	dlbench_txt_unpack_bench( uint32_t type, void* inst )
+		: ctx(0x0)
+		, packed_size(0)
+		, packed(0x0)
+		, txt_size(0)
+		, txt(0x0)
+	{
+		ctx = dlbench_create_cxt( TYPELIB_SRC, sizeof(TYPELIB_SRC) );
+
+		dl_error_t err = dl_instance_store( ctx, type, inst, 0x0, 0, &packed_size );
+		packed = (unsigned char*)malloc( packed_size );
+		err = dl_instance_store( ctx, type, inst, packed, packed_size, 0x0 );
+
+		err = dl_txt_unpack( ctx, type, packed, packed_size, 0x0, 0, &txt_size );
+		txt = (char*)malloc( txt_size );
+		(void)err; // TODO: check err
+	}
+
+	~dlbench_txt_unpack_bench()
+	{
+		free( packed );
+		free( txt );
+		dl_context_destroy( ctx );
+	}
+
+	dl_ctx_t ctx;
+	size_t packed_size;
+	unsigned char* packed;
+	size_t txt_size;
+	char* txt;
+};
+
+static void dlbench_txt_unpack_1m_fp32()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_unpack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+
+	DLBENCH_RUN_START( 10 )
+		dl_txt_unpack( _b.ctx, fp32_array_TYPE_ID, _b.packed, _b.packed_size, _b.txt, _b.txt_size, 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.txt_size )
+}
+
+static void dlbench_txt_unpack_1m_fp64()
+{
+	std::vector<double>data( 1000000 );
+	fp64_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (double)rand() / (double)RAND_MAX * 1000.0;
+
+	dlbench_txt_unpack_bench _b( fp64_array_TYPE_ID, (void*)&inst );
+
+	DLBENCH_RUN_START( 10 )
+		dl_txt_unpack( _b.ctx, fp64_array_TYPE_ID, _b.packed, _b.packed_size, _b.txt, _b.txt_size, 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.txt_size )
+}
+
+static void dlbench_txt_unpack_1m_uint32()
+{
+	std::vector<uint32_t>data( 1000000 );
+	uint32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (uint32_t)rand() * 2654435761u;
+
+	dlbench_txt_unpack_bench _b( uint32_array_TYPE_ID, (void*)&inst );
+
+	DLBENCH_RUN_START( 10 )
+		dl_txt_unpack( _b.ctx, uint32_array_TYPE_ID, _b.packed, _b.packed_size, _b.txt, _b.txt_size, 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.txt_size )
+}
+
+/**
+ * Unpack 1M floats in two passes, dl_txt_unpack_calc_size() followed by dl_txt_unpack().
+ */
+static void dlbench_txt_unpack_1m_fp32_two_pass()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_unpack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+
+	DLBENCH_RUN_START( 10 )
+		size_t txt_size;
+		dl_txt_unpack_calc_size( _b.ctx, fp32_array_TYPE_ID, _b.packed, _b.packed_size, &txt_size );
+		char* txt = (char*)malloc( txt_size );
+		dl_txt_unpack( _b.ctx, fp32_array_TYPE_ID, _b.packed, _b.packed_size, txt, txt_size, 0x0 );
+		free( txt );
+	DLBENCH_RUN_END_BYTES( _b.txt_size )
+}
+
+/**
+ * Same as dlbench_txt_unpack_1m_fp32_two_pass() but in one pass with dl_txt_unpack_alloc().
+ */
+static void dlbench_txt_unpack_1m_fp32_alloc()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)rand() / (float)RAND_MAX * 1000.0f;
+
+	dlbench_txt_unpack_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+
+	DLBENCH_RUN_START( 10 )
+		char* txt;
+		dl_txt_unpack_alloc( _b.ctx, fp32_array_TYPE_ID, _b.packed, _b.packed_size, 0x0, 0x0, &txt, 0x0 );
+		free( txt );
+	DLBENCH_RUN_END_BYTES( _b.txt_size )
+}
+
 static void dlbench_txt_pack_big_array_fp32_zero()
 {
 	std::vector<float>data( 10000 );
@@ -233,6 +435,441 @@ static void dlbench_txt_pack_big_array_str_null()
 	DLBENCH_RUN_END
 }
 
+struct dlbench_load_bench
+{
+	dlbench_load_bench( uint32_t type, void* inst )
+		: ctx(0x0)
+		, packed_size(0)
+		, packed(0x0)
+		, loaded(0x0)
+	{
+		ctx = dlbench_create_cxt( TYPELIB_SRC, sizeof(TYPELIB_SRC) );
+
+		dl_error_t err = dl_instance_store( ctx, type, inst, 0x0, 0, &packed_size );
+		packed = (unsigned char*)malloc( packed_size );
+		loaded = (unsigned char*)malloc( packed_size );
+		err = dl_instance_store( ctx, type, inst, packed, packed_size, 0x0 );
+		(void)err; // TODO: check err
+	}
+
+	~dlbench_load_bench()
+	{
+		free( packed );
+		free( loaded );
+		dl_context_destroy( ctx );
+	}
+
+	dl_ctx_t ctx;
+	size_t packed_size;
+	unsigned char* packed;
+	unsigned char* loaded;
+};
+
+static void dlbench_load_sparse_ptrs()
+{
+	std::vector<sparse_item> data( 10000 );
+	memset( &data[0], 0x0, sizeof( sparse_item ) * data.size() );
+	sparse_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.items[i].sub.name = "apa";
+
+	dlbench_load_bench _b( sparse_array_TYPE_ID, (void*)&inst );
+	printf( "loading %u sparse_item, %f MB\n", (uint32_t)data.size(), (double)_b.packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( 1000 )
+		dl_instance_load( _b.ctx, sparse_array_TYPE_ID, _b.loaded, _b.packed_size, _b.packed, _b.packed_size, 0x0 );
+	DLBENCH_RUN_END
+}
+
+static void dlbench_load_dense_ptrs()
+{
+	uint32_t vals[] = { 1, 2, 3, 4 };
+	std::vector<dense_item> data( 10000 );
+	dense_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i )
+	{
+		inst.items[i].s1 = "apa";
+		inst.items[i].s2 = "bepa";
+		inst.items[i].s3 = "cepa";
+		inst.items[i].s4 = "depa";
+		inst.items[i].vals.data  = vals;
+		inst.items[i].vals.count = DL_ARRAY_LENGTH( vals );
+	}
+
+	dlbench_load_bench _b( dense_array_TYPE_ID, (void*)&inst );
+	printf( "loading %u dense_item, %f MB\n", (uint32_t)data.size(), (double)_b.packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( 1000 )
+		dl_instance_load( _b.ctx, dense_array_TYPE_ID, _b.loaded, _b.packed_size, _b.packed, _b.packed_size, 0x0 );
+	DLBENCH_RUN_END
+}
+
+struct dlbench_buffer_sink
+{
+	unsigned char* buffer;
+	size_t         pos;
+};
+
+static dl_error_t dlbench_buffer_write( const void* data, size_t size, void* write_ctx )
+{
+	dlbench_buffer_sink* sink = (dlbench_buffer_sink*)write_ctx;
+	memcpy( sink->buffer + sink->pos, data, size );
+	sink->pos += size;
+	return DL_ERROR_OK;
+}
+
+/**
+ * Store a graph of node_count nodes where every node points to an earlier stored node, all pointers need to be
+ * tracked by the store so that shared nodes are only written once.
+ * Stored both with dl_instance_store(), placing subdata while walking the instance, and planned and written front to
+ * back by dl_instance_store_stream() to the same buffer.
+ */
+static void dlbench_store_graph( uint32_t node_count )
+{
+	std::vector<graph_node>  nodes( node_count );
+	std::vector<graph_node*> node_ptrs( node_count );
+	for( uint32_t i = 0; i < node_count; ++i )
+	{
+		nodes[i].id     = i;
+		nodes[i].parent = i == 0 ? 0x0 : &nodes[( i - 1 ) / 2];
+		node_ptrs[i]    = &nodes[i];
+	}
+	graph inst = { { &node_ptrs[0], node_count } };
+
+	dl_ctx_t ctx = dlbench_create_cxt( TYPELIB_SRC, sizeof(TYPELIB_SRC) );
+
+	size_t packed_size;
+	dl_instance_calc_size( ctx, graph_TYPE_ID, &inst, &packed_size );
+	unsigned char* packed = (unsigned char*)malloc( packed_size );
+
+	printf( "storing graph with %u nodes, %f MB\n", node_count, (double)packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		dl_instance_store( ctx, graph_TYPE_ID, &inst, packed, packed_size, 0x0 );
+	DLBENCH_RUN_END
+
+	printf( "storing graph with %u nodes front to back\n", node_count );
+
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		dlbench_buffer_sink sink = { packed, 0 };
+		dl_instance_store_stream( ctx, graph_TYPE_ID, &inst, dlbench_buffer_write, &sink, 0x0 );
+	DLBENCH_RUN_END
+
+	free( packed );
+	dl_context_destroy( ctx );
+}
+
+static dl_error_t dlbench_discard_write( const void* data, size_t size, void* write_ctx )
+{
+	(void)data;
+	*(size_t*)write_ctx += size;
+	return DL_ERROR_OK;
+}
+
+/**
+ * Store a graph of node_count nodes, shaped as in dlbench_store_graph(), to a newly allocated buffer. Once in two
+ * passes with dl_instance_calc_size() + dl_instance_store() and once in a single pass with dl_instance_store_alloc().
+ * Also streams it with dl_instance_store_stream() to a sink that drops all data.
+ */
+
+static void dlbench_store_graph_alloc( uint32_t node_count )
+{
+	std::vector<graph_node>  nodes( node_count );
+	std::vector<graph_node*> node_ptrs( node_count );
+	for( uint32_t i = 0; i < node_count; ++i )
+	{
+		nodes[i].id     = i;
+		nodes[i].parent = i == 0 ? 0x0 : &nodes[( i - 1 ) / 2];
+		node_ptrs[i]    = &nodes[i];
+	}
+	graph inst = { { &node_ptrs[0], node_count } };
+
+	dl_ctx_t ctx = dlbench_create_cxt( TYPELIB_SRC, sizeof(TYPELIB_SRC) );
+
+	printf( "two pass store of graph with %u nodes\n", node_count );
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		size_t packed_size;
+		dl_instance_calc_size( ctx, graph_TYPE_ID, &inst, &packed_size );
+		unsigned char* packed = (unsigned char*)malloc( packed_size );
+		dl_instance_store( ctx, graph_TYPE_ID, &inst, packed, packed_size, 0x0 );
+		free( packed );
+	DLBENCH_RUN_END
+
+	printf( "single pass store of graph with %u nodes\n", node_count );
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		unsigned char* packed;
+		dl_instance_store_alloc( ctx, graph_TYPE_ID, &inst, 0x0, 0x0, &packed, 0x0 );
+		free( packed );
+	DLBENCH_RUN_END
+
+	printf( "streamed store of graph with %u nodes\n", node_count );
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		size_t streamed = 0;
+		dl_instance_store_stream( ctx, graph_TYPE_ID, &inst, dlbench_discard_write, &streamed, 0x0 );
+	DLBENCH_RUN_END
+
+	dl_context_destroy( ctx );
+}
+
+/**
+ * Load a graph of node_count nodes shaped as in dlbench_store_graph(), all nodes need to be tracked while patching
+ * so that shared nodes are only patched once.
+ */
+static void dlbench_load_graph( uint32_t node_count )
+{
+	std::vector<graph_node>  nodes( node_count );
+	std::vector<graph_node*> node_ptrs( node_count );
+	for( uint32_t i = 0; i < node_count; ++i )
+	{
+		nodes[i].id     = i;
+		nodes[i].parent = i == 0 ? 0x0 : &nodes[( i - 1 ) / 2];
+		node_ptrs[i]    = &nodes[i];
+	}
+	graph inst = { { &node_ptrs[0], node_count } };
+
+	dlbench_load_bench _b( graph_TYPE_ID, (void*)&inst );
+	printf( "loading graph with %u nodes, %f MB\n", node_count, (double)_b.packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		dl_instance_load( _b.ctx, graph_TYPE_ID, _b.loaded, _b.packed_size, _b.packed, _b.packed_size, 0x0 );
+	DLBENCH_RUN_END
+}
+
+/**
+ * Convert a graph of node_count nodes, shaped as in dlbench_store_graph(), to the other endian and pointer-size.
+ */
+static void dlbench_convert_graph( uint32_t node_count )
+{
+	std::vector<graph_node>  nodes( node_count );
+	std::vector<graph_node*> node_ptrs( node_count );
+	for( uint32_t i = 0; i < node_count; ++i )
+	{
+		nodes[i].id     = i;
+		nodes[i].parent = i == 0 ? 0x0 : &nodes[( i - 1 ) / 2];
+		node_ptrs[i]    = &nodes[i];
+	}
+	graph inst = { { &node_ptrs[0], node_count } };
+
+	dlbench_load_bench _b( graph_TYPE_ID, (void*)&inst );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	size_t other_ptr_size = sizeof(void*) == 8 ? 4 : 8;
+
+	size_t converted_size;
+	dl_convert_calc_size( _b.ctx, graph_TYPE_ID, _b.packed, _b.packed_size, other_ptr_size, &converted_size );
+	unsigned char* converted = (unsigned char*)malloc( converted_size );
+
+	printf( "converting graph with %u nodes, %f MB\n", node_count, (double)_b.packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( node_count > 100000 ? 10 : 100 )
+		dl_convert( _b.ctx, graph_TYPE_ID, _b.packed, _b.packed_size, converted, converted_size, other_endian, other_ptr_size, 0x0 );
+	DLBENCH_RUN_END
+
+	free( converted );
+}
+
+/**
+ * Convert 1M uint16 to the other endian, pointer-size is kept so that only the byte-swap of the array is measured.
+ */
+static void dlbench_convert_1m_uint16()
+{
+	std::vector<uint16_t>data( 1000000 );
+	uint16_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (uint16_t)i;
+
+	dlbench_load_bench _b( uint16_array_TYPE_ID, (void*)&inst );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	DLBENCH_RUN_START( 100 )
+		dl_convert( _b.ctx, uint16_array_TYPE_ID, _b.packed, _b.packed_size, _b.loaded, _b.packed_size, other_endian, sizeof(void*), 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.packed_size )
+}
+
+static void dlbench_convert_1m_fp32()
+{
+	std::vector<float>data( 1000000 );
+	fp32_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (float)i;
+
+	dlbench_load_bench _b( fp32_array_TYPE_ID, (void*)&inst );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	DLBENCH_RUN_START( 100 )
+		dl_convert( _b.ctx, fp32_array_TYPE_ID, _b.packed, _b.packed_size, _b.loaded, _b.packed_size, other_endian, sizeof(void*), 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.packed_size )
+}
+
+static void dlbench_convert_1m_fp64()
+{
+	std::vector<double>data( 1000000 );
+	fp64_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.arr[i] = (double)i;
+
+	dlbench_load_bench _b( fp64_array_TYPE_ID, (void*)&inst );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	DLBENCH_RUN_START( 100 )
+		dl_convert( _b.ctx, fp64_array_TYPE_ID, _b.packed, _b.packed_size, _b.loaded, _b.packed_size, other_endian, sizeof(void*), 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.packed_size )
+}
+
+/**
+ * Convert 1M structs made up of 4 fp32 to the other endian, these are swapped as one big fp32-array.
+ */
+static void dlbench_convert_1m_vec4()
+{
+	std::vector<vec4>data( 1000000 );
+	vec4_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i )
+	{
+		inst.arr[i].x = (float)i;
+		inst.arr[i].y = (float)i * 2.0f;
+		inst.arr[i].z = (float)i * 3.0f;
+		inst.arr[i].w = 1.0f;
+	}
+
+	dlbench_load_bench _b( vec4_array_TYPE_ID, (void*)&inst );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	DLBENCH_RUN_START( 100 )
+		dl_convert( _b.ctx, vec4_array_TYPE_ID, _b.packed, _b.packed_size, _b.loaded, _b.packed_size, other_endian, sizeof(void*), 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.packed_size )
+}
+
+/**
+ * Unpack and pack a graph of node_count nodes, shaped as in dlbench_store_graph(), as text. Every node will be
+ * one entry in "__subdata".
+ */
+static void dlbench_convert_sparse()
+{
+	std::vector<sparse_item> data( 10000 );
+	memset( &data[0], 0x0, sizeof( sparse_item ) * data.size() );
+	sparse_array inst = { { &data[0], (uint32_t)data.size() } };
+	for( size_t i = 0; i < data.size(); ++i ) inst.items[i].sub.name = "apa";
+
+	dlbench_load_bench _b( sparse_array_TYPE_ID, (void*)&inst );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	printf( "converting %u sparse_item, %f MB\n", (uint32_t)data.size(), (double)_b.packed_size / ( 1024.0 * 1024.0 ) );
+
+	DLBENCH_RUN_START( 100 )
+		dl_convert( _b.ctx, sparse_array_TYPE_ID, _b.packed, _b.packed_size, _b.loaded, _b.packed_size, other_endian, sizeof(void*), 0x0 );
+	DLBENCH_RUN_END_BYTES( _b.packed_size )
+}
+
+static void dlbench_txt_graph( uint32_t node_count )
+{
+	std::vector<graph_node>  nodes( node_count );
+	std::vector<graph_node*> node_ptrs( node_count );
+	for( uint32_t i = 0; i < node_count; ++i )
+	{
+		nodes[i].id     = i;
+		nodes[i].parent = i == 0 ? 0x0 : &nodes[( i - 1 ) / 2];
+		node_ptrs[i]    = &nodes[i];
+	}
+	graph inst = { { &node_ptrs[0], node_count } };
+
+	dlbench_load_bench _b( graph_TYPE_ID, (void*)&inst );
+
+	size_t txt_size;
+	dl_txt_unpack_calc_size( _b.ctx, graph_TYPE_ID, _b.packed, _b.packed_size, &txt_size );
+	char* txt = (char*)malloc( txt_size );
+	dl_txt_unpack( _b.ctx, graph_TYPE_ID, _b.packed, _b.packed_size, txt, txt_size, 0x0 );
+
+	printf( "txt unpack graph with %u nodes, %f MB\n", node_count, (double)txt_size / ( 1024.0 * 1024.0 ) );
+	DLBENCH_RUN_START( 10 )
+		dl_txt_unpack( _b.ctx, graph_TYPE_ID, _b.packed, _b.packed_size, txt, txt_size, 0x0 );
+	DLBENCH_RUN_END
+
+	printf( "txt pack graph with %u nodes, %f MB\n", node_count, (double)txt_size / ( 1024.0 * 1024.0 ) );
+	DLBENCH_RUN_START( 10 )
+		dl_txt_pack( _b.ctx, txt, _b.loaded, _b.packed_size, 0x0 );
+	DLBENCH_RUN_END
+
+	free( txt );
+}
+
+/**
+ * Create a context with type_count generated types, used to see how lookups scale with the amount of loaded types.
+ */
+static dl_ctx_t dlbench_create_ctx_with_types( unsigned int type_count )
+{
+	std::string tl = "{ \"types\" : {";
+	for( unsigned int i = 0; i < type_count; ++i )
+	{
+		char type[128];
+		snprintf( type, sizeof(type), "%s\"gen_type_%u\" : { \"members\" : [ { \"name\" : \"m\", \"type\" : \"uint32\" } ] }", i == 0 ? "" : ",", i );
+		tl += type;
+	}
+	tl += "} }";
+
+	dl_ctx_t ctx;
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT(p);
+
+	if( dl_context_create( &ctx, &p ) != DL_ERROR_OK )
+		return 0x0;
+
+	if( dl_context_load_txt_type_library( ctx, tl.c_str(), tl.size() ) != DL_ERROR_OK )
+	{
+		dl_context_destroy( ctx );
+		return 0x0;
+	}
+
+	return ctx;
+}
+
+static void dlbench_type_lookup( unsigned int type_count )
+{
+	dl_ctx_t ctx = dlbench_create_ctx_with_types( type_count );
+
+	std::vector<dl_type_info_t> types( type_count );
+	dl_reflect_loaded_types( ctx, &types[0], type_count );
+
+	printf( "type lookup with %u types loaded:\n", type_count );
+
+	// ... always do the same amount of lookups, the time should stay flat when adding types ...
+	DLBENCH_RUN_START( 100 )
+		for( unsigned int i = 0; i < 100000; ++i )
+		{
+			dl_type_info_t info;
+			dl_reflect_get_type_info( ctx, types[ ( i * 7919 ) % type_count ].tid, &info );
+		}
+	DLBENCH_RUN_END
+
+	dl_context_destroy( ctx );
+}
+
+/**
+ * Load a type-library with type_count types into a new context, copied and borrowed.
+ */
+static void dlbench_load_type_library( unsigned int type_count )
+{
+	dl_ctx_t src_ctx = dlbench_create_ctx_with_types( type_count );
+	size_t tl_size = 0;
+	dl_context_write_type_library( src_ctx, 0x0, 0, &tl_size );
+	std::vector<uint32_t> tl( ( tl_size + sizeof(uint32_t) - 1 ) / sizeof(uint32_t) ); // ... borrowing require 4 byte alignment ...
+	dl_context_write_type_library( src_ctx, (unsigned char*)&tl[0], tl_size, 0x0 );
+	dl_context_destroy( src_ctx );
+
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT(p);
+
+	printf( "loading type library with %u types (%u bytes):\n", type_count, (uint32_t)tl_size );
+	DLBENCH_RUN_START( 100 )
+		dl_ctx_t ctx;
+		dl_context_create( &ctx, &p );
+		dl_context_load_type_library( ctx, (const unsigned char*)&tl[0], tl_size );
+		dl_context_destroy( ctx );
+	DLBENCH_RUN_END
+
+	printf( "loading borrowed type library with %u types (%u bytes):\n", type_count, (uint32_t)tl_size );
+	DLBENCH_RUN_START( 100 )
+		dl_ctx_t ctx;
+		dl_context_create( &ctx, &p );
+		dl_context_load_type_library_borrowed( ctx, (const unsigned char*)&tl[0], tl_size );
+		dl_context_destroy( ctx );
+	DLBENCH_RUN_END
+}
+
 int main( int argc, const char** argv )
 {
 	(void)argc; (void)argv;
@@ -240,10 +877,56 @@ int main( int argc, const char** argv )
 	// ... dl_txt_pack() benchmarks ...
 	dlbench_txt_pack_small_array_fp32();
 	dlbench_txt_pack_big_array_fp32();
+	dlbench_txt_pack_1m_fp32();
+	dlbench_txt_pack_1m_fp64();
+	dlbench_txt_pack_1m_fp32_two_pass();
+	dlbench_txt_pack_1m_fp32_alloc();
 	dlbench_txt_pack_big_array_fp32_zero();
 	dlbench_txt_pack_big_array_array_fp32();
 	dlbench_txt_pack_big_array_str();
 	dlbench_txt_pack_big_array_str_null();
+	dlbench_txt_graph( 1000 );
+	dlbench_txt_graph( 50000 );
+
+	// ... dl_txt_unpack() benchmarks ...
+	dlbench_txt_unpack_1m_fp32();
+	dlbench_txt_unpack_1m_fp64();
+	dlbench_txt_unpack_1m_uint32();
+	dlbench_txt_unpack_1m_fp32_two_pass();
+	dlbench_txt_unpack_1m_fp32_alloc();
+
+	// ... dl_instance_load() benchmarks ...
+	dlbench_load_sparse_ptrs();
+	dlbench_load_dense_ptrs();
+	dlbench_load_graph( 1000 );
+	dlbench_load_graph( 100000 );
+	dlbench_load_graph( 1000000 );
+
+	// ... dl_instance_store() benchmarks ...
+	dlbench_store_graph( 1000 );
+	dlbench_store_graph( 100000 );
+	dlbench_store_graph( 1000000 );
+	dlbench_store_graph_alloc( 1000 );
+	dlbench_store_graph_alloc( 1000000 );
+
+	// ... dl_convert() benchmarks ...
+	dlbench_convert_graph( 1000 );
+	dlbench_convert_graph( 100000 );
+	dlbench_convert_graph( 1000000 );
+	dlbench_convert_1m_uint16();
+	dlbench_convert_1m_fp32();
+	dlbench_convert_1m_fp64();
+	dlbench_convert_1m_vec4();
+	dlbench_convert_sparse();
+
+	// ... type lookup benchmarks ...
+	dlbench_type_lookup( 16 );
+	dlbench_type_lookup( 256 );
+	dlbench_type_lookup( 4096 );
+
+	// ... type library load benchmarks ...
+	dlbench_load_type_library( 256 );
+	dlbench_load_type_library( 4096 );
 
 	return 0;
 }
@@ -100,7 +100,7 @@ class DLContext:
             self.py_type = py_type
             
     class dl_type_context_info(Structure): _fields_ = [ ('num_types', c_uint),   ('num_enums',   c_uint) ]
-    class dl_instance_info(Structure):     _fields_ = [ ('load_size', c_uint),   ('ptrsize',     c_uint), ('endian',     c_uint), ('root_type',    c_uint32) ]
+    class dl_instance_info(Structure):     _fields_ = [ ('load_size', c_size_t), ('ptrsize',     c_uint), ('endian',     c_uint), ('root_type',    c_uint32), ('relative', c_uint), ('version', c_uint) ]
     class dl_type_info(Structure):         _fields_ = [ ('tid',       c_uint),   ('name',      c_char_p), ('size',       c_uint),  ('alignment', c_uint), ('member_count', c_uint) ]
     class dl_enum_info(Structure):         _fields_ = [ ('tid',       c_uint),   ('name',      c_char_p), ('value_count', c_uint) ]
     class dl_enum_value_info(Structure):   _fields_ = [ ('name',      c_char_p), ('value',       c_uint) ]
@@ -305,17 +305,27 @@ class DLContext:
         
         class dl_create_params(Structure):
             _fields_ = [ ('alloc_func',     c_void_p), 
+                         ('realloc_func',   c_void_p), 
                          ('free_func',      c_void_p), 
                          ('alloc_ctx',      c_void_p),
                          ('error_msg_func', self.CDL_MSG_HANDLER),
-                         ('error_msg_ctx',  c_void_p) ]
+                         ('error_msg_ctx',  c_void_p),
+                         ('stats_mode',     c_uint),
+                         ('trace_begin_func', c_void_p),
+                         ('trace_end_func',   c_void_p),
+                         ('trace_ctx',        c_void_p) ]
             
         params = dl_create_params()
-        params.alloc_func = 0
-        params.free_func  = 0
-        params.alloc_ctx  = 0
+        params.alloc_func   = 0
+        params.realloc_func = 0
+        params.free_func    = 0
+        params.alloc_ctx    = 0
         params.error_msg_func = self.msg_handler
         params.error_msg_ctx  = 0
+        params.stats_mode     = 0
+        params.trace_begin_func = 0
+        params.trace_end_func   = 0
+        params.trace_ctx        = 0
         err = self.dl.dl_context_create( byref(self.dl_ctx), byref(params) )
         
         if err != 0:
@@ -45,6 +45,11 @@ typedef struct dl_context* dl_ctx_t;
 	DL_ERROR_UTIL_FILE_TYPE_MISMATCH                       - File type specified to read do not match file content.
 
 	DL_ERROR_INTERNAL_ERROR                                - Internal error, contact dev!
+
+	DL_ERROR_UTIL_FILE_WRITE_FAILED                        - Writing to a file or stream failed.
+
+	DL_ERROR_ARCHIVE_KEY_NOT_FOUND                         - No entry with the requested key was found in archive.
+	DL_ERROR_ARCHIVE_DUPLICATE_KEY                         - An entry with the same key is already added to archive.
 */
 typedef enum
 {
@@ -79,7 +84,12 @@ typedef enum
 	DL_ERROR_UTIL_FILE_NOT_FOUND,
 	DL_ERROR_UTIL_FILE_TYPE_MISMATCH,
 
-	DL_ERROR_INTERNAL_ERROR
+	DL_ERROR_INTERNAL_ERROR,
+
+	DL_ERROR_UTIL_FILE_WRITE_FAILED,
+
+	DL_ERROR_ARCHIVE_KEY_NOT_FOUND,
+	DL_ERROR_ARCHIVE_DUPLICATE_KEY
 } dl_error_t;
 
 /*
@@ -190,6 +200,35 @@ typedef void* (*dl_realloc_func)( void* ptr, size_t size, size_t old_size, void*
 */
 typedef void  (*dl_free_func) ( void* ptr, void* alloc_ctx );
 
+/*
+	Function: dl_grow_func
+		Callback used by DL to grow an output-buffer that is written in a single pass, see for example dl_txt_pack_alloc.
+
+	Parameters:
+		ptr      - buffer to grow, 0x0 on the first call.
+		size     - requested new size of the buffer. If 0 ptr should be freed and 0x0 returned.
+		old_size - size of ptr, the first old_size bytes of ptr is required to be kept in the returned buffer.
+		grow_ctx - same ptr that was passed together with the callback.
+
+	Return:
+		Pointer to the grown buffer or 0x0 on failure, in which case ptr is still valid.
+*/
+typedef void* (*dl_grow_func)( void* ptr, size_t size, size_t old_size, void* grow_ctx );
+
+/*
+	Function: dl_write_func
+		Callback used by DL to pass output to the user a chunk at a time, see for example dl_instance_store_stream.
+
+	Parameters:
+		data      - data to write.
+		size      - number of bytes in data.
+		write_ctx - same ptr that was passed together with the callback.
+
+	Return:
+		DL_ERROR_OK on success, any other error will abort the operation and be returned to the caller.
+*/
+typedef dl_error_t (*dl_write_func)( const void* data, size_t size, void* write_ctx );
+
 /*
 	Function: dl_error_msg_handler
 		Callback used by DL to report error-messages.
@@ -200,6 +239,58 @@ typedef void  (*dl_free_func) ( void* ptr, void* alloc_ctx );
 */
 typedef void  (*dl_error_msg_handler)( const char* msg, void* msg_ctx );
 
+/*
+	Struct: dl_trace_event_t
+		An operation, or a phase of an operation, reported to the trace-callbacks of a context.
+
+	Members:
+		name      - Name of the operation, public entry-points are named after the function, such as
+		            "dl_instance_store", and phases of operations are named "<area>.<phase>". The phases reported
+		            are "load.patch", "convert.collect", "convert.write", "txt_pack.parse" and
+		            "txt_pack.finalize_subdata". Points to a static string.
+		type_name - Name of the type that the operation works on, 0x0 if not known yet, as when a txt-pack begins.
+		            Points into the context and is valid as long as the type-library is loaded.
+		bytes_in  - Bytes of packed instances, text or type-library read by the operation, 0 if not known.
+		bytes_out - Bytes produced by the operation, only set when the operation ends successfully.
+*/
+typedef struct dl_trace_event
+{
+	const char* name;
+	const char* type_name;
+	size_t      bytes_in;
+	size_t      bytes_out;
+} dl_trace_event_t;
+
+/*
+	Function: dl_trace_func
+		Callback used by DL to report when a traced operation begins or ends, see dl_create_params_t.
+
+		Begin and end of operations are always reported in pairs and properly nested, operations can be nested as
+		public functions call other public functions and phases are reported within the operation they are part of.
+		Functions that only calculate a size are reported as the function that does the work, such as
+		dl_instance_calc_size() as "dl_instance_store".
+
+	Parameters:
+		event     - The operation that begins or ends, only valid during the call.
+		trace_ctx - same ptr that was passed to dl_context_create via dl_create_params.trace_ctx.
+*/
+typedef void  (*dl_trace_func)( const dl_trace_event_t* event, void* trace_ctx );
+
+/*
+	Enum: dl_stats_mode_t
+		Statistics collected by a context, see dl_context_get_stats().
+
+	DL_STATS_NONE     - Collect no statistics.
+	DL_STATS_COUNTERS - Count calls, bytes, patched ptrs, type-lookups and allocations.
+	DL_STATS_TIMING   - As DL_STATS_COUNTERS but also measure the time spent in each operation.
+*/
+typedef enum
+{
+	DL_STATS_NONE,
+	DL_STATS_COUNTERS,
+	DL_STATS_TIMING
+} dl_stats_mode_t;
+
 /*
 	Struct: dl_create_params_t
 		Passed with initialization parameters to dl_context_create.
@@ -215,6 +306,12 @@ typedef void  (*dl_error_msg_handler)( const char* msg, void* msg_ctx );
 		                 to the user, set to 0x0 to ignore error-strings.
 		error_msg_ctx  - data passed to error_msg_func as user-data.
 
+		stats_mode - statistics to collect in the context, see dl_context_get_stats(). Defaults to DL_STATS_NONE.
+
+		trace_begin_func - called when a traced operation begins, set to 0x0 to not trace. See dl_trace_func.
+		trace_end_func   - called when a traced operation ends, set to 0x0 to not trace. See dl_trace_func.
+		trace_ctx        - data passed to trace_begin_func/trace_end_func as user-data.
+
 	Note:
 		As a user you might replace the internal memory allocation function by using alloc_func, realloc_func
 		and free_func.
@@ -230,6 +327,12 @@ typedef struct dl_create_params
 
 	dl_error_msg_handler error_msg_func;
 	void*                error_msg_ctx;
+
+	dl_stats_mode_t stats_mode;
+
+	dl_trace_func trace_begin_func;
+	dl_trace_func trace_end_func;
+	void*         trace_ctx;
 } dl_create_params_t;
 
 /*
@@ -251,7 +354,11 @@ typedef struct dl_create_params
 		params.free_func    = 0x0; \
 		params.alloc_ctx    = 0x0; \
 		params.error_msg_func = 0x0; \
-		params.error_msg_ctx  = 0x0;
+		params.error_msg_ctx  = 0x0; \
+		params.stats_mode     = DL_STATS_NONE; \
+		params.trace_begin_func = 0x0; \
+		params.trace_end_func   = 0x0; \
+		params.trace_ctx        = 0x0;
 
 /*
 	Group: Context
@@ -286,6 +393,135 @@ dl_error_t DL_DLL_EXPORT dl_context_destroy( dl_ctx_t dl_ctx );
 */
 dl_error_t DL_DLL_EXPORT dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size );
 
+/*
+	Function: dl_context_load_type_library_borrowed
+		Load a type-library from bin-data into the context without copying it, the context will reference lib_data
+		directly. Intended for type-libraries that are memory-mapped or embedded in the executable, where the pages can
+		be shared between processes.
+
+		Type-libraries written by dl_context_write_type_library contain all lookup-tables that the context need, and
+		loading them only checks that the tables are in range, nothing is built or allocated. For type-libraries
+		without them, or with tables written on a platform with another ptr-size or endianness, the lookup-tables are
+		built and owned by the context.
+
+		Loading more type-libraries into the context after this will copy the borrowed data to memory owned by the
+		context before the new type-library is added.
+
+	Parameters:
+		dl_ctx        - Context to load type-library into, no other type-library may be loaded in it.
+		lib_data      - Pointer to binary-data with type-library, aligned to 4 bytes and in the endianness of the
+		                platform. Needs to be valid and unmodified for the lifetime of dl_ctx, or until another
+		                type-library is loaded into it.
+		lib_data_size - Size of lib_data.
+
+	Return:
+		DL_ERROR_OK on success.
+		DL_ERROR_INVALID_PARAMETER if a type-library is already loaded in dl_ctx.
+		DL_ERROR_BAD_ALIGNMENT if lib_data is not aligned to 4 bytes.
+		DL_ERROR_ENDIAN_MISMATCH if lib_data is not in the endianness of the platform.
+*/
+dl_error_t DL_DLL_EXPORT dl_context_load_type_library_borrowed( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size );
+
+/*
+	Group: Stats
+*/
+
+/*
+	Enum: dl_stats_op_t
+		Operations that statistics are collected for. Calls made by DL itself while performing an operation, such as
+		dl_instance_calc_size() calling dl_instance_store(), are only counted as the outermost operation.
+
+	DL_STATS_OP_STORE        - dl_instance_store(), dl_instance_store_alloc(), dl_instance_store_stream() and
+	                           dl_instance_calc_size().
+	DL_STATS_OP_LOAD         - dl_instance_load(), dl_instance_load_inplace(), dl_instance_load_relative(),
+	                           dl_instance_load_any() and dl_instance_load_any_alloc().
+	DL_STATS_OP_CONVERT      - dl_convert(), dl_convert_inplace(), dl_convert_to_relative() and dl_convert_calc_size().
+	DL_STATS_OP_TXT_PACK     - dl_txt_pack(), dl_txt_pack_alloc() and dl_txt_pack_calc_size().
+	DL_STATS_OP_TXT_UNPACK   - dl_txt_unpack(), dl_txt_unpack_alloc() and dl_txt_unpack_calc_size().
+	DL_STATS_OP_TYPELIB_LOAD - dl_context_load_type_library(), dl_context_load_type_library_borrowed() and
+	                           dl_context_load_txt_type_library().
+*/
+typedef enum
+{
+	DL_STATS_OP_STORE,
+	DL_STATS_OP_LOAD,
+	DL_STATS_OP_CONVERT,
+	DL_STATS_OP_TXT_PACK,
+	DL_STATS_OP_TXT_UNPACK,
+	DL_STATS_OP_TYPELIB_LOAD,
+
+	DL_STATS_OP_COUNT
+} dl_stats_op_t;
+
+/*
+	Struct: dl_stats_op_counters_t
+		Counters for one dl_stats_op_t.
+
+	Members:
+		calls       - number of calls, including calls that failed.
+		bytes_in    - bytes of packed instances, text or type-libraries read by successful calls. Not counted for
+		              store where the input is an instance in memory.
+		bytes_out   - bytes produced by successful calls, or that would have been produced for calls only calculating
+		              the size. For load this is the size of the loaded instance.
+		nanoseconds - time spent in all calls, only measured with DL_STATS_TIMING.
+*/
+typedef struct dl_stats_op_counters
+{
+	unsigned long long calls;
+	unsigned long long bytes_in;
+	unsigned long long bytes_out;
+	unsigned long long nanoseconds;
+} dl_stats_op_counters_t;
+
+/*
+	Struct: dl_context_stats_t
+		Statistics collected by a context created with stats_mode set in dl_create_params_t.
+
+	Members:
+		ops                  - counters per operation, indexed by dl_stats_op_t.
+		ptrs_patched         - number of non-null ptrs patched while loading instances.
+		type_lookups         - number of lookups of types by id or name.
+		allocations          - number of allocations and reallocations done by the context for its own use. Buffers
+		                       returned to the caller, as by dl_instance_store_alloc(), are not included.
+		allocated_bytes      - bytes currently allocated by the context for its own use.
+		peak_allocated_bytes - highest allocated_bytes since the context was created or the stats were reset.
+*/
+typedef struct dl_context_stats
+{
+	dl_stats_op_counters_t ops[DL_STATS_OP_COUNT];
+	unsigned long long     ptrs_patched;
+	unsigned long long     type_lookups;
+	unsigned long long     allocations;
+	unsigned long long     allocated_bytes;
+	unsigned long long     peak_allocated_bytes;
+} dl_context_stats_t;
+
+/*
+	Function: dl_context_get_stats
+		Fetch statistics collected by a context.
+
+	Parameters:
+		dl_ctx    - Context to fetch statistics from.
+		out_stats - Statistics are returned here.
+
+	Return:
+		DL_ERROR_OK on success. DL_ERROR_UNSUPPORTED_OPERATION if dl_ctx was created with stats_mode DL_STATS_NONE.
+
+	Note:
+		Statistics are updated without synchronization, as with everything else in the context.
+*/
+dl_error_t DL_DLL_EXPORT dl_context_get_stats( dl_ctx_t dl_ctx, dl_context_stats_t* out_stats );
+
+/*
+	Function: dl_context_reset_stats
+		Reset all statistics collected by a context to 0, except for allocated_bytes that keep tracking the memory
+		currently allocated. peak_allocated_bytes is reset to allocated_bytes.
+
+	Return:
+		DL_ERROR_OK on success. DL_ERROR_UNSUPPORTED_OPERATION if dl_ctx was created with stats_mode DL_STATS_NONE.
+*/
+dl_error_t DL_DLL_EXPORT dl_context_reset_stats( dl_ctx_t dl_ctx );
+
 
 /*
 	Group: Load
@@ -328,11 +564,101 @@ dl_error_t DL_DLL_EXPORT dl_instance_load( dl_ctx_t             dl_ctx,
 
 	Note:
 		Some small memory-waste will be incurred by this function since some header-data will be left in memory.
+		Instances stored with relative refs can not be loaded with this function, see dl_instance_load_relative.
 */
 dl_error_t DL_DLL_EXPORT dl_instance_load_inplace( dl_ctx_t       dl_ctx,          dl_typeid_t type,
 												   unsigned char* packed_instance, size_t      packed_instance_size,
 												   void**         loaded_instance, size_t*     consumed );
 
+/*
+	Function: dl_instance_load_relative
+		Loads an instance converted with dl_convert_to_relative(). Ptrs, strings and arrays in such an instance are
+		stored as offsets from the ref itself so nothing need to be patched, the instance is returned where it is
+		and packed_instance is never written to. This makes it possible to load instances from read-only memory or
+		from pages shared between processes.
+
+	Parameters:
+		dl_ctx               - DL-context to use when loading instance.
+		dl_typeid            - Type of instance in the packed data.
+		packed_instance      - Packed instance-data to load.
+		packed_instance_size - Size of buffer pointed to by packed_instance.
+		loaded_instance      - Loaded instance will be returned here.
+		consumed             - Number of bytes consumed to load an instance is returned here, 0x0 to ignore.
+
+	Note:
+		Refs in the loaded instance need to be read with the accessors generated in the c-header of the
+		type-library, see dl_context_write_type_library_c_header.
+
+	Return:
+		DL_ERROR_OK on success. DL_ERROR_UNSUPPORTED_OPERATION if the instance is not stored with relative refs.
+*/
+dl_error_t DL_DLL_EXPORT dl_instance_load_relative( dl_ctx_t             dl_ctx,          dl_typeid_t type,
+													const unsigned char* packed_instance, size_t      packed_instance_size,
+													const void**         loaded_instance, size_t*     consumed );
+
+/*
+	Function: dl_instance_load_any
+		Loads an instance stored with any endian and ptr-size. Instances not in host-format are converted and loaded
+		in the same pass over the data, this is the same as dl_convert() followed by dl_instance_load() but without
+		calculating the size first and without the intermediate packed instance.
+
+	Parameters:
+		dl_ctx               - DL-context to use when loading instance.
+		dl_typeid            - Type of instance in the packed data.
+		instance             - Ptr to memory-area to load the instance into. If 0x0 the instance is loaded in place,
+		                       as with dl_instance_load_inplace(). If equal to packed_instance the instance is also
+		                       loaded in place but placed at the start of packed_instance. Any other memory-area
+		                       may not overlap packed_instance.
+		instance_size        - Size of the memory-area pointed to by instance, ignored if instance is 0x0.
+		packed_instance      - Packed instance-data to load.
+		packed_instance_size - Size of buffer pointed to by packed_instance.
+		loaded_instance      - Loaded instance will be returned here.
+		consumed             - Number of bytes consumed from packed_instance is returned here, 0x0 to ignore.
+
+	Note:
+		For instances stored with the hosts ptr-size the size needed is load_size from dl_instance_get_info(), for
+		other instances dl_convert_calc_size() give a size that is large enough. Use dl_instance_load_any_alloc() to
+		not need to know the size up front.
+
+	Return:
+		DL_ERROR_OK on success. DL_ERROR_BUFFER_TO_SMALL if instance_size is too small.
+		DL_ERROR_UNSUPPORTED_OPERATION if loading in place and ptrs in packed_instance are smaller than host-ptrs or if
+		the instance is stored with relative refs.
+*/
+dl_error_t DL_DLL_EXPORT dl_instance_load_any( dl_ctx_t       dl_ctx,          dl_typeid_t type,
+											   void*          instance,        size_t      instance_size,
+											   unsigned char* packed_instance, size_t      packed_instance_size,
+											   void**         loaded_instance, size_t*     consumed );
+
+/*
+	Function: dl_instance_load_any_alloc
+		Loads an instance stored with any endian and ptr-size into a buffer that is grown as needed. Works as
+		dl_instance_load_any() but can also load instances where ptrs grow without knowing the loaded size up front.
+
+	Parameters:
+		dl_ctx               - DL-context to use when loading instance.
+		dl_typeid            - Type of instance in the packed data.
+		packed_instance      - Packed instance-data to load, only read.
+		packed_instance_size - Size of buffer pointed to by packed_instance.
+		grow_func            - Callback used to allocate and grow the instance-buffer, if 0x0 the allocator of dl_ctx
+		                       is used.
+		grow_ctx             - Passed to grow_func.
+		loaded_instance      - Loaded instance is returned here, at the start of the allocated buffer. 0x0 on failure.
+		loaded_size          - Size of the loaded instance is returned here, 0x0 to ignore. The allocated buffer might
+		                       be bigger than this.
+
+	Return:
+		DL_ERROR_OK on success, DL_ERROR_OUT_OF_INSTANCE_MEMORY if grow_func failed.
+
+	Note:
+		The returned buffer is owned by the caller, see dl_instance_store_alloc() for how to free it if grow_func
+		was 0x0.
+*/
+dl_error_t DL_DLL_EXPORT dl_instance_load_any_alloc( dl_ctx_t             dl_ctx,          dl_typeid_t type,
+													 const unsigned char* packed_instance, size_t      packed_instance_size,
+													 dl_grow_func         grow_func,       void*       grow_ctx,
+													 void**               loaded_instance, size_t*     loaded_size );
+
 /*
 	Group: Store
 */
@@ -375,6 +701,55 @@ dl_error_t DL_DLL_EXPORT dl_instance_calc_size( dl_ctx_t dl_ctx, dl_typeid_t typ
 dl_error_t DL_DLL_EXPORT dl_instance_store( dl_ctx_t       dl_ctx,     dl_typeid_t type,            const void* instance,
 											unsigned char* out_buffer, size_t      out_buffer_size, size_t*     produced_bytes );
 
+/*
+	Function: dl_instance_store_alloc
+		Store instance in a single pass, writing to a buffer that is grown as needed.
+		This is the same as calling dl_instance_calc_size() followed by dl_instance_store() but only walks the
+		instance once.
+
+	Parameters:
+		dl_ctx         - Context to load type-library into.
+		type           - Type id for type to store.
+		instance       - Ptr to instance to store.
+		grow_func      - Callback used to allocate and grow the out-buffer, if 0x0 the allocator of dl_ctx is used.
+		grow_ctx       - Passed to grow_func.
+		out_buffer     - Stored instance is returned here, 0x0 on failure.
+		produced_bytes - Size of the stored instance, the allocated buffer might be bigger than this.
+
+	Return:
+		DL_ERROR_OK on success, DL_ERROR_OUT_OF_INSTANCE_MEMORY if grow_func failed.
+
+	Note:
+		The returned buffer is owned by the caller. If grow_func was 0x0 it is freed with the free_func passed to
+		dl_context_create() via dl_create_params_t, or with free() if that was not set.
+*/
+dl_error_t DL_DLL_EXPORT dl_instance_store_alloc( dl_ctx_t        dl_ctx,     dl_typeid_t type,      const void* instance,
+                                                  dl_grow_func    grow_func,  void*       grow_ctx,
+                                                  unsigned char** out_buffer, size_t*     produced_bytes );
+
+/*
+	Function: dl_instance_store_stream
+		Store instance front to back, passing the output to write_func in chunks as it is produced.
+
+	Parameters:
+		dl_ctx         - Context to load type-library into.
+		type           - Type id for type to store.
+		instance       - Ptr to instance to store.
+		write_func     - Callback receiving the stored instance, in order, a chunk at a time.
+		write_ctx      - Passed to write_func.
+		produced_bytes - Total number of bytes passed to write_func.
+
+	Return:
+		DL_ERROR_OK on success or the first error returned by write_func.
+
+	Note:
+		The placement of all data is planned before anything is written. This needs memory proportional to the number
+		of strings, arrays and pointed to instances in instance but not to the amount of data stored.
+		The output is the same as from dl_instance_store().
+*/
+dl_error_t DL_DLL_EXPORT dl_instance_store_stream( dl_ctx_t      dl_ctx,     dl_typeid_t type,      const void* instance,
+                                                   dl_write_func write_func, void*       write_ctx, size_t*     produced_bytes );
+
 
 /*
 	Group: Util
@@ -388,10 +763,12 @@ DL_DLL_EXPORT const char* dl_error_to_string( dl_error_t error );
 
 typedef struct dl_instance_info
 {
-	unsigned int load_size;
+	size_t       load_size;
 	unsigned int ptrsize;
 	dl_endian_t  endian;
 	dl_typeid_t  root_type;
+	unsigned int relative; ///< 1 if the instance is stored with relative refs, see dl_convert_to_relative().
+	unsigned int version;  ///< format-version the instance is stored with, instances stored with older versions can be read but are always converted to the current version.
 } dl_instance_info_t;
 
 /*
@@ -404,7 +781,8 @@ typedef struct dl_instance_info
 		out_info             - Ptr to dl_instance_info where to return info.
 
 	Return:
-		DL_ERROR_OK on success.
+		DL_ERROR_OK on success. DL_ERROR_VERSION_MISMATCH is returned if the instance is stored with a format-version
+		that can not be read.
 */
 dl_error_t DL_DLL_EXPORT dl_instance_get_info( const unsigned char* packed_instance, size_t packed_instance_size, dl_instance_info_t* out_info );
 
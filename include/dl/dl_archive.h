@@ -0,0 +1,162 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_DL_ARCHIVE_H_INCLUDED
+#define DL_DL_ARCHIVE_H_INCLUDED
+
+/*
+	File: dl_archive.h
+		Functions to build and read archives, containers of many packed instances that can be found by a key.
+
+		An archive starts with a hashed index from key to entry, followed by the keys and last the packed
+		instances, so that a single instance can be found and loaded without touching the rest of the archive.
+		This makes archives suitable to memory-map, see dl_util_map_archive.
+*/
+
+#include <dl/dl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/*
+	Handle: dl_archive_writer_t
+		Handle to an archive that is being built, created with dl_archive_writer_create.
+*/
+typedef struct dl_archive_writer* dl_archive_writer_t;
+
+/*
+	Struct: dl_archive_entry_t
+		Information about an entry in an archive.
+
+	Members:
+		key    - Key of entry, points into the archive.
+		index  - Index of entry in the archive, see dl_archive_get_entry.
+		offset - Offset of packed instance from the start of the archive.
+		size   - Size of packed instance.
+*/
+typedef struct dl_archive_entry
+{
+	const char*  key;
+	unsigned int index;
+	size_t       offset;
+	size_t       size;
+} dl_archive_entry_t;
+
+/*
+	Function: dl_archive_writer_create
+		Create an archive-writer.
+
+	Parameters:
+		dl_ctx     - Context to allocate memory with, needs to be valid until the writer is destroyed.
+		out_writer - Created writer is returned here.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_writer_create( dl_ctx_t dl_ctx, dl_archive_writer_t* out_writer );
+
+/*
+	Function: dl_archive_writer_destroy
+		Destroy an archive-writer and free all memory allocated by it.
+*/
+void DL_DLL_EXPORT dl_archive_writer_destroy( dl_archive_writer_t writer );
+
+/*
+	Function: dl_archive_writer_add
+		Add a copy of a packed instance to the archive.
+
+	Parameters:
+		writer               - Writer to add to.
+		key                  - Zero-terminated key to find instance by.
+		packed_instance      - Packed instance to add.
+		packed_instance_size - Size of packed_instance.
+		alignment            - Alignment of the instance when loaded in place from the archive, given that the
+		                       archive is loaded at an address aligned to at least this. Power of 2, 0 for default
+		                       of 8.
+
+	Note:
+		All instances in an archive need to have the same endianness, the index is written in that endianness.
+
+	Return:
+		DL_ERROR_OK on success.
+		DL_ERROR_ARCHIVE_DUPLICATE_KEY if key is already used in the archive.
+		DL_ERROR_ENDIAN_MISMATCH if packed_instance is of another endianness than earlier instances.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_writer_add( dl_archive_writer_t  writer,
+												const char*          key,
+												const unsigned char* packed_instance,
+												size_t               packed_instance_size,
+												size_t               alignment );
+
+/*
+	Function: dl_archive_writer_finish
+		Write the archive with all added instances, a chunk at a time.
+
+	Parameters:
+		writer         - Writer to write archive of.
+		write_func     - Callback that is passed all output in order.
+		write_ctx      - User-data passed to write_func.
+		produced_bytes - Total size of the archive is returned here, can be set to 0x0.
+
+	Return:
+		DL_ERROR_OK on success or the first error returned by write_func.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_writer_finish( dl_archive_writer_t writer,
+												   dl_write_func       write_func,
+												   void*               write_ctx,
+												   size_t*             produced_bytes );
+
+/*
+	Function: dl_archive_entry_count
+		Get the number of entries in an archive.
+
+	Parameters:
+		archive         - Archive data, aligned to 8 bytes.
+		archive_size    - Size of archive.
+		out_entry_count - Number of entries is returned here.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_entry_count( const unsigned char* archive, size_t archive_size, unsigned int* out_entry_count );
+
+/*
+	Function: dl_archive_get_entry
+		Get an entry in an archive by its index, entries are stored in the order they were added.
+
+	Parameters:
+		archive      - Archive data, aligned to 8 bytes.
+		archive_size - Size of archive.
+		entry_index  - Index of entry to get.
+		out_entry    - Entry is returned here.
+
+	Return:
+		DL_ERROR_OK on success, DL_ERROR_INVALID_PARAMETER if entry_index is out of range.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_get_entry( const unsigned char* archive,
+											   size_t               archive_size,
+											   unsigned int         entry_index,
+											   dl_archive_entry_t*  out_entry );
+
+/*
+	Function: dl_archive_find
+		Find an entry in an archive by key in constant time, only the parts of the index needed to find key are read.
+
+	Parameters:
+		archive      - Archive data, aligned to 8 bytes.
+		archive_size - Size of archive.
+		key          - Zero-terminated key to search for.
+		out_entry    - Entry is returned here.
+
+	Example:
+		dl_archive_entry_t entry;
+		if( dl_archive_find( archive, archive_size, "my_key", &entry ) == DL_ERROR_OK )
+			dl_instance_load_inplace( dl_ctx, type, archive + entry.offset, entry.size, &instance, 0x0 );
+
+	Return:
+		DL_ERROR_OK on success, DL_ERROR_ARCHIVE_KEY_NOT_FOUND if there is no entry with key.
+*/
+dl_error_t DL_DLL_EXPORT dl_archive_find( const unsigned char* archive,
+										  size_t               archive_size,
+										  const char*          key,
+										  dl_archive_entry_t*  out_entry );
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif // DL_DL_ARCHIVE_H_INCLUDED
@@ -7,6 +7,13 @@
 	File: dl_convert.h
 		Exposes functionality to convert packed dl-instances between different formats
 		regarding pointer-size and endianness.
+
+	Note:
+		How to convert a type between two formats is computed the first time it is converted and then cached in the
+		context, so converting modifies the context and may not be done from several threads at once with the same
+		context. Call dl_convert_prepare() for each pair of formats that will be converted between before sharing the
+		context between threads, converting between prepared formats only reads the context. This also holds for
+		dl_instance_load_any() that converts instances not in host-format.
 */
 
 #include <dl/dl.h>
@@ -49,7 +56,8 @@ dl_error_t DL_DLL_EXPORT dl_convert( dl_ctx_t       dl_ctx,          dl_typeid_t
 		produced_bytes       - Ptr where new size of instance will be returned. Can be set to 0x0.
 
 	Note:
-		Function is restricted to converting endianness and converting 8-byte ptr:s to 4-byte ptr:s
+		Function is restricted to converting endianness and converting 8-byte ptr:s to 4-byte ptr:s. Instances stored
+		with an older format-version can not be converted inplace.
 
 	Return:
 		DL_ERROR_OK on success. DL_ERROR_UNSUPORTED_OPERATION is returned if trying to convert to format not
@@ -60,6 +68,36 @@ dl_error_t DL_DLL_EXPORT dl_convert_inplace( dl_ctx_t dl_ctx,                dl_
                                              dl_endian_t    out_endian,      size_t      out_ptr_size,
                                              size_t*        produced_bytes );
 
+/*
+	Function: dl_convert_to_relative
+		Converts a packed instance to the relative format, where ptrs, strings and arrays are stored as signed offsets
+		from the ref itself instead of offsets from the start of the instance. An instance in this format can be
+		loaded without patching by dl_instance_load_relative().
+
+	Parameters:
+		dl_ctx               - Handle to valid DL-context.
+		type                 - DL-type expected to be found in packed instance.
+		packed_instance      - Ptr to memory-area where packed instance is to be found.
+		packed_instance_size - Size of packed_instance.
+		out_instance         - Ptr to memory-area where to place the converted instance, 0x0 to only calculate size.
+		out_instance_size    - Size of out_instance_size.
+		out_endian           - Endian to convert the packed instance to.
+		out_ref_size         - Size in bytes of refs after conversion, valid values 4 and 8. The layout of the converted
+		                       instance is the same as of an instance with ptrs of this size.
+		produced_bytes       - Ptr where size of converted instance will be returned. Can be set to 0x0.
+
+	Note:
+		A null ptr is stored as 0, a ref can therefore not point to itself. DL_ERROR_UNSUPPORTED_OPERATION is returned
+		for instances where a ptr is the first member of the struct it points to.
+		Instances already in the relative format can not be converted, DL_ERROR_UNSUPPORTED_OPERATION is returned.
+		4-byte refs are signed, DL_ERROR_UNSUPPORTED_OPERATION is returned if the converted instance is 2GB or larger.
+*/
+dl_error_t DL_DLL_EXPORT dl_convert_to_relative( dl_ctx_t       dl_ctx,          dl_typeid_t type,
+                                                 unsigned char* packed_instance, size_t      packed_instance_size,
+                                                 unsigned char* out_instance,    size_t      out_instance_size,
+                                                 dl_endian_t    out_endian,      size_t      out_ref_size,
+                                                 size_t*        produced_bytes );
+
 /*
 	Function: dl_convert_calc_size
 		Calculates size of an instance after _PtrSize-conversion.
@@ -76,6 +114,28 @@ dl_error_t DL_DLL_EXPORT dl_convert_calc_size( dl_ctx_t       dl_ctx,          d
                                                unsigned char* packed_instance, size_t      packed_instance_size,
                                                size_t         out_ptr_size,    size_t*     out_size );
 
+/*
+	Function: dl_convert_prepare
+		Compute how to convert all types loaded in the context between two formats, see the note at the top of this
+		file.
+
+	Parameters:
+		dl_ctx       - Handle to valid DL-context.
+		src_endian   - Endian of the instances that will be converted.
+		src_ptr_size - Size in bytes of pointers in the instances that will be converted, valid values 4 and 8.
+		out_endian   - Endian the instances will be converted to.
+		out_ptr_size - Size in bytes of pointers after conversions, valid values 4 and 8.
+
+	Return:
+		DL_ERROR_OK on success.
+
+	Note:
+		Types loaded after this call are not prepared, call this again after loading more type-libraries.
+*/
+dl_error_t DL_DLL_EXPORT dl_convert_prepare( dl_ctx_t    dl_ctx,
+                                             dl_endian_t src_endian, size_t src_ptr_size,
+                                             dl_endian_t out_endian, size_t out_ptr_size );
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,69 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_DL_TRACE_H_INCLUDED
+#define DL_DL_TRACE_H_INCLUDED
+
+/*
+	File: dl_trace.h
+		Built-in writer of the trace-events reported by a context, see trace_begin_func in dl_create_params_t.
+
+		Events are written in the Chrome trace-event JSON-format, as an array of "B"- and "E"-events with the
+		type-name and byte-counts of each operation as args, that can be opened in chrome://tracing or Perfetto.
+*/
+
+#include <dl/dl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/*
+	Struct: dl_trace_chrome_t
+		State of a Chrome-trace that is being written, set up with dl_trace_chrome_start(). All members are private.
+*/
+typedef struct dl_trace_chrome
+{
+	dl_write_func      write_func;
+	void*              write_ctx;
+	dl_error_t         err;
+	unsigned long long start_ns;
+	unsigned long long event_count;
+} dl_trace_chrome_t;
+
+/*
+	Function: dl_trace_chrome_start
+		Start to write a Chrome-trace and set up create_params so that the context created with it reports all
+		events to the trace. Timestamps in the trace are relative to this call.
+
+	Parameters:
+		trace         - Trace to start, needs to be valid until dl_trace_chrome_finish() is called.
+		write_func    - Function that the JSON-output is passed to, a chunk at a time.
+		write_ctx     - Passed to write_func.
+		create_params - trace_begin_func, trace_end_func and trace_ctx is set to write to trace.
+
+	Return:
+		DL_ERROR_OK on success or the error returned by write_func.
+
+	Note:
+		A trace can be shared by many contexts as long as they are not used from different threads at once.
+*/
+dl_error_t DL_DLL_EXPORT dl_trace_chrome_start( dl_trace_chrome_t*  trace,
+												dl_write_func       write_func,
+												void*               write_ctx,
+												dl_create_params_t* create_params );
+
+/*
+	Function: dl_trace_chrome_finish
+		Finish the JSON-output of a trace, no events may be reported to the trace after this.
+
+	Return:
+		DL_ERROR_OK on success or the first error returned by write_func while the trace was written, after a failed
+		write nothing more is written.
+*/
+dl_error_t DL_DLL_EXPORT dl_trace_chrome_finish( dl_trace_chrome_t* trace );
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif // DL_DL_TRACE_H_INCLUDED
@@ -36,6 +36,30 @@ extern "C" {
 */
 dl_error_t DL_DLL_EXPORT dl_txt_pack( dl_ctx_t dl_ctx, const char* txt_instance, unsigned char* out_buffer, size_t out_buffer_size, size_t* produced_bytes );
 
+/*
+	Function: dl_txt_pack_alloc
+		Pack string of intermediate-data to binary blob in a single pass, writing to a buffer that is grown as needed.
+		This is the same as calling dl_txt_pack_calc_size() followed by dl_txt_pack() but only parses txt_instance once.
+
+	Parameters:
+		dl_ctx         - Context to use.
+		txt_instance   - Zero-terminated string to pack to binary blob.
+		grow_func      - Callback used to allocate and grow the out-buffer, if 0x0 the allocator of dl_ctx is used.
+		grow_ctx       - Passed to grow_func.
+		out_buffer     - Packed instance is returned here, 0x0 on failure.
+		produced_bytes - Size of the packed instance, the allocated buffer might be bigger than this.
+
+	Return:
+		DL_ERROR_OK on success, DL_ERROR_OUT_OF_INSTANCE_MEMORY if grow_func failed.
+
+	Note:
+		The returned buffer is owned by the caller. If grow_func was 0x0 it is freed with the free_func passed to
+		dl_context_create() via dl_create_params_t, or with free() if that was not set.
+*/
+dl_error_t DL_DLL_EXPORT dl_txt_pack_alloc( dl_ctx_t        dl_ctx,     const char* txt_instance,
+                                            dl_grow_func    grow_func,  void*       grow_ctx,
+                                            unsigned char** out_buffer, size_t*     produced_bytes );
+
 /*
 	Function: dl_txt_pack_calc_size
 		Calculate the amount of memory needed to pack intermediate data to binary blob.
@@ -68,6 +92,32 @@ dl_error_t DL_DLL_EXPORT dl_txt_unpack( dl_ctx_t dl_ctx,                       d
                                         char*                out_txt_instance, size_t      out_txt_instance_size,
                                         size_t*              produced_bytes );
 
+/*
+	Function: dl_txt_unpack_alloc
+		Unpack binary blob to intermediate-data-format in a single pass, writing to a buffer that is grown as needed.
+		This is the same as calling dl_txt_unpack_calc_size() followed by dl_txt_unpack() but only walks packed_instance
+		once.
+
+	Parameters:
+		dl_ctx               - Context to use.
+		type                 - Type stored in packed_instace.
+		packed_instance      - Buffer with packed data.
+		packed_instance_size - Size of packed_instance_size.
+		grow_func            - Callback used to allocate and grow the out-buffer, if 0x0 the allocator of dl_ctx is used.
+		grow_ctx             - Passed to grow_func.
+		out_txt_instance     - Zero-terminated txt-data is returned here, 0x0 on failure.
+		produced_bytes       - Number of bytes written to out_txt_instance, including the zero-terminator.
+
+	Note:
+		The returned buffer is owned by the caller, see dl_txt_pack_alloc() for how to free it.
+		Packed instance to unpack is required to be in current platform endian, if not DL_ERROR_ENDIAN_ERROR will be returned.
+*/
+dl_error_t DL_DLL_EXPORT dl_txt_unpack_alloc( dl_ctx_t             dl_ctx,          dl_typeid_t type,
+                                              const unsigned char* packed_instance, size_t      packed_instance_size,
+                                              dl_grow_func         grow_func,       void*       grow_ctx,
+                                              char**               out_txt_instance,
+                                              size_t*              produced_bytes );
+
 /*
 	Function: dl_txt_unpack_calc_size
 		Calculate the amount of memory needed to unpack binary data to intermediate data.
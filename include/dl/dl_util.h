@@ -94,23 +94,146 @@ dl_error_t dl_util_load_from_stream( dl_ctx_t dl_ctx,       dl_typeid_t
 	Note:
 		This function allocates memory internally by use of malloc/free and should therefore
 		be used accordingly.
+		Binary files stored in the hosts endian and pointer-size are loaded directly from a memory-mapping of the file
+		without any intermediate buffer.
 
 	Parameters:
 		dl_ctx            - Context to use for operations.
-		type              - Type expected to be found in file.
+		type              - Type expected to be found in file, set to 0 if not known.
 		filename          - Path to file to load from.
-		filetype          - Type of file to read, see EDLUtilFileType.
+		filetype          - Type of file to read, see dl_util_file_type_t.
 		out_instance      - Pointer to area to load instance to.
-		out_instance_size - Size of buffer pointed to by _ppInstance
+		out_instance_size - Size of buffer pointed to by out_instance.
+		out_type          - TypeID of instance found in file, can be set to 0x0.
 
 	Returns:
-		DL_ERROR_OK on success.
+		DL_ERROR_OK on success, DL_ERROR_BUFFER_TO_SMALL if the instance do not fit in out_instance.
 */
 dl_error_t dl_util_load_from_file_inplace( dl_ctx_t     dl_ctx,       dl_typeid_t         type,
 										   const char*  filename,     dl_util_file_type_t filetype,
 										   void*        out_instance, size_t              out_instance_size,
 										   dl_typeid_t* out_type );
 
+/*
+	Handle: dl_util_mapped_file_t
+		Handle to a file mapped with dl_util_map_file(), owns the memory of the instance loaded from it.
+*/
+typedef struct dl_util_mapped_file* dl_util_mapped_file_t;
+
+/*
+	Enum: dl_util_map_flags_t
+		Hints passed to dl_util_map_file(), ignored on platforms where they are not supported.
+
+	DL_UTIL_MAP_FLAG_POPULATE  - Read the entire file into memory while mapping instead of on first access, MAP_POPULATE.
+	DL_UTIL_MAP_FLAG_WILL_NEED - The entire instance will be accessed soon, start reading it ahead, MADV_WILLNEED.
+*/
+typedef enum
+{
+	DL_UTIL_MAP_FLAG_POPULATE  = 1 << 0,
+	DL_UTIL_MAP_FLAG_WILL_NEED = 1 << 1
+} dl_util_map_flags_t;
+
+/*
+	Function: dl_util_map_file
+		Utility function that memory-maps a binary dl-instance and loads it where it is mapped.
+
+	Note:
+		The file is mapped copy-on-write, patching pointers in the loaded instance or writing to it will never modify
+		the file. Only pages containing pointers will be copied by patching.
+		Instances stored in another endian or pointer-size than the hosts are converted. This is done in the mapping
+		if possible, otherwise the instance is converted into a buffer allocated with malloc and the file unmapped.
+		Text-files can not be mapped, DL_ERROR_UTIL_FILE_TYPE_MISMATCH is returned for these.
+		Instances converted with dl_convert_to_relative() are loaded with dl_instance_load_relative() and are never
+		written to, refs in them need to be read with the generated accessors.
+
+	Parameters:
+		dl_ctx       - Context to use for operations.
+		type         - Type expected to be found in file, set to 0 if not known.
+		filename     - Path to file to map.
+		map_flags    - Hints for mapping, see dl_util_map_flags_t, or 0.
+		out_mapped   - Handle to pass to dl_util_unmap_file() when the instance is not used anymore.
+		out_instance - Pointer to fill with loaded instance, valid until the file is unmapped.
+		out_type     - TypeID of instance found in file, can be set to 0x0.
+
+	Returns:
+		DL_ERROR_OK on success.
+*/
+dl_error_t dl_util_map_file( dl_ctx_t               dl_ctx,     dl_typeid_t  type,
+							 const char*            filename,   unsigned int map_flags,
+							 dl_util_mapped_file_t* out_mapped, void**       out_instance,
+							 dl_typeid_t*           out_type );
+
+/*
+	Function: dl_util_unmap_file
+		Unmap a file mapped with dl_util_map_file(), the instance loaded from it is not valid anymore.
+
+	Parameters:
+		mapped - Handle returned by dl_util_map_file().
+*/
+void dl_util_unmap_file( dl_util_mapped_file_t mapped );
+
+/*
+	Function: dl_util_map_type_library
+		Utility function that memory-maps a binary type-library and loads it into a context without copying it, see
+		dl_context_load_type_library_borrowed(). Processes mapping the same type-library share its pages.
+
+	Note:
+		The file may not be modified or truncated while it is mapped.
+
+	Parameters:
+		dl_ctx     - Context to load type-library into, no other type-library may be loaded in it.
+		filename   - Path to type-library to map.
+		out_mapped - Handle to pass to dl_util_unmap_file() after dl_ctx is destroyed.
+
+	Returns:
+		DL_ERROR_OK on success.
+*/
+dl_error_t dl_util_map_type_library( dl_ctx_t dl_ctx, const char* filename, dl_util_mapped_file_t* out_mapped );
+
+/*
+	Function: dl_util_map_archive
+		Utility function that memory-maps an archive built with dl_archive_writer_finish(), instances are loaded from it
+		with dl_util_load_from_archive(). Only the pages of the index and of the loaded instances are read.
+
+	Note:
+		The file is mapped copy-on-write in the same way as in dl_util_map_file(). Only archives with the endianness of
+		the host can be mapped.
+
+	Parameters:
+		filename   - Path to archive to map.
+		map_flags  - Hints for mapping, see dl_util_map_flags_t, or 0.
+		out_mapped - Handle to pass to dl_util_unmap_file() when no instance loaded from it is used anymore.
+
+	Returns:
+		DL_ERROR_OK on success, DL_ERROR_ENDIAN_MISMATCH if the archive is not in the endianness of the host.
+*/
+dl_error_t dl_util_map_archive( const char* filename, unsigned int map_flags, dl_util_mapped_file_t* out_mapped );
+
+/*
+	Function: dl_util_load_from_archive
+		Utility function that loads an instance from an archive mapped with dl_util_map_archive(), where it is mapped.
+
+	Note:
+		An instance is only loaded once, loading the same key again returns the same instance.
+		Instances stored with 4-byte pointers on a 64-bit host are converted into a buffer allocated with malloc.
+		Instances converted with dl_convert_to_relative() are loaded with dl_instance_load_relative().
+
+	Parameters:
+		dl_ctx       - Context to use for operations.
+		mapped       - Archive to load instance from.
+		type         - Type expected to be found in entry, set to 0 if not known.
+		key          - Key of entry to load.
+		out_instance - Pointer to fill with loaded instance, valid until the archive is unmapped.
+		out_type     - TypeID of loaded instance, can be set to 0x0.
+
+	Returns:
+		DL_ERROR_OK on success, DL_ERROR_ARCHIVE_KEY_NOT_FOUND if there is no entry with key.
+*/
+dl_error_t dl_util_load_from_archive( dl_ctx_t              dl_ctx, dl_util_mapped_file_t mapped,
+									  dl_typeid_t           type,   const char*           key,
+									  void**                out_instance,
+									  dl_typeid_t*          out_type );
+
 /*
 	Function: dl_util_store_to_file
 		Utility function that writes an instance to file.
@@ -129,7 +252,7 @@ dl_error_t dl_util_load_from_file_inplace( dl_ctx_t     dl_ctx,       dl_typeid_
 		out_instance - Pointer to instance to write
 
 	Returns:
-		DL_ERROR_OK on success.
+		DL_ERROR_OK on success, DL_ERROR_UTIL_FILE_WRITE_FAILED if the file could not be written.
 */
 dl_error_t dl_util_store_to_file( dl_ctx_t    dl_ctx,     dl_typeid_t         type,
 								  const char* filename,   dl_util_file_type_t filetype,
@@ -154,7 +277,7 @@ dl_error_t dl_util_store_to_file( dl_ctx_t    dl_ctx,     dl_typeid_t         ty
 		out_instance - Pointer to instance to write
 
 	Returns:
-		DL_ERROR_OK on success.
+		DL_ERROR_OK on success, DL_ERROR_UTIL_FILE_WRITE_FAILED if the stream could not be written.
 */
 dl_error_t dl_util_store_to_stream( dl_ctx_t    dl_ctx,     dl_typeid_t         type,
 									FILE*       stream,     dl_util_file_type_t filetype,
@@ -4,6 +4,7 @@
 #define CONTAINER_ARRAY_H_INCLUDED
 
 #include <dl/dl_defines.h>
+#include "../dl_alloc.h"
 #include <new>
 
 /*
@@ -148,4 +149,118 @@ public:
 	inline T* GetBasePtr() { return m_Storage; }
 };
 
+/*
+Class: CArrayDynamic
+An implementation of an array that grows on a dl_allocator as elements are added. Elements are moved with memcpy
+when the array grows so T need to be trivially copyable.
+*/
+
+template <typename T>
+class CArrayDynamic
+{
+	dl_allocator* m_pAlloc;
+	T* m_pStorage;
+	size_t m_nElements;
+	size_t m_nCapacity;
+
+	CArrayDynamic(const CArrayDynamic&);
+	CArrayDynamic& operator=(const CArrayDynamic&);
+public:
+	/*
+	Constructor: CArrayDynamic
+	Constructs an empty array allocating its storage on _pAlloc.
+	*/
+	CArrayDynamic(dl_allocator* _pAlloc) : m_pAlloc(_pAlloc), m_pStorage(0x0), m_nElements(0), m_nCapacity(0) {}
+
+	/*
+	Destructor: CArrayDynamic
+	Free all storage.
+	*/
+	~CArrayDynamic()
+	{
+		if(m_pStorage != 0x0)
+			dl_free(m_pAlloc, m_pStorage);
+	}
+
+	/*
+	Function: Len()
+	Get used size
+
+	Returns:
+	Returns Return used length;
+	*/
+	inline size_t Len() const {return m_nElements;}
+
+	/*
+	Function: Empty()
+	Returns true if the array is empty
+	*/
+	inline bool Empty() const { return m_nElements == 0; }
+
+	/*
+	Function: Add()
+	Add an element to the array, growing the storage if needed.
+
+	Parameters:
+	_Element - Element to add
+
+	Returns:
+	Returns false if the storage could not grow.
+	*/
+	bool Add(const T& _Element)
+	{
+		if(m_nElements == m_nCapacity)
+		{
+			size_t new_cap = m_nCapacity == 0 ? 64 : m_nCapacity * 2;
+			T* new_storage = (T*)dl_realloc(m_pAlloc, m_pStorage, new_cap * sizeof(T), m_nCapacity * sizeof(T));
+			if(new_storage == 0x0)
+				return false;
+			m_pStorage  = new_storage;
+			m_nCapacity = new_cap;
+		}
+		new(&(m_pStorage[m_nElements])) T(_Element);
+		m_nElements++;
+		return true;
+	}
+
+	/*
+	Function: operator[]
+	Get element.
+	Parameters:
+	_iEl - Index of wanted element.
+
+	Returns:
+	Returns reference to wanted element.
+	*/
+	T& operator[](size_t _iEl)
+	{
+		DL_ASSERT(_iEl < m_nElements && "Index out of bound");
+		return m_pStorage[_iEl];
+	}
+
+	/*
+	Function: operator[]
+	Get element.
+	Parameters:
+	_iEl - Index of wanted element. Const version.
+
+	Returns:
+	Returns const reference to wanted element.
+	*/
+	const T& operator[](size_t _iEl) const
+	{
+		DL_ASSERT(_iEl < m_nElements && "Index out of bound");
+		return m_pStorage[_iEl];
+	}
+
+	/*
+	Function: GetBasePtr
+	Get the array base pointer.
+
+	Returns:
+	Returns array base pointer.
+	*/
+	inline T* GetBasePtr() { return m_pStorage; }
+};
+
 #endif //CONTAINER_ARRAY_H_INCLUDED
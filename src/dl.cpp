@@ -2,11 +2,19 @@
 #include "dl_swap.h"
 #include "dl_binary_writer.h"
 #include "dl_patch_ptr.h"
+#include "dl_convert_plan.h"
+#include "dl_ptr_map.h"
+#include "dl_stats.h"
 
 #include "container/dl_array.h"
 
 #include <dl/dl.h>
 
+/**
+ * Size of the buffer that dl_instance_store_stream() collects output in before passing it to the write-callback.
+ */
+#define DL_STORE_STREAM_CHUNK_SIZE ( 64 * 1024 )
+
 dl_error_t dl_context_create( dl_ctx_t* dl_ctx, dl_create_params_t* create_params )
 {
 	dl_allocator alloc;
@@ -18,46 +26,92 @@ dl_error_t dl_context_create( dl_ctx_t* dl_ctx, dl_create_params_t* create_param
 		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
 
 	memset(ctx, 0x0, sizeof(dl_context));
-	memcpy(&ctx->alloc, &alloc, sizeof( dl_allocator ) );
+	memcpy(&ctx->alloc,          &alloc, sizeof( dl_allocator ) );
+	memcpy(&ctx->instance_alloc, &alloc, sizeof( dl_allocator ) );
 
 	ctx->error_msg_func = create_params->error_msg_func;
 	ctx->error_msg_ctx  = create_params->error_msg_ctx;
 
+	ctx->trace_begin_func = create_params->trace_begin_func;
+	ctx->trace_end_func   = create_params->trace_end_func;
+	ctx->trace_ctx        = create_params->trace_ctx;
+
+	ctx->stats_mode = create_params->stats_mode;
+	if( ctx->stats_mode != DL_STATS_NONE )
+		dl_internal_stats_track_allocations( ctx );
+
 	*dl_ctx = ctx;
 
 	return DL_ERROR_OK;
 }
 
+/**
+ * Free ptr if it is owned by the context and not part of a borrowed type-library.
+ */
+static void dl_context_free_owned( dl_ctx_t dl_ctx, void* ptr )
+{
+	if( !dl_internal_is_borrowed( dl_ctx, ptr ) )
+		dl_free( &dl_ctx->alloc, ptr );
+}
+
 dl_error_t dl_context_destroy(dl_ctx_t dl_ctx)
 {
-	dl_free( &dl_ctx->alloc, dl_ctx->type_ids );
-	dl_free( &dl_ctx->alloc, dl_ctx->type_descs );
-	dl_free( &dl_ctx->alloc, dl_ctx->enum_ids );
-	dl_free( &dl_ctx->alloc, dl_ctx->enum_descs );
-	dl_free( &dl_ctx->alloc, dl_ctx->member_descs );
-	dl_free( &dl_ctx->alloc, dl_ctx->enum_value_descs );
-	dl_free( &dl_ctx->alloc, dl_ctx->enum_alias_descs );
-	dl_free( &dl_ctx->alloc, dl_ctx->typedata_strings );
-	dl_free( &dl_ctx->alloc, dl_ctx->default_data );
-	dl_free( &dl_ctx->alloc, dl_ctx );
+	dl_context_free_owned( dl_ctx, dl_ctx->type_ids );
+	dl_context_free_owned( dl_ctx, dl_ctx->type_descs );
+	dl_context_free_owned( dl_ctx, dl_ctx->type_caches );
+	dl_context_free_owned( dl_ctx, dl_ctx->patch_ops );
+	dl_context_free_owned( dl_ctx, dl_ctx->enum_ids );
+	dl_context_free_owned( dl_ctx, dl_ctx->enum_descs );
+	dl_context_free_owned( dl_ctx, dl_ctx->member_descs );
+	dl_context_free_owned( dl_ctx, dl_ctx->enum_value_descs );
+	dl_context_free_owned( dl_ctx, dl_ctx->enum_alias_descs );
+	dl_context_free_owned( dl_ctx, dl_ctx->typedata_strings );
+	dl_context_free_owned( dl_ctx, dl_ctx->default_data );
+
+	dl_index_map* maps[DL_TYPELIB_LOOKUP_MAP_COUNT];
+	dl_internal_lookup_maps( dl_ctx, maps );
+	for( int i = 0; i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+		dl_context_free_owned( dl_ctx, maps[i]->entries );
+
+	dl_internal_convert_plans_free( dl_ctx );
+
+	// ... the context itself is allocated before allocations are tracked ...
+	dl_free( &dl_ctx->instance_alloc, dl_ctx );
 	return DL_ERROR_OK;
 }
 
+/**
+ * Patch all ptrs of an instance loaded at instance to be valid, reported as the patch-phase of loading when traced.
+ */
+static dl_error_t dl_internal_load_patch( dl_ctx_t dl_ctx, const dl_type_desc* type, uint8_t* instance, size_t instance_size )
+{
+	dl_trace_scope trace( dl_ctx, "load.patch", dl_internal_type_name( dl_ctx, type ), instance_size );
+	dl_error_t err = dl_internal_patch_instance( dl_ctx, type, instance, 0x0, (uintptr_t)instance );
+	if( err == DL_ERROR_OK )
+		trace.bytes( instance_size, instance_size );
+	return err;
+}
+
 dl_error_t dl_instance_load( dl_ctx_t             dl_ctx,          dl_typeid_t  type_id,
                              void*                instance,        size_t instance_size,
                              const unsigned char* packed_instance, size_t packed_instance_size,
                              size_t*              consumed )
 {
-	dl_data_header* header = (dl_data_header*)packed_instance;
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_LOAD, "dl_instance_load", dl_internal_trace_type_name( dl_ctx, type_id ), packed_instance_size );
 
-	if( packed_instance_size < sizeof(dl_data_header) ) return DL_ERROR_MALFORMED_DATA;
-	if( header->id == DL_INSTANCE_ID_SWAPED )          return DL_ERROR_ENDIAN_MISMATCH;
-	if( header->id != DL_INSTANCE_ID )                 return DL_ERROR_MALFORMED_DATA;
-	if( header->version != DL_INSTANCE_VERSION )       return DL_ERROR_VERSION_MISMATCH;
-	if( header->root_instance_type != type_id )        return DL_ERROR_TYPE_MISMATCH;
-	if( header->instance_size > instance_size )        return DL_ERROR_BUFFER_TO_SMALL;
-
-	const dl_type_desc* root_type = dl_internal_find_type( dl_ctx, header->root_instance_type );
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( endian != DL_ENDIAN_HOST )                    return DL_ERROR_ENDIAN_MISMATCH;
+	if( header.root_instance_type != type_id )        return DL_ERROR_TYPE_MISMATCH;
+	if( header.is_relative_ptr )                      return DL_ERROR_UNSUPPORTED_OPERATION;
+	if( header.instance_size > instance_size )        return DL_ERROR_BUFFER_TO_SMALL;
+
+	const dl_type_desc* root_type = dl_internal_find_type( dl_ctx, header.root_instance_type );
 	if( root_type == 0x0 )
 		return DL_ERROR_TYPE_NOT_FOUND;
 
@@ -66,14 +120,16 @@ dl_error_t dl_instance_load( dl_ctx_t             dl_ctx,          dl_typeid_t
 	// if( !dl_internal_is_align( instance, pType->m_Alignment[DL_PTR_SIZE_HOST] ) )
 	//	return DL_ERROR_BAD_ALIGNMENT;
 
-	// TODO: memmove here is a hack, should only need memcpy but due to abuse of dl_instance_load in dl_util.cpp
-	// memmove is needed!
-	memmove( instance, packed_instance + sizeof(dl_data_header), header->instance_size );
+	// ... memmove since dl_instance_load_any() loads in place to the start of the packed buffer through here ...
+	memmove( instance, packed_instance + header_size, (size_t)header.instance_size );
 
-	dl_internal_patch_instance( dl_ctx, root_type, (uint8_t*)instance, 0x0, (uintptr_t)instance );
+	err = dl_internal_load_patch( dl_ctx, root_type, (uint8_t*)instance, (size_t)header.instance_size );
+	if( err != DL_ERROR_OK )
+		return err;
 
+	stats.bytes( (size_t)header.instance_size + header_size, (size_t)header.instance_size );
 	if( consumed )
-		*consumed = (size_t)header->instance_size + sizeof(dl_data_header);
+		*consumed = (size_t)header.instance_size + header_size;
 
 	return DL_ERROR_OK;
 }
@@ -82,62 +138,180 @@ dl_error_t DL_DLL_EXPORT dl_instance_load_inplace( dl_ctx_t       dl_ctx,
 												   unsigned char* packed_instance, size_t      packed_instance_size,
 												   void**         loaded_instance, size_t*     consumed)
 {
-	dl_data_header* header = (dl_data_header*)packed_instance;
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_LOAD, "dl_instance_load_inplace", dl_internal_trace_type_name( dl_ctx, type_id ), packed_instance_size );
 
-	if( packed_instance_size < sizeof(dl_data_header) ) return DL_ERROR_MALFORMED_DATA;
-	if( header->id == DL_INSTANCE_ID_SWAPED )           return DL_ERROR_ENDIAN_MISMATCH;
-	if( header->id != DL_INSTANCE_ID )                  return DL_ERROR_MALFORMED_DATA;
-	if( header->version != DL_INSTANCE_VERSION )        return DL_ERROR_VERSION_MISMATCH;
-	if( header->root_instance_type != type_id )         return DL_ERROR_TYPE_MISMATCH;
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( endian != DL_ENDIAN_HOST )                     return DL_ERROR_ENDIAN_MISMATCH;
+	if( header.root_instance_type != type_id )         return DL_ERROR_TYPE_MISMATCH;
+	if( header.is_relative_ptr )                       return DL_ERROR_UNSUPPORTED_OPERATION;
 
-	const dl_type_desc* type = dl_internal_find_type(dl_ctx, header->root_instance_type);
+	const dl_type_desc* type = dl_internal_find_type(dl_ctx, header.root_instance_type);
 	if( type == 0x0 )
 		return DL_ERROR_TYPE_NOT_FOUND;
 
-	uint8_t* instance_ptr = packed_instance + sizeof(dl_data_header);
-	dl_internal_patch_instance( dl_ctx, type, instance_ptr, 0x0, (uintptr_t)instance_ptr );
+	uint8_t* instance_ptr = packed_instance + header_size;
+	err = dl_internal_load_patch( dl_ctx, type, instance_ptr, (size_t)header.instance_size );
+	if( err != DL_ERROR_OK )
+		return err;
 
 	*loaded_instance = instance_ptr;
 
+	stats.bytes( (size_t)header.instance_size + header_size, (size_t)header.instance_size );
 	if( consumed )
-		*consumed = header->instance_size + sizeof(dl_data_header);
+		*consumed = (size_t)header.instance_size + header_size;
 
 	return DL_ERROR_OK;
 }
 
+dl_error_t DL_DLL_EXPORT dl_instance_load_relative( dl_ctx_t             dl_ctx,          dl_typeid_t type_id,
+													const unsigned char* packed_instance, size_t      packed_instance_size,
+													const void**         loaded_instance, size_t*     consumed )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_LOAD, "dl_instance_load_relative", dl_internal_trace_type_name( dl_ctx, type_id ), packed_instance_size );
+
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( endian != DL_ENDIAN_HOST )                                      return DL_ERROR_ENDIAN_MISMATCH;
+	if( header.root_instance_type != type_id )                          return DL_ERROR_TYPE_MISMATCH;
+	if( !header.is_relative_ptr )                                       return DL_ERROR_UNSUPPORTED_OPERATION;
+	if( header.instance_size > packed_instance_size - header_size )     return DL_ERROR_MALFORMED_DATA;
+
+	if( dl_internal_find_type( dl_ctx, header.root_instance_type ) == 0x0 )
+		return DL_ERROR_TYPE_NOT_FOUND;
+
+	// ... all refs are relative to themselves, there is nothing to patch ...
+	*loaded_instance = packed_instance + header_size;
+
+	stats.bytes( (size_t)header.instance_size + header_size, (size_t)header.instance_size );
+	if( consumed )
+		*consumed = (size_t)header.instance_size + header_size;
+
+	return DL_ERROR_OK;
+}
+
+/**
+ * Data-block that is placed at the end of the output while storing. When planning a store all blocks are recorded in
+ * the order they are placed, i.e. with increasing offset, so that they can be emitted front to back afterwards.
+ */
+struct dl_store_block
+{
+	const uint8_t*      src;
+	const dl_type_desc* type;       ///< type of struct or array-element, 0x0 if not a struct.
+	uintptr_t           offset;
+	uintptr_t           elem_size;  ///< size of one array-element, size of struct or length of string including '\0'.
+	uint32_t            count;      ///< number of array-elements, 1 if not an array.
+	uint32_t            subtree;    ///< number of blocks placed while storing this block, including the block itself.
+	uint32_t            first_ref;  ///< index of the first ptr-reference recorded while storing this block.
+	uint32_t            ref_count;  ///< number of ptr-references recorded while storing this block, including sub-blocks.
+	dl_type_t           block_type; ///< DL_TYPE_ATOM_POD and storage struct or str for pointed to structs and strings,
+	                                ///< DL_TYPE_ATOM_ARRAY and storage of elements for array data.
+};
+
 struct CDLBinStoreContext
 {
-	CDLBinStoreContext( uint8_t* out_data, size_t out_data_size, bool is_dummy )
+	CDLBinStoreContext( uint8_t* out_data, size_t out_data_size, bool is_dummy, dl_allocator* alloc )
+		: blocks( alloc )
+		, refs( alloc )
 	{
 		dl_binary_writer_init( &writer, out_data, out_data_size, is_dummy, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
-		num_written_ptrs = 0;
+		dl_ptr_map_init( &written_ptrs, alloc );
+		err = DL_ERROR_OK;
+		plan = false;
 	}
 
-	uintptr_t FindWrittenPtr( void* ptr )
+	CDLBinStoreContext( dl_grow_func grow_func, void* grow_ctx, size_t head_size, dl_allocator* alloc )
+		: blocks( alloc )
+		, refs( alloc )
+	{
+		dl_binary_writer_init_grow( &writer, grow_func, grow_ctx, head_size, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+		dl_ptr_map_init( &written_ptrs, alloc );
+		err = DL_ERROR_OK;
+		plan = false;
+	}
+
+	~CDLBinStoreContext()
 	{
-		for( int i = 0; i < num_written_ptrs; ++i )
-			if( written_ptrs[i].ptr == ptr )
-				return written_ptrs[i].pos;
+		dl_ptr_map_free( &written_ptrs );
+	}
 
-		return (uintptr_t)-1;
+	uintptr_t FindWrittenPtr( void* ptr )
+	{
+		return dl_ptr_map_find( &written_ptrs, (uintptr_t)ptr );
 	}
 
 	void AddWrittenPtr( const void* ptr, uintptr_t pos )
 	{
-		DL_ASSERT( num_written_ptrs < (int)DL_ARRAY_LENGTH(written_ptrs) );
-		written_ptrs[num_written_ptrs].ptr = ptr;
-		written_ptrs[num_written_ptrs].pos = pos;
-		++num_written_ptrs;
+		dl_error_t add_err = dl_ptr_map_insert( &written_ptrs, (uintptr_t)ptr, pos );
+		if( add_err != DL_ERROR_OK )
+			err = add_err;
 	}
 
-	dl_binary_writer writer;
+	/// record a block placed at offset if planning, return its index to be passed to PlanBlockEnd().
+	size_t PlanBlock( dl_type_t block_type, const void* src, const dl_type_desc* type, uintptr_t offset, uintptr_t elem_size, uint32_t count )
+	{
+		if( !plan )
+			return 0;
+
+		dl_store_block block;
+		block.src        = (const uint8_t*)src;
+		block.type       = type;
+		block.offset     = offset;
+		block.elem_size  = elem_size;
+		block.count      = count;
+		block.subtree    = 1;
+		block.first_ref  = (uint32_t)refs.Len();
+		block.ref_count  = 0;
+		block.block_type = block_type;
+		if( !blocks.Add( block ) )
+			err = DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+		return blocks.Len() - 1;
+	}
+
+	/// all sub-blocks of block has been placed.
+	void PlanBlockEnd( size_t block )
+	{
+		if( plan && block < blocks.Len() )
+		{
+			blocks[block].subtree   = (uint32_t)( blocks.Len() - block );
+			blocks[block].ref_count = (uint32_t)( refs.Len() - blocks[block].first_ref );
+		}
+	}
 
-	struct
+	/// record offset written for a non-null ptr if planning, must be called before the block it places, if any, is
+	/// planned.
+	void PlanRef( uintptr_t offset )
 	{
-		uintptr_t   pos;
-		const void* ptr;
-	} written_ptrs[128];
-	int num_written_ptrs;
+		if( plan && !refs.Add( offset ) )
+			err = DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+
+	dl_binary_writer writer;
+
+	/// map from pointer in the instance being stored to its offset in the output.
+	dl_ptr_map written_ptrs;
+
+	/// true if blocks should be recorded while storing.
+	bool plan;
+
+	/// all blocks in the order they were placed, only recorded when planning.
+	CArrayDynamic<dl_store_block> blocks;
+
+	/// offsets written for all non-null ptrs in the order they were stored, only recorded when planning.
+	CArrayDynamic<uintptr_t> refs;
+
+	/// first error that could not be returned directly while storing.
+	dl_error_t err;
 };
 
 static void dl_internal_store_string( const uint8_t* instance, CDLBinStoreContext* store_ctx )
@@ -151,7 +325,9 @@ static void dl_internal_store_string( const uint8_t* instance, CDLBinStoreContex
 	uintptr_t pos = dl_binary_writer_tell( &store_ctx->writer );
 	dl_binary_writer_seek_end( &store_ctx->writer );
 	uintptr_t offset = dl_binary_writer_tell( &store_ctx->writer );
-	dl_binary_writer_write( &store_ctx->writer, str, strlen(str) + 1 );
+	size_t len = strlen(str) + 1;
+	store_ctx->PlanBlock( (dl_type_t)( DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STR ), str, 0x0, offset, len, 1 );
+	dl_binary_writer_write( &store_ctx->writer, str, len );
 	dl_binary_writer_seek_set( &store_ctx->writer, pos );
 	dl_binary_writer_write( &store_ctx->writer, &offset, sizeof(uintptr_t) );
 }
@@ -184,10 +360,15 @@ static void dl_internal_store_ptr( dl_ctx_t dl_ctx, uint8_t* instance, const dl_
 
 		store_ctx->AddWrittenPtr(data, offset);
 
+		store_ctx->PlanRef( offset );
+		size_t block = store_ctx->PlanBlock( (dl_type_t)( DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STRUCT ), data, sub_type, offset, size, 1 );
 		dl_internal_instance_store(dl_ctx, sub_type, data, store_ctx);
+		store_ctx->PlanBlockEnd( block );
 
 		dl_binary_writer_seek_set( &store_ctx->writer, pos );
 	}
+	else
+		store_ctx->PlanRef( offset );
 
 	dl_binary_writer_write( &store_ctx->writer, &offset, sizeof(uintptr_t) );
 }
@@ -332,7 +513,9 @@ static dl_error_t dl_internal_store_member( dl_ctx_t dl_ctx, const dl_member_des
 
 				uint8_t* data = *(uint8_t**)data_ptr;
 
+				size_t block = store_ctx->PlanBlock( (dl_type_t)( DL_TYPE_ATOM_ARRAY | storage_type ), data, sub_type, offset, size, count );
 				dl_internal_store_array( dl_ctx, storage_type, sub_type, data, count, size, store_ctx );
+				store_ctx->PlanBlockEnd( block );
 				dl_binary_writer_seek_set( &store_ctx->writer, pos );
 			}
 
@@ -401,9 +584,38 @@ static dl_error_t dl_internal_instance_store( dl_ctx_t dl_ctx, const dl_type_des
 	return DL_ERROR_OK;
 }
 
+static dl_error_t dl_internal_store_root( dl_ctx_t dl_ctx, const dl_type_desc* type, const void* instance, CDLBinStoreContext* store_ctx )
+{
+	dl_binary_writer_reserve( &store_ctx->writer, type->size[DL_PTR_SIZE_HOST] );
+	store_ctx->AddWrittenPtr(instance, 0); // if pointer refere to root-node, it can be found at offset 0
+
+	size_t block = store_ctx->PlanBlock( (dl_type_t)( DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STRUCT ), instance, type, 0, type->size[DL_PTR_SIZE_HOST], 1 );
+	dl_error_t err = dl_internal_instance_store( dl_ctx, type, (uint8_t*)instance, store_ctx );
+	store_ctx->PlanBlockEnd( block );
+	if( err == DL_ERROR_OK )
+		err = store_ctx->err;
+	dl_binary_writer_seek_end( &store_ctx->writer );
+	return err;
+}
+
+static void dl_internal_store_header( unsigned char* out_buffer, dl_typeid_t type_id, size_t instance_size )
+{
+	dl_data_header header;
+	header.id = DL_INSTANCE_ID;
+	header.version = DL_INSTANCE_VERSION;
+	header.root_instance_type = type_id;
+	header.is_64_bit_ptr = sizeof(void*) == 8 ? 1 : 0;
+	header.is_relative_ptr = 0;
+	header.pad[0] = header.pad[1] = 0;
+	header.instance_size = instance_size;
+	memcpy(out_buffer, &header, sizeof(dl_data_header));
+}
+
 dl_error_t dl_instance_store( dl_ctx_t       dl_ctx,     dl_typeid_t type_id,         const void* instance,
 							  unsigned char* out_buffer, size_t      out_buffer_size, size_t*     produced_bytes )
 {
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_STORE, "dl_instance_store", dl_internal_trace_type_name( dl_ctx, type_id ), 0 );
+
 	if( out_buffer_size > 0 && out_buffer_size <= sizeof(dl_data_header) )
 		return DL_ERROR_BUFFER_TO_SMALL;
 
@@ -411,48 +623,377 @@ dl_error_t dl_instance_store( dl_ctx_t       dl_ctx,     dl_typeid_t type_id,
 	if( type == 0x0 )
 		return DL_ERROR_TYPE_NOT_FOUND;
 
-	// write header
-	dl_data_header header;
-	header.id = DL_INSTANCE_ID;
-	header.version = DL_INSTANCE_VERSION;
-	header.root_instance_type = type_id;
-	header.instance_size = 0;
-	header.is_64_bit_ptr = sizeof(void*) == 8 ? 1 : 0;
-	header.pad[0] = header.pad[1] = header.pad[2] = 0;
-
 	unsigned char* store_ctx_buffer      = 0x0;
 	size_t         store_ctx_buffer_size = 0;
 	bool           store_ctx_is_dummy    = out_buffer_size == 0;
 
+	// write header
 	if( out_buffer_size > 0 )
 	{
-		memcpy(out_buffer, &header, sizeof(dl_data_header));
+		dl_internal_store_header( out_buffer, type_id, 0 );
 		store_ctx_buffer      = out_buffer + sizeof(dl_data_header);
 		store_ctx_buffer_size = out_buffer_size - sizeof(dl_data_header);
 	}
 
-	CDLBinStoreContext store_context( store_ctx_buffer, store_ctx_buffer_size, store_ctx_is_dummy );
+	CDLBinStoreContext store_context( store_ctx_buffer, store_ctx_buffer_size, store_ctx_is_dummy, &dl_ctx->alloc );
 
-	dl_binary_writer_reserve( &store_context.writer, type->size[DL_PTR_SIZE_HOST] );
-	store_context.AddWrittenPtr(instance, 0); // if pointer refere to root-node, it can be found at offset 0
-
-	dl_error_t err = dl_internal_instance_store( dl_ctx, type, (uint8_t*)instance, &store_context );
+	dl_error_t err = dl_internal_store_root( dl_ctx, type, instance, &store_context );
 
 	// write instance size!
-	dl_data_header* out_header = (dl_data_header*)out_buffer;
-	dl_binary_writer_seek_end( &store_context.writer );
-	if( out_buffer )
-		out_header->instance_size = (uint32_t)dl_binary_writer_tell( &store_context.writer );
+	size_t instance_size = dl_binary_writer_tell( &store_context.writer );
+	if( out_buffer_size > 0 )
+		dl_internal_store_header( out_buffer, type_id, instance_size );
 
 	if( produced_bytes )
-		*produced_bytes = (uint32_t)dl_binary_writer_tell( &store_context.writer ) + sizeof(dl_data_header);
+		*produced_bytes = instance_size + sizeof(dl_data_header);
 
-	if( out_buffer_size > 0 && out_header->instance_size > out_buffer_size )
+	if( out_buffer_size > 0 && instance_size > out_buffer_size )
 		return DL_ERROR_BUFFER_TO_SMALL;
 
+	if( err == DL_ERROR_OK )
+		stats.bytes( 0, instance_size + sizeof(dl_data_header) );
 	return err;
 }
 
+dl_error_t dl_instance_store_alloc( dl_ctx_t        dl_ctx,     dl_typeid_t  type_id,   const void* instance,
+									dl_grow_func    grow_func,  void*        grow_ctx,
+									unsigned char** out_buffer, size_t*      produced_bytes )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_STORE, "dl_instance_store_alloc", dl_internal_trace_type_name( dl_ctx, type_id ), 0 );
+
+	*out_buffer = 0x0;
+
+	const dl_type_desc* type = dl_internal_find_type( dl_ctx, type_id );
+	if( type == 0x0 )
+		return DL_ERROR_TYPE_NOT_FOUND;
+
+	if( grow_func == 0x0 )
+	{
+		grow_func = dl_allocator_grow;
+		grow_ctx  = &dl_ctx->instance_alloc;
+	}
+
+	CDLBinStoreContext store_context( grow_func, grow_ctx, sizeof(dl_data_header), &dl_ctx->alloc );
+
+	dl_error_t err = dl_internal_store_root( dl_ctx, type, instance, &store_context );
+	if( err == DL_ERROR_OK && store_context.writer.out_of_memory )
+		err = DL_ERROR_OUT_OF_INSTANCE_MEMORY;
+	if( err != DL_ERROR_OK )
+	{
+		dl_binary_writer_free( &store_context.writer );
+		return err;
+	}
+
+	size_t instance_size = dl_binary_writer_tell( &store_context.writer );
+	*out_buffer = dl_binary_writer_release( &store_context.writer );
+	dl_internal_store_header( *out_buffer, type_id, instance_size );
+
+	stats.bytes( 0, instance_size + sizeof(dl_data_header) );
+	if( produced_bytes )
+		*produced_bytes = instance_size + sizeof(dl_data_header);
+	return DL_ERROR_OK;
+}
+
+/**
+ * Sequential output used when emitting a planned store. Data is either written straight to a buffer that is large
+ * enough for the whole instance or collected in buffer and passed to write_func a chunk at a time.
+ */
+struct dl_store_out
+{
+	uint8_t*      buffer;
+	size_t        buffer_size;
+	size_t        buffer_pos;
+	size_t        pos;        ///< position in the stored instance.
+	dl_write_func write_func;
+	void*         write_ctx;
+	dl_error_t    err;
+};
+
+static void dl_store_out_flush( dl_store_out* out )
+{
+	if( out->write_func == 0x0 || out->buffer_pos == 0 )
+		return;
+	if( out->err == DL_ERROR_OK )
+		out->err = out->write_func( out->buffer, out->buffer_pos, out->write_ctx );
+	out->buffer_pos = 0;
+}
+
+static void dl_store_out_write( dl_store_out* out, const void* data, size_t size )
+{
+	out->pos += size;
+	if( out->write_func == 0x0 )
+	{
+		DL_ASSERT( out->buffer_pos + size <= out->buffer_size );
+		memcpy( out->buffer + out->buffer_pos, data, size );
+		out->buffer_pos += size;
+		return;
+	}
+
+	if( out->buffer_pos + size > out->buffer_size )
+	{
+		dl_store_out_flush( out );
+
+		// ... big writes, i.e. large pod-arrays, are passed directly without going through buffer ...
+		if( size >= out->buffer_size )
+		{
+			if( out->err == DL_ERROR_OK )
+				out->err = out->write_func( data, size, out->write_ctx );
+			return;
+		}
+	}
+	memcpy( out->buffer + out->buffer_pos, data, size );
+	out->buffer_pos += size;
+}
+
+static void dl_store_out_pad( dl_store_out* out, size_t to_pos )
+{
+	DL_ASSERT( to_pos >= out->pos );
+	static const uint8_t zero[64] = { 0 };
+	while( out->pos < to_pos )
+	{
+		size_t bytes = to_pos - out->pos;
+		dl_store_out_write( out, zero, bytes < sizeof(zero) ? bytes : sizeof(zero) );
+	}
+}
+
+struct dl_store_emit_ctx
+{
+	const dl_store_block* blocks;
+	size_t                block_count;
+	const uintptr_t*      refs;
+	size_t                next_block; ///< next block placed by a reference in the block being emitted.
+	size_t                next_ref;   ///< next reference in the block being emitted.
+	dl_store_out*         out;
+};
+
+/**
+ * Offset of the next block placed from the block being emitted. Blocks and ptr-references was recorded depth first
+ * while planning so everything recorded while storing the taken block is skipped.
+ */
+static uintptr_t dl_internal_emit_take_block( dl_store_emit_ctx* emit )
+{
+	DL_ASSERT( emit->next_block < emit->block_count );
+	const dl_store_block* block = &emit->blocks[emit->next_block];
+	DL_ASSERT( block->first_ref == emit->next_ref );
+	emit->next_ref    = block->first_ref + block->ref_count;
+	emit->next_block += block->subtree;
+	return block->offset;
+}
+
+/**
+ * Offset of the next non-null ptr in the block being emitted. The ptr that placed a block is the only one that refers
+ * to the next block, all others refer to earlier blocks.
+ */
+static uintptr_t dl_internal_emit_take_ref( dl_store_emit_ctx* emit )
+{
+	uintptr_t offset = emit->refs[emit->next_ref++];
+	if( emit->next_block < emit->block_count && emit->blocks[emit->next_block].offset == offset )
+		dl_internal_emit_take_block( emit );
+	return offset;
+}
+
+static void dl_internal_emit_string( dl_store_emit_ctx* emit, const uint8_t* instance )
+{
+	uintptr_t offset = *(char**)instance == 0x0 ? DL_NULL_PTR_OFFSET[ DL_PTR_SIZE_HOST ] : dl_internal_emit_take_block( emit );
+	dl_store_out_write( emit->out, &offset, sizeof(uintptr_t) );
+}
+
+static void dl_internal_emit_ptr( dl_store_emit_ctx* emit, const uint8_t* instance )
+{
+	uintptr_t offset = *(const uint8_t**)instance == 0x0 ? (uintptr_t)-1 : dl_internal_emit_take_ref( emit );
+	dl_store_out_write( emit->out, &offset, sizeof(uintptr_t) );
+}
+
+static void dl_internal_emit_struct( dl_ctx_t dl_ctx, dl_store_emit_ctx* emit, const dl_type_desc* type, const uint8_t* instance );
+
+static void dl_internal_emit_array( dl_ctx_t dl_ctx, dl_store_emit_ctx* emit, dl_type_t storage_type, const dl_type_desc* sub_type, const uint8_t* instance, uint32_t count, uintptr_t size )
+{
+	switch( storage_type )
+	{
+		case DL_TYPE_STORAGE_STRUCT:
+		{
+			uintptr_t size_ = sub_type->size[DL_PTR_SIZE_HOST];
+			if( sub_type->flags & DL_TYPE_FLAG_HAS_SUBDATA )
+			{
+				for( uint32_t elem = 0; elem < count; ++elem )
+					dl_internal_emit_struct( dl_ctx, emit, sub_type, instance + elem * size_ );
+			}
+			else
+				dl_store_out_write( emit->out, instance, count * size_ );
+		}
+		break;
+		case DL_TYPE_STORAGE_STR:
+			for( uint32_t elem = 0; elem < count; ++elem )
+				dl_internal_emit_string( emit, instance + elem * sizeof(char*) );
+			break;
+		case DL_TYPE_STORAGE_PTR:
+			for( uint32_t elem = 0; elem < count; ++elem )
+				dl_internal_emit_ptr( emit, instance + elem * sizeof(void*) );
+			break;
+		default:
+			dl_store_out_write( emit->out, instance, count * size );
+			break;
+	}
+}
+
+/**
+ * Emit member, same layout as dl_internal_store_member() but all subdata is already placed.
+ */
+static void dl_internal_emit_member( dl_ctx_t dl_ctx, dl_store_emit_ctx* emit, const dl_member_desc* member, const uint8_t* instance )
+{
+	dl_type_t storage_type = member->StorageType();
+	switch( member->AtomType() )
+	{
+		case DL_TYPE_ATOM_POD:
+			switch( storage_type )
+			{
+				case DL_TYPE_STORAGE_STRUCT: dl_internal_emit_struct( dl_ctx, emit, dl_internal_find_type( dl_ctx, member->type_id ), instance ); break;
+				case DL_TYPE_STORAGE_STR:    dl_internal_emit_string( emit, instance ); break;
+				case DL_TYPE_STORAGE_PTR:    dl_internal_emit_ptr( emit, instance ); break;
+				default:                     dl_store_out_write( emit->out, instance, member->size[DL_PTR_SIZE_HOST] ); break;
+			}
+			break;
+		case DL_TYPE_ATOM_INLINE_ARRAY:
+		{
+			const dl_type_desc* sub_type = 0x0;
+			uint32_t count = member->inline_array_cnt();
+			if( storage_type == DL_TYPE_STORAGE_STRUCT || storage_type == DL_TYPE_STORAGE_PTR )
+				sub_type = dl_internal_find_type( dl_ctx, member->type_id );
+			else if( storage_type != DL_TYPE_STORAGE_STR )
+				count = member->size[DL_PTR_SIZE_HOST];
+			dl_internal_emit_array( dl_ctx, emit, storage_type, sub_type, instance, count, 1 );
+		}
+		break;
+		case DL_TYPE_ATOM_ARRAY:
+		{
+			uint32_t  count  = *(const uint32_t*)( instance + sizeof(void*) );
+			uintptr_t offset = count == 0 ? DL_NULL_PTR_OFFSET[ DL_PTR_SIZE_HOST ] : dl_internal_emit_take_block( emit );
+			dl_store_out_write( emit->out, &offset, sizeof(uintptr_t) );
+			dl_store_out_write( emit->out, &count, sizeof(uint32_t) );
+		}
+		break;
+		case DL_TYPE_ATOM_BITFIELD:
+			dl_store_out_write( emit->out, instance, member->size[DL_PTR_SIZE_HOST] );
+			break;
+		default:
+			DL_ASSERT(false && "Invalid ATOM-type!");
+			break;
+	}
+}
+
+/**
+ * Emit struct, same layout as dl_internal_instance_store().
+ */
+static void dl_internal_emit_struct( dl_ctx_t dl_ctx, dl_store_emit_ctx* emit, const dl_type_desc* type, const uint8_t* instance )
+{
+	dl_store_out* out = emit->out;
+	dl_store_out_pad( out, dl_internal_align_up( out->pos, type->alignment[DL_PTR_SIZE_HOST] ) );
+	size_t instance_pos = out->pos;
+
+	if( type->flags & DL_TYPE_FLAG_IS_UNION )
+	{
+		size_t max_member_size = dl_internal_largest_member_size( dl_ctx, type, DL_PTR_SIZE_HOST );
+		uint32_t union_type = *((const uint32_t*)(instance + max_member_size));
+		const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( dl_ctx, type, union_type );
+
+		dl_store_out_pad( out, instance_pos + member->offset[DL_PTR_SIZE_HOST] );
+		dl_internal_emit_member( dl_ctx, emit, member, instance + member->offset[DL_PTR_SIZE_HOST] );
+		dl_store_out_pad( out, dl_internal_align_up( instance_pos + max_member_size, 4 ) );
+		dl_store_out_write( out, &union_type, sizeof(uint32_t) );
+	}
+	else
+	{
+		bool last_was_bitfield = false;
+		for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
+		{
+			const dl_member_desc* member = dl_get_type_member( dl_ctx, type, member_index );
+			if( !last_was_bitfield || member->AtomType() != DL_TYPE_ATOM_BITFIELD )
+			{
+				dl_store_out_pad( out, instance_pos + member->offset[DL_PTR_SIZE_HOST] );
+				dl_internal_emit_member( dl_ctx, emit, member, instance + member->offset[DL_PTR_SIZE_HOST] );
+			}
+			last_was_bitfield = member->AtomType() == DL_TYPE_ATOM_BITFIELD;
+		}
+	}
+}
+
+/**
+ * Write all blocks recorded by a planning store front to back, padding between blocks is zeroed.
+ */
+static void dl_internal_store_emit( dl_ctx_t dl_ctx, CDLBinStoreContext* plan_ctx, dl_store_out* out, size_t instance_size )
+{
+	dl_store_emit_ctx emit;
+	emit.blocks       = plan_ctx->blocks.GetBasePtr();
+	emit.block_count  = plan_ctx->blocks.Len();
+	emit.refs         = plan_ctx->refs.GetBasePtr();
+	emit.out          = out;
+
+	for( size_t i = 0; i < emit.block_count && out->err == DL_ERROR_OK; ++i )
+	{
+		const dl_store_block* block = &emit.blocks[i];
+		dl_store_out_pad( out, block->offset );
+		emit.next_block = i + 1;
+		emit.next_ref   = block->first_ref;
+
+		dl_type_t storage_type = dl_type_t( block->block_type & DL_TYPE_STORAGE_MASK );
+		if( ( block->block_type & DL_TYPE_ATOM_MASK ) == DL_TYPE_ATOM_ARRAY )
+			dl_internal_emit_array( dl_ctx, &emit, storage_type, block->type, block->src, block->count, block->elem_size );
+		else if( storage_type == DL_TYPE_STORAGE_STRUCT )
+			dl_internal_emit_struct( dl_ctx, &emit, block->type, block->src );
+		else
+			dl_store_out_write( out, block->src, block->elem_size );
+		DL_ASSERT( emit.next_block == i + block->subtree );
+		DL_ASSERT( emit.next_ref == block->first_ref + block->ref_count );
+	}
+	dl_store_out_pad( out, instance_size );
+	dl_store_out_flush( out );
+}
+
+dl_error_t dl_instance_store_stream( dl_ctx_t      dl_ctx,     dl_typeid_t type_id,   const void* instance,
+									 dl_write_func write_func, void*       write_ctx, size_t*     produced_bytes )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_STORE, "dl_instance_store_stream", dl_internal_trace_type_name( dl_ctx, type_id ), 0 );
+
+	const dl_type_desc* type = dl_internal_find_type( dl_ctx, type_id );
+	if( type == 0x0 )
+		return DL_ERROR_TYPE_NOT_FOUND;
+
+	// ... plan where all data will be placed without writing anything ...
+	CDLBinStoreContext plan_ctx( 0x0, 0, true, &dl_ctx->alloc );
+	plan_ctx.plan = true;
+	dl_error_t err = dl_internal_store_root( dl_ctx, type, instance, &plan_ctx );
+	if( err != DL_ERROR_OK )
+		return err;
+	size_t instance_size = dl_binary_writer_tell( &plan_ctx.writer );
+
+	// ... and emit it front to back in chunks ...
+	dl_store_out out;
+	out.buffer_size = DL_STORE_STREAM_CHUNK_SIZE;
+	out.buffer      = (uint8_t*)dl_alloc( &dl_ctx->alloc, out.buffer_size );
+	out.buffer_pos  = 0;
+	out.pos         = 0;
+	out.write_func  = write_func;
+	out.write_ctx   = write_ctx;
+	out.err         = DL_ERROR_OK;
+	if( out.buffer == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	dl_data_header header;
+	dl_internal_store_header( (unsigned char*)&header, type_id, instance_size );
+	dl_store_out_write( &out, &header, sizeof(header) );
+	out.pos = 0; // ... alignment and offsets are relative to the instance, not the header ...
+
+	dl_internal_store_emit( dl_ctx, &plan_ctx, &out, instance_size );
+	dl_free( &dl_ctx->alloc, out.buffer );
+	if( out.err != DL_ERROR_OK )
+		return out.err;
+
+	stats.bytes( 0, out.pos + sizeof(dl_data_header) );
+	if( produced_bytes )
+		*produced_bytes = out.pos + sizeof(dl_data_header);
+	return DL_ERROR_OK;
+}
+
 dl_error_t dl_instance_calc_size( dl_ctx_t dl_ctx, dl_typeid_t type, void* instance, size_t* out_size )
 {
 	return dl_instance_store( dl_ctx, type, instance, 0x0, 0, out_size );
@@ -495,33 +1036,86 @@ const char* dl_error_to_string( dl_error_t error )
 		DL_ERR_TO_STR(DL_ERROR_UTIL_FILE_TYPE_MISMATCH);
 
 		DL_ERR_TO_STR(DL_ERROR_INTERNAL_ERROR);
+
+		DL_ERR_TO_STR(DL_ERROR_UTIL_FILE_WRITE_FAILED);
+
+		DL_ERR_TO_STR(DL_ERROR_ARCHIVE_KEY_NOT_FOUND);
+		DL_ERR_TO_STR(DL_ERROR_ARCHIVE_DUPLICATE_KEY);
 		default: return "Unknown error!";
 	}
 #undef DL_ERR_TO_STR
 }
 
-dl_error_t dl_instance_get_info( const unsigned char* packed_instance, size_t packed_instance_size, dl_instance_info_t* out_info )
+dl_error_t dl_internal_read_instance_header( const unsigned char* packed_instance, size_t packed_instance_size,
+											 dl_data_header* header, size_t* header_size, dl_endian_t* endian )
 {
-	dl_data_header* header = (dl_data_header*)packed_instance;
-
-	if( packed_instance_size < sizeof(dl_data_header) && header->id != DL_INSTANCE_ID_SWAPED && header->id != DL_INSTANCE_ID )
+	if( packed_instance_size < sizeof(dl_data_header_v1) )
 		return DL_ERROR_MALFORMED_DATA;
-	if(header->version != DL_INSTANCE_VERSION && header->version != DL_INSTANCE_VERSION_SWAPED)
-		return DL_ERROR_VERSION_MISMATCH;
 
-	out_info->ptrsize   = header->is_64_bit_ptr ? 8 : 4;
-	if( header->id == DL_INSTANCE_ID )
+	uint32_t id, version;
+	memcpy( &id,      packed_instance,                    sizeof(uint32_t) );
+	memcpy( &version, packed_instance + sizeof(uint32_t), sizeof(uint32_t) );
+
+	if( id == DL_INSTANCE_ID )
+		*endian = DL_ENDIAN_HOST;
+	else if( id == DL_INSTANCE_ID_SWAPED )
 	{
-		out_info->load_size = header->instance_size;
-		out_info->endian    = DL_ENDIAN_HOST;
-		out_info->root_type = header->root_instance_type ;
+		*endian = dl_other_endian( DL_ENDIAN_HOST );
+		version = dl_swap_endian_uint32( version );
 	}
 	else
+		return DL_ERROR_MALFORMED_DATA;
+
+	bool swap = *endian != DL_ENDIAN_HOST;
+	switch( version )
 	{
-		out_info->load_size = dl_swap_endian_uint32( header->instance_size );
-		out_info->endian    = dl_other_endian( DL_ENDIAN_HOST );
-		out_info->root_type = dl_swap_endian_uint32( header->root_instance_type );
+		case DL_INSTANCE_VERSION:
+			if( packed_instance_size < sizeof(dl_data_header) )
+				return DL_ERROR_MALFORMED_DATA;
+			memcpy( header, packed_instance, sizeof(dl_data_header) );
+			if( swap )
+				header->instance_size = dl_swap_endian_uint64( header->instance_size );
+			*header_size = sizeof(dl_data_header);
+			break;
+		case DL_INSTANCE_VERSION_1:
+		{
+			dl_data_header_v1 header_v1;
+			memcpy( &header_v1, packed_instance, sizeof(dl_data_header_v1) );
+			header->root_instance_type = header_v1.root_instance_type;
+			header->is_64_bit_ptr      = header_v1.is_64_bit_ptr;
+			header->is_relative_ptr    = 0;
+			header->pad[0]             = 0;
+			header->pad[1]             = 0;
+			header->instance_size      = swap ? dl_swap_endian_uint32( header_v1.instance_size ) : header_v1.instance_size;
+			*header_size = sizeof(dl_data_header_v1);
+		}
+		break;
+		default:
+			return DL_ERROR_VERSION_MISMATCH;
 	}
 
+	header->id      = DL_INSTANCE_ID;
+	header->version = version;
+	if( swap )
+		header->root_instance_type = dl_swap_endian_uint32( header->root_instance_type );
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_instance_get_info( const unsigned char* packed_instance, size_t packed_instance_size, dl_instance_info_t* out_info )
+{
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	out_info->load_size = (size_t)header.instance_size;
+	out_info->ptrsize   = header.is_64_bit_ptr ? 8 : 4;
+	out_info->endian    = endian;
+	out_info->root_type = header.root_instance_type;
+	out_info->relative  = header.is_relative_ptr;
+	out_info->version   = header.version;
+
 	return DL_ERROR_OK;
 }
@@ -45,6 +45,8 @@ inline void* dl_realloc( dl_allocator* alloc, void* ptr, size_t size, size_t old
 		return alloc->realloc( ptr, size, old_size, alloc->ctx );
 
 	void* new_ptr = dl_alloc( alloc, size );
+	if( new_ptr == 0x0 )
+		return 0x0;
 	if( ptr != 0x0 )
 	{
 		memcpy( new_ptr, ptr, old_size );
@@ -53,5 +55,20 @@ inline void* dl_realloc( dl_allocator* alloc, void* ptr, size_t size, size_t old
 	return new_ptr;
 }
 
+/**
+ * dl_grow_func growing buffers on the dl_allocator passed as grow_ctx.
+ */
+inline void* dl_allocator_grow( void* ptr, size_t size, size_t old_size, void* grow_ctx )
+{
+	dl_allocator* alloc = (dl_allocator*)grow_ctx;
+	if( size == 0 )
+	{
+		if( ptr != 0x0 )
+			dl_free( alloc, ptr );
+		return 0x0;
+	}
+	return dl_realloc( alloc, ptr, size, old_size );
+}
+
 #endif // DL_ALLOC_H_INCLUDED
 
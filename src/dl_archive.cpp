@@ -0,0 +1,364 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <dl/dl_archive.h>
+#include "dl_types.h"
+#include "dl_binary_writer.h"
+#include "dl_index_map.h"
+#include "dl_hash.h"
+
+#include "container/dl_array.h"
+
+static const uint32_t DL_ARCHIVE_ID         = ('D'<< 24) | ('L' << 16) | ('A' << 8) | 'R';
+static const uint32_t DL_ARCHIVE_ID_SWAPED  = dl_swap_endian_uint32( DL_ARCHIVE_ID );
+static const uint32_t DL_ARCHIVE_VERSION    = 1;
+static const uint32_t DL_ARCHIVE_EMPTY_SLOT = 0xFFFFFFFF;
+
+/**
+ * Layout of an archive, all parts are stored in the endianness of the instances in the archive:
+ *
+ *   dl_archive_header
+ *   dl_archive_index_entry[entry_count], in the order they were added.
+ *   uint32_t[slot_count], open-addressed hash-table from key-hash to index of entry, DL_ARCHIVE_EMPTY_SLOT if unused.
+ *   all keys, zero-terminated.
+ *   all packed instances, placed so that the instance after its dl_data_header is aligned as requested.
+ */
+struct dl_archive_header
+{
+	uint32_t id;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t slot_count;
+};
+
+struct dl_archive_index_entry
+{
+	uint64_t offset;     ///< offset of packed instance from start of archive.
+	uint64_t size;       ///< size of packed instance.
+	uint64_t key_offset; ///< offset of zero-terminated key from start of archive.
+	uint32_t key_hash;
+	uint32_t key_len;    ///< length of key, excluding '\0'.
+};
+
+struct dl_archive_writer_entry
+{
+	size_t   data_offset; ///< offset of packed instance in dl_archive_writer::data.
+	size_t   size;
+	size_t   key_offset;  ///< offset of key in dl_archive_writer::keys.
+	uint32_t key_hash;
+	uint32_t key_len;
+	size_t   alignment;
+};
+
+struct dl_archive_writer
+{
+	dl_ctx_t                                ctx;
+	CArrayDynamic<dl_archive_writer_entry> entries;
+	dl_binary_writer                        keys;
+	dl_binary_writer                        data;
+	dl_index_map                            lookup; ///< key-hash -> index in entries, used to find duplicate keys.
+	dl_endian_t                             endian;
+
+	explicit dl_archive_writer( dl_ctx_t dl_ctx )
+		: ctx( dl_ctx )
+		, entries( &dl_ctx->alloc )
+		, endian( DL_ENDIAN_HOST )
+	{
+		dl_binary_writer_init_grow( &keys, dl_allocator_grow, &dl_ctx->alloc, 0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+		dl_binary_writer_init_grow( &data, dl_allocator_grow, &dl_ctx->alloc, 0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+		memset( &lookup, 0x0, sizeof( lookup ) );
+	}
+
+	~dl_archive_writer()
+	{
+		dl_binary_writer_free( &keys );
+		dl_binary_writer_free( &data );
+		dl_index_map_free( &ctx->alloc, &lookup );
+	}
+};
+
+static uint32_t dl_archive_hash_key( const char* key, size_t key_len )
+{
+	return dl_internal_hash_buffer( (const uint8_t*)key, key_len );
+}
+
+static uint32_t dl_archive_slot_count( uint32_t entry_count )
+{
+	// ... same load-factor as dl_index_map, at most 50% ...
+	uint32_t slot_count = 16;
+	while( slot_count < entry_count * 2 )
+		slot_count *= 2;
+	return slot_count;
+}
+
+dl_error_t dl_archive_writer_create( dl_ctx_t dl_ctx, dl_archive_writer_t* out_writer )
+{
+	void* mem = dl_alloc( &dl_ctx->alloc, sizeof( dl_archive_writer ) );
+	if( mem == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	*out_writer = new ( mem ) dl_archive_writer( dl_ctx );
+	return DL_ERROR_OK;
+}
+
+void dl_archive_writer_destroy( dl_archive_writer_t writer )
+{
+	if( writer == 0x0 )
+		return;
+	dl_ctx_t ctx = writer->ctx;
+	writer->~dl_archive_writer();
+	dl_free( &ctx->alloc, writer );
+}
+
+static const char* dl_archive_writer_key( dl_archive_writer_t writer, const dl_archive_writer_entry* entry )
+{
+	return (const char*)writer->keys.data + entry->key_offset;
+}
+
+dl_error_t dl_archive_writer_add( dl_archive_writer_t  writer,
+								  const char*          key,
+								  const unsigned char* packed_instance,
+								  size_t               packed_instance_size,
+								  size_t               alignment )
+{
+	if( alignment == 0 )
+		alignment = 8;
+	if( ( alignment & ( alignment - 1 ) ) != 0 )
+		return DL_ERROR_INVALID_PARAMETER;
+
+	dl_instance_info_t info;
+	dl_error_t err = dl_instance_get_info( packed_instance, packed_instance_size, &info );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( writer->entries.Len() == 0 )
+		writer->endian = info.endian;
+	else if( info.endian != writer->endian )
+		return DL_ERROR_ENDIAN_MISMATCH;
+
+	size_t   key_len  = strlen( key );
+	uint32_t key_hash = dl_archive_hash_key( key, key_len );
+
+	uint32_t iter = 0;
+	uint32_t entry_index;
+	while( ( entry_index = dl_index_map_find_next( &writer->lookup, key_hash, &iter ) ) != DL_INDEX_MAP_EMPTY )
+		if( strcmp( dl_archive_writer_key( writer, &writer->entries[entry_index] ), key ) == 0 )
+			return DL_ERROR_ARCHIVE_DUPLICATE_KEY;
+
+	dl_archive_writer_entry entry;
+	entry.data_offset = dl_binary_writer_tell( &writer->data );
+	entry.size        = packed_instance_size;
+	entry.key_offset  = dl_binary_writer_tell( &writer->keys );
+	entry.key_hash    = key_hash;
+	entry.key_len     = (uint32_t)key_len;
+	entry.alignment   = alignment;
+
+	dl_binary_writer_write_string( &writer->keys, key, key_len );
+	dl_binary_writer_write( &writer->data, packed_instance, packed_instance_size );
+	if( writer->keys.out_of_memory || writer->data.out_of_memory )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	err = dl_index_map_insert( &writer->ctx->alloc, &writer->lookup, key_hash, (uint32_t)writer->entries.Len() );
+	if( err != DL_ERROR_OK )
+		return err;
+	if( !writer->entries.Add( entry ) )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	return DL_ERROR_OK;
+}
+
+/**
+ * Offset to place a packed instance at, at or after pos, so that the instance after its header is aligned.
+ */
+static size_t dl_archive_instance_offset( size_t pos, size_t alignment )
+{
+	return dl_internal_align_up( pos + sizeof( dl_data_header ), alignment ) - sizeof( dl_data_header );
+}
+
+static uint32_t dl_archive_swap32( uint32_t v, dl_endian_t endian ) { return endian == DL_ENDIAN_HOST ? v : dl_swap_endian_uint32( v ); }
+static uint64_t dl_archive_swap64( uint64_t v, dl_endian_t endian ) { return endian == DL_ENDIAN_HOST ? v : dl_swap_endian_uint64( v ); }
+
+/**
+ * Write size zero-bytes to write_func.
+ */
+static dl_error_t dl_archive_write_zero( dl_write_func write_func, void* write_ctx, size_t size )
+{
+	static const uint8_t zero[64] = { 0 };
+	while( size > 0 )
+	{
+		size_t chunk = size < sizeof( zero ) ? size : sizeof( zero );
+		dl_error_t err = write_func( zero, chunk, write_ctx );
+		if( err != DL_ERROR_OK )
+			return err;
+		size -= chunk;
+	}
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_archive_writer_finish( dl_archive_writer_t writer,
+									 dl_write_func       write_func,
+									 void*               write_ctx,
+									 size_t*             produced_bytes )
+{
+	dl_allocator* alloc       = &writer->ctx->alloc;
+	dl_endian_t   endian      = writer->endian;
+	uint32_t      entry_count = (uint32_t)writer->entries.Len();
+	uint32_t      slot_count  = dl_archive_slot_count( entry_count );
+
+	size_t index_size = sizeof( dl_archive_header ) + sizeof( dl_archive_index_entry ) * entry_count + sizeof( uint32_t ) * slot_count;
+	size_t keys_size  = dl_binary_writer_needed_size( &writer->keys );
+
+	// ... build the whole index in memory, it is small compared to the instances that are written straight from the writer ...
+	uint8_t* index = (uint8_t*)dl_alloc( alloc, index_size );
+	if( index == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	dl_archive_header*      header  = (dl_archive_header*)index;
+	dl_archive_index_entry* entries = (dl_archive_index_entry*)( header + 1 );
+	uint32_t*               slots   = (uint32_t*)( entries + entry_count );
+
+	header->id          = dl_archive_swap32( DL_ARCHIVE_ID, endian );
+	header->version     = dl_archive_swap32( DL_ARCHIVE_VERSION, endian );
+	header->entry_count = dl_archive_swap32( entry_count, endian );
+	header->slot_count  = dl_archive_swap32( slot_count, endian );
+	memset( slots, 0xFF, sizeof( uint32_t ) * slot_count );
+
+	size_t pos = index_size + keys_size;
+	for( uint32_t i = 0; i < entry_count; ++i )
+	{
+		const dl_archive_writer_entry* src = &writer->entries[i];
+		pos = dl_archive_instance_offset( pos, src->alignment );
+
+		entries[i].offset     = dl_archive_swap64( pos, endian );
+		entries[i].size       = dl_archive_swap64( src->size, endian );
+		entries[i].key_offset = dl_archive_swap64( index_size + src->key_offset, endian );
+		entries[i].key_hash   = dl_archive_swap32( src->key_hash, endian );
+		entries[i].key_len    = dl_archive_swap32( src->key_len, endian );
+		pos += src->size;
+
+		uint32_t slot = dl_index_map_slot( src->key_hash, slot_count );
+		while( slots[slot] != DL_ARCHIVE_EMPTY_SLOT )
+			slot = ( slot + 1 ) & ( slot_count - 1 );
+		slots[slot] = dl_archive_swap32( i, endian );
+	}
+
+	dl_error_t err = write_func( index, index_size, write_ctx );
+	if( err == DL_ERROR_OK && keys_size > 0 )
+		err = write_func( writer->keys.data, keys_size, write_ctx );
+
+	pos = index_size + keys_size;
+	for( uint32_t i = 0; i < entry_count && err == DL_ERROR_OK; ++i )
+	{
+		const dl_archive_writer_entry* src = &writer->entries[i];
+		size_t offset = dl_archive_instance_offset( pos, src->alignment );
+		err = dl_archive_write_zero( write_func, write_ctx, offset - pos );
+		if( err == DL_ERROR_OK )
+			err = write_func( writer->data.data + src->data_offset, src->size, write_ctx );
+		pos = offset + src->size;
+	}
+
+	dl_free( alloc, index );
+
+	if( err == DL_ERROR_OK && produced_bytes )
+		*produced_bytes = pos;
+	return err;
+}
+
+/**
+ * Validate the header of archive and that the index fit in it.
+ */
+static dl_error_t dl_archive_read_header( const unsigned char* archive, size_t archive_size, const dl_archive_header** out_header )
+{
+	if( !dl_internal_is_align( archive, 8 ) )          return DL_ERROR_BAD_ALIGNMENT;
+	if( archive_size < sizeof( dl_archive_header ) ) return DL_ERROR_MALFORMED_DATA;
+
+	const dl_archive_header* header = (const dl_archive_header*)archive;
+	if( header->id == DL_ARCHIVE_ID_SWAPED )     return DL_ERROR_ENDIAN_MISMATCH;
+	if( header->id != DL_ARCHIVE_ID )            return DL_ERROR_MALFORMED_DATA;
+	if( header->version != DL_ARCHIVE_VERSION )  return DL_ERROR_VERSION_MISMATCH;
+	if( header->slot_count == 0 || ( header->slot_count & ( header->slot_count - 1 ) ) != 0 )
+		return DL_ERROR_MALFORMED_DATA;
+
+	size_t index_size = sizeof( dl_archive_header ) + sizeof( dl_archive_index_entry ) * header->entry_count + sizeof( uint32_t ) * header->slot_count;
+	if( index_size > archive_size )
+		return DL_ERROR_MALFORMED_DATA;
+
+	*out_header = header;
+	return DL_ERROR_OK;
+}
+
+static dl_error_t dl_archive_read_entry( const unsigned char* archive, size_t archive_size, const dl_archive_index_entry* entries, uint32_t entry_index, dl_archive_entry_t* out_entry )
+{
+	const dl_archive_index_entry* entry = &entries[entry_index];
+	if( entry->key_offset + entry->key_len >= archive_size || entry->offset + entry->size > archive_size || entry->offset + entry->size < entry->offset )
+		return DL_ERROR_MALFORMED_DATA;
+
+	out_entry->key    = (const char*)archive + entry->key_offset;
+	out_entry->index  = entry_index;
+	out_entry->offset = (size_t)entry->offset;
+	out_entry->size   = (size_t)entry->size;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_archive_entry_count( const unsigned char* archive, size_t archive_size, unsigned int* out_entry_count )
+{
+	const dl_archive_header* header;
+	dl_error_t err = dl_archive_read_header( archive, archive_size, &header );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	*out_entry_count = header->entry_count;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_archive_get_entry( const unsigned char* archive,
+								 size_t               archive_size,
+								 unsigned int         entry_index,
+								 dl_archive_entry_t*  out_entry )
+{
+	const dl_archive_header* header;
+	dl_error_t err = dl_archive_read_header( archive, archive_size, &header );
+	if( err != DL_ERROR_OK )
+		return err;
+	if( entry_index >= header->entry_count )
+		return DL_ERROR_INVALID_PARAMETER;
+
+	const dl_archive_index_entry* entries = (const dl_archive_index_entry*)( header + 1 );
+	return dl_archive_read_entry( archive, archive_size, entries, entry_index, out_entry );
+}
+
+dl_error_t dl_archive_find( const unsigned char* archive,
+							size_t               archive_size,
+							const char*          key,
+							dl_archive_entry_t*  out_entry )
+{
+	const dl_archive_header* header;
+	dl_error_t err = dl_archive_read_header( archive, archive_size, &header );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	const dl_archive_index_entry* entries = (const dl_archive_index_entry*)( header + 1 );
+	const uint32_t*               slots   = (const uint32_t*)( entries + header->entry_count );
+
+	size_t   key_len  = strlen( key );
+	uint32_t key_hash = dl_archive_hash_key( key, key_len );
+	uint32_t mask     = header->slot_count - 1;
+
+	// ... the table is never full, so an empty slot is always found if the key is not in it ...
+	for( uint32_t slot = dl_index_map_slot( key_hash, header->slot_count ), probes = 0; probes < header->slot_count; slot = ( slot + 1 ) & mask, ++probes )
+	{
+		uint32_t entry_index = slots[slot];
+		if( entry_index == DL_ARCHIVE_EMPTY_SLOT )
+			break;
+		if( entry_index >= header->entry_count )
+			return DL_ERROR_MALFORMED_DATA;
+
+		const dl_archive_index_entry* entry = &entries[entry_index];
+		if( entry->key_hash != key_hash || entry->key_len != key_len )
+			continue;
+
+		err = dl_archive_read_entry( archive, archive_size, entries, entry_index, out_entry );
+		if( err != DL_ERROR_OK )
+			return err;
+		if( memcmp( out_entry->key, key, key_len ) == 0 )
+			return DL_ERROR_OK;
+	}
+	return DL_ERROR_ARCHIVE_KEY_NOT_FOUND;
+}
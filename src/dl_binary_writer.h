@@ -22,6 +22,12 @@ struct dl_binary_writer
 	size_t        needed_size;
 	uint8_t*      data;
 	size_t        data_size;
+
+	// ... if grow_func is set data is grown on demand, the allocation starts grow_head bytes before data ...
+	dl_grow_func  grow_func;
+	void*         grow_ctx;
+	size_t        grow_head;
+	bool          out_of_memory;
 };
 
 static inline void dl_binary_writer_init( dl_binary_writer* writer,
@@ -37,6 +43,86 @@ static inline void dl_binary_writer_init( dl_binary_writer* writer,
 	writer->needed_size    = 0;
 	writer->data           = out_data;
 	writer->data_size      = out_data_size;
+	writer->grow_func      = 0x0;
+	writer->grow_ctx       = 0x0;
+	writer->grow_head      = 0;
+	writer->out_of_memory  = false;
+}
+
+/**
+ * Initialize a writer that writes in a single pass to a buffer that is grown through grow_func as needed. head_size
+ * bytes are allocated in front of the written data for the user to fill in when done, i.e. a header.
+ * Memory grown into is zeroed.
+ *
+ * If growing fails writer->out_of_memory is set and the writer continues as a dummy-writer.
+ */
+static inline void dl_binary_writer_init_grow( dl_binary_writer* writer,
+											   dl_grow_func grow_func, void* grow_ctx, size_t head_size,
+											   dl_endian_t source_endian, dl_endian_t target_endian,
+											   dl_ptr_size_t target_ptr_size )
+{
+	dl_binary_writer_init( writer, 0x0, 0, false, source_endian, target_endian, target_ptr_size );
+	writer->grow_func = grow_func;
+	writer->grow_ctx  = grow_ctx;
+	writer->grow_head = head_size;
+}
+
+static inline void dl_binary_writer_grow( dl_binary_writer* writer, size_t min_size )
+{
+	if( writer->out_of_memory )
+		return;
+
+	size_t new_size = writer->data_size * 2;
+	if( new_size < min_size ) new_size = min_size;
+	if( new_size < 256 )      new_size = 256;
+
+	uint8_t* old_alloc = writer->data == 0x0 ? 0x0 : writer->data - writer->grow_head;
+	size_t   old_size  = writer->data == 0x0 ? 0   : writer->data_size + writer->grow_head;
+	uint8_t* new_alloc = (uint8_t*)writer->grow_func( old_alloc, new_size + writer->grow_head, old_size, writer->grow_ctx );
+	if( new_alloc == 0x0 )
+	{
+		writer->out_of_memory = true;
+		writer->dummy = true;
+		return;
+	}
+
+	if( old_alloc == 0x0 )
+		memset( new_alloc, 0x0, writer->grow_head );
+	memset( new_alloc + writer->grow_head + writer->data_size, 0x0, new_size - writer->data_size );
+	writer->data      = new_alloc + writer->grow_head;
+	writer->data_size = new_size;
+}
+
+/**
+ * Make sure that there is room for size bytes in a growing writer, no-op for all other writers.
+ */
+static inline void dl_binary_writer_ensure( dl_binary_writer* writer, size_t size )
+{
+	if( size > writer->data_size && writer->grow_func != 0x0 )
+		dl_binary_writer_grow( writer, size );
+}
+
+/**
+ * Return start of the allocation made by a growing writer, including head. Ownership of the buffer is passed to the
+ * caller.
+ */
+static inline uint8_t* dl_binary_writer_release( dl_binary_writer* writer )
+{
+	uint8_t* alloc = writer->data == 0x0 ? 0x0 : writer->data - writer->grow_head;
+	writer->data      = 0x0;
+	writer->data_size = 0;
+	return alloc;
+}
+
+/**
+ * Free the allocation made by a growing writer, if any.
+ */
+static inline void dl_binary_writer_free( dl_binary_writer* writer )
+{
+	size_t   size  = writer->data_size + writer->grow_head;
+	uint8_t* alloc = dl_binary_writer_release( writer );
+	if( alloc != 0x0 )
+		writer->grow_func( alloc, 0, size, writer->grow_ctx );
 }
 
 static inline void   dl_binary_writer_seek_set( dl_binary_writer* writer, size_t pos ) { writer->pos  = pos;                 DL_LOG_BIN_WRITER_VERBOSE("Seek Set: " DL_PINT_FMT_STR, writer->pos); }
@@ -51,6 +137,7 @@ static inline void dl_binary_writer_update_needed_size( dl_binary_writer* writer
 
 static inline void dl_binary_writer_write( dl_binary_writer* writer, const void* data, size_t size )
 {
+	dl_binary_writer_ensure( writer, writer->pos + size );
 	if( !writer->dummy && ( writer->pos + size <= writer->data_size ) )
 	{
 		switch( size )
@@ -153,21 +240,18 @@ static inline void dl_binary_writer_write_array( dl_binary_writer* writer, const
 		}
 	}
 
-	if( writer->source_endian != writer->target_endian )
+	if( writer->source_endian != writer->target_endian && elem_size > 1 )
 	{
-		for(size_t i = 0; i < count; ++i)
-		{
-			switch( elem_size )
-			{
-				case 1: dl_binary_writer_write_1byte( writer, (const uint8_t*)array + i * elem_size ); break;
-				case 2: dl_binary_writer_write_2byte( writer, (const uint8_t*)array + i * elem_size ); break;
-				case 4: dl_binary_writer_write_4byte( writer, (const uint8_t*)array + i * elem_size ); break;
-				case 8: dl_binary_writer_write_8byte( writer, (const uint8_t*)array + i * elem_size ); break;
-				default:
-					DL_ASSERT( false && "unhandled case!" );
-					break;
-			}
-		}
+		DL_ASSERT( ( elem_size == 2 || elem_size == 4 || elem_size == 8 ) && "unhandled case!" );
+
+		// ... swap the whole array straight into the out-buffer, writes that do not fit are skipped as in write() ...
+		size_t size = elem_size * count;
+		dl_binary_writer_ensure( writer, writer->pos + size );
+		if( !writer->dummy && ( writer->pos + size <= writer->data_size ) )
+			dl_swap_endian_array( writer->data + writer->pos, array, count, elem_size );
+
+		writer->pos += size;
+		dl_binary_writer_update_needed_size( writer );
 	}
 	else
 		dl_binary_writer_write( writer, array, elem_size * count );
@@ -200,6 +284,25 @@ static inline void dl_binary_writer_write_ptr( dl_binary_writer* writer, size_t
 	}
 }
 
+// write self-relative ref, val is expected to be in host-endian and is sign-extended to 64 bit ptr-size.
+static inline void dl_binary_writer_write_ref( dl_binary_writer* writer, int64_t val )
+{
+	if( writer->ptr_size == DL_PTR_SIZE_64BIT )
+	{
+		uint64_t u = (uint64_t)val;
+		if( writer->target_endian != DL_ENDIAN_HOST )
+			u = dl_swap_endian_uint64( u );
+		dl_binary_writer_write( writer, &u, 8 );
+	}
+	else
+	{
+		uint32_t u = (uint32_t)val;
+		if( writer->target_endian != DL_ENDIAN_HOST )
+			u = dl_swap_endian_uint32( u );
+		dl_binary_writer_write( writer, &u, 4 );
+	}
+}
+
 static inline void dl_binary_writer_write_string( dl_binary_writer* writer, const void* str, size_t len )
 {
 	char str_end = '\0';
@@ -210,10 +313,10 @@ static inline void dl_binary_writer_write_string( dl_binary_writer* writer, cons
 
 static inline void dl_binary_writer_write_zero( dl_binary_writer* writer, size_t bytes )
 {
-	if( !writer->dummy )
+	dl_binary_writer_ensure( writer, writer->pos + bytes );
+	if( !writer->dummy && ( writer->pos + bytes <= writer->data_size ) )
 	{
 		DL_LOG_BIN_WRITER_VERBOSE("Write zero: " DL_PINT_FMT_STR " + " DL_PINT_FMT_STR, writer->pos, bytes);
-		DL_ASSERT( writer->pos + bytes <= writer->data_size && "To small buffer!" );
 		memset( writer->data + writer->pos, 0x0, bytes );
 	}
 
@@ -224,6 +327,7 @@ static inline void dl_binary_writer_write_zero( dl_binary_writer* writer, size_t
 static inline void dl_binary_writer_reserve( dl_binary_writer* writer, size_t bytes )
 {
 	DL_LOG_BIN_WRITER_VERBOSE( "Reserve: " DL_PINT_FMT_STR " + " DL_PINT_FMT_STR, writer->pos, bytes );
+	dl_binary_writer_ensure( writer, writer->pos + bytes );
 	writer->needed_size = writer->needed_size >= writer->pos + bytes ? writer->needed_size : writer->pos + bytes;
 }
 
@@ -235,7 +339,8 @@ static inline uint64_t dl_binary_writer_read_uint64( dl_binary_writer* writer )
 static inline void dl_binary_writer_align( dl_binary_writer* writer, size_t align )
 {
 	size_t alignment = dl_internal_align_up( writer->pos, align );
-	if( !writer->dummy && alignment != writer->pos )
+	dl_binary_writer_ensure( writer, alignment );
+	if( !writer->dummy && alignment != writer->pos && alignment <= writer->data_size )
 	{
 		DL_LOG_BIN_WRITER_VERBOSE( "Align: " DL_PINT_FMT_STR " + " DL_PINT_FMT_STR " (" DL_PINT_FMT_STR ")", writer->pos, alignment - writer->pos, align );
 		memset( writer->data + writer->pos, 0x0, alignment - writer->pos);
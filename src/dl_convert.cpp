@@ -2,6 +2,9 @@
 
 #include "dl_types.h"
 #include "dl_binary_writer.h"
+#include "dl_convert_plan.h"
+#include "dl_ptr_map.h"
+#include "dl_stats.h"
 #include "container/dl_array.h"
 
 #include <dl/dl.h>
@@ -15,13 +18,15 @@ struct SInstance
 		, offset_after_patch(0)
 		, type(0x0)
 		, type_id(DL_TYPE_ATOM_MIN_BIT)
+		, plan(DL_CONVERT_PLAN_NONE)
 		{}
-	SInstance( const uint8_t* address, const dl_type_desc* type, size_t array_count, dl_type_t tid )
+	SInstance( const uint8_t* address, const dl_type_desc* type, size_t array_count, dl_type_t tid, uint32_t plan )
 		: address(address)
 		, array_count(array_count)
 		, offset_after_patch(0)
 		, type(type)
 		, type_id(tid)
+		, plan(plan)
 		{ }
 
 	const uint8_t*      address;
@@ -29,32 +34,69 @@ struct SInstance
 	uintptr_t           offset_after_patch;
 	const dl_type_desc* type;
 	dl_type_t           type_id;
+	uint32_t            plan; ///< conversion-plan for type, DL_CONVERT_PLAN_NONE for instances not of struct-type.
+};
+
+/**
+ * What refs are written as when converting.
+ */
+enum dl_convert_out_refs
+{
+	DL_CONVERT_OUT_REFS_OFFSET,   ///< offsets from the start of the instance, the regular packed format.
+	DL_CONVERT_OUT_REFS_RELATIVE, ///< offsets from the ref itself, see dl_convert_to_relative.
+	DL_CONVERT_OUT_REFS_LOADED    ///< host pointers to the written data, i.e. a loaded instance.
 };
 
 class SConvertContext
 {
 public:
-	SConvertContext( dl_endian_t src_endian, dl_endian_t tgt_endian, dl_ptr_size_t src_ptr_size, dl_ptr_size_t tgt_ptr_size )
+	SConvertContext( dl_endian_t src_endian, dl_endian_t tgt_endian, dl_ptr_size_t src_ptr_size, dl_ptr_size_t tgt_ptr_size, dl_convert_out_refs out_refs, dl_allocator* alloc )
 		: src_endian(src_endian)
 		, tgt_endian(tgt_endian)
 		, src_ptr_size(src_ptr_size)
 		, target_ptr_size(tgt_ptr_size)
-	{}
+		, out_refs(out_refs)
+		, instances(alloc)
+		, m_lPatchOffset(alloc)
+		, err(DL_ERROR_OK)
+	{
+		dl_ptr_map_init( &swapped_ptrs, alloc );
+	}
+
+	~SConvertContext()
+	{
+		dl_ptr_map_free( &swapped_ptrs );
+	}
 
 	bool IsSwapped( const uint8_t* ptr )
 	{
-		for(unsigned int i = 0; i < instances.Len(); ++i)
-			if(ptr == instances[i].address)
-				return true;
-		return false;
+		return dl_ptr_map_find( &swapped_ptrs, (uintptr_t)ptr ) != DL_PTR_MAP_EMPTY;
+	}
+
+	void AddInstance( const SInstance& inst )
+	{
+		if( !instances.Add( inst ) )
+			err = DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+
+	void AddPtrInstance( const SInstance& inst )
+	{
+		AddInstance( inst );
+		dl_error_t add_err = dl_ptr_map_insert( &swapped_ptrs, (uintptr_t)inst.address, 0 );
+		if( add_err != DL_ERROR_OK )
+			err = add_err;
 	}
 
 	dl_endian_t src_endian;
 	dl_endian_t tgt_endian;
 	dl_ptr_size_t src_ptr_size;
 	dl_ptr_size_t target_ptr_size;
+	dl_convert_out_refs out_refs;
 
-	CArrayStatic<SInstance, 128> instances;
+	CArrayDynamic<SInstance> instances;
+
+	/// set of all instances pointed to by ptr-members, collected in instances.
+	dl_ptr_map swapped_ptrs;
 
 	struct PatchPos
 	{
@@ -67,7 +109,10 @@ public:
 		uintptr_t old_offset;
 	};
 
-	CArrayStatic<PatchPos, 256> m_lPatchOffset;
+	CArrayDynamic<PatchPos> m_lPatchOffset;
+
+	/// first error that could not be returned directly while converting.
+	dl_error_t err;
 };
 
 static inline void dl_swap_header( dl_data_header* header )
@@ -75,7 +120,7 @@ static inline void dl_swap_header( dl_data_header* header )
 	header->id                 = dl_swap_endian_uint32( header->id );
 	header->version            = dl_swap_endian_uint32( header->version );
 	header->root_instance_type = dl_swap_endian_uint32( header->root_instance_type );
-	header->instance_size      = dl_swap_endian_uint32( header->instance_size );
+	header->instance_size      = dl_swap_endian_uint64( header->instance_size );
 }
 
 static uintptr_t dl_internal_read_ptr_data( const uint8_t* data,
@@ -165,11 +210,11 @@ static void dl_internal_read_array_data( const uint8_t* array_data,
 	}
 }
 
-static dl_error_t dl_internal_convert_collect_instances( dl_ctx_t            dl_ctx,
-														 const dl_type_desc* type,
-														 const uint8_t*      instance,
-														 const uint8_t*      base_data,
-														 SConvertContext&    convert_ctx );
+static void dl_internal_convert_collect_plan( dl_ctx_t         dl_ctx,
+											  uint32_t         plan,
+											  const uint8_t*   instance,
+											  const uint8_t*   base_data,
+											  SConvertContext& convert_ctx );
 
 static void dl_internal_convert_collect_instances_from_str( const uint8_t*        member_data,
 																  const uint8_t*        base_data,
@@ -177,11 +222,11 @@ static void dl_internal_convert_collect_instances_from_str( const uint8_t*
 {
 	uintptr_t offset = dl_internal_read_ptr_data( member_data, convert_ctx.src_endian, convert_ctx.src_ptr_size );
 	if(offset != DL_NULL_PTR_OFFSET[convert_ctx.src_ptr_size])
-		convert_ctx.instances.Add(SInstance(base_data + offset, 0x0, 1337, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STR)));
+		convert_ctx.AddInstance(SInstance(base_data + offset, 0x0, 1337, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STR), DL_CONVERT_PLAN_NONE));
 }
 
 static void dl_internal_convert_collect_instances_from_ptr( dl_ctx_t              ctx,
-															const dl_type_desc*   sub_type,
+															uint32_t              plan,
 															const uint8_t*        member_data,
 															const uint8_t*        base_data,
 															SConvertContext&      convert_ctx )
@@ -192,466 +237,333 @@ static void dl_internal_convert_collect_instances_from_ptr( dl_ctx_t
 
 	if(offset != DL_NULL_PTR_OFFSET[convert_ctx.src_ptr_size] && !convert_ctx.IsSwapped(ptr_data))
 	{
-		convert_ctx.instances.Add(SInstance(ptr_data, sub_type, 0, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_PTR)));
-		dl_internal_convert_collect_instances(ctx, sub_type, base_data + offset, base_data, convert_ctx);
+		const dl_type_desc* sub_type = ctx->type_descs + ctx->convert_ops[plan].type_index;
+		convert_ctx.AddPtrInstance(SInstance(ptr_data, sub_type, 0, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_PTR), plan));
+		dl_internal_convert_collect_plan(ctx, plan, ptr_data, base_data, convert_ctx);
 	}
 }
 
-static void dl_internal_convert_collect_instances_from_struct_array( dl_ctx_t            ctx,
-																	 const uint8_t*      array_data,
-																	 uintptr_t           array_count,
-																	 const dl_type_desc* sub_type,
-																	 const uint8_t*      base_data,
-																	 SConvertContext&    convert_ctx )
+static void dl_internal_convert_collect_instances_from_array( dl_ctx_t             ctx,
+															  const dl_convert_op* op,
+															  const uint8_t*       member_data,
+															  const uint8_t*       base_data,
+															  SConvertContext&     convert_ctx )
 {
-	uint32_t elem_size = sub_type->size[convert_ctx.src_ptr_size];
-	for( uint32_t elem = 0; elem < array_count; ++elem )
-		dl_internal_convert_collect_instances(ctx, sub_type, array_data + (elem * elem_size), base_data, convert_ctx);
-}
+	uintptr_t offset = 0; uint32_t array_count = 0;
+	dl_internal_read_array_data( member_data, &offset, &array_count, convert_ctx.src_endian, convert_ctx.src_ptr_size );
 
-static void dl_internal_convert_collect_instances_from_str_array( const uint8_t*   array_data,
-																  uintptr_t        array_count,
-																  const uint8_t*   base_data,
-																  SConvertContext& convert_ctx )
-{
-	// TODO: This might be optimized if we look at all the data in i inline-array of strings as 1 instance continuous in memory.
-	// I am not sure if that is true for all cases right now!
-
-	uint32_t ptr_size = (uint32_t)dl_internal_ptr_size(convert_ctx.src_ptr_size);
-
-	for( uintptr_t elem = 0; elem < array_count; ++elem )
-		dl_internal_convert_collect_instances_from_str( array_data + (elem * ptr_size), base_data, convert_ctx );
-}
+	if(offset == DL_NULL_PTR_OFFSET[convert_ctx.src_ptr_size])
+	{
+		DL_ASSERT( array_count == 0 );
+		return;
+	}
 
-static void dl_internal_convert_collect_instances_from_ptr_array( dl_ctx_t            ctx,
-																  const uint8_t*      array_data,
-																  uintptr_t           array_count,
-																  const dl_type_desc* sub_type,
-																  const uint8_t*      base_data,
-																  SConvertContext&    convert_ctx )
-{
-	uint32_t ptr_size = (uint32_t)dl_internal_ptr_size(convert_ctx.src_ptr_size);
-	for( uintptr_t elem = 0; elem < array_count; ++elem )
-		dl_internal_convert_collect_instances_from_ptr( ctx, sub_type, array_data + (elem * ptr_size), base_data, convert_ctx );
-}
+	const uint8_t* array_data = base_data + offset;
+	const dl_type_desc* sub_type = 0x0;
 
-static dl_error_t dl_internal_convert_collect_instances_from_member( dl_ctx_t              ctx,
-																	 const dl_member_desc* member,
-																	 const uint8_t*        member_data,
-																	 const uint8_t*        base_data,
-																	 SConvertContext&      convert_ctx )
-{
-	dl_type_t atom_type    = member->AtomType();
-	dl_type_t storage_type = member->StorageType();
-
-	switch(atom_type)
+	switch( op->type & DL_TYPE_STORAGE_MASK )
 	{
-		case DL_TYPE_ATOM_POD:
+		case DL_TYPE_STORAGE_STR:
 		{
-			switch( storage_type )
-			{
-				case DL_TYPE_STORAGE_STR:
-					dl_internal_convert_collect_instances_from_str( member_data, base_data, convert_ctx );
-				break;
-				case DL_TYPE_STORAGE_PTR:
-					dl_internal_convert_collect_instances_from_ptr( ctx, dl_internal_find_type(ctx, member->type_id), member_data, base_data, convert_ctx );
-				break;
-				case DL_TYPE_STORAGE_STRUCT:
-					dl_internal_convert_collect_instances(ctx, dl_internal_find_type(ctx, member->type_id), member_data, base_data, convert_ctx);
-				break;
-				default:
-					break;
-			}
+			// TODO: This might be optimized if we look at all the data in i inline-array of strings as 1 instance continuous in memory.
+			// I am not sure if that is true for all cases right now!
+			uint32_t ptr_size = (uint32_t)dl_internal_ptr_size(convert_ctx.src_ptr_size);
+			for( uintptr_t elem = 0; elem < array_count; ++elem )
+				dl_internal_convert_collect_instances_from_str( array_data + (elem * ptr_size), base_data, convert_ctx );
 		}
 		break;
-		case DL_TYPE_ATOM_INLINE_ARRAY:
+		case DL_TYPE_STORAGE_PTR:
 		{
-			switch(storage_type)
-			{
-				case DL_TYPE_STORAGE_STRUCT:
-					dl_internal_convert_collect_instances_from_struct_array( ctx,
-																			 member_data,
-																			 member->inline_array_cnt(),
-																			 dl_internal_find_type(ctx, member->type_id),
-																			 base_data,
-																			 convert_ctx );
-					break;
-				case DL_TYPE_STORAGE_STR:
-					dl_internal_convert_collect_instances_from_str_array( member_data,
-																		  member->inline_array_cnt(),
-																		  base_data,
-																		  convert_ctx );
-					break;
-				case DL_TYPE_STORAGE_PTR:
-					dl_internal_convert_collect_instances_from_ptr_array( ctx,
-																		  member_data,
-																		  member->inline_array_cnt(),
-																		  dl_internal_find_type(ctx, member->type_id),
-																		  base_data,
-																		  convert_ctx );
-					break;
-				default:
-					DL_ASSERT(member->IsSimplePod() || storage_type == DL_TYPE_STORAGE_ENUM);
-					// ignore
-			}
+			sub_type = ctx->type_descs + op->type_index;
+			uint32_t ptr_size = (uint32_t)dl_internal_ptr_size(convert_ctx.src_ptr_size);
+			for( uintptr_t elem = 0; elem < array_count; ++elem )
+				dl_internal_convert_collect_instances_from_ptr( ctx, op->plan, array_data + (elem * ptr_size), base_data, convert_ctx );
 		}
 		break;
-
-		case DL_TYPE_ATOM_ARRAY:
+		case DL_TYPE_STORAGE_STRUCT:
 		{
-			uintptr_t offset = 0; uint32_t array_count = 0;
-			dl_internal_read_array_data( member_data, &offset, &array_count, convert_ctx.src_endian, convert_ctx.src_ptr_size );
+			sub_type = ctx->type_descs + op->type_index;
 
-			if(offset == DL_NULL_PTR_OFFSET[convert_ctx.src_ptr_size])
-			{
-				DL_ASSERT( array_count == 0 );
+			// ... nothing to collect from elements without subdata ...
+			if( ( sub_type->flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
 				break;
-			}
-
-			const uint8_t* array_data = base_data + offset;
-			const dl_type_desc* sub_type = 0x0;
 
-			switch(storage_type)
-			{
-				case DL_TYPE_STORAGE_STR:
-					dl_internal_convert_collect_instances_from_str_array(array_data, array_count, base_data, convert_ctx);
-					break;
-				case DL_TYPE_STORAGE_PTR:
-					sub_type = dl_internal_find_type(ctx, member->type_id);
-					dl_internal_convert_collect_instances_from_ptr_array( ctx,
-																		  array_data,
-																		  array_count,
-																		  sub_type,
-																		  base_data,
-																		  convert_ctx );
-					break;
-				case DL_TYPE_STORAGE_STRUCT:
-				{
-					sub_type = dl_internal_find_type(ctx, member->type_id);
-					dl_internal_convert_collect_instances_from_struct_array( ctx,
-																			 array_data,
-																			 array_count,
-																			 sub_type,
-																			 base_data,
-																			 convert_ctx );
-				}
-				break;
-				default:
-					DL_ASSERT(member->IsSimplePod() || storage_type == DL_TYPE_STORAGE_ENUM);
-					break;
-			}
-
-			convert_ctx.instances.Add(SInstance(array_data, sub_type, array_count, member->type));
+			size_t elem_size = sub_type->size[convert_ctx.src_ptr_size];
+			for( uint32_t elem = 0; elem < array_count; ++elem )
+				dl_internal_convert_collect_plan( ctx, op->plan, array_data + (elem * elem_size), base_data, convert_ctx );
 		}
 		break;
-
-		case DL_TYPE_ATOM_BITFIELD:
-			// ignore
-			break;
-
 		default:
-			DL_ASSERT(false && "Invalid ATOM-type!");
 			break;
 	}
 
-	return DL_ERROR_OK;
+	convert_ctx.AddInstance(SInstance(array_data, sub_type, array_count, dl_type_t(op->type), op->plan));
 }
 
-static dl_error_t dl_internal_convert_collect_instances( dl_ctx_t            dl_ctx,
-														 const dl_type_desc* type,
-														 const uint8_t*      instance,
-														 const uint8_t*      base_data,
-														 SConvertContext&    convert_ctx )
+/**
+ * Find the DL_CONVERT_OP_CASE for the member stored in the union converted by the DL_CONVERT_OP_UNION at union_op.
+ *
+ * @return index of the case-op or DL_CONVERT_PLAN_NONE if the type-tag of the union is not valid.
+ */
+static uint32_t dl_internal_convert_find_case( dl_ctx_t ctx, uint32_t union_op, const uint8_t* instance, dl_ptr_size_t src_ptr_size )
 {
-	if( type->flags & DL_TYPE_FLAG_IS_UNION )
-	{
-		// TODO: extract to helper-function?
-		size_t max_member_size = dl_internal_largest_member_size( dl_ctx, type, convert_ctx.src_ptr_size );
+	const dl_convert_op* op = ctx->convert_ops + union_op;
+	size_t max_member_size = dl_internal_largest_member_size( ctx, ctx->type_descs + op->type_index, src_ptr_size );
 
-		// find member index from union type ...
-		uint32_t union_type = *((uint32_t*)(instance + max_member_size));
-		const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( dl_ctx, type, union_type );
-		const uint8_t* member_data = instance + member->offset[convert_ctx.src_ptr_size];
+	uint32_t union_type;
+	memcpy( &union_type, instance + op->src_offset + max_member_size, sizeof(uint32_t) );
 
-		return dl_internal_convert_collect_instances_from_member( dl_ctx, member, member_data, base_data, convert_ctx );
-	}
-	else
+	uint32_t case_op = union_op + 1;
+	for( uint32_t i = 0; i < op->count; ++i )
 	{
-		for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
-		{
-			const dl_member_desc* member = dl_get_type_member( dl_ctx, type, member_index );
-			const uint8_t* member_data = instance + member->offset[convert_ctx.src_ptr_size];
-
-			dl_error_t err = dl_internal_convert_collect_instances_from_member( dl_ctx, member, member_data, base_data, convert_ctx );
-			if( err != DL_ERROR_OK )
-				return err;
-		}
+		if( ctx->convert_ops[case_op].type == union_type )
+			return case_op;
+		case_op += ctx->convert_ops[case_op].count + 1;
 	}
-
-	return DL_ERROR_OK;
+	return DL_CONVERT_PLAN_NONE;
 }
 
-template<typename T>
-static T dl_convert_bf_format( T old_val, const dl_member_desc* bf_members, uint32_t bf_members_count, SConvertContext* conv_ctx )
+/**
+ * Collect all instances referenced by ops [op_index, op_end) of a conversion-plan run on the struct at instance.
+ */
+static void dl_internal_convert_collect_ops( dl_ctx_t         dl_ctx,
+											 uint32_t         op_index,
+											 uint32_t         op_end,
+											 const uint8_t*   instance,
+											 const uint8_t*   base_data,
+											 SConvertContext& convert_ctx )
 {
-	T new_val = 0;
-
-	for( uint32_t i = 0; i < bf_members_count; ++i )
+	uint32_t ptr_size = (uint32_t)dl_internal_ptr_size( convert_ctx.src_ptr_size );
+	while( op_index < op_end )
 	{
-		const dl_member_desc& bf_member = bf_members[i];
-
-		uint32_t bf_bits         = bf_member.BitFieldBits();
-		uint32_t bf_offset       = bf_member.BitFieldOffset();
-		uint32_t bf_source_offset = dl_bf_offset( conv_ctx->src_endian, sizeof(T), bf_offset, bf_bits );
-		uint32_t bf_target_offset = dl_bf_offset( conv_ctx->tgt_endian, sizeof(T), bf_offset, bf_bits );
+		const dl_convert_op* op = dl_ctx->convert_ops + op_index++;
+		const uint8_t* member_data = instance + op->src_offset;
 
- 		T extracted = (T)DL_EXTRACT_BITS( old_val, T(bf_source_offset), T(bf_bits) );
- 		new_val     = (T)DL_INSERT_BITS ( new_val, extracted, T(bf_target_offset), T(bf_bits) );
+		switch( op->op )
+		{
+			case DL_CONVERT_OP_STR:
+				for( uint32_t elem = 0; elem < op->count; ++elem )
+					dl_internal_convert_collect_instances_from_str( member_data + elem * ptr_size, base_data, convert_ctx );
+				break;
+			case DL_CONVERT_OP_PTR:
+				for( uint32_t elem = 0; elem < op->count; ++elem )
+					dl_internal_convert_collect_instances_from_ptr( dl_ctx, op->plan, member_data + elem * ptr_size, base_data, convert_ctx );
+				break;
+			case DL_CONVERT_OP_ARRAY:
+				dl_internal_convert_collect_instances_from_array( dl_ctx, op, member_data, base_data, convert_ctx );
+				break;
+			case DL_CONVERT_OP_STRUCT:
+				for( uint32_t elem = 0; elem < op->count; ++elem )
+					dl_internal_convert_collect_plan( dl_ctx, op->plan, member_data + elem * op->size, base_data, convert_ctx );
+				break;
+			case DL_CONVERT_OP_UNION:
+			{
+				uint32_t case_op = dl_internal_convert_find_case( dl_ctx, op_index - 1, instance, convert_ctx.src_ptr_size );
+				if( case_op == DL_CONVERT_PLAN_NONE )
+				{
+					convert_ctx.err = DL_ERROR_MALFORMED_DATA;
+					return;
+				}
+				dl_internal_convert_collect_ops( dl_ctx, case_op + 1, case_op + 1 + dl_ctx->convert_ops[case_op].count, instance, base_data, convert_ctx );
+				op_index += op->size;
+			}
+			break;
+			case DL_CONVERT_OP_BITFIELD:
+				op_index += op->count;
+				break;
+			default:
+				// ... pods, nothing to collect ...
+				break;
+		}
 	}
-
-	return new_val;
 }
 
-static uint8_t dl_convert_bit_field_format_uint8( uint8_t old_value, const dl_member_desc* first_bf_member, uint32_t num_bf_member, SConvertContext* conv_ctx )
+static void dl_internal_convert_collect_plan( dl_ctx_t         dl_ctx,
+											  uint32_t         plan,
+											  const uint8_t*   instance,
+											  const uint8_t*   base_data,
+											  SConvertContext& convert_ctx )
 {
-	if( conv_ctx->src_endian != DL_ENDIAN_HOST )
-		return dl_swap_endian_uint8( dl_convert_bf_format( dl_swap_endian_uint8( old_value ), first_bf_member, num_bf_member, conv_ctx ) );
-
-	return dl_convert_bf_format( old_value, first_bf_member, num_bf_member, conv_ctx );
-}
-
-static uint16_t dl_convert_bit_field_format_uint16( uint16_t old_value, const dl_member_desc* first_bf_member, uint32_t num_bf_member, SConvertContext* conv_ctx )
-{
-	if( conv_ctx->src_endian != DL_ENDIAN_HOST )
-		return dl_swap_endian_uint16( dl_convert_bf_format( dl_swap_endian_uint16( old_value ), first_bf_member, num_bf_member, conv_ctx ) );
-
-	return dl_convert_bf_format( old_value, first_bf_member, num_bf_member, conv_ctx );
+	const dl_convert_op* begin = dl_ctx->convert_ops + plan;
+	if( ( dl_ctx->type_descs[begin->type_index].flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
+		return;
+	dl_internal_convert_collect_ops( dl_ctx, plan + 1, plan + 1 + begin->count, instance, base_data, convert_ctx );
 }
 
-static uint32_t dl_convert_bit_field_format_uint32( uint32_t old_value, const dl_member_desc* first_bf_member, uint32_t num_bf_member, SConvertContext* conv_ctx )
+static void dl_internal_convert_save_patch_pos( SConvertContext* conv_ctx, dl_binary_writer* writer, size_t patch_pos, uintptr_t offset )
 {
-	if( conv_ctx->src_endian != DL_ENDIAN_HOST )
-		return dl_swap_endian_uint32( dl_convert_bf_format( dl_swap_endian_uint32( old_value ), first_bf_member, num_bf_member, conv_ctx ) );
+	if( offset == DL_NULL_PTR_OFFSET[conv_ctx->src_ptr_size] )
+	{
+		// ... only offsets use -1 as null, relative refs and loaded ptrs use 0 ...
+		dl_binary_writer_write_ptr( writer, conv_ctx->out_refs == DL_CONVERT_OUT_REFS_OFFSET ? DL_NULL_PTR_OFFSET[conv_ctx->target_ptr_size] : 0 );
+		return;
+	}
 
-	return dl_convert_bf_format( old_value, first_bf_member, num_bf_member, conv_ctx );
+	if( !conv_ctx->m_lPatchOffset.Add( SConvertContext::PatchPos( patch_pos, offset ) ) )
+		conv_ctx->err = DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	dl_binary_writer_write_ptr( writer, 0x0 );
 }
 
-static uint64_t dl_convert_bit_field_format_uint64( uint64_t old_value, const dl_member_desc* first_bf_member, uint32_t num_bf_member, SConvertContext* conv_ctx )
+/**
+ * Write the bitfields converted by the DL_CONVERT_OP_BITFIELD bf_op, the ops describing each bitfield follow bf_op.
+ */
+static void dl_internal_convert_write_bitfield( const dl_convert_op* bf_op, const uint8_t* data, SConvertContext& conv_ctx, dl_binary_writer* writer )
 {
-	if( conv_ctx->src_endian != DL_ENDIAN_HOST )
-		return dl_swap_endian_uint64( dl_convert_bf_format( dl_swap_endian_uint64( old_value ), first_bf_member, num_bf_member, conv_ctx ) );
+	union { uint8_t u8; uint16_t u16; uint32_t u32; uint64_t u64; } val;
+	val.u64 = 0;
+	memcpy( &val, data, bf_op->size );
 
-	return dl_convert_bf_format( old_value, first_bf_member, num_bf_member, conv_ctx );
-}
+	uint64_t old_val;
+	switch( bf_op->size )
+	{
+		case 1:  old_val = val.u8; break;
+		case 2:  old_val = conv_ctx.src_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint16( val.u16 ) : val.u16; break;
+		case 4:  old_val = conv_ctx.src_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint32( val.u32 ) : val.u32; break;
+		case 8:  old_val = conv_ctx.src_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint64( val.u64 ) : val.u64; break;
+		default:
+			DL_ASSERT(false && "Not supported pod-size or bitfield-size!");
+			return;
+	}
 
-static void dl_internal_convert_save_patch_pos( SConvertContext* conv_ctx, dl_binary_writer* writer, size_t patch_pos, uintptr_t offset )
-{
-	if( offset == DL_NULL_PTR_OFFSET[conv_ctx->src_ptr_size] )
+	uint64_t new_val = 0;
+	for( uint32_t i = 1; i <= bf_op->count; ++i )
 	{
-		dl_binary_writer_write_ptr( writer, DL_NULL_PTR_OFFSET[conv_ctx->target_ptr_size] );
-		return;
+		const dl_convert_op* bits = bf_op + i;
+		uint64_t extracted = DL_EXTRACT_BITS( old_val, (uint64_t)bits->src_offset, (uint64_t)bits->size );
+		new_val = DL_INSERT_BITS( new_val, extracted, (uint64_t)bits->dst_offset, (uint64_t)bits->size );
 	}
 
-	conv_ctx->m_lPatchOffset.Add( SConvertContext::PatchPos( patch_pos, offset ) );
-	dl_binary_writer_write_ptr( writer, 0x0 );
+	switch( bf_op->size )
+	{
+		case 1: val.u8  = (uint8_t)new_val; break;
+		case 2: val.u16 = conv_ctx.tgt_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint16( (uint16_t)new_val ) : (uint16_t)new_val; break;
+		case 4: val.u32 = conv_ctx.tgt_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint32( (uint32_t)new_val ) : (uint32_t)new_val; break;
+		case 8: val.u64 = conv_ctx.tgt_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint64( new_val )           : new_val;           break;
+	}
+	dl_binary_writer_write( writer, &val, bf_op->size );
 }
 
-static dl_error_t dl_internal_convert_write_struct( dl_ctx_t            dl_ctx,
-													const uint8_t*      instance,
-													const dl_type_desc* type,
-													SConvertContext&    conv_ctx,
-													dl_binary_writer*   writer );
-
-static dl_error_t dl_internal_convert_write_member( dl_ctx_t              ctx,
-													const uint8_t*        member_data,
-													const dl_type_desc*   type,
-													const dl_member_desc* member,
-													uint32_t&             member_index, // TODO: ref == urgh!
-													SConvertContext&      conv_ctx,
-													dl_binary_writer*     writer )
+static dl_error_t dl_internal_convert_write_plan( dl_ctx_t          dl_ctx,
+												  uint32_t          plan,
+												  const uint8_t*    instance,
+												  SConvertContext&  conv_ctx,
+												  dl_binary_writer* writer );
+
+/**
+ * Write ops [op_index, op_end) of a conversion-plan run on the struct at instance, written at struct_pos.
+ */
+static dl_error_t dl_internal_convert_write_ops( dl_ctx_t          dl_ctx,
+												 uint32_t          op_index,
+												 uint32_t          op_end,
+												 const uint8_t*    instance,
+												 uintptr_t         struct_pos,
+												 SConvertContext&  conv_ctx,
+												 dl_binary_writer* writer )
 {
-	dl_type_t atom_type    = member->AtomType();
-	dl_type_t storage_type = member->StorageType();
-
-	switch(atom_type)
+	size_t ptr_size = dl_internal_ptr_size( conv_ctx.src_ptr_size );
+	while( op_index < op_end )
 	{
-		case DL_TYPE_ATOM_POD:
+		const dl_convert_op* op = dl_ctx->convert_ops + op_index++;
+		const uint8_t* member_data = instance + op->src_offset;
+
+		// ... zero padding before member ...
+		uintptr_t member_pos = struct_pos + op->dst_offset;
+		if( dl_binary_writer_tell( writer ) < member_pos )
+			dl_binary_writer_write_zero( writer, member_pos - dl_binary_writer_tell( writer ) );
+
+		switch( op->op )
 		{
-			switch(storage_type)
-			{
-				case DL_TYPE_STORAGE_STRUCT:
-				{
-					const dl_type_desc* sub_type = dl_internal_find_type(ctx, member->type_id);
-					if(sub_type == 0x0)
-						return DL_ERROR_TYPE_NOT_FOUND;
-					dl_internal_convert_write_struct( ctx, member_data, sub_type, conv_ctx, writer );
-				}
+			case DL_CONVERT_OP_COPY:
+				dl_binary_writer_write( writer, member_data, op->count );
 				break;
-				case DL_TYPE_STORAGE_STR:
-				case DL_TYPE_STORAGE_PTR:
-				{
-					uintptr_t offset = dl_internal_read_ptr_data(member_data, conv_ctx.src_endian, conv_ctx.src_ptr_size);
-					dl_internal_convert_save_patch_pos( &conv_ctx, writer, dl_binary_writer_tell( writer), offset );
-				}
+			case DL_CONVERT_OP_SWAP:
+				dl_binary_writer_write_array( writer, member_data, op->count, op->size );
 				break;
-				default:
-					DL_ASSERT(member->IsSimplePod() || storage_type == DL_TYPE_STORAGE_ENUM);
-					dl_binary_writer_write_swap( writer, member_data, member->size[conv_ctx.src_ptr_size] );
-					break;
-			}
-		}
-		break;
-		case DL_TYPE_ATOM_INLINE_ARRAY:
-		{
-			switch(storage_type)
-			{
-				case DL_TYPE_STORAGE_STRUCT:
+			case DL_CONVERT_OP_STR:
+			case DL_CONVERT_OP_PTR:
+				for( uint32_t elem = 0; elem < op->count; ++elem )
 				{
-					const dl_type_desc* sub_type = dl_internal_find_type(ctx, member->type_id);
-					if(sub_type == 0x0)
-						return DL_ERROR_TYPE_NOT_FOUND;
-
-					uintptr_t SubtypeSize = sub_type->size[conv_ctx.src_ptr_size];
-					for( uint32_t i = 0; i < member->inline_array_cnt(); ++i )
-						dl_internal_convert_write_struct( ctx, member_data + i * SubtypeSize, sub_type, conv_ctx, writer );
-				}
-				break;
-				case DL_TYPE_STORAGE_STR:
-				case DL_TYPE_STORAGE_PTR:
-				{
-					uintptr_t src_ptr_size = dl_internal_ptr_size(conv_ctx.src_ptr_size);
-					uintptr_t tgt_ptr_size = dl_internal_ptr_size(conv_ctx.target_ptr_size);
-					uintptr_t array_pos = dl_binary_writer_tell( writer );
-
-					for (uintptr_t elem_index = 0; elem_index < member->inline_array_cnt(); ++elem_index)
-					{
-						uintptr_t offset = dl_internal_read_ptr_data(member_data + (elem_index * src_ptr_size), conv_ctx.src_endian, conv_ctx.src_ptr_size);
-						dl_internal_convert_save_patch_pos( &conv_ctx, writer, array_pos + (elem_index * tgt_ptr_size), offset );
-					}
+					uintptr_t offset = dl_internal_read_ptr_data( member_data + elem * ptr_size, conv_ctx.src_endian, conv_ctx.src_ptr_size );
+					dl_internal_convert_save_patch_pos( &conv_ctx, writer, dl_binary_writer_tell( writer ), offset );
 				}
 				break;
-				default:
+			case DL_CONVERT_OP_ARRAY:
+			{
+				uintptr_t offset = 0; uint32_t count = 0;
+				dl_internal_read_array_data( member_data, &offset, &count, conv_ctx.src_endian, conv_ctx.src_ptr_size );
+				dl_internal_convert_save_patch_pos( &conv_ctx, writer, dl_binary_writer_tell( writer ), offset );
+				dl_binary_writer_write_4byte( writer, member_data + ptr_size );
+				if( conv_ctx.target_ptr_size == DL_PTR_SIZE_64BIT )
+					dl_binary_writer_write_zero( writer, 4 );
+			}
+			break;
+			case DL_CONVERT_OP_STRUCT:
+				for( uint32_t elem = 0; elem < op->count; ++elem )
 				{
-					DL_ASSERT(member->IsSimplePod() || storage_type == DL_TYPE_STORAGE_ENUM);
-					dl_binary_writer_write_array( writer, member_data, member->inline_array_cnt(), dl_pod_size( member->type ) );
+					dl_error_t err = dl_internal_convert_write_plan( dl_ctx, op->plan, member_data + elem * op->size, conv_ctx, writer );
+					if( err != DL_ERROR_OK )
+						return err;
 				}
 				break;
-			}
-		}
-		break;
-
-		case DL_TYPE_ATOM_ARRAY:
-		{
-			uintptr_t offset = 0; uint32_t count = 0;
-			dl_internal_read_array_data( member_data, &offset, &count, conv_ctx.src_endian, conv_ctx.src_ptr_size );
-			dl_internal_convert_save_patch_pos( &conv_ctx, writer, dl_binary_writer_tell( writer ), offset );
-			dl_binary_writer_write_4byte( writer, member_data + dl_internal_ptr_size( conv_ctx.src_ptr_size ) );
-			if( conv_ctx.target_ptr_size == DL_PTR_SIZE_64BIT )
-				dl_binary_writer_write_zero( writer, 4 );
-		}
-		break;
-
-		case DL_TYPE_ATOM_BITFIELD:
-		{
-			uint32_t j = member_index;
-
-			do { j++; } while(j < type->member_count && dl_get_type_member( ctx, type, j )->AtomType() == DL_TYPE_ATOM_BITFIELD);
-
-			if(conv_ctx.src_endian != conv_ctx.tgt_endian)
+			case DL_CONVERT_OP_UNION:
 			{
-				uint32_t nBFMembers = j - member_index;
-
-				switch(member->size[conv_ctx.src_ptr_size])
-				{
-					case 1:
-					{
-						uint8_t val = dl_convert_bit_field_format_uint8( *(uint8_t*)member_data, member, nBFMembers, &conv_ctx );
-						dl_binary_writer_write_1byte( writer, &val );
-					} break;
-					case 2:
-					{
-						uint16_t val = dl_convert_bit_field_format_uint16( *(uint16_t*)member_data, member, nBFMembers, &conv_ctx );
-						dl_binary_writer_write_2byte( writer, &val );
-					} break;
-					case 4:
-					{
-						uint32_t val = dl_convert_bit_field_format_uint32( *(uint32_t*)member_data, member, nBFMembers, &conv_ctx );
-						dl_binary_writer_write_4byte( writer, &val );
-					} break;
-					case 8:
-					{
-						uint64_t val = dl_convert_bit_field_format_uint64( *(uint64_t*)member_data, member, nBFMembers, &conv_ctx );
-						dl_binary_writer_write_8byte( writer, &val );
-					} break;
-					default:
-						DL_ASSERT(false && "Not supported pod-size or bitfield-size!");
-				}
+				uint32_t case_op = dl_internal_convert_find_case( dl_ctx, op_index - 1, instance, conv_ctx.src_ptr_size );
+				if( case_op == DL_CONVERT_PLAN_NONE )
+					return DL_ERROR_MALFORMED_DATA;
+
+				const dl_convert_op* case_desc = dl_ctx->convert_ops + case_op;
+				dl_error_t err = dl_internal_convert_write_ops( dl_ctx, case_op + 1, case_op + 1 + case_desc->count, instance, struct_pos, conv_ctx, writer );
+				if( err != DL_ERROR_OK )
+					return err;
+
+				// ... type-tag is stored after the largest member ...
+				const dl_type_desc* union_type = dl_ctx->type_descs + op->type_index;
+				uintptr_t tag_pos = member_pos + dl_internal_largest_member_size( dl_ctx, union_type, conv_ctx.target_ptr_size );
+				if( dl_binary_writer_tell( writer ) < tag_pos )
+					dl_binary_writer_write_zero( writer, tag_pos - dl_binary_writer_tell( writer ) );
+				dl_binary_writer_align( writer, 4 );
+				dl_binary_writer_write_uint32( writer, case_desc->type );
+				op_index += op->size;
 			}
-			else
-				dl_binary_writer_write( writer, member_data, member->size[conv_ctx.src_ptr_size] );
-
-			member_index = j - 1;
-		}
-		break;
-
-		default:
-			DL_ASSERT(false && "Invalid ATOM-type!");
 			break;
+			case DL_CONVERT_OP_BITFIELD:
+				dl_internal_convert_write_bitfield( op, member_data, conv_ctx, writer );
+				op_index += op->count;
+				break;
+			default:
+				DL_ASSERT(false && "Invalid convert-op!");
+				break;
+		}
 	}
 
 	return DL_ERROR_OK;
 }
 
-static dl_error_t dl_internal_convert_write_struct( dl_ctx_t            dl_ctx,
-													const uint8_t*      instance,
-													const dl_type_desc* type,
-													SConvertContext&    conv_ctx,
-													dl_binary_writer*   writer )
+static dl_error_t dl_internal_convert_write_plan( dl_ctx_t          dl_ctx,
+												  uint32_t          plan,
+												  const uint8_t*    instance,
+												  SConvertContext&  conv_ctx,
+												  dl_binary_writer* writer )
 {
+	const dl_convert_op* begin = dl_ctx->convert_ops + plan;
+	const dl_type_desc*  type  = dl_ctx->type_descs + begin->type_index;
+	size_t type_size = type->size[conv_ctx.target_ptr_size];
+
 	dl_binary_writer_align( writer, type->alignment[conv_ctx.target_ptr_size] );
 	uintptr_t pos = dl_binary_writer_tell( writer );
-	dl_binary_writer_reserve( writer, type->size[conv_ctx.target_ptr_size] );
-
-	if( type->flags & DL_TYPE_FLAG_IS_UNION )
-	{
-		// TODO: extract to helper-function?
-		size_t src_max_member_size = dl_internal_largest_member_size( dl_ctx, type, conv_ctx.src_ptr_size );
-		size_t tgt_max_member_size = dl_internal_largest_member_size( dl_ctx, type, conv_ctx.target_ptr_size );
-
-		uint32_t union_type = *((uint32_t*)(instance + src_max_member_size));
-		const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( dl_ctx, type, union_type );
-		const uint8_t* member_data = instance + member->offset[conv_ctx.src_ptr_size];
-
-		uint32_t member_index = 0;
-		dl_error_t err = dl_internal_convert_write_member( dl_ctx, member_data, type, member, member_index, conv_ctx, writer );
-		if( err != DL_ERROR_OK )
-			return err;
-
-		dl_binary_writer_seek_set( writer, pos + tgt_max_member_size );
-		dl_binary_writer_align( writer, 4 );
-		dl_binary_writer_write_uint32( writer, union_type );
-	}
-	else
-	{
-		for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
-		{
-			const dl_member_desc* member = dl_get_type_member( dl_ctx, type, member_index );
-			const uint8_t* member_data   = instance + member->offset[conv_ctx.src_ptr_size];
+	dl_binary_writer_reserve( writer, type_size );
 
-			dl_binary_writer_align( writer, member->alignment[conv_ctx.target_ptr_size] );
-			dl_error_t err = dl_internal_convert_write_member( dl_ctx, member_data, type, member, member_index, conv_ctx, writer );
-			if( err != DL_ERROR_OK )
-				return err;
-		}
-	}
+	dl_error_t err = dl_internal_convert_write_ops( dl_ctx, plan + 1, plan + 1 + begin->count, instance, pos, conv_ctx, writer );
+	if( err != DL_ERROR_OK )
+		return err;
 
 	// we need to write our entire size with zeroes. Our entire size might be less than the sum of the members.
 	uintptr_t pos_diff = dl_binary_writer_tell( writer ) - pos;
 
-	if( pos_diff < type->size[conv_ctx.target_ptr_size] )
-		dl_binary_writer_write_zero( writer, type->size[conv_ctx.target_ptr_size] - pos_diff );
+	if( pos_diff < type_size )
+		dl_binary_writer_write_zero( writer, type_size - pos_diff );
 
-	DL_ASSERT( dl_binary_writer_tell( writer ) - pos == type->size[conv_ctx.target_ptr_size] );
+	DL_ASSERT( dl_binary_writer_tell( writer ) - pos == type_size );
 
 	return DL_ERROR_OK;
 }
@@ -684,9 +596,17 @@ static dl_error_t dl_internal_convert_write_instance( dl_ctx_t          dl_ctx,
 				case DL_TYPE_STORAGE_STRUCT:
 				{
 					uintptr_t type_size = inst.type->size[conv_ctx.src_ptr_size];
+					uint32_t  width     = dl_ctx->convert_ops[inst.plan].size;
+					if( width != 0 )
+					{
+						// ... no padding or subdata to care about, swap all elements as one big pod-array ...
+						dl_binary_writer_write_array( writer, u8, inst.array_count * type_size / width, width );
+						return DL_ERROR_OK;
+					}
+
 					for( uintptr_t elem = 0; elem < inst.array_count; ++elem )
 					{
-						dl_error_t err = dl_internal_convert_write_struct( dl_ctx, u8 + ( elem * type_size ), inst.type, conv_ctx, writer );
+						dl_error_t err = dl_internal_convert_write_plan( dl_ctx, inst.plan, u8 + ( elem * type_size ), conv_ctx, writer );
 						if(err != DL_ERROR_OK) return err;
 					}
 				}
@@ -744,7 +664,7 @@ static dl_error_t dl_internal_convert_write_instance( dl_ctx_t          dl_ctx,
 					return DL_ERROR_OK;
 				case DL_TYPE_STORAGE_STRUCT:
 				case DL_TYPE_STORAGE_PTR:
-					return dl_internal_convert_write_struct( dl_ctx, u8, inst.type, conv_ctx, writer );
+					return dl_internal_convert_write_plan( dl_ctx, inst.plan, u8, conv_ctx, writer );
 				default:
 					// ignore ...
 					break;
@@ -763,64 +683,101 @@ static dl_error_t dl_internal_convert_write_instance( dl_ctx_t          dl_ctx,
 
 bool dl_internal_sort_pred( const SInstance& i1, const SInstance& i2 ) { return i1.address < i2.address; }
 
-dl_error_t dl_internal_convert_no_header( dl_ctx_t       dl_ctx,
-                                          unsigned char* packed_instance, unsigned char* packed_instance_base,
-                                          unsigned char* out_instance,    size_t         out_instance_size,
-                                          size_t*        needed_size,
-                                          dl_endian_t    src_endian,      dl_endian_t    out_endian,
-                                          dl_ptr_size_t  src_ptr_size,    dl_ptr_size_t  out_ptr_size,
-                                          const dl_type_desc* root_type,  size_t         base_offset )
+static dl_error_t dl_internal_convert_no_header( dl_ctx_t            dl_ctx,
+                                                 unsigned char*      packed_instance, unsigned char* packed_instance_base,
+                                                 dl_binary_writer*   writer,          size_t*        needed_size,
+                                                 dl_endian_t         src_endian,      dl_endian_t    out_endian,
+                                                 dl_ptr_size_t       src_ptr_size,    dl_ptr_size_t  out_ptr_size,
+                                                 const dl_type_desc* root_type,       size_t         base_offset,
+                                                 dl_convert_out_refs out_refs )
 {
-	dl_binary_writer writer;
-	dl_binary_writer_init( &writer, out_instance, out_instance_size, out_instance == 0x0, src_endian, out_endian, out_ptr_size );
+	SConvertContext conv_ctx( src_endian, out_endian, src_ptr_size, out_ptr_size, out_refs, &dl_ctx->alloc );
+	const char* type_name = dl_internal_type_name( dl_ctx, root_type );
 
-	SConvertContext conv_ctx( src_endian, out_endian, src_ptr_size, out_ptr_size );
+	dl_error_t err;
+	{
+		dl_trace_scope trace( dl_ctx, "convert.collect", type_name, 0 );
 
-	conv_ctx.instances.Add(SInstance(packed_instance, root_type, 0x0, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STRUCT)));
-	dl_error_t err = dl_internal_convert_collect_instances(dl_ctx, root_type, packed_instance, packed_instance_base, conv_ctx);
+		// ... plans are built before anything is collected, no plans are added while converting so ops can be referenced directly ...
+		uint32_t root_plan;
+		err = dl_internal_convert_plan( dl_ctx, root_type, dl_internal_convert_plan_variant( src_endian, src_ptr_size, out_endian, out_ptr_size ), &root_plan );
+		if( err != DL_ERROR_OK )
+			return err;
+
+		conv_ctx.AddPtrInstance(SInstance(packed_instance, root_type, 0x0, dl_type_t(DL_TYPE_ATOM_POD | DL_TYPE_STORAGE_STRUCT), root_plan)); // ptrs to root should not write it again
+		dl_internal_convert_collect_plan(dl_ctx, root_plan, packed_instance, packed_instance_base, conv_ctx);
+		err = conv_ctx.err;
+		if( err != DL_ERROR_OK )
+			return err;
 
-	// TODO: we need to sort the instances here after their offset!
+		// ... sort instances after their offset, this way they are written in the same order as in the source data and
+		//     the sorted array can be used to map old offsets to new ones ...
+		std::sort( conv_ctx.instances.GetBasePtr(), conv_ctx.instances.GetBasePtr() + conv_ctx.instances.Len(), dl_internal_sort_pred );
+	}
 
+	dl_trace_scope trace( dl_ctx, "convert.write", type_name, 0 );
 	SInstance* insts = conv_ctx.instances.GetBasePtr();
-	std::sort( insts, insts + conv_ctx.instances.Len(), dl_internal_sort_pred );
+	SInstance* insts_end = insts + conv_ctx.instances.Len();
 
 	for(unsigned int i = 0; i < conv_ctx.instances.Len(); ++i)
 	{
-		err = dl_internal_convert_write_instance( dl_ctx, conv_ctx.instances[i], &conv_ctx.instances[i].offset_after_patch, conv_ctx, &writer );
+		err = dl_internal_convert_write_instance( dl_ctx, conv_ctx.instances[i], &conv_ctx.instances[i].offset_after_patch, conv_ctx, writer );
 		if(err != DL_ERROR_OK) 
 			return err;
 	}
+	if( conv_ctx.err != DL_ERROR_OK )
+		return conv_ctx.err;
+
+	// ... 32-bit refs can not reference data beyond 4GB, and relative 32-bit refs are signed so they can not reach
+	//     further than 2GB ...
+	if( out_ptr_size == DL_PTR_SIZE_32BIT )
+	{
+		uint64_t max_size = out_refs == DL_CONVERT_OUT_REFS_RELATIVE ? (uint64_t)0x7FFFFFFF : (uint64_t)DL_NULL_PTR_OFFSET[DL_PTR_SIZE_32BIT];
+		if( (uint64_t)dl_binary_writer_needed_size( writer ) + base_offset > max_size )
+			return DL_ERROR_UNSUPPORTED_OPERATION;
+	}
 
-	if(out_instance != 0x0) // no need to patch data if we are only calculating size
+	if( !writer->dummy ) // no need to patch data if we are only calculating size
 	{
 		for(unsigned int i = 0; i < conv_ctx.m_lPatchOffset.Len(); ++i)
 		{
 			SConvertContext::PatchPos& pp = conv_ctx.m_lPatchOffset[i];
 
 			// find new offset
-			uintptr_t new_offset = (uintptr_t)-1;
+			SInstance key;
+			key.address = packed_instance_base + pp.old_offset;
+			SInstance* inst = std::lower_bound( insts, insts_end, key, dl_internal_sort_pred );
 
-			for( size_t j = 0; j < conv_ctx.instances.Len(); ++j )
-			{
-				uintptr_t old_offset = (uintptr_t)(conv_ctx.instances[j].address - packed_instance_base);
+			DL_ASSERT(inst != insts_end && inst->address == key.address && "We should have found the instance!");
+			if( inst == insts_end || inst->address != key.address )
+				return DL_ERROR_MALFORMED_DATA;
 
-				if(old_offset == pp.old_offset)
-				{
-					new_offset = conv_ctx.instances[j].offset_after_patch;
+			dl_binary_writer_seek_set( writer, pp.pos );
+			switch( out_refs )
+			{
+				case DL_CONVERT_OUT_REFS_OFFSET:
+					dl_binary_writer_write_ptr( writer, inst->offset_after_patch + base_offset );
+					break;
+				case DL_CONVERT_OUT_REFS_RELATIVE:
+					// ... offset from the ptr itself, negative for back-references. 0 is null so a ptr that is the
+					//     first member of the struct it points to can not be stored ...
+					if( inst->offset_after_patch == pp.pos )
+						return DL_ERROR_UNSUPPORTED_OPERATION;
+					dl_binary_writer_write_ref( writer, (int64_t)inst->offset_after_patch - (int64_t)pp.pos );
+					break;
+				case DL_CONVERT_OUT_REFS_LOADED:
+					// ... a growing writer might have moved the data while writing, so the base is read here ...
+					dl_binary_writer_write_ptr( writer, (uintptr_t)writer->data + inst->offset_after_patch );
 					break;
-				}
 			}
-
-			DL_ASSERT(new_offset != (uintptr_t)-1 && "We should have found the instance!");
-
-			dl_binary_writer_seek_set( &writer, pp.pos );
-			dl_binary_writer_write_ptr( &writer, new_offset + base_offset );
 		}
 	}
 
-	dl_binary_writer_seek_end( &writer );
-	*needed_size = (unsigned int)dl_binary_writer_tell( &writer );
+	dl_binary_writer_seek_end( writer );
+	*needed_size = dl_binary_writer_tell( writer );
 
+	if( err == DL_ERROR_OK )
+		trace.bytes( 0, *needed_size );
 	return err;
 }
 
@@ -828,20 +785,24 @@ static dl_error_t dl_internal_convert_instance( dl_ctx_t       dl_ctx,
                                                 unsigned char* packed_instance, size_t      packed_instance_size,
                                                 unsigned char* out_instance,    size_t      out_instance_size,
                                                 dl_endian_t    out_endian,      size_t      out_ptr_size,
-                                                size_t*        out_size )
+                                                dl_convert_out_refs out_refs,   size_t*     out_size,
+                                                const char*    trace_name )
 {
-	dl_data_header* header = (dl_data_header*)packed_instance;
-
-	if( packed_instance_size < sizeof(dl_data_header) )             return DL_ERROR_MALFORMED_DATA;
-	if( header->id != DL_INSTANCE_ID &&
-		header->id != DL_INSTANCE_ID_SWAPED )                       return DL_ERROR_MALFORMED_DATA;
-	if( header->version != DL_INSTANCE_VERSION &&
-		header->version != DL_INSTANCE_VERSION_SWAPED )             return DL_ERROR_VERSION_MISMATCH;
-	if( header->root_instance_type != type &&
-		header->root_instance_type != dl_swap_endian_uint32(type) ) return DL_ERROR_TYPE_MISMATCH;
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_CONVERT, trace_name, dl_internal_trace_type_name( dl_ctx, type ), packed_instance_size );
+
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    src_endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &src_endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( header.root_instance_type != type )                         return DL_ERROR_TYPE_MISMATCH;
 	if( out_ptr_size != 4 && out_ptr_size != 8 )                    return DL_ERROR_INVALID_PARAMETER;
+	if( header.is_relative_ptr )                                    return DL_ERROR_UNSUPPORTED_OPERATION;
+	if( header.instance_size > packed_instance_size - header_size ) return DL_ERROR_MALFORMED_DATA;
 
-	dl_ptr_size_t src_ptr_size = header->is_64_bit_ptr != 0 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT;
+	dl_ptr_size_t src_ptr_size = header.is_64_bit_ptr != 0 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT;
 	dl_ptr_size_t dst_ptr_size;
 
 	switch(out_ptr_size)
@@ -855,35 +816,48 @@ static dl_error_t dl_internal_convert_instance( dl_ctx_t       dl_ctx,
 	if( dst_ptr_size > src_ptr_size && packed_instance == out_instance )
 		return DL_ERROR_UNSUPPORTED_OPERATION;
 
-	dl_endian_t src_endian = header->id == DL_INSTANCE_ID ? DL_ENDIAN_HOST : dl_other_endian( DL_ENDIAN_HOST );
+	// ... older versions has a smaller header, the converted data would be written ahead of the data it is read from ...
+	if( header_size < sizeof(dl_data_header) && packed_instance == out_instance )
+		return DL_ERROR_UNSUPPORTED_OPERATION;
 
-	if(src_endian == out_endian && src_ptr_size == dst_ptr_size)
+	if(src_endian == out_endian && src_ptr_size == dst_ptr_size && out_refs == DL_CONVERT_OUT_REFS_OFFSET && header.version == DL_INSTANCE_VERSION)
 	{
+		*out_size = header_size + (size_t)header.instance_size;
 		if(out_instance != 0x0)
-			memmove(out_instance, packed_instance, packed_instance_size); // TODO: This is a bug! data_size is only the size of buffer, not the size of the packed instance!
-
-		*out_size = packed_instance_size; // TODO: This is a bug! data_size is only the size of buffer, not the size of the packed instance!
+		{
+			if( *out_size > out_instance_size )
+				return DL_ERROR_BUFFER_TO_SMALL;
+			memmove(out_instance, packed_instance, *out_size);
+		}
+		stats.bytes( *out_size, *out_size );
 		return DL_ERROR_OK;
 	}
 
-	dl_typeid_t root_type_id = src_endian != DL_ENDIAN_HOST ? dl_swap_endian_uint32( header->root_instance_type ) : header->root_instance_type;
-
-	const dl_type_desc* root_type = dl_internal_find_type(dl_ctx, root_type_id);
+	const dl_type_desc* root_type = dl_internal_find_type(dl_ctx, header.root_instance_type);
 	if(root_type == 0x0)
 		return DL_ERROR_TYPE_NOT_FOUND;
 
-	dl_error_t err = dl_internal_convert_no_header( dl_ctx,
-												    packed_instance + sizeof(dl_data_header),
-												    packed_instance + sizeof(dl_data_header),
-												    out_instance == 0x0 ? 0x0 : out_instance + sizeof(dl_data_header),
-												    out_instance_size - sizeof(dl_data_header),
+	dl_binary_writer writer;
+	dl_binary_writer_init( &writer,
+						   out_instance == 0x0 ? 0x0 : out_instance + sizeof(dl_data_header),
+						   out_instance_size - sizeof(dl_data_header),
+						   out_instance == 0x0,
+						   src_endian,
+						   out_endian,
+						   dst_ptr_size );
+
+	err = dl_internal_convert_no_header( dl_ctx,
+										 packed_instance + header_size,
+										 packed_instance + header_size,
+												    &writer,
 												    out_size,
 												    src_endian,
 												    out_endian,
 												    src_ptr_size,
 												    dst_ptr_size,
 												    root_type,
-												    0u );
+												    0u,
+												    out_refs );
 
 	if(out_instance != 0x0)
 	{
@@ -891,17 +865,44 @@ static dl_error_t dl_internal_convert_instance( dl_ctx_t       dl_ctx,
 		new_header->id                 = DL_INSTANCE_ID;
 		new_header->version            = DL_INSTANCE_VERSION;
 		new_header->root_instance_type = type;
-		new_header->instance_size      = uint32_t(*out_size);
 		new_header->is_64_bit_ptr      = out_ptr_size == 4 ? 0 : 1;
+		new_header->is_relative_ptr    = out_refs == DL_CONVERT_OUT_REFS_RELATIVE ? 1 : 0;
+		new_header->pad[0]             = 0;
+		new_header->pad[1]             = 0;
+		new_header->instance_size      = *out_size;
 
 		if(DL_ENDIAN_HOST != out_endian)
 			dl_swap_header(new_header);
 	}
 
 	*out_size += sizeof(dl_data_header);
+	if( err == DL_ERROR_OK )
+		stats.bytes( header_size + (size_t)header.instance_size, *out_size );
 	return err;
 }
 
+/**
+ * Validate the header of a packed instance of any endian and ptr-size, header is returned in host-endian.
+ */
+static dl_error_t dl_internal_read_any_header( dl_ctx_t             dl_ctx,          dl_typeid_t         type,
+											   const unsigned char* packed_instance, size_t              packed_instance_size,
+											   dl_data_header*      header,          size_t*             header_size,
+											   dl_endian_t*         src_endian,      const dl_type_desc** root_type )
+{
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, header, header_size, src_endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( header->root_instance_type != type )                                return DL_ERROR_TYPE_MISMATCH;
+	if( header->is_relative_ptr )                                           return DL_ERROR_UNSUPPORTED_OPERATION;
+	if( header->instance_size > packed_instance_size - *header_size )       return DL_ERROR_MALFORMED_DATA;
+
+	*root_type = dl_internal_find_type( dl_ctx, type );
+	if( *root_type == 0x0 )
+		return DL_ERROR_TYPE_NOT_FOUND;
+	return DL_ERROR_OK;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
@@ -914,7 +915,7 @@ dl_error_t dl_convert_inplace( dl_ctx_t       dl_ctx,          dl_typeid_t type,
 	size_t dummy;
 	if( produced_bytes == 0x0 )
 		produced_bytes = &dummy;
-	return dl_internal_convert_instance( dl_ctx, type, packed_instance, packed_instance_size, packed_instance, packed_instance_size, out_endian, out_ptr_size, produced_bytes );
+	return dl_internal_convert_instance( dl_ctx, type, packed_instance, packed_instance_size, packed_instance, packed_instance_size, out_endian, out_ptr_size, DL_CONVERT_OUT_REFS_OFFSET, produced_bytes, "dl_convert_inplace" );
 }
 
 dl_error_t dl_convert( dl_ctx_t       dl_ctx,          dl_typeid_t type,
@@ -927,7 +928,20 @@ dl_error_t dl_convert( dl_ctx_t       dl_ctx,          dl_typeid_t type,
 	size_t dummy;
 	if( produced_bytes == 0x0 )
 		produced_bytes = &dummy;
-	return dl_internal_convert_instance( dl_ctx, type, packed_instance, packed_instance_size, out_instance, out_instance_size, out_endian, out_ptr_size, produced_bytes );
+	return dl_internal_convert_instance( dl_ctx, type, packed_instance, packed_instance_size, out_instance, out_instance_size, out_endian, out_ptr_size, DL_CONVERT_OUT_REFS_OFFSET, produced_bytes, "dl_convert" );
+}
+
+dl_error_t dl_convert_to_relative( dl_ctx_t       dl_ctx,          dl_typeid_t type,
+                                   unsigned char* packed_instance, size_t      packed_instance_size,
+                                   unsigned char* out_instance,    size_t      out_instance_size,
+                                   dl_endian_t    out_endian,      size_t      out_ref_size,
+                                   size_t*        produced_bytes )
+{
+	DL_ASSERT(out_instance != packed_instance && "Src and destination can not be the same!");
+	size_t dummy;
+	if( produced_bytes == 0x0 )
+		produced_bytes = &dummy;
+	return dl_internal_convert_instance( dl_ctx, type, packed_instance, packed_instance_size, out_instance, out_instance_size, out_endian, out_ref_size, DL_CONVERT_OUT_REFS_RELATIVE, produced_bytes, "dl_convert_to_relative" );
 }
 
 dl_error_t dl_convert_calc_size( dl_ctx_t       dl_ctx,          dl_typeid_t type,
@@ -937,6 +951,133 @@ dl_error_t dl_convert_calc_size( dl_ctx_t       dl_ctx,          dl_typeid_t typ
 	return dl_convert( dl_ctx, type, packed_instance, packed_instance_size, 0x0, 0, DL_ENDIAN_HOST, out_ptr_size, out_size );
 }
 
+dl_error_t dl_convert_prepare( dl_ctx_t    dl_ctx,
+                               dl_endian_t src_endian, size_t src_ptr_size,
+                               dl_endian_t out_endian, size_t out_ptr_size )
+{
+	if( src_ptr_size != 4 && src_ptr_size != 8 ) return DL_ERROR_INVALID_PARAMETER;
+	if( out_ptr_size != 4 && out_ptr_size != 8 ) return DL_ERROR_INVALID_PARAMETER;
+
+	dl_ptr_size_t src = src_ptr_size == 8 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT;
+	dl_ptr_size_t out = out_ptr_size == 8 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT;
+	return dl_internal_build_convert_plans( dl_ctx, dl_internal_convert_plan_variant( src_endian, src, out_endian, out ) );
+}
+
+dl_error_t dl_instance_load_any( dl_ctx_t       dl_ctx,          dl_typeid_t type,
+                                 void*          instance,        size_t      instance_size,
+                                 unsigned char* packed_instance, size_t      packed_instance_size,
+                                 void**         loaded_instance, size_t*     consumed )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_LOAD, "dl_instance_load_any", dl_internal_trace_type_name( dl_ctx, type ), packed_instance_size );
+
+	dl_data_header      header;
+	size_t              header_size;
+	dl_endian_t         src_endian;
+	const dl_type_desc* root_type;
+	dl_error_t err = dl_internal_read_any_header( dl_ctx, type, packed_instance, packed_instance_size, &header, &header_size, &src_endian, &root_type );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	dl_ptr_size_t src_ptr_size = header.is_64_bit_ptr != 0 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT;
+
+	// ... already in host-format, only ptrs need to be patched ...
+	if( src_endian == DL_ENDIAN_HOST && src_ptr_size == DL_PTR_SIZE_HOST )
+	{
+		if( instance == 0x0 )
+			err = dl_instance_load_inplace( dl_ctx, type, packed_instance, packed_instance_size, loaded_instance, consumed );
+		else
+		{
+			err = dl_instance_load( dl_ctx, type, instance, instance_size, packed_instance, packed_instance_size, consumed );
+			if( err == DL_ERROR_OK )
+				*loaded_instance = instance;
+		}
+		if( err == DL_ERROR_OK )
+			stats.bytes( (size_t)header.instance_size + header_size, (size_t)header.instance_size );
+		return err;
+	}
+
+	unsigned char* packed_data = packed_instance + header_size;
+	if( instance == 0x0 || instance == packed_instance )
+	{
+		// ... in place the output is always written before the source-data it is converted from, as long as ptrs
+		//     do not grow ...
+		if( src_ptr_size < DL_PTR_SIZE_HOST )
+			return DL_ERROR_UNSUPPORTED_OPERATION;
+
+		if( instance == 0x0 )
+		{
+			instance      = packed_data;
+			instance_size = (size_t)header.instance_size;
+		}
+	}
+
+	dl_binary_writer writer;
+	dl_binary_writer_init( &writer, (uint8_t*)instance, instance_size, false, src_endian, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+
+	size_t load_size = 0;
+	err = dl_internal_convert_no_header( dl_ctx, packed_data, packed_data, &writer, &load_size,
+										 src_endian, DL_ENDIAN_HOST, src_ptr_size, DL_PTR_SIZE_HOST,
+										 root_type, 0u, DL_CONVERT_OUT_REFS_LOADED );
+	if( err != DL_ERROR_OK )
+		return err;
+	if( load_size > instance_size )
+		return DL_ERROR_BUFFER_TO_SMALL;
+
+	*loaded_instance = instance;
+	stats.bytes( (size_t)header.instance_size + header_size, load_size );
+	if( consumed )
+		*consumed = (size_t)header.instance_size + header_size;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_instance_load_any_alloc( dl_ctx_t             dl_ctx,          dl_typeid_t type,
+                                       const unsigned char* packed_instance, size_t      packed_instance_size,
+                                       dl_grow_func         grow_func,       void*       grow_ctx,
+                                       void**               loaded_instance, size_t*     loaded_size )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_LOAD, "dl_instance_load_any_alloc", dl_internal_trace_type_name( dl_ctx, type ), packed_instance_size );
+
+	*loaded_instance = 0x0;
+
+	dl_data_header      header;
+	size_t              header_size;
+	dl_endian_t         src_endian;
+	const dl_type_desc* root_type;
+	dl_error_t err = dl_internal_read_any_header( dl_ctx, type, packed_instance, packed_instance_size, &header, &header_size, &src_endian, &root_type );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( grow_func == 0x0 )
+	{
+		grow_func = dl_allocator_grow;
+		grow_ctx  = &dl_ctx->instance_alloc;
+	}
+
+	dl_binary_writer writer;
+	dl_binary_writer_init_grow( &writer, grow_func, grow_ctx, 0, src_endian, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+
+	// ... the packed data is only read, the cast is only to share the code-path with dl_convert_inplace ...
+	unsigned char* packed_data = (unsigned char*)packed_instance + header_size;
+	size_t load_size = 0;
+	err = dl_internal_convert_no_header( dl_ctx, packed_data, packed_data, &writer, &load_size,
+										 src_endian, DL_ENDIAN_HOST,
+										 header.is_64_bit_ptr != 0 ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT, DL_PTR_SIZE_HOST,
+										 root_type, 0u, DL_CONVERT_OUT_REFS_LOADED );
+	if( err == DL_ERROR_OK && writer.out_of_memory )
+		err = DL_ERROR_OUT_OF_INSTANCE_MEMORY;
+	if( err != DL_ERROR_OK )
+	{
+		dl_binary_writer_free( &writer );
+		return err;
+	}
+
+	*loaded_instance = dl_binary_writer_release( &writer );
+	stats.bytes( (size_t)header.instance_size + header_size, load_size );
+	if( loaded_size )
+		*loaded_size = load_size;
+	return DL_ERROR_OK;
+}
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,346 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include "dl_convert_plan.h"
+#include "container/dl_array.h"
+
+struct dl_convert_plan_builder
+{
+	dl_convert_plan_builder( dl_ctx_t ctx, uint32_t variant )
+		: ctx( ctx )
+		, variant( variant )
+		, src_ptr_size( ( variant & 1 ) ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT )
+		, tgt_ptr_size( ( variant & 2 ) ? DL_PTR_SIZE_64BIT : DL_PTR_SIZE_32BIT )
+		, src_endian( ( variant & 4 ) ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE )
+		, tgt_endian( ( variant & 8 ) ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE )
+		, merge_start( 0 )
+		, ops( &ctx->alloc )
+	{}
+
+	dl_ctx_t      ctx;
+	uint32_t      variant;
+	dl_ptr_size_t src_ptr_size;
+	dl_ptr_size_t tgt_ptr_size;
+	dl_endian_t   src_endian;
+	dl_endian_t   tgt_endian;
+
+	/// first op that later ops may be merged into, ops in union-cases must not be merged with ops outside the case.
+	size_t merge_start;
+
+	CArrayDynamic<dl_convert_op> ops;
+};
+
+static dl_convert_op dl_internal_convert_op( dl_convert_op_type op_type, uint32_t src_offset, uint32_t dst_offset, uint32_t count, uint32_t size )
+{
+	dl_convert_op op;
+	op.op         = (uint32_t)op_type;
+	op.type       = 0;
+	op.src_offset = src_offset;
+	op.dst_offset = dst_offset;
+	op.count      = count;
+	op.size       = size;
+	op.type_index = 0;
+	op.plan       = DL_CONVERT_PLAN_NONE;
+	return op;
+}
+
+static dl_error_t dl_internal_convert_plan_emit( dl_convert_plan_builder* b, const dl_convert_op& op )
+{
+	// ... merge with previous copy/swap if they are consecutive in both source and target ...
+	if( ( op.op == DL_CONVERT_OP_COPY || op.op == DL_CONVERT_OP_SWAP ) && b->ops.Len() > b->merge_start )
+	{
+		dl_convert_op& last = b->ops[b->ops.Len() - 1];
+		uint32_t last_bytes = last.count * last.size;
+		if( last.op == op.op && last.size == op.size && last.src_offset + last_bytes == op.src_offset && last.dst_offset + last_bytes == op.dst_offset )
+		{
+			last.count += op.count;
+			return DL_ERROR_OK;
+		}
+	}
+
+	return b->ops.Add( op ) ? DL_ERROR_OK : DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+}
+
+static dl_error_t dl_internal_convert_plan_emit_pod( dl_convert_plan_builder* b, uint32_t src_offset, uint32_t dst_offset, uint32_t count, uint32_t width )
+{
+	if( b->src_endian != b->tgt_endian && width > 1 )
+		return dl_internal_convert_plan_emit( b, dl_internal_convert_op( DL_CONVERT_OP_SWAP, src_offset, dst_offset, count, width ) );
+	return dl_internal_convert_plan_emit( b, dl_internal_convert_op( DL_CONVERT_OP_COPY, src_offset, dst_offset, count * width, 1 ) );
+}
+
+static dl_error_t dl_internal_convert_plan_emit_struct( dl_convert_plan_builder* b, const dl_type_desc* type, uint32_t src_offset, uint32_t dst_offset );
+
+/**
+ * Emit ops for member *member_index of type, *member_index is moved to the last member of a group of bitfields.
+ */
+static dl_error_t dl_internal_convert_plan_emit_member( dl_convert_plan_builder* b, const dl_type_desc* type, uint32_t* member_index, uint32_t src_base, uint32_t dst_base )
+{
+	dl_ctx_t ctx = b->ctx;
+	const dl_member_desc* member = dl_get_type_member( ctx, type, *member_index );
+	uint32_t  src_offset = src_base + member->offset[b->src_ptr_size];
+	uint32_t  dst_offset = dst_base + member->offset[b->tgt_ptr_size];
+	dl_type_t storage    = member->StorageType();
+
+	const dl_type_desc* sub_type = 0x0;
+	if( storage == DL_TYPE_STORAGE_PTR || storage == DL_TYPE_STORAGE_STRUCT )
+	{
+		sub_type = dl_internal_find_type( ctx, member->type_id );
+		if( sub_type == 0x0 )
+			return DL_ERROR_TYPE_NOT_FOUND;
+	}
+	uint32_t sub_type_index = sub_type == 0x0 ? 0 : (uint32_t)( sub_type - ctx->type_descs );
+
+	switch( member->AtomType() )
+	{
+		case DL_TYPE_ATOM_POD:
+		case DL_TYPE_ATOM_INLINE_ARRAY:
+		{
+			uint32_t count = member->AtomType() == DL_TYPE_ATOM_POD ? 1 : member->inline_array_cnt();
+			switch( storage )
+			{
+				case DL_TYPE_STORAGE_STR:
+					return dl_internal_convert_plan_emit( b, dl_internal_convert_op( DL_CONVERT_OP_STR, src_offset, dst_offset, count, 0 ) );
+				case DL_TYPE_STORAGE_PTR:
+				{
+					// ... plan is resolved when this plan is done, the type might reference itself ...
+					dl_convert_op op = dl_internal_convert_op( DL_CONVERT_OP_PTR, src_offset, dst_offset, count, 0 );
+					op.type_index = sub_type_index;
+					return dl_internal_convert_plan_emit( b, op );
+				}
+				case DL_TYPE_STORAGE_STRUCT:
+				{
+					// ... flatten single inline structs into this plan ...
+					if( count == 1 )
+						return dl_internal_convert_plan_emit_struct( b, sub_type, src_offset, dst_offset );
+
+					uint32_t sub_plan;
+					dl_error_t err = dl_internal_convert_plan( ctx, sub_type, b->variant, &sub_plan );
+					if( err != DL_ERROR_OK )
+						return err;
+
+					uint32_t elem_width = ctx->convert_ops[sub_plan].size;
+					if( elem_width != 0 )
+						return dl_internal_convert_plan_emit_pod( b, src_offset, dst_offset, count * sub_type->size[b->src_ptr_size] / elem_width, elem_width );
+
+					dl_convert_op op = dl_internal_convert_op( DL_CONVERT_OP_STRUCT, src_offset, dst_offset, count, sub_type->size[b->src_ptr_size] );
+					op.type_index = sub_type_index;
+					op.plan       = sub_plan;
+					return dl_internal_convert_plan_emit( b, op );
+				}
+				default:
+					DL_ASSERT( member->IsSimplePod() || storage == DL_TYPE_STORAGE_ENUM );
+					return dl_internal_convert_plan_emit_pod( b, src_offset, dst_offset, count, (uint32_t)dl_pod_size( member->type ) );
+			}
+		}
+		break;
+
+		case DL_TYPE_ATOM_ARRAY:
+		{
+			dl_convert_op op = dl_internal_convert_op( DL_CONVERT_OP_ARRAY, src_offset, dst_offset, 1, 0 );
+			op.type       = member->type;
+			op.type_index = sub_type_index;
+			return dl_internal_convert_plan_emit( b, op );
+		}
+
+		case DL_TYPE_ATOM_BITFIELD:
+		{
+			uint32_t first = *member_index;
+			uint32_t end   = first;
+			do { end++; } while( end < type->member_count && dl_get_type_member( ctx, type, end )->AtomType() == DL_TYPE_ATOM_BITFIELD );
+			*member_index = end - 1;
+
+			uint32_t bf_size = member->size[b->src_ptr_size];
+			if( b->src_endian == b->tgt_endian )
+				return dl_internal_convert_plan_emit_pod( b, src_offset, dst_offset, bf_size, 1 );
+
+			dl_error_t err = dl_internal_convert_plan_emit( b, dl_internal_convert_op( DL_CONVERT_OP_BITFIELD, src_offset, dst_offset, end - first, bf_size ) );
+			for( uint32_t i = first; i < end && err == DL_ERROR_OK; ++i )
+			{
+				const dl_member_desc* bf_member = dl_get_type_member( ctx, type, i );
+				uint32_t bits   = bf_member->BitFieldBits();
+				uint32_t offset = bf_member->BitFieldOffset();
+				err = dl_internal_convert_plan_emit( b, dl_internal_convert_op( DL_CONVERT_OP_BITS,
+																				dl_bf_offset( b->src_endian, bf_size, offset, bits ),
+																				dl_bf_offset( b->tgt_endian, bf_size, offset, bits ),
+																				0,
+																				bits ) );
+			}
+			return err;
+		}
+
+		default:
+			DL_ASSERT( false && "Invalid ATOM-type!" );
+			break;
+	}
+
+	return DL_ERROR_OK;
+}
+
+static dl_error_t dl_internal_convert_plan_emit_union( dl_convert_plan_builder* b, const dl_type_desc* type, uint32_t src_offset, uint32_t dst_offset )
+{
+	size_t union_op = b->ops.Len();
+	dl_convert_op op = dl_internal_convert_op( DL_CONVERT_OP_UNION, src_offset, dst_offset, type->member_count, 0 );
+	op.type_index = (uint32_t)( type - b->ctx->type_descs );
+	dl_error_t err = dl_internal_convert_plan_emit( b, op );
+
+	for( uint32_t member_index = 0; member_index < type->member_count && err == DL_ERROR_OK; ++member_index )
+	{
+		const dl_member_desc* member = dl_get_type_member( b->ctx, type, member_index );
+
+		size_t case_op = b->ops.Len();
+		dl_convert_op case_desc = dl_internal_convert_op( DL_CONVERT_OP_CASE, src_offset, dst_offset, 0, 0 );
+		case_desc.type = dl_internal_hash_string( dl_internal_member_name( b->ctx, member ) );
+		err = dl_internal_convert_plan_emit( b, case_desc );
+		b->merge_start = b->ops.Len();
+
+		if( err == DL_ERROR_OK )
+			err = dl_internal_convert_plan_emit_member( b, type, &member_index, src_offset, dst_offset );
+		if( err == DL_ERROR_OK )
+			b->ops[case_op].count = (uint32_t)( b->ops.Len() - case_op - 1 );
+	}
+
+	if( err == DL_ERROR_OK )
+		b->ops[union_op].size = (uint32_t)( b->ops.Len() - union_op - 1 );
+	b->merge_start = b->ops.Len();
+	return err;
+}
+
+static dl_error_t dl_internal_convert_plan_emit_struct( dl_convert_plan_builder* b, const dl_type_desc* type, uint32_t src_offset, uint32_t dst_offset )
+{
+	if( type->flags & DL_TYPE_FLAG_IS_UNION )
+		return dl_internal_convert_plan_emit_union( b, type, src_offset, dst_offset );
+
+	for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
+	{
+		dl_error_t err = dl_internal_convert_plan_emit_member( b, type, &member_index, src_offset, dst_offset );
+		if( err != DL_ERROR_OK )
+			return err;
+	}
+	return DL_ERROR_OK;
+}
+
+/**
+ * Remove all plans built from op_start and forward, used to not leave plans referencing plans that failed to build.
+ */
+static void dl_internal_convert_plan_rollback( dl_ctx_t ctx, uint32_t op_start )
+{
+	for( uint32_t i = op_start; i < ctx->convert_op_count; i += ctx->convert_ops[i].count + 1 )
+	{
+		const dl_convert_op* begin = ctx->convert_ops + i;
+		dl_index_map_remove( &ctx->convert_plan_lookup, dl_internal_scoped_key( begin->type_index, begin->type ), i );
+	}
+	ctx->convert_op_count = op_start;
+}
+
+static dl_error_t dl_internal_convert_plan_store( dl_ctx_t ctx, const dl_convert_op& begin, const CArrayDynamic<dl_convert_op>& ops, uint32_t* plan )
+{
+	uint32_t needed = ctx->convert_op_count + 1 + (uint32_t)ops.Len();
+	if( needed > ctx->convert_op_capacity )
+	{
+		uint32_t new_cap = ctx->convert_op_capacity == 0 ? 64 : ctx->convert_op_capacity * 2;
+		while( new_cap < needed )
+			new_cap *= 2;
+		dl_convert_op* new_ops = (dl_convert_op*)dl_realloc( &ctx->alloc, ctx->convert_ops, sizeof( dl_convert_op ) * new_cap, sizeof( dl_convert_op ) * ctx->convert_op_capacity );
+		if( new_ops == 0x0 )
+			return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+		ctx->convert_ops = new_ops;
+		ctx->convert_op_capacity = new_cap;
+	}
+
+	*plan = ctx->convert_op_count;
+	ctx->convert_ops[*plan] = begin;
+	for( size_t i = 0; i < ops.Len(); ++i )
+		ctx->convert_ops[*plan + 1 + i] = ops[i];
+	ctx->convert_op_count = needed;
+
+	return dl_index_map_insert( &ctx->alloc, &ctx->convert_plan_lookup, dl_internal_scoped_key( begin.type_index, begin.type ), *plan );
+}
+
+dl_error_t dl_internal_convert_plan( dl_ctx_t ctx, const dl_type_desc* type, uint32_t variant, uint32_t* plan )
+{
+	uint32_t type_index = (uint32_t)( type - ctx->type_descs );
+	uint32_t iter = 0;
+	uint32_t found;
+	while( ( found = dl_index_map_find_next( &ctx->convert_plan_lookup, dl_internal_scoped_key( type_index, variant ), &iter ) ) != DL_INDEX_MAP_EMPTY )
+	{
+		if( ctx->convert_ops[found].type_index == type_index && ctx->convert_ops[found].type == variant )
+		{
+			*plan = found;
+			return DL_ERROR_OK;
+		}
+	}
+
+	uint32_t op_start = ctx->convert_op_count;
+
+	dl_convert_plan_builder b( ctx, variant );
+	dl_error_t err = dl_internal_convert_plan_emit_struct( &b, type, 0, 0 );
+	if( err != DL_ERROR_OK )
+	{
+		dl_internal_convert_plan_rollback( ctx, op_start );
+		return err;
+	}
+
+	dl_convert_op begin = dl_internal_convert_op( DL_CONVERT_OP_BEGIN, 0, 0, (uint32_t)b.ops.Len(), 0 );
+	begin.type       = variant;
+	begin.type_index = type_index;
+
+	// ... a type that is converted with one copy or swap of its entire size can be converted in one go in arrays ...
+	if( b.ops.Len() == 1 && type->size[b.src_ptr_size] == type->size[b.tgt_ptr_size] )
+	{
+		const dl_convert_op& op = b.ops[0];
+		if( ( op.op == DL_CONVERT_OP_COPY || op.op == DL_CONVERT_OP_SWAP ) && op.src_offset == 0 && op.dst_offset == 0 && op.count * op.size == type->size[b.src_ptr_size] )
+			begin.size = op.size;
+	}
+
+	uint32_t new_plan;
+	err = dl_internal_convert_plan_store( ctx, begin, b.ops, &new_plan );
+
+	// ... resolve plans of referenced types after this plan is stored so that types referencing themselves find it ...
+	for( uint32_t i = 0; i < begin.count && err == DL_ERROR_OK; ++i )
+	{
+		dl_convert_op op = ctx->convert_ops[new_plan + 1 + i];
+		bool need_plan = op.op == DL_CONVERT_OP_PTR
+					  || ( op.op == DL_CONVERT_OP_ARRAY && ( ( op.type & DL_TYPE_STORAGE_MASK ) == DL_TYPE_STORAGE_PTR || ( op.type & DL_TYPE_STORAGE_MASK ) == DL_TYPE_STORAGE_STRUCT ) );
+		if( !need_plan )
+			continue;
+
+		uint32_t sub_plan;
+		err = dl_internal_convert_plan( ctx, ctx->type_descs + op.type_index, variant, &sub_plan );
+		if( err == DL_ERROR_OK )
+			ctx->convert_ops[new_plan + 1 + i].plan = sub_plan;
+	}
+
+	if( err != DL_ERROR_OK )
+	{
+		dl_internal_convert_plan_rollback( ctx, op_start );
+		return err;
+	}
+
+	*plan = new_plan;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_internal_build_convert_plans( dl_ctx_t ctx, uint32_t variant )
+{
+	for( uint32_t type_index = 0; type_index < ctx->type_count; ++type_index )
+	{
+		uint32_t plan;
+		dl_error_t err = dl_internal_convert_plan( ctx, ctx->type_descs + type_index, variant, &plan );
+
+		// ... type reference a type that is not loaded, it can not be converted until that type is loaded ...
+		if( err == DL_ERROR_TYPE_NOT_FOUND )
+			continue;
+		if( err != DL_ERROR_OK )
+			return err;
+	}
+	return DL_ERROR_OK;
+}
+
+void dl_internal_convert_plans_free( dl_ctx_t ctx )
+{
+	if( ctx->convert_ops )
+		dl_free( &ctx->alloc, ctx->convert_ops );
+	ctx->convert_ops = 0x0;
+	ctx->convert_op_count = 0;
+	ctx->convert_op_capacity = 0;
+	dl_index_map_free( &ctx->alloc, &ctx->convert_plan_lookup );
+}
@@ -0,0 +1,88 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_CONVERT_PLAN_H_INCLUDED
+#define DL_CONVERT_PLAN_H_INCLUDED
+
+#include "dl_types.h"
+
+/**
+ * Op in a conversion-plan. A conversion-plan is a flat list of what to do with the members of a type when converting
+ * it from one endian and ptr-size to another, built the first time a type is converted between two formats or by
+ * dl_convert_prepare() and then cached in the context so that convert do not need to interpret the type-descriptors.
+ * Inline structs and unions are flattened into the plan of the type containing them and consecutive pods are merged
+ * into one op.
+ *
+ * A plan starts with a DL_CONVERT_OP_BEGIN followed by the ops of the plan. All offsets are relative to the start of
+ * the struct the plan is run on.
+ */
+enum dl_convert_op_type
+{
+	DL_CONVERT_OP_BEGIN,    ///< start of plan for type_index, type is the plan-variant, count the number of ops in the plan and size the element-size an array of the type can be converted as in one go, 0 if it can not.
+	DL_CONVERT_OP_COPY,     ///< copy count bytes.
+	DL_CONVERT_OP_SWAP,     ///< byte-swap count elements of size bytes.
+	DL_CONVERT_OP_STR,      ///< count refs to strings.
+	DL_CONVERT_OP_PTR,      ///< count refs to instances of type_index.
+	DL_CONVERT_OP_ARRAY,    ///< array with members of type, type_index is the element type for struct- and ptr-arrays.
+	DL_CONVERT_OP_STRUCT,   ///< inline-array of count structs of type_index, size is the source-size of each struct.
+	DL_CONVERT_OP_UNION,    ///< union of type_index, followed by count DL_CONVERT_OP_CASE. size is the number of ops in all cases.
+	DL_CONVERT_OP_CASE,     ///< ops for the union-member with type-tag type, the count ops following this op.
+	DL_CONVERT_OP_BITFIELD, ///< size bytes of bitfields, followed by count DL_CONVERT_OP_BITS.
+	DL_CONVERT_OP_BITS,     ///< bitfield of size bits moved from bit src_offset to bit dst_offset.
+};
+
+struct dl_convert_op
+{
+	uint32_t op;         ///< dl_convert_op_type
+	uint32_t type;       ///< dl_type_t of member for DL_CONVERT_OP_ARRAY.
+	uint32_t src_offset; ///< offset of the member in the source struct.
+	uint32_t dst_offset; ///< offset of the member in the converted struct.
+	uint32_t count;
+	uint32_t size;
+	uint32_t type_index; ///< index of sub-type in dl_context::type_descs.
+	uint32_t plan;       ///< index of the plan of type_index in dl_context::convert_ops, DL_CONVERT_PLAN_NONE if not needed.
+};
+
+static const uint32_t DL_CONVERT_PLAN_NONE = 0xFFFFFFFF;
+
+/**
+ * Return the variant of conversion-plans to use when converting between the specified formats. Plans that do not change
+ * endian are the same for both endians so they all use the little-endian variant.
+ */
+static inline uint32_t dl_internal_convert_plan_variant( dl_endian_t src_endian, dl_ptr_size_t src_ptr_size, dl_endian_t tgt_endian, dl_ptr_size_t tgt_ptr_size )
+{
+	if( src_endian == tgt_endian )
+		src_endian = tgt_endian = DL_ENDIAN_LITTLE;
+
+	return   (uint32_t)src_ptr_size
+		 | ( (uint32_t)tgt_ptr_size << 1 )
+		 | ( ( src_endian == DL_ENDIAN_BIG ? 1u : 0u ) << 2 )
+		 | ( ( tgt_endian == DL_ENDIAN_BIG ? 1u : 0u ) << 3 );
+}
+
+/**
+ * Find the conversion-plan for type in variant, building it and the plans of all types it reference if not built yet.
+ *
+ * @param ctx dl-context containing all types used in type.
+ * @param type type to find plan for.
+ * @param variant plan-variant, see dl_internal_convert_plan_variant().
+ * @param plan set to index of the DL_CONVERT_OP_BEGIN of the plan in ctx->convert_ops.
+ *
+ * @return DL_ERROR_OK on success, DL_ERROR_TYPE_NOT_FOUND if type reference a type that is not loaded or
+ *         DL_ERROR_OUT_OF_LIBRARY_MEMORY if the plan could not be allocated.
+ */
+dl_error_t dl_internal_convert_plan( dl_ctx_t ctx, const dl_type_desc* type, uint32_t variant, uint32_t* plan );
+
+/**
+ * Build the conversion-plans in variant of all types loaded in ctx, types referencing types that are not loaded are
+ * skipped.
+ *
+ * @return DL_ERROR_OK on success or DL_ERROR_OUT_OF_LIBRARY_MEMORY if the plans could not be allocated.
+ */
+dl_error_t dl_internal_build_convert_plans( dl_ctx_t ctx, uint32_t variant );
+
+/**
+ * Free all conversion-plans built in ctx.
+ */
+void dl_internal_convert_plans_free( dl_ctx_t ctx );
+
+#endif // DL_CONVERT_PLAN_H_INCLUDED
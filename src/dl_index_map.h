@@ -0,0 +1,193 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_INDEX_MAP_H_INCLUDED
+#define DL_INDEX_MAP_H_INCLUDED
+
+#include <stdint.h>
+#include "dl_alloc.h"
+
+/**
+ * Open-addressing hash-map from an uint32_t key ( usually a typeid or name-hash ) to an uint32_t index into
+ * one of the arrays in dl_context. Linear probing is used and the table is kept at a load-factor of at most 50%.
+ *
+ * Multiple entries with the same key are allowed, dl_index_map_find() will return them in insertion-order. This
+ * is used to keep the "first loaded wins"-semantics of the old linear searches.
+ */
+struct dl_index_map_entry
+{
+	uint32_t key;
+	uint32_t value;
+};
+
+struct dl_index_map
+{
+	dl_index_map_entry* entries;
+	uint32_t            capacity; ///< number of entries, always 0 or a power of 2.
+	uint32_t            count;
+};
+
+static const uint32_t DL_INDEX_MAP_EMPTY = 0xFFFFFFFF;
+
+static inline uint32_t dl_index_map_slot( uint32_t key, uint32_t capacity )
+{
+	// ... keys are mostly djb2-hashes with bad distribution in the low bits, mix them up a bit ...
+	uint32_t h = key * 2654435761u;
+	h ^= h >> 16;
+	return h & ( capacity - 1 );
+}
+
+/**
+ * Find the first value stored for key, starting the search at *iter.
+ * *iter should be set to 0 before the first call and can be passed again to find the next value with the same key.
+ *
+ * @return the found value or DL_INDEX_MAP_EMPTY if no more values was found.
+ */
+static inline uint32_t dl_index_map_find_next( const dl_index_map* map, uint32_t key, uint32_t* iter )
+{
+	if( map->count == 0 )
+		return DL_INDEX_MAP_EMPTY;
+
+	uint32_t mask = map->capacity - 1;
+	uint32_t slot = ( dl_index_map_slot( key, map->capacity ) + *iter ) & mask;
+	while( true )
+	{
+		const dl_index_map_entry* e = &map->entries[slot];
+		if( e->value == DL_INDEX_MAP_EMPTY )
+			return DL_INDEX_MAP_EMPTY;
+
+		slot = ( slot + 1 ) & mask;
+		++*iter;
+
+		if( e->key == key )
+			return e->value;
+	}
+}
+
+/**
+ * Find the first value stored for key.
+ *
+ * @return the found value or DL_INDEX_MAP_EMPTY if key is not in map.
+ */
+static inline uint32_t dl_index_map_find( const dl_index_map* map, uint32_t key )
+{
+	uint32_t iter = 0;
+	return dl_index_map_find_next( map, key, &iter );
+}
+
+static inline void dl_index_map_insert_no_grow( dl_index_map* map, uint32_t key, uint32_t value )
+{
+	uint32_t mask = map->capacity - 1;
+	uint32_t slot = dl_index_map_slot( key, map->capacity );
+	while( map->entries[slot].value != DL_INDEX_MAP_EMPTY )
+		slot = ( slot + 1 ) & mask;
+
+	map->entries[slot].key   = key;
+	map->entries[slot].value = value;
+	++map->count;
+}
+
+/**
+ * Make sure that map can hold at least count entries without growing.
+ */
+static inline dl_error_t dl_index_map_reserve( dl_allocator* alloc, dl_index_map* map, uint32_t count )
+{
+	uint32_t new_cap = map->capacity == 0 ? 16 : map->capacity;
+	while( new_cap < count * 2 )
+		new_cap *= 2;
+
+	if( new_cap == map->capacity )
+		return DL_ERROR_OK;
+
+	dl_index_map_entry* new_entries = (dl_index_map_entry*)dl_alloc( alloc, sizeof( dl_index_map_entry ) * new_cap );
+	if( new_entries == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	memset( new_entries, 0xFF, sizeof( dl_index_map_entry ) * new_cap );
+
+	dl_index_map old = *map;
+	map->entries  = new_entries;
+	map->capacity = new_cap;
+	map->count    = 0;
+
+	// ... re-insert in old probe-order to keep insertion order between equal keys ...
+	for( uint32_t i = 0; i < old.capacity; ++i )
+	{
+		// start at an empty slot so that no chain is split when wrapping around.
+		uint32_t slot = i;
+		if( old.entries[slot].value != DL_INDEX_MAP_EMPTY )
+			continue;
+		for( uint32_t j = 1; j <= old.capacity; ++j )
+		{
+			slot = ( i + j ) & ( old.capacity - 1 );
+			if( old.entries[slot].value != DL_INDEX_MAP_EMPTY )
+				dl_index_map_insert_no_grow( map, old.entries[slot].key, old.entries[slot].value );
+		}
+		break;
+	}
+
+	if( old.entries )
+		dl_free( alloc, old.entries );
+	return DL_ERROR_OK;
+}
+
+/**
+ * Insert value for key in map, growing the map if needed. Existing values for key are kept and will be found before this one.
+ */
+static inline dl_error_t dl_index_map_insert( dl_allocator* alloc, dl_index_map* map, uint32_t key, uint32_t value )
+{
+	dl_error_t err = dl_index_map_reserve( alloc, map, map->count + 1 );
+	if( err != DL_ERROR_OK )
+		return err;
+	dl_index_map_insert_no_grow( map, key, value );
+	return DL_ERROR_OK;
+}
+
+/**
+ * Remove the entry with key and value from map if it exist.
+ */
+static inline void dl_index_map_remove( dl_index_map* map, uint32_t key, uint32_t value )
+{
+	if( map->count == 0 )
+		return;
+
+	uint32_t mask = map->capacity - 1;
+	uint32_t slot = dl_index_map_slot( key, map->capacity );
+	while( map->entries[slot].key != key || map->entries[slot].value != value )
+	{
+		if( map->entries[slot].value == DL_INDEX_MAP_EMPTY )
+			return;
+		slot = ( slot + 1 ) & mask;
+	}
+
+	// ... backward-shift following entries into the hole so no probe-chain is broken ...
+	uint32_t hole = slot;
+	while( true )
+	{
+		slot = ( slot + 1 ) & mask;
+		dl_index_map_entry* e = &map->entries[slot];
+		if( e->value == DL_INDEX_MAP_EMPTY )
+			break;
+
+		uint32_t home = dl_index_map_slot( e->key, map->capacity );
+		// ... move e if its home-slot is not in the range (hole, slot] ...
+		if( ( ( slot - home ) & mask ) >= ( ( slot - hole ) & mask ) )
+		{
+			map->entries[hole] = *e;
+			hole = slot;
+		}
+	}
+	map->entries[hole].key   = DL_INDEX_MAP_EMPTY;
+	map->entries[hole].value = DL_INDEX_MAP_EMPTY;
+	--map->count;
+}
+
+static inline void dl_index_map_free( dl_allocator* alloc, dl_index_map* map )
+{
+	if( map->entries )
+		dl_free( alloc, map->entries );
+	map->entries  = 0x0;
+	map->capacity = 0;
+	map->count    = 0;
+}
+
+#endif // DL_INDEX_MAP_H_INCLUDED
@@ -1,39 +1,62 @@
 #include "dl_patch_ptr.h"
 #include "dl_types.h"
+#include "dl_ptr_map.h"
 
+/**
+ * Set of already patched sub-instances, used so that instances pointed to from more than one place only get patched
+ * once. The root instance is tracked separately so that instances without any pointers never allocate.
+ */
 struct dl_patched_ptrs
 {
-	uint8_t* addresses[128];
-	unsigned int next_addr;
+	uint8_t*   root;
+	dl_ptr_map addresses;
+	dl_error_t err;
+	uint64_t   ptr_count; ///< number of non-null ptrs patched.
 
-	dl_patched_ptrs()
-		: next_addr(0)
-	{}
+	dl_patched_ptrs( dl_allocator* alloc, uint8_t* root_instance )
+		: root( root_instance )
+		, err( DL_ERROR_OK )
+		, ptr_count( 0 )
+	{
+		dl_ptr_map_init( &addresses, alloc );
+	}
 
-	void add( uint8_t* addr )
+	~dl_patched_ptrs()
 	{
-		DL_ASSERT( next_addr < DL_ARRAY_LENGTH( addresses ) );
-		DL_ASSERT( !patched( addr ) );
-		addresses[next_addr++] = addr;
+		dl_ptr_map_free( &addresses );
 	}
 
-	bool patched( uint8_t* addr )
+	/**
+	 * Mark addr as patched.
+	 *
+	 * @return false if addr was already patched or could not be tracked.
+	 */
+	bool add( uint8_t* addr )
 	{
-		for( unsigned int i = 0; i < next_addr; ++i )
-			if( addr == addresses[i] )
-				return true;
-		return false;
+		if( addr == root || dl_ptr_map_find( &addresses, (uintptr_t)addr ) != DL_PTR_MAP_EMPTY )
+			return false;
+
+		dl_error_t add_err = dl_ptr_map_insert( &addresses, (uintptr_t)addr, 0 );
+		if( add_err != DL_ERROR_OK )
+		{
+			err = add_err;
+			return false;
+		}
+		return true;
 	}
 };
 
-static uintptr_t dl_internal_patch_ptr( uint8_t* ptrptr, uintptr_t patch_distance )
+static uintptr_t dl_internal_patch_ptr( uint8_t* ptrptr, uintptr_t patch_distance, dl_patched_ptrs* patched_ptrs )
 {
 	union { uint8_t* src; uintptr_t* ptr; };
 	src = ptrptr;
 	if ( *ptr == DL_NULL_PTR_OFFSET[DL_PTR_SIZE_HOST] )
 		*ptr = 0x0;
 	else
+	{
 		*ptr = *ptr + patch_distance;
+		++patched_ptrs->ptr_count;
+	}
 	return *ptr;
 }
 
@@ -51,22 +74,25 @@ static void dl_internal_patch_ptr_instance( dl_ctx_t            ctx,
 											uintptr_t           patch_distance,
 											dl_patched_ptrs*    patched_ptrs )
 {
-	uintptr_t offset = dl_internal_patch_ptr( ptr_data, patch_distance );
+	uintptr_t offset = dl_internal_patch_ptr( ptr_data, patch_distance, patched_ptrs );
 	if( offset == 0x0 )
 		return;
 
+	// ... instances without subdata has nothing to patch, no need to track them ...
+	if( ( sub_type->flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
+		return;
+
 	uint8_t* ptr = (uint8_t*)base_address + offset;
-	if( patched_ptrs->patched( ptr ) )
+	if( !patched_ptrs->add( ptr ) )
 		return;
 
-	patched_ptrs->add( ptr );
 	dl_internal_patch_struct( ctx, sub_type, ptr, base_address, patch_distance, patched_ptrs );
 }
 
-static void dl_internal_patch_str_array( uint8_t* array_data, uint32_t count, uintptr_t patch_distance )
+static void dl_internal_patch_str_array( uint8_t* array_data, uint32_t count, uintptr_t patch_distance, dl_patched_ptrs* patched_ptrs )
 {
 	for( uint32_t index = 0; index < count; ++index )
-		dl_internal_patch_ptr( array_data + index * sizeof(char*), patch_distance );
+		dl_internal_patch_ptr( array_data + index * sizeof(char*), patch_distance, patched_ptrs );
 }
 
 static void dl_internal_patch_ptr_array( dl_ctx_t            ctx,
@@ -89,7 +115,7 @@ static void dl_internal_patch_struct_array( dl_ctx_t            ctx,
 											uintptr_t           patch_distance,
 											dl_patched_ptrs*    patched_ptrs )
 {
-	uint32_t size = dl_internal_align_up( type->size[DL_PTR_SIZE_HOST], type->alignment[DL_PTR_SIZE_HOST] );
+	size_t size = dl_internal_align_up( (size_t)type->size[DL_PTR_SIZE_HOST], type->alignment[DL_PTR_SIZE_HOST] );
 	for( uint32_t index = 0; index < count; ++index )
 	{
 		uint8_t* struct_data = array_data + index * size;
@@ -114,7 +140,7 @@ static void dl_internal_patch_member( dl_ctx_t              ctx,
 			switch( storage_type )
 			{
 				case DL_TYPE_STORAGE_STR:
-					dl_internal_patch_ptr( member_data, patch_distance );
+					dl_internal_patch_ptr( member_data, patch_distance, patched_ptrs );
 				break;
 				case DL_TYPE_STORAGE_PTR:
 					dl_internal_patch_ptr_instance( ctx,
@@ -143,7 +169,7 @@ static void dl_internal_patch_member( dl_ctx_t              ctx,
 			switch( storage_type )
 			{
 				case DL_TYPE_STORAGE_STR:
-					dl_internal_patch_str_array( member_data, member->inline_array_cnt(), patch_distance );
+					dl_internal_patch_str_array( member_data, member->inline_array_cnt(), patch_distance, patched_ptrs );
 				break;
 				case DL_TYPE_STORAGE_PTR:
 					dl_internal_patch_ptr_array( ctx,
@@ -171,11 +197,9 @@ static void dl_internal_patch_member( dl_ctx_t              ctx,
 
 		case DL_TYPE_ATOM_ARRAY:
 		{
-			uintptr_t offset = dl_internal_patch_ptr( member_data, patch_distance );
+			uintptr_t offset = dl_internal_patch_ptr( member_data, patch_distance, patched_ptrs );
 
-			union { uint8_t* src; uint32_t ptr; };
-			src = member_data + sizeof( void* );
-			uint32_t count = *src;
+			uint32_t count = *(uint32_t*)( member_data + sizeof( void* ) );
 
 			if( count != 0 )
 			{
@@ -183,7 +207,7 @@ static void dl_internal_patch_member( dl_ctx_t              ctx,
 				switch( storage_type )
 				{
 					case DL_TYPE_STORAGE_STR:
-						dl_internal_patch_str_array( array_data, count, patch_distance );
+						dl_internal_patch_str_array( array_data, count, patch_distance, patched_ptrs );
 					break;
 					case DL_TYPE_STORAGE_PTR:
 						dl_internal_patch_ptr_array( ctx,
@@ -214,6 +238,74 @@ static void dl_internal_patch_member( dl_ctx_t              ctx,
 	}
 }
 
+static void dl_internal_patch_union( dl_ctx_t            ctx,
+									 const dl_type_desc* type,
+									 uint8_t*            union_data,
+									 uintptr_t           base_address,
+									 uintptr_t           patch_distance,
+									 dl_patched_ptrs*    patched_ptrs )
+{
+	size_t max_member_size = dl_internal_largest_member_size( ctx, type, DL_PTR_SIZE_HOST );
+
+	// find member index from union type ...
+	uint32_t union_type = *((uint32_t*)(union_data + max_member_size));
+	const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( ctx, type, union_type );
+	dl_internal_patch_member( ctx, member, union_data + member->offset[DL_PTR_SIZE_HOST], base_address, patch_distance, patched_ptrs );
+}
+
+static void dl_internal_patch_run_program( dl_ctx_t           ctx,
+										   const dl_patch_op* ops,
+										   uint32_t           op_count,
+										   uint8_t*           struct_data,
+										   uintptr_t          base_address,
+										   uintptr_t          patch_distance,
+										   dl_patched_ptrs*   patched_ptrs )
+{
+	for( uint32_t op_index = 0; op_index < op_count; ++op_index )
+	{
+		const dl_patch_op* op = ops + op_index;
+		uint8_t* data = struct_data + op->offset;
+		switch( op->op )
+		{
+			case DL_PATCH_OP_STR:
+				dl_internal_patch_str_array( data, op->count, patch_distance, patched_ptrs );
+				break;
+			case DL_PATCH_OP_PTR:
+				dl_internal_patch_ptr_array( ctx, data, op->count, ctx->type_descs + op->type_index, base_address, patch_distance, patched_ptrs );
+				break;
+			case DL_PATCH_OP_STRUCT:
+				dl_internal_patch_struct_array( ctx, ctx->type_descs + op->type_index, data, op->count, base_address, patch_distance, patched_ptrs );
+				break;
+			case DL_PATCH_OP_UNION:
+				dl_internal_patch_union( ctx, ctx->type_descs + op->type_index, data, base_address, patch_distance, patched_ptrs );
+				break;
+			default:
+			{
+				uintptr_t offset = dl_internal_patch_ptr( data, patch_distance, patched_ptrs );
+				uint32_t  count  = *(uint32_t*)( data + sizeof( void* ) );
+				if( count == 0 )
+					break;
+
+				uint8_t* array_data = (uint8_t*)base_address + offset;
+				switch( op->op )
+				{
+					case DL_PATCH_OP_ARRAY_STR:
+						dl_internal_patch_str_array( array_data, count, patch_distance, patched_ptrs );
+						break;
+					case DL_PATCH_OP_ARRAY_PTR:
+						dl_internal_patch_ptr_array( ctx, array_data, count, ctx->type_descs + op->type_index, base_address, patch_distance, patched_ptrs );
+						break;
+					case DL_PATCH_OP_ARRAY_STRUCT:
+						dl_internal_patch_struct_array( ctx, ctx->type_descs + op->type_index, array_data, count, base_address, patch_distance, patched_ptrs );
+						break;
+					default:
+						DL_ASSERT( false && "unknown patch-op!" );
+				}
+			}
+		}
+	}
+}
+
 void dl_internal_patch_struct( dl_ctx_t            ctx,
 							   const dl_type_desc* type,
 							   uint8_t*            struct_data,
@@ -221,67 +313,173 @@ void dl_internal_patch_struct( dl_ctx_t            ctx,
 							   uintptr_t           patch_distance,
 							   dl_patched_ptrs*    patched_ptrs )
 {
-	if( type->flags & DL_TYPE_FLAG_HAS_SUBDATA )
+	if( ( type->flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
+		return;
+
+	const dl_type_cache* cache = &ctx->type_caches[ type - ctx->type_descs ];
+	if( cache->patch_op_start != DL_PATCH_PROGRAM_NOT_BUILT )
 	{
-		if( type->flags & DL_TYPE_FLAG_IS_UNION )
-		{
-			// TODO: extract to helper-function?
-			size_t max_member_size = dl_internal_largest_member_size( ctx, type, DL_PTR_SIZE_HOST );
+		dl_internal_patch_run_program( ctx, ctx->patch_ops + cache->patch_op_start, cache->patch_op_count, struct_data, base_address, patch_distance, patched_ptrs );
+		return;
+	}
 
-			// find member index from union type ...
-			uint32_t union_type = *((uint32_t*)(struct_data + max_member_size));
-			const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( ctx, type, union_type );
-			dl_internal_patch_member( ctx, member, struct_data + member->offset[DL_PTR_SIZE_HOST], base_address, patch_distance, patched_ptrs );
-		}
-		else
+	// ... no program built for type, i.e. while loading the typelib, interpret the type-desc ...
+	if( type->flags & DL_TYPE_FLAG_IS_UNION )
+		dl_internal_patch_union( ctx, type, struct_data, base_address, patch_distance, patched_ptrs );
+	else
+	{
+		for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
 		{
-			for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
-			{
-				const dl_member_desc* member = dl_get_type_member( ctx, type, member_index );
-				dl_internal_patch_member( ctx, member, struct_data + member->offset[DL_PTR_SIZE_HOST], base_address, patch_distance, patched_ptrs );
-			}
+			const dl_member_desc* member = dl_get_type_member( ctx, type, member_index );
+			dl_internal_patch_member( ctx, member, struct_data + member->offset[DL_PTR_SIZE_HOST], base_address, patch_distance, patched_ptrs );
 		}
 	}
 }
 
-void dl_internal_patch_member( dl_ctx_t              ctx,
-							   const dl_member_desc* member,
-							   uint8_t*              member_data,
-							   uintptr_t             base_address,
-							   uintptr_t             patch_distance )
+dl_error_t dl_internal_patch_member( dl_ctx_t              ctx,
+									 const dl_member_desc* member,
+									 uint8_t*              member_data,
+									 uintptr_t             base_address,
+									 uintptr_t             patch_distance )
 {
-	dl_patched_ptrs patched;
+	dl_patched_ptrs patched( &ctx->alloc, 0x0 );
 	dl_internal_patch_member( ctx, member, member_data, base_address, patch_distance, &patched );
+	if( ctx->stats_mode != DL_STATS_NONE )
+		ctx->stats.ptrs_patched += patched.ptr_count;
+	return patched.err;
 }
 
-void dl_internal_patch_instance( dl_ctx_t            ctx,
-								 const dl_type_desc* type,
-								 uint8_t*            instance,
-								 uintptr_t           base_address,
-								 uintptr_t           patch_distance )
+dl_error_t dl_internal_patch_instance( dl_ctx_t            ctx,
+									   const dl_type_desc* type,
+									   uint8_t*            instance,
+									   uintptr_t           base_address,
+									   uintptr_t           patch_distance )
 {
-	dl_patched_ptrs patched;
-	patched.add( instance );
+	dl_patched_ptrs patched( &ctx->alloc, instance );
+	dl_internal_patch_struct( ctx, type, instance, base_address, patch_distance, &patched );
+	if( ctx->stats_mode != DL_STATS_NONE )
+		ctx->stats.ptrs_patched += patched.ptr_count;
+	return patched.err;
+}
 
-	if( type->flags & DL_TYPE_FLAG_IS_UNION )
+static bool dl_internal_patch_program_emit( dl_ctx_t ctx, dl_patch_op_type op_type, uint32_t offset, uint32_t count, const dl_type_desc* sub_type )
+{
+	if( ctx->patch_op_count == ctx->patch_op_capacity )
 	{
-		// TODO: extract to helper-function?
-		size_t max_member_size = dl_internal_largest_member_size( ctx, type, DL_PTR_SIZE_HOST );
-
-		// find member index from union type ...
-		uint32_t union_type = *((uint32_t*)(instance + max_member_size));
-		const dl_member_desc* member = dl_internal_find_member_desc_by_name_hash( ctx, type, union_type );
-		uint8_t*   member_data = instance + member->offset[DL_PTR_SIZE_HOST];
-		dl_internal_patch_member( ctx, member, member_data, base_address, patch_distance, &patched );
+		uint32_t new_cap = ctx->patch_op_capacity == 0 ? 64 : ctx->patch_op_capacity * 2;
+		dl_patch_op* new_ops = (dl_patch_op*)dl_realloc( &ctx->alloc, ctx->patch_ops, sizeof( dl_patch_op ) * new_cap, sizeof( dl_patch_op ) * ctx->patch_op_capacity );
+		if( new_ops == 0x0 )
+			return false;
+		ctx->patch_ops = new_ops;
+		ctx->patch_op_capacity = new_cap;
 	}
-	else
+
+	dl_patch_op* op = ctx->patch_ops + ctx->patch_op_count++;
+	op->op         = (uint32_t)op_type;
+	op->offset     = offset;
+	op->count      = count;
+	op->type_index = sub_type == 0x0 ? 0 : (uint32_t)( sub_type - ctx->type_descs );
+	return true;
+}
+
+/**
+ * Emit ops for all pointers in type, located at offset, to ctx->patch_ops.
+ *
+ * @return false if type referenced a type that is not loaded yet or if out of memory.
+ */
+static bool dl_internal_patch_program_emit_struct( dl_ctx_t ctx, const dl_type_desc* type, uint32_t offset )
+{
+	if( type->flags & DL_TYPE_FLAG_IS_UNION )
+		return dl_internal_patch_program_emit( ctx, DL_PATCH_OP_UNION, offset, 1, type );
+
+	for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
 	{
-		for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
+		const dl_member_desc* member = dl_get_type_member( ctx, type, member_index );
+		uint32_t member_offset = offset + member->offset[DL_PTR_SIZE_HOST];
+		dl_type_t storage = member->StorageType();
+
+		const dl_type_desc* sub_type = 0x0;
+		if( storage == DL_TYPE_STORAGE_PTR || storage == DL_TYPE_STORAGE_STRUCT )
 		{
-			const dl_member_desc* member = dl_get_type_member( ctx, type, member_index );
-			uint8_t*   member_data = instance + member->offset[DL_PTR_SIZE_HOST];
+			sub_type = dl_internal_find_type( ctx, member->type_id );
+			if( sub_type == 0x0 )
+				return false;
+		}
 
-			dl_internal_patch_member( ctx, member, member_data, base_address, patch_distance, &patched );
+		bool ok = true;
+		switch( member->AtomType() )
+		{
+			case DL_TYPE_ATOM_POD:
+			case DL_TYPE_ATOM_INLINE_ARRAY:
+			{
+				uint32_t count = member->AtomType() == DL_TYPE_ATOM_POD ? 1 : member->inline_array_cnt();
+				switch( storage )
+				{
+					case DL_TYPE_STORAGE_STR: ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_STR, member_offset, count, 0x0 ); break;
+					case DL_TYPE_STORAGE_PTR: ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_PTR, member_offset, count, sub_type ); break;
+					case DL_TYPE_STORAGE_STRUCT:
+						if( ( sub_type->flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
+							break;
+						// ... flatten single inline structs into this program ...
+						if( count == 1 )
+							ok = dl_internal_patch_program_emit_struct( ctx, sub_type, member_offset );
+						else
+							ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_STRUCT, member_offset, count, sub_type );
+						break;
+					default:
+						break;
+				}
+			}
+			break;
+			case DL_TYPE_ATOM_ARRAY:
+			{
+				switch( storage )
+				{
+					case DL_TYPE_STORAGE_STR:    ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_ARRAY_STR,    member_offset, 1, 0x0 ); break;
+					case DL_TYPE_STORAGE_PTR:    ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_ARRAY_PTR,    member_offset, 1, sub_type ); break;
+					case DL_TYPE_STORAGE_STRUCT:
+						if( sub_type->flags & DL_TYPE_FLAG_HAS_SUBDATA )
+							ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_ARRAY_STRUCT, member_offset, 1, sub_type );
+						else
+							ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_STR, member_offset, 1, 0x0 );
+						break;
+					default:
+						// ... array of pods, only the data-pointer need patching ...
+						ok = dl_internal_patch_program_emit( ctx, DL_PATCH_OP_STR, member_offset, 1, 0x0 );
+						break;
+				}
+			}
+			break;
+			default:
+				break;
 		}
+
+		if( !ok )
+			return false;
+	}
+	return true;
+}
+
+void dl_internal_build_patch_programs( dl_ctx_t ctx )
+{
+	for( uint32_t type_index = 0; type_index < ctx->type_count; ++type_index )
+	{
+		const dl_type_desc* type = ctx->type_descs + type_index;
+		dl_type_cache* cache = ctx->type_caches + type_index;
+		if( cache->patch_op_start != DL_PATCH_PROGRAM_NOT_BUILT )
+			continue;
+		if( ( type->flags & DL_TYPE_FLAG_HAS_SUBDATA ) == 0 )
+			continue;
+
+		uint32_t op_start = ctx->patch_op_count;
+		if( !dl_internal_patch_program_emit_struct( ctx, type, 0 ) )
+		{
+			// ... type is not complete, it will be retried when the next typelib is loaded ...
+			ctx->patch_op_count = op_start;
+			continue;
+		}
+
+		cache->patch_op_start = op_start;
+		cache->patch_op_count = ctx->patch_op_count - op_start;
 	}
 }
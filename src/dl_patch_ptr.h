@@ -3,6 +3,30 @@
 
 #include "dl_types.h"
 
+/**
+ * Op in a patch-program. A patch-program is a flat list of all pointers in a type that need patching, built once per
+ * type so that load do not need to interpret the type-descriptors. Inline structs are flattened into the program of
+ * the type containing them.
+ */
+enum dl_patch_op_type
+{
+	DL_PATCH_OP_STR,          ///< count pointers to strings, or pod-array-data, only the pointer itself needs patching.
+	DL_PATCH_OP_PTR,          ///< count pointers to instances of type_index.
+	DL_PATCH_OP_STRUCT,       ///< inline-array of count structs of type_index.
+	DL_PATCH_OP_UNION,        ///< union of type_index, the member to patch is decided by the type-tag.
+	DL_PATCH_OP_ARRAY_STR,    ///< array of strings.
+	DL_PATCH_OP_ARRAY_PTR,    ///< array of pointers to instances of type_index.
+	DL_PATCH_OP_ARRAY_STRUCT, ///< array of structs of type_index.
+};
+
+struct dl_patch_op
+{
+	uint32_t op;         ///< dl_patch_op_type
+	uint32_t offset;     ///< offset to patch, from the start of the struct the program is run on.
+	uint32_t count;      ///< number of consecutive elements for inline arrays.
+	uint32_t type_index; ///< index of sub-type in dl_context::type_descs.
+};
+
 /**
  * Patch all pointers in an instance.
  *
@@ -11,12 +35,14 @@
  * @param instance pointer to instance to patch.
  * @param base_address base address to patch the pointers against.
  * @param patch_distance distance in bytes to patch all pointers.
+ *
+ * @return DL_ERROR_OUT_OF_LIBRARY_MEMORY if the set of patched sub-instances could not be allocated.
  */
-void dl_internal_patch_instance( dl_ctx_t            ctx,
-								 const dl_type_desc* type,
-								 uint8_t*            instance,
-								 uintptr_t           base_address,
-								 uintptr_t           patch_distance );
+dl_error_t dl_internal_patch_instance( dl_ctx_t            ctx,
+									   const dl_type_desc* type,
+									   uint8_t*            instance,
+									   uintptr_t           base_address,
+									   uintptr_t           patch_distance );
 
 /**
  * Patch all pointers in a member.
@@ -26,11 +52,22 @@ void dl_internal_patch_instance( dl_ctx_t            ctx,
  * @param member_data pointer to member to patch.
  * @param base_address base address to patch the pointers against.
  * @param patch_distance distance in bytes to patch all pointers.
+ *
+ * @return DL_ERROR_OUT_OF_LIBRARY_MEMORY if the set of patched sub-instances could not be allocated.
+ */
+dl_error_t dl_internal_patch_member( dl_ctx_t              ctx,
+									 const dl_member_desc* member,
+									 uint8_t*              member_data,
+									 uintptr_t             base_address,
+									 uintptr_t             patch_distance );
+
+/**
+ * Build patch-programs, flat lists of all pointers that need patching, for all types in ctx that do not have one.
+ * Types that reference types that are not loaded yet will be patched by interpreting the type-descs until a
+ * later call can build its program.
+ *
+ * @param ctx dl-context to build programs for.
  */
-void dl_internal_patch_member( dl_ctx_t                ctx,
-								 const dl_member_desc* member,
-								 uint8_t*              member_data,
-								 uintptr_t             base_address,
-								 uintptr_t             patch_distance );
+void dl_internal_build_patch_programs( dl_ctx_t ctx );
 
 #endif // DL_PATCH_PTR_H_INCLUDED
@@ -0,0 +1,120 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_PTR_MAP_H_INCLUDED
+#define DL_PTR_MAP_H_INCLUDED
+
+#include <stdint.h>
+#include "dl_alloc.h"
+
+/**
+ * Open-addressing hash-map from a pointer or offset to an uintptr_t, used to keep track of already written or
+ * visited sub-instances. Grows without limit on the allocator it was initialized with.
+ *
+ * (uintptr_t)-1 is used to mark empty slots and can not be used as a key.
+ */
+struct dl_ptr_map_entry
+{
+	uintptr_t key;
+	uintptr_t value;
+};
+
+struct dl_ptr_map
+{
+	dl_allocator*     alloc;
+	dl_ptr_map_entry* entries;
+	size_t            capacity; ///< number of entries, always 0 or a power of 2.
+	size_t            count;
+};
+
+static const uintptr_t DL_PTR_MAP_EMPTY = (uintptr_t)-1;
+
+static inline void dl_ptr_map_init( dl_ptr_map* map, dl_allocator* alloc )
+{
+	map->alloc    = alloc;
+	map->entries  = 0x0;
+	map->capacity = 0;
+	map->count    = 0;
+}
+
+static inline void dl_ptr_map_free( dl_ptr_map* map )
+{
+	if( map->entries )
+		dl_free( map->alloc, map->entries );
+	map->entries  = 0x0;
+	map->capacity = 0;
+	map->count    = 0;
+}
+
+static inline size_t dl_ptr_map_slot( uintptr_t key, size_t capacity )
+{
+	uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+	return (size_t)( h ^ ( h >> 32 ) ) & ( capacity - 1 );
+}
+
+/**
+ * Find value stored for key.
+ *
+ * @return the stored value or DL_PTR_MAP_EMPTY if key is not in map.
+ */
+static inline uintptr_t dl_ptr_map_find( const dl_ptr_map* map, uintptr_t key )
+{
+	if( map->count == 0 )
+		return DL_PTR_MAP_EMPTY;
+
+	size_t mask = map->capacity - 1;
+	size_t slot = dl_ptr_map_slot( key, map->capacity );
+	while( true )
+	{
+		const dl_ptr_map_entry* e = &map->entries[slot];
+		if( e->key == key )
+			return e->value;
+		if( e->key == DL_PTR_MAP_EMPTY )
+			return DL_PTR_MAP_EMPTY;
+		slot = ( slot + 1 ) & mask;
+	}
+}
+
+static inline void dl_ptr_map_insert_no_grow( dl_ptr_map* map, uintptr_t key, uintptr_t value )
+{
+	size_t mask = map->capacity - 1;
+	size_t slot = dl_ptr_map_slot( key, map->capacity );
+	while( map->entries[slot].key != DL_PTR_MAP_EMPTY && map->entries[slot].key != key )
+		slot = ( slot + 1 ) & mask;
+
+	if( map->entries[slot].key == DL_PTR_MAP_EMPTY )
+		++map->count;
+	map->entries[slot].key   = key;
+	map->entries[slot].value = value;
+}
+
+/**
+ * Set value stored for key, replacing any earlier value.
+ */
+static inline dl_error_t dl_ptr_map_insert( dl_ptr_map* map, uintptr_t key, uintptr_t value )
+{
+	if( ( map->count + 1 ) * 2 > map->capacity )
+	{
+		size_t new_cap = map->capacity == 0 ? 64 : map->capacity * 2;
+		dl_ptr_map_entry* new_entries = (dl_ptr_map_entry*)dl_alloc( map->alloc, sizeof( dl_ptr_map_entry ) * new_cap );
+		if( new_entries == 0x0 )
+			return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+		memset( new_entries, 0xFF, sizeof( dl_ptr_map_entry ) * new_cap );
+
+		dl_ptr_map old = *map;
+		map->entries  = new_entries;
+		map->capacity = new_cap;
+		map->count    = 0;
+
+		for( size_t i = 0; i < old.capacity; ++i )
+			if( old.entries[i].key != DL_PTR_MAP_EMPTY )
+				dl_ptr_map_insert_no_grow( map, old.entries[i].key, old.entries[i].value );
+
+		if( old.entries )
+			dl_free( map->alloc, old.entries );
+	}
+
+	dl_ptr_map_insert_no_grow( map, key, value );
+	return DL_ERROR_OK;
+}
+
+#endif // DL_PTR_MAP_H_INCLUDED
@@ -73,7 +73,7 @@ dl_error_t dl_reflect_loaded_enums( dl_ctx_t dl_ctx, dl_enum_info_t* out_enums,
 
 dl_error_t dl_reflect_get_type_id( dl_ctx_t dl_ctx, const char* type_name, dl_typeid_t* out_type_id )
 {
-	const dl_type_desc* type = dl_internal_find_type_by_name( dl_ctx, type_name );
+	const dl_type_desc* type = dl_internal_find_type_by_name( dl_ctx, type_name, strlen( type_name ) );
 	if(type == 0x0)
 		return DL_ERROR_TYPE_NOT_FOUND;
 
@@ -0,0 +1,111 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include "dl_stats.h"
+
+#if defined( _WIN32 )
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+/**
+ * Size of the header in front of each allocation when tracking allocations, large enough to keep the alignment that
+ * the underlying allocator returns.
+ */
+#define DL_STATS_ALLOC_HEADER_SIZE ( 2 * sizeof( size_t ) )
+
+uint64_t dl_internal_stats_time_ns()
+{
+#if defined( _WIN32 )
+	static LARGE_INTEGER freq = { { 0, 0 } };
+	if( freq.QuadPart == 0 )
+		QueryPerformanceFrequency( &freq );
+	LARGE_INTEGER now;
+	QueryPerformanceCounter( &now );
+	uint64_t ticks = (uint64_t)now.QuadPart;
+	uint64_t tps   = (uint64_t)freq.QuadPart;
+	return ticks / tps * 1000000000ull + ticks % tps * 1000000000ull / tps;
+#else
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static void dl_internal_stats_allocated( dl_ctx_t ctx, uint8_t* block, size_t size )
+{
+	*(size_t*)block = size;
+	++ctx->stats.allocations;
+	ctx->stats.allocated_bytes += size;
+	if( ctx->stats.allocated_bytes > ctx->stats.peak_allocated_bytes )
+		ctx->stats.peak_allocated_bytes = ctx->stats.allocated_bytes;
+}
+
+static void* dl_internal_stats_alloc( size_t size, void* alloc_ctx )
+{
+	dl_ctx_t ctx = (dl_ctx_t)alloc_ctx;
+	uint8_t* block = (uint8_t*)dl_alloc( &ctx->instance_alloc, size + DL_STATS_ALLOC_HEADER_SIZE );
+	if( block == 0x0 )
+		return 0x0;
+	dl_internal_stats_allocated( ctx, block, size );
+	return block + DL_STATS_ALLOC_HEADER_SIZE;
+}
+
+static void* dl_internal_stats_realloc( void* ptr, size_t size, size_t old_size, void* alloc_ctx )
+{
+	if( ptr == 0x0 )
+		return dl_internal_stats_alloc( size, alloc_ctx );
+
+	dl_ctx_t ctx = (dl_ctx_t)alloc_ctx;
+	uint8_t* block = (uint8_t*)ptr - DL_STATS_ALLOC_HEADER_SIZE;
+	size_t   block_size = *(size_t*)block;
+	DL_ASSERT( block_size >= old_size );
+	(void)old_size;
+
+	block = (uint8_t*)dl_realloc( &ctx->instance_alloc, block, size + DL_STATS_ALLOC_HEADER_SIZE, block_size + DL_STATS_ALLOC_HEADER_SIZE );
+	if( block == 0x0 )
+		return 0x0;
+	ctx->stats.allocated_bytes -= block_size;
+	dl_internal_stats_allocated( ctx, block, size );
+	return block + DL_STATS_ALLOC_HEADER_SIZE;
+}
+
+static void dl_internal_stats_free( void* ptr, void* alloc_ctx )
+{
+	if( ptr == 0x0 )
+		return;
+
+	dl_ctx_t ctx = (dl_ctx_t)alloc_ctx;
+	uint8_t* block = (uint8_t*)ptr - DL_STATS_ALLOC_HEADER_SIZE;
+	ctx->stats.allocated_bytes -= *(size_t*)block;
+	dl_free( &ctx->instance_alloc, block );
+}
+
+void dl_internal_stats_track_allocations( dl_ctx_t ctx )
+{
+	ctx->alloc.alloc   = dl_internal_stats_alloc;
+	ctx->alloc.realloc = dl_internal_stats_realloc;
+	ctx->alloc.free    = dl_internal_stats_free;
+	ctx->alloc.ctx     = ctx;
+}
+
+dl_error_t dl_context_get_stats( dl_ctx_t dl_ctx, dl_context_stats_t* out_stats )
+{
+	if( dl_ctx->stats_mode == DL_STATS_NONE )
+		return DL_ERROR_UNSUPPORTED_OPERATION;
+	*out_stats = dl_ctx->stats;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_context_reset_stats( dl_ctx_t dl_ctx )
+{
+	if( dl_ctx->stats_mode == DL_STATS_NONE )
+		return DL_ERROR_UNSUPPORTED_OPERATION;
+
+	unsigned long long allocated_bytes = dl_ctx->stats.allocated_bytes;
+	memset( &dl_ctx->stats, 0x0, sizeof( dl_ctx->stats ) );
+	dl_ctx->stats.allocated_bytes      = allocated_bytes;
+	dl_ctx->stats.peak_allocated_bytes = allocated_bytes;
+	return DL_ERROR_OK;
+}
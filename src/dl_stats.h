@@ -0,0 +1,148 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_STATS_H_INCLUDED
+#define DL_STATS_H_INCLUDED
+
+#include "dl_types.h"
+
+/**
+ * Return a monotonic time in nanoseconds, used to time operations when collecting stats with DL_STATS_TIMING.
+ */
+uint64_t dl_internal_stats_time_ns();
+
+/**
+ * Make ctx->alloc track all memory allocated by the context in ctx->stats. Memory is allocated with
+ * ctx->instance_alloc prefixed by a small header holding the size of the allocation.
+ */
+void dl_internal_stats_track_allocations( dl_ctx_t ctx );
+
+/**
+ * Return the name of a type to report in trace-events, 0x0 if the context is not traced or the type is not loaded.
+ * Not counted as a type-lookup in ctx->stats.
+ */
+static inline const char* dl_internal_trace_type_name( dl_ctx_t ctx, dl_typeid_t type )
+{
+	if( ctx->trace_begin_func == 0x0 && ctx->trace_end_func == 0x0 )
+		return 0x0;
+
+	uint32_t type_index = dl_index_map_find( &ctx->type_lookup, type );
+	if( type_index == DL_INDEX_MAP_EMPTY )
+		return 0x0;
+	return dl_internal_type_name( ctx, &ctx->type_descs[type_index] );
+}
+
+/**
+ * Report that the operation described by event begins to the trace-callbacks of the context.
+ */
+static inline void dl_internal_trace_begin( dl_ctx_t ctx, dl_trace_event_t* event, const char* name, const char* type_name, size_t bytes_in )
+{
+	event->name      = name;
+	event->type_name = type_name;
+	event->bytes_in  = bytes_in;
+	event->bytes_out = 0;
+	if( ctx->trace_begin_func != 0x0 )
+		ctx->trace_begin_func( event, ctx->trace_ctx );
+}
+
+/**
+ * Report that an operation begun with dl_internal_trace_begin() ends. Used directly instead of dl_trace_scope by
+ * code that might longjmp past the end of a scope, see dl_txt_read_failed().
+ */
+static inline void dl_internal_trace_end( dl_ctx_t ctx, const dl_trace_event_t* event )
+{
+	if( ctx->trace_end_func != 0x0 )
+		ctx->trace_end_func( event, ctx->trace_ctx );
+}
+
+/**
+ * Reports an operation, or a phase of an operation, to the trace-callbacks of the context for the lifetime of the
+ * scope. Unlike stats nested scopes are all reported.
+ */
+struct dl_trace_scope
+{
+	dl_trace_scope( dl_ctx_t dl_ctx, const char* name, const char* type_name, size_t bytes_in )
+		: ctx( dl_ctx )
+	{
+		dl_internal_trace_begin( ctx, &event, name, type_name, bytes_in );
+	}
+
+	~dl_trace_scope()
+	{
+		dl_internal_trace_end( ctx, &event );
+	}
+
+	/// set the type worked on when it was not known as the scope began.
+	void type_name( const char* name ) { event.type_name = name; }
+
+	/// record the bytes read and produced by a successful operation.
+	void bytes( size_t in, size_t out )
+	{
+		event.bytes_in  = in;
+		event.bytes_out = out;
+	}
+
+	dl_ctx_t         ctx;
+	dl_trace_event_t event;
+};
+
+/**
+ * Records one call to a public function in ctx->stats for the lifetime of the scope. Only the outermost scope is
+ * recorded so that calls DL makes to its own public functions are not counted twice.
+ *
+ * The call is also reported to the trace-callbacks of the context as trace_name, outside of the timed part so that
+ * the time spent in the callbacks is not counted.
+ */
+struct dl_stats_scope
+{
+	dl_stats_scope( dl_ctx_t dl_ctx, dl_stats_op_t stats_op, const char* trace_name, const char* type_name, size_t trace_bytes_in )
+		: trace( dl_ctx, trace_name, type_name, trace_bytes_in )
+		, ctx( dl_ctx )
+		, op( stats_op )
+		, active( false )
+		, start( 0 )
+		, bytes_in( 0 )
+		, bytes_out( 0 )
+	{
+		if( ctx->stats_mode == DL_STATS_NONE )
+			return;
+
+		active = ctx->stats_depth++ == 0;
+		if( active && ctx->stats_mode == DL_STATS_TIMING )
+			start = dl_internal_stats_time_ns();
+	}
+
+	~dl_stats_scope()
+	{
+		if( ctx->stats_mode == DL_STATS_NONE )
+			return;
+
+		--ctx->stats_depth;
+		if( !active )
+			return;
+
+		dl_stats_op_counters_t* counters = &ctx->stats.ops[op];
+		++counters->calls;
+		counters->bytes_in  += bytes_in;
+		counters->bytes_out += bytes_out;
+		if( ctx->stats_mode == DL_STATS_TIMING )
+			counters->nanoseconds += dl_internal_stats_time_ns() - start;
+	}
+
+	/// record the bytes read and produced by a successful call.
+	void bytes( size_t in, size_t out )
+	{
+		bytes_in  = in;
+		bytes_out = out;
+		trace.bytes( in, out );
+	}
+
+	dl_trace_scope trace;
+	dl_ctx_t       ctx;
+	dl_stats_op_t  op;
+	bool           active;
+	uint64_t       start;
+	size_t         bytes_in;
+	size_t         bytes_out;
+};
+
+#endif // DL_STATS_H_INCLUDED
@@ -0,0 +1,177 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include "dl_types.h"
+#include "dl_swap.h"
+
+#include <string.h>
+
+#if !defined( DL_NO_SIMD )
+#  if defined( __AVX2__ )
+#    define DL_SWAP_AVX2
+#    include <immintrin.h>
+#  elif defined( __SSSE3__ )
+#    define DL_SWAP_SSSE3
+#    include <tmmintrin.h>
+#  elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#    define DL_SWAP_SSE2
+#    include <emmintrin.h>
+#  endif
+#endif
+
+static void dl_swap_endian_array_scalar( uint8_t* dst, const uint8_t* src, size_t count, size_t elem_size )
+{
+	switch( elem_size )
+	{
+		case 2:
+			for( size_t i = 0; i < count; ++i )
+			{
+				uint16_t v;
+				memcpy( &v, src + i * 2, 2 );
+				v = dl_swap_endian_uint16( v );
+				memcpy( dst + i * 2, &v, 2 );
+			}
+			break;
+		case 4:
+			for( size_t i = 0; i < count; ++i )
+			{
+				uint32_t v;
+				memcpy( &v, src + i * 4, 4 );
+				v = dl_swap_endian_uint32( v );
+				memcpy( dst + i * 4, &v, 4 );
+			}
+			break;
+		case 8:
+			for( size_t i = 0; i < count; ++i )
+			{
+				uint64_t v;
+				memcpy( &v, src + i * 8, 8 );
+				v = dl_swap_endian_uint64( v );
+				memcpy( dst + i * 8, &v, 8 );
+			}
+			break;
+		default:
+			if( dst != src )
+				memmove( dst, src, count * elem_size );
+			break;
+	}
+}
+
+#if defined( DL_SWAP_AVX2 )
+
+static inline __m256i dl_swap_mask( size_t elem_size )
+{
+	switch( elem_size )
+	{
+		case 2:  return _mm256_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+										  1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+		case 4:  return _mm256_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+										  3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+		default: return _mm256_setr_epi8( 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+										  7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 );
+	}
+}
+
+static size_t dl_swap_endian_array_simd( uint8_t* dst, const uint8_t* src, size_t bytes, size_t elem_size )
+{
+	__m256i mask = dl_swap_mask( elem_size );
+	size_t i = 0;
+	for( ; i + 32 <= bytes; i += 32 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)( src + i ) );
+		_mm256_storeu_si256( (__m256i*)( dst + i ), _mm256_shuffle_epi8( v, mask ) );
+	}
+	return i;
+}
+
+#elif defined( DL_SWAP_SSSE3 )
+
+static inline __m128i dl_swap_mask( size_t elem_size )
+{
+	switch( elem_size )
+	{
+		case 2:  return _mm_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+		case 4:  return _mm_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+		default: return _mm_setr_epi8( 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 );
+	}
+}
+
+static size_t dl_swap_endian_array_simd( uint8_t* dst, const uint8_t* src, size_t bytes, size_t elem_size )
+{
+	__m128i mask = dl_swap_mask( elem_size );
+	size_t i = 0;
+	for( ; i + 16 <= bytes; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( src + i ) );
+		_mm_storeu_si128( (__m128i*)( dst + i ), _mm_shuffle_epi8( v, mask ) );
+	}
+	return i;
+}
+
+#elif defined( DL_SWAP_SSE2 )
+
+static inline __m128i dl_swap_16( __m128i v )
+{
+	return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+}
+
+static inline __m128i dl_swap_32( __m128i v )
+{
+	// ... swap 16-bit halves of each 32-bit word, then the bytes in each half ...
+	v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+	v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+	return dl_swap_16( v );
+}
+
+static inline __m128i dl_swap_64( __m128i v )
+{
+	// ... reverse the 16-bit quarters of each 64-bit word, then the bytes in each quarter ...
+	v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+	v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+	return dl_swap_16( v );
+}
+
+static size_t dl_swap_endian_array_simd( uint8_t* dst, const uint8_t* src, size_t bytes, size_t elem_size )
+{
+	size_t i = 0;
+	switch( elem_size )
+	{
+		case 2:
+			for( ; i + 16 <= bytes; i += 16 )
+				_mm_storeu_si128( (__m128i*)( dst + i ), dl_swap_16( _mm_loadu_si128( (const __m128i*)( src + i ) ) ) );
+			break;
+		case 4:
+			for( ; i + 16 <= bytes; i += 16 )
+				_mm_storeu_si128( (__m128i*)( dst + i ), dl_swap_32( _mm_loadu_si128( (const __m128i*)( src + i ) ) ) );
+			break;
+		default:
+			for( ; i + 16 <= bytes; i += 16 )
+				_mm_storeu_si128( (__m128i*)( dst + i ), dl_swap_64( _mm_loadu_si128( (const __m128i*)( src + i ) ) ) );
+			break;
+	}
+	return i;
+}
+
+#else
+
+static size_t dl_swap_endian_array_simd( uint8_t*, const uint8_t*, size_t, size_t )
+{
+	return 0;
+}
+
+#endif
+
+void dl_swap_endian_array( void* dst, const void* src, size_t count, size_t elem_size )
+{
+	uint8_t*       d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+
+	if( elem_size != 2 && elem_size != 4 && elem_size != 8 )
+	{
+		dl_swap_endian_array_scalar( d, s, count, elem_size );
+		return;
+	}
+
+	// ... vectors are loaded before they are stored and processed front to back, so dst <= src is safe ...
+	size_t done = dl_swap_endian_array_simd( d, s, count * elem_size, elem_size );
+	dl_swap_endian_array_scalar( d + done, s + done, count - done / elem_size, elem_size );
+}
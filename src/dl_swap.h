@@ -48,4 +48,13 @@ DL_FORCEINLINE double dl_swap_endian_fp64( double f )
 
 DL_FORCEINLINE dl_type_t dl_swap_endian_dl_type( dl_type_t val ) { return (dl_type_t)dl_swap_endian_uint32( val ); }
 
+/**
+ * Byte-swap count elements of elem_size bytes each from src to dst. elem_size is expected to be 1, 2, 4 or 8.
+ *
+ * dst and src may be the same buffer, dst may also overlap src as long as dst <= src. The swap is done with SSSE3 or
+ * AVX2 byte-shuffles when available, SSE2 shifts on plain x86-64 and define DL_NO_SIMD to always use the scalar
+ * implementation.
+ */
+void dl_swap_endian_array( void* dst, const void* src, size_t count, size_t elem_size );
+
 #endif // DL_DL_SWAP_H_INCLUDED
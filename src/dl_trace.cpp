@@ -0,0 +1,83 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <dl/dl_trace.h>
+#include "dl_stats.h"
+
+#include <stdio.h>
+
+/**
+ * Longest type-name written to the trace, longer names are truncated so that an event always fit in the buffer it is
+ * formatted in.
+ */
+#define DL_TRACE_CHROME_MAX_TYPE_NAME 256
+
+static void dl_trace_chrome_write( dl_trace_chrome_t* trace, const char* data, size_t size )
+{
+	if( trace->err == DL_ERROR_OK )
+		trace->err = trace->write_func( data, size, trace->write_ctx );
+}
+
+/**
+ * Write one event to the trace, phase is 'B' or 'E'. Names of types and operations are identifiers so no escaping of
+ * strings is needed.
+ */
+static void dl_trace_chrome_event( dl_trace_chrome_t* trace, const dl_trace_event_t* event, char phase )
+{
+	if( trace->err != DL_ERROR_OK )
+		return;
+
+	unsigned long long ts = dl_internal_stats_time_ns() - trace->start_ns;
+
+	char buffer[DL_TRACE_CHROME_MAX_TYPE_NAME + 256];
+	int len = snprintf( buffer, sizeof( buffer ), "%s\n{\"name\":\"%s\",\"cat\":\"dl\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":1,\"args\":{",
+						trace->event_count == 0 ? "" : ",",
+						event->name,
+						phase,
+						ts / 1000,
+						(unsigned int)( ts % 1000 ) );
+	if( event->type_name != 0x0 )
+		len += snprintf( buffer + len, sizeof( buffer ) - (size_t)len, "\"type\":\"%.*s\",", DL_TRACE_CHROME_MAX_TYPE_NAME, event->type_name );
+	len += snprintf( buffer + len, sizeof( buffer ) - (size_t)len, "\"bytes_in\":%llu", (unsigned long long)event->bytes_in );
+	if( phase == 'E' )
+		len += snprintf( buffer + len, sizeof( buffer ) - (size_t)len, ",\"bytes_out\":%llu", (unsigned long long)event->bytes_out );
+	len += snprintf( buffer + len, sizeof( buffer ) - (size_t)len, "}}" );
+	DL_ASSERT( len > 0 && (size_t)len < sizeof( buffer ) );
+
+	++trace->event_count;
+	dl_trace_chrome_write( trace, buffer, (size_t)len );
+}
+
+static void dl_trace_chrome_begin_event( const dl_trace_event_t* event, void* trace_ctx )
+{
+	dl_trace_chrome_event( (dl_trace_chrome_t*)trace_ctx, event, 'B' );
+}
+
+static void dl_trace_chrome_end_event( const dl_trace_event_t* event, void* trace_ctx )
+{
+	dl_trace_chrome_event( (dl_trace_chrome_t*)trace_ctx, event, 'E' );
+}
+
+dl_error_t dl_trace_chrome_start( dl_trace_chrome_t*  trace,
+								  dl_write_func       write_func,
+								  void*               write_ctx,
+								  dl_create_params_t* create_params )
+{
+	trace->write_func  = write_func;
+	trace->write_ctx   = write_ctx;
+	trace->err         = DL_ERROR_OK;
+	trace->start_ns    = dl_internal_stats_time_ns();
+	trace->event_count = 0;
+
+	create_params->trace_begin_func = dl_trace_chrome_begin_event;
+	create_params->trace_end_func   = dl_trace_chrome_end_event;
+	create_params->trace_ctx        = trace;
+
+	dl_trace_chrome_write( trace, "[", 1 );
+	return trace->err;
+}
+
+dl_error_t dl_trace_chrome_finish( dl_trace_chrome_t* trace )
+{
+	dl_trace_chrome_write( trace, "\n]\n", 3 );
+	return trace->err;
+}
@@ -0,0 +1,55 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_TXT_FLOAT_H_INCLUDED
+#define DL_TXT_FLOAT_H_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * Parse a floating point number from str, accepting the same input as strtod()/strtof() but always using '.' as
+ * decimal-point independent of locale.
+ *
+ * Decimal numbers are converted with the Eisel-Lemire algorithm, correctly rounded to the nearest fp32/fp64.
+ * Numbers with more than 19 significant digits are rounded with an arbitrary precision decimal instead. Hex-floats,
+ * inf and nan are parsed here as well, no CRT-function is ever called. The payload of "nan(...)" is ignored.
+ *
+ * @param str string to parse.
+ * @param out parsed value is returned here.
+ *
+ * @return pointer to the first char after the parsed number, str if no number could be parsed.
+ */
+const char* dl_txt_parse_fp32( const char* str, float* out );
+const char* dl_txt_parse_fp64( const char* str, double* out );
+
+/**
+ * Size of buffer that is always big enough for the dl_txt_format_*-functions.
+ */
+#define DL_TXT_FORMAT_BUFFER_SIZE 32
+
+/**
+ * Format a floating point number as the shortest decimal string that parses back to the exact same value, found with
+ * the Schubfach algorithm.
+ *
+ * Output is the same as printf( "%.*g", precision, value ) where precision is the number of significant digits needed,
+ * but at least 6. I.e. values that round-trip with plain "%g" are written exactly as "%g" would.
+ *
+ * @param buf buffer of at least DL_TXT_FORMAT_BUFFER_SIZE bytes to write to, result is not zero-terminated.
+ * @param value value to format.
+ *
+ * @return number of chars written to buf.
+ */
+int dl_txt_format_fp32( char* buf, float value );
+int dl_txt_format_fp64( char* buf, double value );
+
+/**
+ * Format an integer as decimal, same output as printf( "%d" ) and printf( "%u" ).
+ *
+ * @param buf buffer of at least DL_TXT_FORMAT_BUFFER_SIZE bytes to write to, result is not zero-terminated.
+ * @param value value to format.
+ *
+ * @return number of chars written to buf.
+ */
+int dl_txt_format_int64( char* buf, int64_t value );
+int dl_txt_format_uint64( char* buf, uint64_t value );
+
+#endif // DL_TXT_FLOAT_H_INCLUDED
@@ -0,0 +1,134 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include "dl_txt_index.h"
+
+#if !defined( DL_NO_SIMD )
+#  if defined( __AVX2__ )
+#    define DL_TXT_INDEX_AVX2
+#    include <immintrin.h>
+#  elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#    define DL_TXT_INDEX_SSE2
+#    include <emmintrin.h>
+#  endif
+#endif
+
+static inline bool dl_txt_index_is_structural( char c )
+{
+	switch( c )
+	{
+		case '"':
+		case '\\':
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ',':
+		case ':':
+		case '/':
+		case '\0':
+			return true;
+		default:
+			return false;
+	}
+}
+
+static uint64_t dl_txt_index_block_scalar( const char* block, size_t len )
+{
+	uint64_t bits = 0;
+	for( size_t i = 0; i < len; ++i )
+		if( dl_txt_index_is_structural( block[i] ) )
+			bits |= 1ULL << i;
+	return bits;
+}
+
+#if defined( DL_TXT_INDEX_AVX2 )
+
+static inline uint32_t dl_txt_index_32( const char* p )
+{
+	__m256i v = _mm256_loadu_si256( (const __m256i*)p );
+	__m256i m =                     _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ',' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ':' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '/' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_setzero_si256() ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '[' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ']' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '{' ) ) );
+	m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '}' ) ) );
+	return (uint32_t)_mm256_movemask_epi8( m );
+}
+
+static inline uint64_t dl_txt_index_block( const char* block )
+{
+	return (uint64_t)dl_txt_index_32( block ) | ( (uint64_t)dl_txt_index_32( block + 32 ) << 32 );
+}
+
+#elif defined( DL_TXT_INDEX_SSE2 )
+
+static inline uint32_t dl_txt_index_16( const char* p )
+{
+	__m128i v = _mm_loadu_si128( (const __m128i*)p );
+	__m128i m =                  _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( ',' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( ':' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '/' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_setzero_si128() ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '[' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( ']' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '{' ) ) );
+	m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '}' ) ) );
+	return (uint32_t)_mm_movemask_epi8( m );
+}
+
+static inline uint64_t dl_txt_index_block( const char* block )
+{
+	return   (uint64_t)dl_txt_index_16( block )
+		 | ( (uint64_t)dl_txt_index_16( block + 16 ) << 16 )
+		 | ( (uint64_t)dl_txt_index_16( block + 32 ) << 32 )
+		 | ( (uint64_t)dl_txt_index_16( block + 48 ) << 48 );
+}
+
+#else
+
+static inline uint64_t dl_txt_index_block( const char* block )
+{
+	return dl_txt_index_block_scalar( block, 64 );
+}
+
+#endif
+
+dl_error_t dl_txt_index_build( dl_allocator* alloc, dl_txt_index* index, const char* start, const char* end )
+{
+	size_t len = (size_t)( end - start );
+	index->start      = start;
+	index->end        = end;
+	index->word_count = ( len + 63 ) / 64;
+	index->bits       = 0x0;
+	if( index->word_count == 0 )
+		return DL_ERROR_OK;
+
+	index->bits = (uint64_t*)dl_alloc( alloc, index->word_count * sizeof(uint64_t) );
+	if( index->bits == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	size_t full_words = len / 64;
+	for( size_t i = 0; i < full_words; ++i )
+		index->bits[i] = dl_txt_index_block( start + i * 64 );
+	if( full_words != index->word_count )
+		index->bits[full_words] = dl_txt_index_block_scalar( start + full_words * 64, len - full_words * 64 );
+
+	// ... always stop at the last char, the skip-functions handle reaching end differently depending on what came before ...
+	index->bits[( len - 1 ) / 64] |= 1ULL << ( ( len - 1 ) % 64 );
+
+	return DL_ERROR_OK;
+}
+
+void dl_txt_index_free( dl_allocator* alloc, dl_txt_index* index )
+{
+	if( index->bits )
+		dl_free( alloc, index->bits );
+	index->bits = 0x0;
+	index->word_count = 0;
+}
@@ -0,0 +1,75 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#ifndef DL_TXT_INDEX_H_INCLUDED
+#define DL_TXT_INDEX_H_INCLUDED
+
+#include <stdint.h>
+#include "dl_alloc.h"
+
+/**
+ * Structural index of a text buffer, one bit per char set for all chars that the text-parser might need to stop at
+ * when skipping data, i.e. '"', '\\', '{', '}', '[', ']', ',', ':', '/' and '\0'. The last char of the buffer is always
+ * marked as well.
+ *
+ * Used to jump directly between structural chars instead of scanning byte by byte when skipping maps, strings and
+ * counting array elements. The index is built with SSE2 or AVX2 when available, define DL_NO_SIMD to always use the
+ * scalar implementation.
+ */
+struct dl_txt_index
+{
+	const char* start;
+	const char* end;
+	uint64_t*   bits;
+	size_t      word_count;
+};
+
+/**
+ * Build index of [start, end).
+ *
+ * @return DL_ERROR_OK on success, DL_ERROR_OUT_OF_LIBRARY_MEMORY if the index could not be allocated.
+ */
+dl_error_t dl_txt_index_build( dl_allocator* alloc, dl_txt_index* index, const char* start, const char* end );
+
+void dl_txt_index_free( dl_allocator* alloc, dl_txt_index* index );
+
+static inline int dl_txt_index_lowest_bit( uint64_t v )
+{
+#if defined( __GNUC__ )
+	return __builtin_ctzll( v );
+#else
+	int n = 0;
+	while( ( v & 1 ) == 0 )
+	{
+		v >>= 1;
+		++n;
+	}
+	return n;
+#endif
+}
+
+/**
+ * Find the first structural char at or after p.
+ *
+ * @param index index to search, if 0x0 p is returned as is.
+ *
+ * @return pointer to the first structural char at or after p, index->end if there is none. p is returned as is if it
+ *         is outside the indexed buffer.
+ */
+static inline const char* dl_txt_index_next( const dl_txt_index* index, const char* p )
+{
+	if( index == 0x0 || p < index->start || p >= index->end )
+		return p;
+
+	size_t pos  = (size_t)( p - index->start );
+	size_t word = pos >> 6;
+	uint64_t bits = index->bits[word] & ( ~0ULL << ( pos & 63 ) );
+	while( bits == 0 )
+	{
+		if( ++word == index->word_count )
+			return index->end;
+		bits = index->bits[word];
+	}
+	return index->start + ( word << 6 ) + dl_txt_index_lowest_bit( bits );
+}
+
+#endif // DL_TXT_INDEX_H_INCLUDED
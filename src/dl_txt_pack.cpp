@@ -5,19 +5,15 @@
 #include "dl_binary_writer.h"
 #include "dl_patch_ptr.h"
 #include "dl_txt_read.h"
+#include "dl_index_map.h"
+#include "dl_txt_float.h"
+#include "dl_stats.h"
 
 #include <stdlib.h>
 
 #if defined(_MSC_VER)
-// TODO: any better/faster way to do this, especially strtof?
 #  define strtoll _strtoi64
 #  define strtoull _strtoui64
-#  if _MSC_VER < 1800 // strtof was defined first in MSVC2013
-	float strtof(const char* str, char** endptr)
-	{
-		return (float)strtod( str, endptr );
-	}
-#  endif
 #endif
 
 struct dl_txt_pack_ctx
@@ -25,16 +21,78 @@ struct dl_txt_pack_ctx
 	dl_txt_read_ctx read_ctx;
 	dl_binary_writer* writer;
 	const char* subdata_pos;
-	int subdata_count;
 
-	struct
+	/// all pointers found while packing, patched to point to their "__subdata"-instance when all data is read.
+	struct subdata_ref
 	{
 		dl_txt_read_substr name;
 		const dl_type_desc* type;
 		size_t patch_pos;
-	} subdata[256];
+	}* subdata;
+	uint32_t subdata_count;
+	uint32_t subdata_capacity;
+	dl_index_map subdata_lookup; ///< name-hash -> index of first element in subdata with that name.
+
+	/// all instances found in "__subdata".
+	struct subinstance
+	{
+		dl_txt_read_substr name;
+		size_t pos;
+	}* subinstances;
+	uint32_t subinstances_count;
+	uint32_t subinstances_capacity;
+	dl_index_map subinstance_lookup; ///< name-hash -> index in subinstances, names are unique.
+
+	/// phase of packing currently traced, name is 0x0 between phases. Ended explicitly as read-failures longjmp past any scope.
+	dl_trace_event_t trace_phase;
 };
 
+/**
+ * Grow an array in packctx to fit one more element, fail the pack if out of memory.
+ * Memory is released in dl_txt_pack() as read-failures longjmp out of all pack-functions.
+ */
+template <typename T>
+static void dl_txt_pack_grow( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx, T** arr, uint32_t count, uint32_t* capacity )
+{
+	if( count < *capacity )
+		return;
+
+	uint32_t new_cap = *capacity == 0 ? 64 : *capacity * 2;
+	T* new_arr = (T*)dl_realloc( &dl_ctx->alloc, *arr, sizeof(T) * new_cap, sizeof(T) * *capacity );
+	if( new_arr == 0x0 )
+		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory while packing subdata" );
+	*arr = new_arr;
+	*capacity = new_cap;
+}
+
+static bool dl_txt_pack_substr_equal( dl_txt_read_substr s1, dl_txt_read_substr s2 )
+{
+	return s1.len == s2.len && strncmp( s1.str, s2.str, (size_t)s1.len ) == 0;
+}
+
+/**
+ * Find the element in arr named name via map.
+ *
+ * @return index of element or DL_INDEX_MAP_EMPTY if not found.
+ */
+template <typename T>
+static uint32_t dl_txt_pack_find_name( const dl_index_map* map, const T* arr, dl_txt_read_substr name )
+{
+	uint32_t iter = 0;
+	uint32_t hash = dl_internal_hash_name( name.str, (size_t)name.len );
+	for( uint32_t i = dl_index_map_find_next( map, hash, &iter ); i != DL_INDEX_MAP_EMPTY; i = dl_index_map_find_next( map, hash, &iter ) )
+		if( dl_txt_pack_substr_equal( arr[i].name, name ) )
+			return i;
+	return DL_INDEX_MAP_EMPTY;
+}
+
+static void dl_txt_pack_index_name( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx, dl_index_map* map, dl_txt_read_substr name, uint32_t index )
+{
+	uint32_t hash = dl_internal_hash_name( name.str, (size_t)name.len );
+	if( dl_index_map_insert( &dl_ctx->alloc, map, hash, index ) != DL_ERROR_OK )
+		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory while packing subdata" );
+}
+
 inline bool dl_long_in_range( long v, long min, long max ) { return v >= min && v <= max; }
 
 static void dl_txt_pack_eat_and_write_int8( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx )
@@ -174,8 +232,8 @@ static void dl_txt_pack_eat_and_write_uint64( dl_ctx_t dl_ctx, dl_txt_pack_ctx*
 static void dl_txt_pack_eat_and_write_fp32( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx )
 {
 	dl_txt_eat_white( &packctx->read_ctx );
-	char* next = 0x0;
-	float v = strtof( packctx->read_ctx.iter, &next );
+	float v;
+	const char* next = dl_txt_parse_fp32( packctx->read_ctx.iter, &v );
 	if( packctx->read_ctx.iter == next )
 		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "expected a value of type 'fp32'" );
 	packctx->read_ctx.iter = next;
@@ -185,8 +243,8 @@ static void dl_txt_pack_eat_and_write_fp32( dl_ctx_t dl_ctx, dl_txt_pack_ctx* pa
 static void dl_txt_pack_eat_and_write_fp64( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx )
 {
 	dl_txt_eat_white( &packctx->read_ctx );
-	char* next = 0x0;
-	double v = strtod( packctx->read_ctx.iter, &next );
+	double v;
+	const char* next = dl_txt_parse_fp64( packctx->read_ctx.iter, &v );
 	if( packctx->read_ctx.iter == next )
 		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "expected a value of type 'fp64'" );
 	packctx->read_ctx.iter = next;
@@ -272,8 +330,11 @@ static void dl_txt_pack_eat_and_write_ptr( dl_ctx_t dl_ctx, dl_txt_pack_ctx* pac
 	if( ptr.str == 0x0 )
 		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_TXT_INVALID_MEMBER_TYPE, "expected string" );
 
-	if( packctx->subdata_count == DL_ARRAY_LENGTH( packctx->subdata ) )
-		dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "to many pointers! ( better error here! )" );
+	dl_txt_pack_grow( dl_ctx, packctx, &packctx->subdata, packctx->subdata_count, &packctx->subdata_capacity );
+
+	// ... only index the first pointer with a name, the same name is usually used by many pointers ...
+	if( dl_txt_pack_find_name( &packctx->subdata_lookup, packctx->subdata, ptr ) == DL_INDEX_MAP_EMPTY )
+		dl_txt_pack_index_name( dl_ctx, packctx, &packctx->subdata_lookup, ptr, packctx->subdata_count );
 
 	packctx->subdata[packctx->subdata_count].name = ptr;
 	packctx->subdata[packctx->subdata_count].type = type;
@@ -461,7 +522,11 @@ static uint32_t dl_txt_pack_array_item_size( dl_ctx_t dl_ctx, const dl_member_de
 	}
 }
 
-const char* dl_txt_skip_map( const char* iter, const char* end )
+/**
+ * All skip-functions take an optional structural index, when available chars that can't affect the result are jumped
+ * over instead of scanned one by one.
+ */
+static const char* dl_txt_skip_map_indexed( const dl_txt_index* index, const char* iter, const char* end )
 {
 	iter = dl_txt_skip_white( iter, end );
 	if( *iter != '{' )
@@ -471,7 +536,7 @@ const char* dl_txt_skip_map( const char* iter, const char* end )
 	int depth = 1;
 	while( iter != end && depth > 0 )
 	{
-		iter = dl_txt_skip_white( iter, end );
+		iter = dl_txt_skip_white( dl_txt_index_next( index, iter ), end );
 		switch(*iter)
 		{
 			case 0x0: return "\0";
@@ -485,7 +550,12 @@ const char* dl_txt_skip_map( const char* iter, const char* end )
 	return iter;
 }
 
-const char* dl_txt_pack_skip_string( const char* str, const char* end )
+const char* dl_txt_skip_map( const char* iter, const char* end )
+{
+	return dl_txt_skip_map_indexed( 0x0, iter, end );
+}
+
+static const char* dl_txt_pack_skip_string_indexed( const dl_txt_index* index, const char* str, const char* end )
 {
 	while( str != end && *str != '\"' )
 	{
@@ -500,13 +570,20 @@ const char* dl_txt_pack_skip_string( const char* str, const char* end )
 
 			if( *str == '\"' )
 				++str;
+			++str;
 		}
-		++str;
+		else
+			str = dl_txt_index_next( index, str + 1 );
 	}
 	return str;
 }
 
-static uint32_t dl_txt_pack_find_array_length( const dl_member_desc* member, const char* iter, const char* end )
+const char* dl_txt_pack_skip_string( const char* str, const char* end )
+{
+	return dl_txt_pack_skip_string_indexed( 0x0, str, end );
+}
+
+static uint32_t dl_txt_pack_find_array_length( const dl_member_desc* member, const dl_txt_index* index, const char* iter, const char* end )
 {
 	iter = dl_txt_skip_white( iter, end );
 	if( *iter == ']' )
@@ -530,7 +607,7 @@ static uint32_t dl_txt_pack_find_array_length( const dl_member_desc* member, con
 			uint32_t array_length = 1;
 			while(true)
 			{
-				iter = dl_txt_skip_white( iter, end );
+				iter = dl_txt_skip_white( dl_txt_index_next( index, iter ), end );
 				switch( *iter )
 				{
 					case ',':
@@ -549,14 +626,14 @@ static uint32_t dl_txt_pack_find_array_length( const dl_member_desc* member, con
 			uint32_t array_length = 1;
 			while(true)
 			{
-				iter = dl_txt_skip_white( iter, end );
+				iter = dl_txt_skip_white( dl_txt_index_next( index, iter ), end );
 				switch( *iter )
 				{
 					case ',':
 						++array_length;
 						break;
 					case '"':
-						iter = dl_txt_pack_skip_string( ++iter, end );
+						iter = dl_txt_pack_skip_string_indexed( index, ++iter, end );
 						break;
 					case '\0':
 					case ']':
@@ -570,7 +647,7 @@ static uint32_t dl_txt_pack_find_array_length( const dl_member_desc* member, con
 		{
 			uint32_t array_length = 1;
 			for( ; *iter && *iter != ']'; ++iter )
-				if( *( iter = dl_txt_skip_map( iter, end ) ) == ',' )
+				if( *( iter = dl_txt_skip_map_indexed( index, iter, end ) ) == ',' )
 					++array_length;
 			return array_length;
 		}
@@ -622,7 +699,7 @@ static void dl_txt_pack_member( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx, size_
 		case DL_TYPE_ATOM_ARRAY:
 		{
 			dl_txt_eat_char( dl_ctx, &packctx->read_ctx, '[' );
-			uint32_t array_length = dl_txt_pack_find_array_length( member, packctx->read_ctx.iter, packctx->read_ctx.end );
+			uint32_t array_length = dl_txt_pack_find_array_length( member, packctx->read_ctx.index, packctx->read_ctx.iter, packctx->read_ctx.end );
 			if( array_length == 0 )
 			{
 				dl_binary_writer_write_pint( packctx->writer, (size_t)-1 );
@@ -765,7 +842,7 @@ static void dl_txt_pack_eat_and_write_struct( dl_ctx_t dl_ctx, dl_txt_pack_ctx*
 					dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "\"__subdata\" set twice!" );
 
 				packctx->subdata_pos = packctx->read_ctx.iter;
-				packctx->read_ctx.iter = dl_txt_skip_map( packctx->read_ctx.iter, packctx->read_ctx.end );
+				packctx->read_ctx.iter = dl_txt_skip_map_indexed( packctx->read_ctx.index, packctx->read_ctx.iter, packctx->read_ctx.end );
 				continue;
 			}
 			else
@@ -850,12 +927,33 @@ static void dl_txt_pack_eat_and_write_struct( dl_ctx_t dl_ctx, dl_txt_pack_ctx*
 
 				uint8_t* member_data = packctx->writer->data + member_pos;
 				if( !packctx->writer->dummy )
-					dl_internal_patch_member( dl_ctx, member, member_data, (uintptr_t)packctx->writer->data, subdata_pos - member_size );
+				{
+					dl_error_t err = dl_internal_patch_member( dl_ctx, member, member_data, (uintptr_t)packctx->writer->data, subdata_pos - member_size );
+					if( err != DL_ERROR_OK )
+						dl_txt_read_failed( dl_ctx, &packctx->read_ctx, err, "out of memory while patching default value for member %s", dl_internal_member_name( dl_ctx, member ) );
+				}
 			}
 		}
 	}
 }
 
+static void dl_txt_pack_add_subinstance( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx, dl_txt_read_substr name, size_t pos )
+{
+	// ... if the same name is used more than once in "__subdata" the last one is used ...
+	uint32_t existing = dl_txt_pack_find_name( &packctx->subinstance_lookup, packctx->subinstances, name );
+	if( existing != DL_INDEX_MAP_EMPTY )
+	{
+		packctx->subinstances[existing].pos = pos;
+		return;
+	}
+
+	dl_txt_pack_grow( dl_ctx, packctx, &packctx->subinstances, packctx->subinstances_count, &packctx->subinstances_capacity );
+	dl_txt_pack_index_name( dl_ctx, packctx, &packctx->subinstance_lookup, name, packctx->subinstances_count );
+	packctx->subinstances[packctx->subinstances_count].name = name;
+	packctx->subinstances[packctx->subinstances_count].pos  = pos;
+	++packctx->subinstances_count;
+}
+
 static dl_error_t dl_txt_pack_finalize_subdata( dl_ctx_t dl_ctx, dl_txt_pack_ctx* packctx )
 {
 	if( packctx->subdata_count == 0 )
@@ -865,15 +963,8 @@ static dl_error_t dl_txt_pack_finalize_subdata( dl_ctx_t dl_ctx, dl_txt_pack_ctx
 
 	packctx->read_ctx.iter = packctx->subdata_pos;
 
-	struct
-	{
-		dl_txt_read_substr name;
-		size_t pos;
-	} subinstances[256];
-	subinstances[0].name.str = "__root";
-	subinstances[0].name.len = 6;
-	subinstances[0].pos = 0;
-	size_t subinstances_count = 1;
+	dl_txt_read_substr root_name = { "__root", 6 };
+	dl_txt_pack_add_subinstance( dl_ctx, packctx, root_name, 0 );
 
 	dl_txt_eat_char( dl_ctx, &packctx->read_ctx, '{' );
 
@@ -889,20 +980,8 @@ static dl_error_t dl_txt_pack_finalize_subdata( dl_ctx_t dl_ctx, dl_txt_pack_ctx
 
 		dl_txt_eat_char( dl_ctx, &packctx->read_ctx, ':' );
 
-		int subdata_item = -1;
-		for( int i = 0; i < packctx->subdata_count; ++i )
-		{
-			if( packctx->subdata[i].name.len != subdata_name.len )
-				continue;
-
-			if( strncmp( packctx->subdata[i].name.str, subdata_name.str, (size_t)subdata_name.len ) == 0 )
-			{
-				subdata_item = i;
-				break;
-			}
-		}
-
-		if( subdata_item < 0 )
+		uint32_t subdata_item = dl_txt_pack_find_name( &packctx->subdata_lookup, packctx->subdata, subdata_name );
+		if( subdata_item == DL_INDEX_MAP_EMPTY )
 			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "non-used subdata." );
 		const dl_type_desc* type = packctx->subdata[subdata_item].type;
 
@@ -912,11 +991,7 @@ static dl_error_t dl_txt_pack_finalize_subdata( dl_ctx_t dl_ctx, dl_txt_pack_ctx
 
 		dl_txt_pack_eat_and_write_struct( dl_ctx, packctx, type );
 
-		if( subinstances_count >= DL_ARRAY_LENGTH(subinstances) )
-			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "to many subdatas." );
-		subinstances[subinstances_count].name = subdata_name;
-		subinstances[subinstances_count].pos = inst_pos;
-		++subinstances_count;
+		dl_txt_pack_add_subinstance( dl_ctx, packctx, subdata_name, inst_pos );
 
 		dl_txt_eat_white( &packctx->read_ctx );
 		if( packctx->read_ctx.iter[0] == ',' )
@@ -927,24 +1002,14 @@ static dl_error_t dl_txt_pack_finalize_subdata( dl_ctx_t dl_ctx, dl_txt_pack_ctx
 
 	dl_txt_eat_char( dl_ctx, &packctx->read_ctx, '}' );
 
-	for( int i = 0; i < packctx->subdata_count; ++i )
+	for( uint32_t i = 0; i < packctx->subdata_count; ++i )
 	{
-		bool found = false;
-		for( size_t j = 0; j < subinstances_count; ++j )
-		{
-			if( packctx->subdata[i].name.len != subinstances[j].name.len )
-				continue;
-
-			if( strncmp( packctx->subdata[i].name.str, subinstances[j].name.str, (size_t)subinstances[j].name.len ) == 0 )
-			{
-				found = true;
-				dl_binary_writer_seek_set( packctx->writer, packctx->subdata[i].patch_pos );
-				dl_binary_writer_write_ptr( packctx->writer, subinstances[j].pos );
-			}
-		}
-
-		if( !found )
+		uint32_t found = dl_txt_pack_find_name( &packctx->subinstance_lookup, packctx->subinstances, packctx->subdata[i].name );
+		if( found == DL_INDEX_MAP_EMPTY )
 			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "referenced subdata \"%.*s\"", packctx->subdata[i].name.len, packctx->subdata[i].name.str );
+
+		dl_binary_writer_seek_set( packctx->writer, packctx->subdata[i].patch_pos );
+		dl_binary_writer_write_ptr( packctx->writer, packctx->subinstances[found].pos );
 	}
 
 	return DL_ERROR_OK;
@@ -962,6 +1027,8 @@ static const dl_type_desc* dl_txt_pack_inner( dl_ctx_t dl_ctx, dl_txt_pack_ctx*
 #pragma warning(pop)
 #endif
 	{
+		dl_internal_trace_begin( dl_ctx, &packctx->trace_phase, "txt_pack.parse", 0x0, (size_t)( packctx->read_ctx.end - packctx->read_ctx.start ) );
+
 		// ... find open { for top map
 		dl_txt_eat_char( dl_ctx, &packctx->read_ctx, '{' );
 
@@ -971,22 +1038,100 @@ static const dl_type_desc* dl_txt_pack_inner( dl_ctx_t dl_ctx, dl_txt_pack_ctx*
 		if( root_type_name.str == 0x0 )
 			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_MALFORMED_DATA, "expected map-key with root type name" );
 
-		char type_name[1024] = {0}; // TODO: make a dl_internal_find_type_by_name() that take string name.
-		strncpy( type_name, root_type_name.str, (size_t)root_type_name.len );
-		const dl_type_desc* root_type = dl_internal_find_type_by_name( dl_ctx, type_name );
+		const dl_type_desc* root_type = dl_internal_find_type_by_name( dl_ctx, root_type_name.str, (size_t)root_type_name.len );
 		if( root_type == 0x0 )
-			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_TYPE_NOT_FOUND, "no type named \"%s\" loaded", type_name );
+			dl_txt_read_failed( dl_ctx, &packctx->read_ctx, DL_ERROR_TYPE_NOT_FOUND, "no type named \"%.*s\" loaded", root_type_name.len, root_type_name.str );
+		packctx->trace_phase.type_name = dl_internal_type_name( dl_ctx, root_type );
 
 		dl_txt_eat_char( dl_ctx, &packctx->read_ctx, ':' );
 		dl_txt_pack_eat_and_write_struct( dl_ctx, packctx, root_type );
 		dl_txt_eat_char( dl_ctx, &packctx->read_ctx, '}' );
 
+		packctx->trace_phase.bytes_out = dl_binary_writer_needed_size( packctx->writer );
+		dl_internal_trace_end( dl_ctx, &packctx->trace_phase );
+
+		dl_internal_trace_begin( dl_ctx, &packctx->trace_phase, "txt_pack.finalize_subdata", dl_internal_type_name( dl_ctx, root_type ), 0 );
 		dl_txt_pack_finalize_subdata( dl_ctx, packctx );
+		packctx->trace_phase.bytes_out = dl_binary_writer_needed_size( packctx->writer );
+		dl_internal_trace_end( dl_ctx, &packctx->trace_phase );
+		packctx->trace_phase.name = 0x0;
 		return root_type;
 	}
+
+	// ... a read failed in the middle of a phase ...
+	if( packctx->trace_phase.name != 0x0 )
+		dl_internal_trace_end( dl_ctx, &packctx->trace_phase );
 	return 0x0;
 }
 
+/**
+ * Pack txt_instance to writer, everything except the header that is left for the caller to write.
+ */
+static dl_error_t dl_txt_pack_write( dl_ctx_t dl_ctx, const char* txt_instance, dl_binary_writer* writer, dl_typeid_t* root_type_id, const char* trace_name )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_TXT_PACK, trace_name, 0x0, 0 );
+
+	dl_txt_pack_ctx packctx;
+	packctx.writer  = writer;
+	packctx.read_ctx.start = txt_instance;
+	packctx.read_ctx.end   = txt_instance + strlen(txt_instance); // TODO: pass to function!
+	packctx.read_ctx.iter  = txt_instance;
+	packctx.read_ctx.index = 0x0;
+	packctx.subdata_pos = 0x0;
+	packctx.subdata = 0x0;
+	packctx.subdata_count = 0;
+	packctx.subdata_capacity = 0;
+	memset( &packctx.subdata_lookup, 0x0, sizeof(packctx.subdata_lookup) );
+	packctx.subinstances = 0x0;
+	packctx.subinstances_count = 0;
+	packctx.subinstances_capacity = 0;
+	memset( &packctx.subinstance_lookup, 0x0, sizeof(packctx.subinstance_lookup) );
+	packctx.read_ctx.err = DL_ERROR_OK;
+	packctx.trace_phase.name = 0x0;
+
+	// ... the structural index is only an optimization, pack without it if it could not be allocated ...
+	dl_txt_index index;
+	if( dl_txt_index_build( &dl_ctx->alloc, &index, packctx.read_ctx.start, packctx.read_ctx.end ) == DL_ERROR_OK )
+		packctx.read_ctx.index = &index;
+
+	const dl_type_desc* root_type = dl_txt_pack_inner( dl_ctx, &packctx );
+
+	dl_txt_index_free( &dl_ctx->alloc, &index );
+
+	if( packctx.subdata )
+		dl_free( &dl_ctx->alloc, packctx.subdata );
+	if( packctx.subinstances )
+		dl_free( &dl_ctx->alloc, packctx.subinstances );
+	dl_index_map_free( &dl_ctx->alloc, &packctx.subdata_lookup );
+	dl_index_map_free( &dl_ctx->alloc, &packctx.subinstance_lookup );
+	if( packctx.read_ctx.err != DL_ERROR_OK )
+	{
+		dl_report_error_location( dl_ctx, packctx.read_ctx.start, packctx.read_ctx.end, packctx.read_ctx.iter );
+		return packctx.read_ctx.err;
+	}
+
+	if( writer->out_of_memory )
+		return DL_ERROR_OUT_OF_INSTANCE_MEMORY;
+
+	*root_type_id = dl_internal_typeid_of( dl_ctx, root_type );
+	stats.trace.type_name( dl_internal_type_name( dl_ctx, root_type ) );
+	stats.bytes( (size_t)( packctx.read_ctx.end - packctx.read_ctx.start ), dl_binary_writer_needed_size( writer ) + sizeof(dl_data_header) );
+	return DL_ERROR_OK;
+}
+
+static void dl_txt_pack_write_header( unsigned char* out_buffer, dl_typeid_t root_type_id, size_t instance_size )
+{
+	dl_data_header header;
+	header.id                 = DL_INSTANCE_ID;
+	header.version            = DL_INSTANCE_VERSION;
+	header.root_instance_type = root_type_id;
+	header.is_64_bit_ptr      = sizeof(void*) == 8 ? 1 : 0;
+	header.is_relative_ptr = 0;
+	header.pad[0] = header.pad[1] = 0;
+	header.instance_size      = instance_size;
+	memcpy( out_buffer, &header, sizeof(dl_data_header) );
+}
+
 dl_error_t dl_txt_pack( dl_ctx_t dl_ctx, const char* txt_instance, unsigned char* out_buffer, size_t out_buffer_size, size_t* produced_bytes )
 {
 	dl_binary_writer writer;
@@ -997,38 +1142,54 @@ dl_error_t dl_txt_pack( dl_ctx_t dl_ctx, const char* txt_instance, unsigned char
 						   DL_ENDIAN_HOST,
 						   DL_ENDIAN_HOST,
 						   DL_PTR_SIZE_HOST );
-	dl_txt_pack_ctx packctx;
-	packctx.writer  = &writer;
-	packctx.read_ctx.start = txt_instance;
-	packctx.read_ctx.end   = txt_instance + strlen(txt_instance); // TODO: pass to function!
-	packctx.read_ctx.iter  = txt_instance;
-	packctx.subdata_pos = 0x0;
-	packctx.subdata_count = 0;
-	packctx.read_ctx.err = DL_ERROR_OK;
 
-	const dl_type_desc* root_type = dl_txt_pack_inner( dl_ctx, &packctx );
-	if( packctx.read_ctx.err == DL_ERROR_OK )
+	dl_typeid_t root_type_id;
+	dl_error_t err = dl_txt_pack_write( dl_ctx, txt_instance, &writer, &root_type_id, "dl_txt_pack" );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	// write header
+	if( out_buffer_size > 0 )
+		dl_txt_pack_write_header( out_buffer, root_type_id, dl_binary_writer_needed_size( &writer ) );
+
+	if( produced_bytes )
+		*produced_bytes = dl_binary_writer_needed_size( &writer ) + sizeof(dl_data_header);
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_txt_pack_alloc( dl_ctx_t dl_ctx, const char* txt_instance, dl_grow_func grow_func, void* grow_ctx, unsigned char** out_buffer, size_t* produced_bytes )
+{
+	*out_buffer = 0x0;
+	if( grow_func == 0x0 )
 	{
-		// write header
-		if( out_buffer_size > 0 )
-		{
-			dl_data_header header;
-			header.id                 = DL_INSTANCE_ID;
-			header.version            = DL_INSTANCE_VERSION;
-			header.root_instance_type = dl_internal_typeid_of( dl_ctx, root_type );
-			header.instance_size      = (uint32_t)dl_binary_writer_needed_size( &writer );
-			header.is_64_bit_ptr      = sizeof(void*) == 8 ? 1 : 0;
-			memcpy( out_buffer, &header, sizeof(dl_data_header) );
-		}
+		grow_func = dl_allocator_grow;
+		grow_ctx  = &dl_ctx->instance_alloc;
+	}
+
+	dl_binary_writer writer;
+	dl_binary_writer_init_grow( &writer, grow_func, grow_ctx, sizeof(dl_data_header), DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
 
-		if( produced_bytes )
-			*produced_bytes = (unsigned int)dl_binary_writer_needed_size( &writer ) + sizeof(dl_data_header);
+	dl_typeid_t root_type_id;
+	dl_error_t err = dl_txt_pack_write( dl_ctx, txt_instance, &writer, &root_type_id, "dl_txt_pack_alloc" );
+	if( err == DL_ERROR_OK )
+	{
+		dl_binary_writer_ensure( &writer, dl_binary_writer_needed_size( &writer ) );
+		if( writer.out_of_memory )
+			err = DL_ERROR_OUT_OF_INSTANCE_MEMORY;
 	}
-	else
+	if( err != DL_ERROR_OK )
 	{
-		dl_report_error_location( dl_ctx, packctx.read_ctx.start, packctx.read_ctx.end, packctx.read_ctx.iter );
+		dl_binary_writer_free( &writer );
+		return err;
 	}
-	return packctx.read_ctx.err;
+
+	size_t instance_size = dl_binary_writer_needed_size( &writer );
+	*out_buffer = dl_binary_writer_release( &writer );
+	dl_txt_pack_write_header( *out_buffer, root_type_id, instance_size );
+
+	if( produced_bytes )
+		*produced_bytes = instance_size + sizeof(dl_data_header);
+	return DL_ERROR_OK;
 }
 
 dl_error_t dl_txt_pack_calc_size( dl_ctx_t dl_ctx, const char* txt_instance, size_t* out_instance_size )
@@ -4,6 +4,7 @@
 #include <ctype.h>
 #include <setjmp.h>
 #include "dl_types.h"
+#include "dl_txt_index.h"
 
 struct dl_txt_read_ctx
 {
@@ -11,6 +12,7 @@ struct dl_txt_read_ctx
 	const char* start;
 	const char* end;
 	const char* iter;
+	const dl_txt_index* index; ///< optional structural index of [start, end), 0x0 if not available.
 	dl_error_t err;
 };
 
@@ -109,10 +111,10 @@ static dl_txt_read_substr dl_txt_eat_string( dl_txt_read_ctx* readctx )
 			readctx->iter = res.str + res.len + 1;
 			return res;
 		case '\\':
-			++key_end;
-			// fallthrough
+			key_end += 2;
+			break;
 		default:
-			++key_end;
+			key_end = dl_txt_index_next( readctx->index, key_end + 1 );
 		}
 	}
 	return res;
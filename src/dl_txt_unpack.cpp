@@ -2,6 +2,9 @@
 
 #include "dl_types.h"
 #include "dl_binary_writer.h"
+#include "dl_ptr_map.h"
+#include "dl_txt_float.h"
+#include "dl_stats.h"
 #include <dl/dl_txt.h>
 
 #if defined( __GNUC__ )
@@ -21,13 +24,9 @@ struct dl_txt_unpack_ctx
 {
 	const uint8_t* packed_instance;
 	int indent;
-	struct
-	{
-		uintptr_t offset;
-		dl_typeid_t tid;
-	} ptrs[256];
-	int ptrs_count;
+	dl_ptr_map written_ptrs; ///< offsets of all subdata-instances already written to "__subdata".
 	bool has_ptrs;
+	dl_error_t err;
 };
 
 static void dl_txt_unpack_write_indent( dl_binary_writer* writer, dl_txt_unpack_ctx* unpack_ctx )
@@ -68,74 +67,97 @@ static void dl_txt_unpack_write_string_or_null( dl_binary_writer* writer, dl_txt
 		dl_txt_unpack_write_string( writer, (const char*)&unpack_ctx->packed_instance[offset] );
 }
 
+/**
+ * Numbers are formatted straight into the output buffer when there is room for the longest possible number, else
+ * into fallback.
+ */
+static inline char* dl_txt_unpack_format_begin( dl_binary_writer* writer, char* fallback )
+{
+	dl_binary_writer_ensure( writer, writer->pos + DL_TXT_FORMAT_BUFFER_SIZE );
+	if( !writer->dummy && writer->pos + DL_TXT_FORMAT_BUFFER_SIZE <= writer->data_size )
+		return (char*)writer->data + writer->pos;
+	return fallback;
+}
+
+static inline void dl_txt_unpack_format_end( dl_binary_writer* writer, const char* buffer, const char* fallback, int len )
+{
+	if( buffer == fallback )
+	{
+		dl_binary_writer_write( writer, buffer, (size_t)len );
+		return;
+	}
+	writer->pos += (size_t)len;
+	dl_binary_writer_update_needed_size( writer );
+}
+
 static void dl_txt_unpack_int8( dl_binary_writer* writer, int8_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%d", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_int64( buffer, (int64_t)data ) );
 }
 
 static void dl_txt_unpack_int16( dl_binary_writer* writer, int16_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%d", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_int64( buffer, (int64_t)data ) );
 }
 
 static void dl_txt_unpack_int32( dl_binary_writer* writer, int32_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%d", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_int64( buffer, (int64_t)data ) );
 }
 
 static void dl_txt_unpack_int64( dl_binary_writer* writer, int64_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), DL_INT64_FMT_STR, data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_int64( buffer, data ) );
 }
 
 static void dl_txt_unpack_uint8( dl_binary_writer* writer, uint8_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%u", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_uint64( buffer, (uint64_t)data ) );
 }
 
 static void dl_txt_unpack_uint16( dl_binary_writer* writer, uint16_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%u", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_uint64( buffer, (uint64_t)data ) );
 }
 
 static void dl_txt_unpack_uint32( dl_binary_writer* writer, uint32_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%u", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_uint64( buffer, (uint64_t)data ) );
 }
 
-static void dl_txt_unpack_uint64( dl_binary_writer* writer, const uint64_t data )
+static void dl_txt_unpack_uint64( dl_binary_writer* writer, uint64_t data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), DL_UINT64_FMT_STR, data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_uint64( buffer, data ) );
 }
 
 static void dl_txt_unpack_fp32( dl_binary_writer* writer, float data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%g", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_fp32( buffer, data ) );
 }
 
 static void dl_txt_unpack_fp64( dl_binary_writer* writer, double data )
 {
-	char buffer[256];
-	int len = dl_internal_str_format( buffer, sizeof(buffer), "%g", data );
-	dl_binary_writer_write( writer, buffer, (size_t)len );
+	char fallback[DL_TXT_FORMAT_BUFFER_SIZE];
+	char* buffer = dl_txt_unpack_format_begin( writer, fallback );
+	dl_txt_unpack_format_end( writer, buffer, fallback, dl_txt_format_fp64( buffer, data ) );
 }
 
 static void dl_txt_unpack_enum( dl_ctx_t dl_ctx, dl_binary_writer* writer, dl_typeid_t eid, uint32_t value )
@@ -419,12 +441,15 @@ static void dl_txt_unpack_write_subdata_ptr( dl_ctx_t            dl_ctx,
 	if( offset == 0 )
 		return;
 
-	for( int i = 0; i < unpack_ctx->ptrs_count; ++i )
-		if( unpack_ctx->ptrs[i].offset == offset )
-			return;
+	if( dl_ptr_map_find( &unpack_ctx->written_ptrs, offset ) != DL_PTR_MAP_EMPTY )
+		return;
 
-	// TODO: overflow!
-	unpack_ctx->ptrs[unpack_ctx->ptrs_count++].offset = offset;
+	dl_error_t err = dl_ptr_map_insert( &unpack_ctx->written_ptrs, offset, 0 );
+	if( err != DL_ERROR_OK )
+	{
+		unpack_ctx->err = err;
+		return;
+	}
 
 	dl_txt_unpack_write_indent( writer, unpack_ctx );
 	dl_txt_unpack_ptr( writer, offset );
@@ -523,6 +548,7 @@ static void dl_txt_unpack_write_subdata( dl_ctx_t dl_ctx, dl_txt_unpack_ctx* unp
 								dl_txt_unpack_write_subdata( dl_ctx, unpack_ctx, writer, subtype, array + i * subtype->size[DL_PTR_SIZE_HOST] );
 						}
 					}
+					break;
 					case DL_TYPE_STORAGE_PTR:
 					{
 						uintptr_t array_offset = *(uintptr_t*)(member_data);
@@ -624,19 +650,46 @@ static dl_error_t dl_txt_unpack_root( dl_ctx_t dl_ctx, dl_txt_unpack_ctx* unpack
 	return DL_ERROR_OK;
 }
 
+static dl_error_t dl_txt_unpack_write( dl_ctx_t dl_ctx,                      dl_typeid_t type,
+                                       const unsigned char* packed_instance, size_t      packed_instance_size,
+                                       dl_binary_writer*    writer,          const char* trace_name )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_TXT_UNPACK, trace_name, dl_internal_trace_type_name( dl_ctx, type ), packed_instance_size );
+
+	dl_data_header header;
+	size_t         header_size;
+	dl_endian_t    endian;
+	dl_error_t err = dl_internal_read_instance_header( packed_instance, packed_instance_size, &header, &header_size, &endian );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	if( endian != DL_ENDIAN_HOST )                     return DL_ERROR_ENDIAN_MISMATCH;
+	if( header.root_instance_type != type )            return DL_ERROR_TYPE_MISMATCH;
+	if( header.is_relative_ptr )                       return DL_ERROR_UNSUPPORTED_OPERATION;
+
+	dl_txt_unpack_ctx unpackctx;
+	unpackctx.packed_instance = packed_instance + header_size;
+	unpackctx.indent = 0;
+	unpackctx.has_ptrs = false;
+	unpackctx.err = DL_ERROR_OK;
+	dl_ptr_map_init( &unpackctx.written_ptrs, &dl_ctx->alloc );
+
+	err = dl_txt_unpack_root( dl_ctx, &unpackctx, writer, header.root_instance_type );
+	dl_ptr_map_free( &unpackctx.written_ptrs );
+	if( err == DL_ERROR_OK )
+		err = unpackctx.err;
+	if( err == DL_ERROR_OK && writer->out_of_memory )
+		err = DL_ERROR_OUT_OF_INSTANCE_MEMORY;
+	if( err == DL_ERROR_OK )
+		stats.bytes( header_size + (size_t)header.instance_size, writer->needed_size );
+	return err;
+}
+
 dl_error_t dl_txt_unpack( dl_ctx_t dl_ctx,                       dl_typeid_t type,
                           const unsigned char* packed_instance,  size_t      packed_instance_size,
                           char*                out_txt_instance, size_t      out_txt_instance_size,
                           size_t*              produced_bytes )
 {
-	dl_data_header* header = (dl_data_header*)packed_instance;
-
-	if( packed_instance_size < sizeof(dl_data_header) ) return DL_ERROR_MALFORMED_DATA;
-	if( header->id == DL_INSTANCE_ID_SWAPED )           return DL_ERROR_ENDIAN_MISMATCH;
-	if( header->id != DL_INSTANCE_ID )                  return DL_ERROR_MALFORMED_DATA;
-	if( header->version != DL_INSTANCE_VERSION)         return DL_ERROR_VERSION_MISMATCH;
-	if( header->root_instance_type != type )            return DL_ERROR_TYPE_MISMATCH;
-
 	dl_binary_writer writer;
 	dl_binary_writer_init( &writer,
 						   (uint8_t*)out_txt_instance,
@@ -646,19 +699,45 @@ dl_error_t dl_txt_unpack( dl_ctx_t dl_ctx,                       dl_typeid_t typ
 						   DL_ENDIAN_HOST,
 						   DL_PTR_SIZE_HOST );
 
-	dl_txt_unpack_ctx unpackctx;
-	unpackctx.packed_instance = packed_instance + sizeof(dl_data_header);
-	unpackctx.indent = 0;
-	unpackctx.ptrs_count = 0;
-	unpackctx.has_ptrs = false;
+	dl_error_t err = dl_txt_unpack_write( dl_ctx, type, packed_instance, packed_instance_size, &writer, "dl_txt_unpack" );
+	if( err != DL_ERROR_OK )
+		return err;
 
-	dl_txt_unpack_root( dl_ctx, &unpackctx, &writer, header->root_instance_type );
 	if( produced_bytes )
 		*produced_bytes = writer.needed_size;
 
 	return DL_ERROR_OK;
 };
 
+dl_error_t dl_txt_unpack_alloc( dl_ctx_t dl_ctx,                      dl_typeid_t type,
+                                const unsigned char* packed_instance, size_t      packed_instance_size,
+                                dl_grow_func         grow_func,       void*       grow_ctx,
+                                char**               out_txt_instance,
+                                size_t*              produced_bytes )
+{
+	*out_txt_instance = 0x0;
+	if( grow_func == 0x0 )
+	{
+		grow_func = dl_allocator_grow;
+		grow_ctx  = &dl_ctx->instance_alloc;
+	}
+
+	dl_binary_writer writer;
+	dl_binary_writer_init_grow( &writer, grow_func, grow_ctx, 0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_HOST );
+
+	dl_error_t err = dl_txt_unpack_write( dl_ctx, type, packed_instance, packed_instance_size, &writer, "dl_txt_unpack_alloc" );
+	if( err != DL_ERROR_OK )
+	{
+		dl_binary_writer_free( &writer );
+		return err;
+	}
+
+	if( produced_bytes )
+		*produced_bytes = writer.needed_size;
+	*out_txt_instance = (char*)dl_binary_writer_release( &writer );
+	return DL_ERROR_OK;
+}
+
 dl_error_t dl_txt_unpack_calc_size( dl_ctx_t dl_ctx,                           dl_typeid_t type,
                                     const unsigned char* packed_instance,      size_t      packed_instance_size,
                                     size_t*              out_txt_instance_size )
@@ -1,5 +1,8 @@
 #include <dl/dl_typelib.h>
 #include "dl_types.h"
+#include "dl_patch_ptr.h"
+#include "dl_index_map.h"
+#include "dl_stats.h"
 
 static dl_error_t dl_internal_load_type_library_defaults( dl_ctx_t       dl_ctx,
 														  const uint8_t* default_data,
@@ -80,7 +83,40 @@ static T* dl_grow_array( dl_allocator* alloc, T* ptr, size_t* cap, size_t need )
 	return (T*)dl_realloc( alloc, ptr, need * sizeof( T ), old_cap * sizeof( T ) );
 }
 
-dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size )
+/**
+ * Offsets of all sections in a type-library.
+ */
+struct dl_typelib_layout
+{
+	size_t types_lookup;
+	size_t enums_lookup;
+	size_t types;
+	size_t enums;
+	size_t members;
+	size_t enum_values;
+	size_t enum_aliases;
+	size_t defaults;
+	size_t typedata_strings;
+	size_t end;    ///< end of the sections that are always present.
+	size_t lookup; ///< start of the optional lookup-section.
+};
+
+static void dl_internal_typelib_layout( const dl_typelib_header* header, dl_typelib_layout* layout )
+{
+	layout->types_lookup     = sizeof(dl_typelib_header);
+	layout->enums_lookup     = layout->types_lookup + sizeof( dl_typeid_t ) * header->type_count;
+	layout->types            = layout->enums_lookup + sizeof( dl_typeid_t ) * header->enum_count;
+	layout->enums            = layout->types        + sizeof( dl_type_desc ) * header->type_count;
+	layout->members          = layout->enums        + sizeof( dl_enum_desc ) * header->enum_count;
+	layout->enum_values      = layout->members      + sizeof( dl_member_desc ) * header->member_count;
+	layout->enum_aliases     = layout->enum_values  + sizeof( dl_enum_value_desc ) * header->enum_value_count;
+	layout->defaults         = layout->enum_aliases + sizeof( dl_enum_alias_desc ) * header->enum_alias_count;
+	layout->typedata_strings = layout->defaults     + header->default_value_size;
+	layout->end              = layout->typedata_strings + header->typeinfo_strings_size;
+	layout->lookup           = dl_internal_align_up( layout->end, 4 );
+}
+
+static dl_error_t dl_internal_load_type_library( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size )
 {
 	if(lib_data_size < sizeof(dl_typelib_header))
 		return DL_ERROR_MALFORMED_DATA;
@@ -91,19 +127,20 @@ dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* l
 	if( header.id      != DL_TYPELIB_ID )      return DL_ERROR_MALFORMED_DATA;
 	if( header.version != DL_TYPELIB_VERSION ) return DL_ERROR_VERSION_MISMATCH;
 
-	size_t types_lookup_offset     = sizeof(dl_typelib_header);
-	size_t enums_lookup_offset     = types_lookup_offset + sizeof( dl_typeid_t ) * header.type_count;
-	size_t types_offset            = enums_lookup_offset + sizeof( dl_typeid_t ) * header.enum_count;
-	size_t enums_offset            = types_offset        + sizeof( dl_type_desc ) * header.type_count;
-	size_t members_offset          = enums_offset        + sizeof( dl_enum_desc ) * header.enum_count;
-	size_t enum_values_offset      = members_offset      + sizeof( dl_member_desc ) * header.member_count;
-	size_t enum_aliases_offset     = enum_values_offset  + sizeof( dl_enum_value_desc ) * header.enum_value_count;
-	size_t defaults_offset         = enum_aliases_offset + sizeof( dl_enum_alias_desc ) * header.enum_alias_count;
-	size_t typedata_strings_offset = defaults_offset + header.default_value_size;
+	dl_error_t err = dl_internal_unborrow_type_library( dl_ctx );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	dl_typelib_layout layout;
+	dl_internal_typelib_layout( &header, &layout );
+	if( layout.end > lib_data_size )
+		return DL_ERROR_MALFORMED_DATA;
 
 	size_t cap;
 	cap = dl_ctx->type_capacity;
 	dl_ctx->type_ids         = dl_grow_array( &dl_ctx->alloc, dl_ctx->type_ids,         &cap,                          dl_ctx->type_count + header.type_count );
+	cap = dl_ctx->type_capacity;
+	dl_ctx->type_caches      = dl_grow_array( &dl_ctx->alloc, dl_ctx->type_caches,      &cap,                          dl_ctx->type_count + header.type_count );
 	dl_ctx->type_descs       = dl_grow_array( &dl_ctx->alloc, dl_ctx->type_descs,       &dl_ctx->type_capacity,        dl_ctx->type_count + header.type_count );
 	cap = dl_ctx->enum_capacity;
 	dl_ctx->enum_ids         = dl_grow_array( &dl_ctx->alloc, dl_ctx->enum_ids,         &cap,                          dl_ctx->enum_count + header.enum_count );
@@ -113,14 +150,14 @@ dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* l
 	dl_ctx->enum_alias_descs = dl_grow_array( &dl_ctx->alloc, dl_ctx->enum_alias_descs, &dl_ctx->enum_alias_capacity,  dl_ctx->enum_alias_count + header.enum_alias_count );
 	dl_ctx->typedata_strings = dl_grow_array( &dl_ctx->alloc, dl_ctx->typedata_strings, &dl_ctx->typedata_strings_cap, dl_ctx->typedata_strings_size + header.typeinfo_strings_size );
 
-	memcpy( dl_ctx->type_ids         + dl_ctx->type_count,            lib_data + types_lookup_offset, sizeof( dl_typeid_t ) * header.type_count );
-	memcpy( dl_ctx->enum_ids         + dl_ctx->enum_count,            lib_data + enums_lookup_offset, sizeof( dl_typeid_t ) * header.enum_count );
-	memcpy( dl_ctx->type_descs       + dl_ctx->type_count,            lib_data + types_offset,        sizeof( dl_type_desc ) * header.type_count );
-	memcpy( dl_ctx->enum_descs       + dl_ctx->enum_count,            lib_data + enums_offset,        sizeof( dl_enum_desc ) * header.enum_count );
-	memcpy( dl_ctx->member_descs     + dl_ctx->member_count,          lib_data + members_offset,      sizeof( dl_member_desc ) * header.member_count );
-	memcpy( dl_ctx->enum_value_descs + dl_ctx->enum_value_count,      lib_data + enum_values_offset,  sizeof( dl_enum_value_desc ) * header.enum_value_count );
-	memcpy( dl_ctx->enum_alias_descs + dl_ctx->enum_alias_count,      lib_data + enum_aliases_offset, sizeof( dl_enum_alias_desc ) * header.enum_alias_count );
-	memcpy( dl_ctx->typedata_strings + dl_ctx->typedata_strings_size, lib_data + typedata_strings_offset, header.typeinfo_strings_size );
+	memcpy( dl_ctx->type_ids         + dl_ctx->type_count,            lib_data + layout.types_lookup, sizeof( dl_typeid_t ) * header.type_count );
+	memcpy( dl_ctx->enum_ids         + dl_ctx->enum_count,            lib_data + layout.enums_lookup, sizeof( dl_typeid_t ) * header.enum_count );
+	memcpy( dl_ctx->type_descs       + dl_ctx->type_count,            lib_data + layout.types,        sizeof( dl_type_desc ) * header.type_count );
+	memcpy( dl_ctx->enum_descs       + dl_ctx->enum_count,            lib_data + layout.enums,        sizeof( dl_enum_desc ) * header.enum_count );
+	memcpy( dl_ctx->member_descs     + dl_ctx->member_count,          lib_data + layout.members,      sizeof( dl_member_desc ) * header.member_count );
+	memcpy( dl_ctx->enum_value_descs + dl_ctx->enum_value_count,      lib_data + layout.enum_values,  sizeof( dl_enum_value_desc ) * header.enum_value_count );
+	memcpy( dl_ctx->enum_alias_descs + dl_ctx->enum_alias_count,      lib_data + layout.enum_aliases, sizeof( dl_enum_alias_desc ) * header.enum_alias_count );
+	memcpy( dl_ctx->typedata_strings + dl_ctx->typedata_strings_size, lib_data + layout.typedata_strings, header.typeinfo_strings_size );
 
 	if( DL_ENDIAN_HOST == DL_ENDIAN_BIG )
 	{
@@ -152,9 +189,21 @@ dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* l
 	for( unsigned int i = 0; i < header.enum_alias_count; ++i )
 	{
 		dl_ctx->enum_alias_descs[ dl_ctx->enum_alias_count + i ].name += td_str_offset;
-		dl_ctx->enum_alias_descs[ dl_ctx->enum_alias_count + i ].value_index += dl_ctx->enum_alias_count;
+		dl_ctx->enum_alias_descs[ dl_ctx->enum_alias_count + i ].value_index += dl_ctx->enum_value_count;
 	}
 
+	for( unsigned int i = 0; i < header.enum_value_count; ++i )
+		dl_ctx->enum_value_descs[ dl_ctx->enum_value_count + i ].main_alias += dl_ctx->enum_alias_count;
+
+	for( unsigned int i = 0; i < header.type_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_type( dl_ctx, dl_ctx->type_count + i );
+	for( unsigned int i = 0; i < header.type_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_type_members( dl_ctx, dl_ctx->type_count + i );
+	for( unsigned int i = 0; i < header.enum_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_enum( dl_ctx, dl_ctx->enum_count + i );
+	if( err != DL_ERROR_OK )
+		return err;
+
 	dl_ctx->type_count += header.type_count;
 	dl_ctx->enum_count += header.enum_count;
 	dl_ctx->member_count += header.member_count;
@@ -162,5 +211,267 @@ dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* l
 	dl_ctx->enum_alias_count += header.enum_alias_count;
 	dl_ctx->typedata_strings_size += header.typeinfo_strings_size;
 
-	return dl_internal_load_type_library_defaults( dl_ctx, lib_data + defaults_offset, header.default_value_size );
+	dl_internal_build_patch_programs( dl_ctx );
+
+	return dl_internal_load_type_library_defaults( dl_ctx, lib_data + layout.defaults, header.default_value_size );
+}
+
+template <typename T>
+static T* dl_internal_borrow_section( const unsigned char* lib_data, size_t offset, size_t count )
+{
+	// ... empty sections are kept as 0x0 so that nothing points to the end of the borrowed data ...
+	return count == 0 ? 0x0 : (T*)( lib_data + offset );
+}
+
+/**
+ * Find the lookup-section of a type-library, if present and valid.
+ */
+static const dl_typelib_lookup_header* dl_internal_find_typelib_lookup( const unsigned char* lib_data, size_t lib_data_size, const dl_typelib_header* header, const dl_typelib_layout* layout )
+{
+	if( layout->lookup + sizeof( dl_typelib_lookup_header ) > lib_data_size )
+		return 0x0;
+
+	const dl_typelib_lookup_header* lookup = (const dl_typelib_lookup_header*)( lib_data + layout->lookup );
+	if( lookup->id != DL_TYPELIB_LOOKUP_ID )
+		return 0x0;
+
+	// ... patch-ops and maps are only valid on platforms with the same ptr-size and endian as the one that wrote them ...
+	if( lookup->ptr_size != sizeof(void*) || lookup->endian != DL_ENDIAN_HOST )
+		return 0x0;
+
+	size_t size = sizeof( dl_typelib_lookup_header ) + sizeof( dl_type_cache ) * header->type_count + sizeof( dl_patch_op ) * lookup->patch_op_count;
+	for( int i = 0; i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+	{
+		uint32_t cap = lookup->map_capacity[i];
+		if( ( cap & ( cap - 1 ) ) != 0 || ( cap == 0 ? lookup->map_count[i] != 0 : lookup->map_count[i] >= cap ) )
+			return 0x0;
+		size += sizeof( dl_index_map_entry ) * cap;
+	}
+	if( layout->lookup + size > lib_data_size )
+		return 0x0;
+	return lookup;
+}
+
+/**
+ * Check that all indices and offsets in a lookup-section found by dl_internal_find_typelib_lookup() are in range, so
+ * that they can be used without checks. dl_ctx need to have the sections of the type-library borrowed.
+ */
+static bool dl_internal_typelib_lookup_is_valid( dl_ctx_t dl_ctx, const dl_typelib_lookup_header* lookup )
+{
+	const unsigned char* iter = (const unsigned char*)lookup + sizeof( dl_typelib_lookup_header );
+	const dl_type_cache* caches = (const dl_type_cache*)iter;
+	iter += sizeof( dl_type_cache ) * dl_ctx->type_count;
+	const dl_patch_op* ops = (const dl_patch_op*)iter;
+	iter += sizeof( dl_patch_op ) * lookup->patch_op_count;
+
+	for( uint32_t i = 0; i < lookup->patch_op_count; ++i )
+		if( ops[i].op > DL_PATCH_OP_ARRAY_STRUCT || ops[i].type_index >= dl_ctx->type_count )
+			return false;
+
+	for( uint32_t type_index = 0; type_index < dl_ctx->type_count; ++type_index )
+	{
+		const dl_type_cache* cache = caches + type_index;
+		if( cache->patch_op_start == DL_PATCH_PROGRAM_NOT_BUILT )
+			continue;
+		if( cache->patch_op_start > lookup->patch_op_count || cache->patch_op_count > lookup->patch_op_count - cache->patch_op_start )
+			return false;
+
+		// ... everything patched need to be inside the struct the program is run on ...
+		uint64_t type_size = dl_ctx->type_descs[type_index].size[DL_PTR_SIZE_HOST];
+		for( uint32_t i = 0; i < cache->patch_op_count; ++i )
+		{
+			const dl_patch_op* op = ops + cache->patch_op_start + i;
+			uint64_t sub_size = dl_ctx->type_descs[op->type_index].size[DL_PTR_SIZE_HOST];
+			uint64_t size;
+			switch( op->op )
+			{
+				case DL_PATCH_OP_STRUCT: size = sub_size * op->count; break;
+				case DL_PATCH_OP_UNION:  size = sub_size; break;
+				default:                 size = (uint64_t)sizeof(void*) * op->count; break;
+			}
+			if( (uint64_t)op->offset + size > type_size )
+				return false;
+		}
+	}
+
+	// ... in the same order as dl_internal_lookup_maps() ...
+	const uint32_t value_limit[DL_TYPELIB_LOOKUP_MAP_COUNT] = { dl_ctx->type_count,
+																dl_ctx->type_count,
+																dl_ctx->member_count,
+																dl_ctx->enum_count,
+																dl_ctx->enum_alias_count,
+																dl_ctx->enum_value_count };
+	for( int map = 0; map < DL_TYPELIB_LOOKUP_MAP_COUNT; ++map )
+	{
+		const dl_index_map_entry* entries = (const dl_index_map_entry*)iter;
+		uint32_t used = 0;
+		for( uint32_t i = 0; i < lookup->map_capacity[map]; ++i )
+		{
+			if( entries[i].value == DL_INDEX_MAP_EMPTY )
+				continue;
+			if( entries[i].value >= value_limit[map] )
+				return false;
+			++used;
+		}
+		// ... map_count is less than the capacity, so this also guarantee that lookups find an empty entry ...
+		if( used != lookup->map_count[map] )
+			return false;
+		iter += sizeof( dl_index_map_entry ) * lookup->map_capacity[map];
+	}
+	return true;
+}
+
+static dl_error_t dl_internal_load_type_library_borrowed( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size )
+{
+	if( dl_ctx->type_count != 0 || dl_ctx->enum_count != 0 || dl_ctx->typedata_strings_size != 0 )
+		return DL_ERROR_INVALID_PARAMETER;
+	if( !dl_internal_is_align( lib_data, 4 ) )
+		return DL_ERROR_BAD_ALIGNMENT;
+	if( lib_data_size < sizeof(dl_typelib_header) )
+		return DL_ERROR_MALFORMED_DATA;
+
+	const dl_typelib_header* header = (const dl_typelib_header*)lib_data;
+	if( header->id      == DL_TYPELIB_ID_SWAPED ) return DL_ERROR_ENDIAN_MISMATCH;
+	if( header->id      != DL_TYPELIB_ID )        return DL_ERROR_MALFORMED_DATA;
+	if( header->version != DL_TYPELIB_VERSION )   return DL_ERROR_VERSION_MISMATCH;
+
+	dl_typelib_layout layout;
+	dl_internal_typelib_layout( header, &layout );
+	if( layout.end > lib_data_size )
+		return DL_ERROR_MALFORMED_DATA;
+
+	dl_ctx->borrowed_lib      = lib_data;
+	dl_ctx->borrowed_lib_size = lib_data_size;
+
+	dl_ctx->type_ids         = dl_internal_borrow_section<dl_typeid_t>       ( lib_data, layout.types_lookup,     header->type_count );
+	dl_ctx->enum_ids         = dl_internal_borrow_section<dl_typeid_t>       ( lib_data, layout.enums_lookup,     header->enum_count );
+	dl_ctx->type_descs       = dl_internal_borrow_section<dl_type_desc>      ( lib_data, layout.types,            header->type_count );
+	dl_ctx->enum_descs       = dl_internal_borrow_section<dl_enum_desc>      ( lib_data, layout.enums,            header->enum_count );
+	dl_ctx->member_descs     = dl_internal_borrow_section<dl_member_desc>    ( lib_data, layout.members,          header->member_count );
+	dl_ctx->enum_value_descs = dl_internal_borrow_section<dl_enum_value_desc>( lib_data, layout.enum_values,      header->enum_value_count );
+	dl_ctx->enum_alias_descs = dl_internal_borrow_section<dl_enum_alias_desc>( lib_data, layout.enum_aliases,     header->enum_alias_count );
+	dl_ctx->typedata_strings = dl_internal_borrow_section<char>              ( lib_data, layout.typedata_strings, header->typeinfo_strings_size );
+	dl_ctx->default_data     = dl_internal_borrow_section<uint8_t>           ( lib_data, layout.defaults,         header->default_value_size );
+
+	dl_ctx->type_count       = header->type_count;
+	dl_ctx->enum_count       = header->enum_count;
+	dl_ctx->member_count     = header->member_count;
+	dl_ctx->enum_value_count = header->enum_value_count;
+	dl_ctx->enum_alias_count = header->enum_alias_count;
+
+	dl_ctx->type_capacity       = header->type_count;
+	dl_ctx->enum_capacity       = header->enum_count;
+	dl_ctx->member_capacity     = header->member_count;
+	dl_ctx->enum_value_capacity = header->enum_value_count;
+	dl_ctx->enum_alias_capacity = header->enum_alias_count;
+
+	dl_ctx->typedata_strings_size = header->typeinfo_strings_size;
+	dl_ctx->typedata_strings_cap  = header->typeinfo_strings_size;
+	dl_ctx->default_data_size     = header->default_value_size;
+
+	const dl_typelib_lookup_header* lookup = dl_internal_find_typelib_lookup( lib_data, lib_data_size, header, &layout );
+	if( lookup != 0x0 && dl_internal_typelib_lookup_is_valid( dl_ctx, lookup ) )
+	{
+		const unsigned char* iter = lib_data + layout.lookup + sizeof( dl_typelib_lookup_header );
+		dl_ctx->type_caches = dl_internal_borrow_section<dl_type_cache>( iter, 0, header->type_count );
+		iter += sizeof( dl_type_cache ) * header->type_count;
+
+		dl_ctx->patch_ops = dl_internal_borrow_section<dl_patch_op>( iter, 0, lookup->patch_op_count );
+		dl_ctx->patch_op_count = dl_ctx->patch_op_capacity = lookup->patch_op_count;
+		iter += sizeof( dl_patch_op ) * lookup->patch_op_count;
+
+		dl_index_map* maps[DL_TYPELIB_LOOKUP_MAP_COUNT];
+		dl_internal_lookup_maps( dl_ctx, maps );
+		for( int i = 0; i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+		{
+			maps[i]->entries  = dl_internal_borrow_section<dl_index_map_entry>( iter, 0, lookup->map_capacity[i] );
+			maps[i]->capacity = lookup->map_capacity[i];
+			maps[i]->count    = lookup->map_count[i];
+			iter += sizeof( dl_index_map_entry ) * lookup->map_capacity[i];
+		}
+		return DL_ERROR_OK;
+	}
+
+	// ... type-library without lookup-section, only the lookup-tables need to be built by the context ...
+	if( header->type_count > 0 )
+	{
+		dl_ctx->type_caches = (dl_type_cache*)dl_alloc( &dl_ctx->alloc, sizeof( dl_type_cache ) * header->type_count );
+		if( dl_ctx->type_caches == 0x0 )
+			return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+
+	dl_error_t err = DL_ERROR_OK;
+	for( unsigned int i = 0; i < header->type_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_type( dl_ctx, i );
+	for( unsigned int i = 0; i < header->type_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_type_members( dl_ctx, i );
+	for( unsigned int i = 0; i < header->enum_count && err == DL_ERROR_OK; ++i )
+		err = dl_internal_index_enum( dl_ctx, i );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	dl_internal_build_patch_programs( dl_ctx );
+	return DL_ERROR_OK;
+}
+
+template <typename T>
+static bool dl_internal_unborrow_array( dl_ctx_t ctx, T** array, size_t count )
+{
+	if( !dl_internal_is_borrowed( ctx, *array ) )
+		return true;
+
+	T* owned = (T*)dl_alloc( &ctx->alloc, sizeof( T ) * count );
+	if( owned == 0x0 )
+		return false;
+	memcpy( owned, *array, sizeof( T ) * count );
+	*array = owned;
+	return true;
+}
+
+dl_error_t dl_internal_unborrow_type_library( dl_ctx_t ctx )
+{
+	if( ctx->borrowed_lib == 0x0 )
+		return DL_ERROR_OK;
+
+	dl_index_map* maps[DL_TYPELIB_LOOKUP_MAP_COUNT];
+	dl_internal_lookup_maps( ctx, maps );
+
+	// ... arrays that are already copied will not be copied again if this fails half way through ...
+	bool ok = dl_internal_unborrow_array( ctx, &ctx->type_ids,         ctx->type_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->enum_ids,         ctx->enum_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->type_descs,       ctx->type_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->type_caches,      ctx->type_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->member_descs,     ctx->member_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->enum_descs,       ctx->enum_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->enum_value_descs, ctx->enum_value_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->enum_alias_descs, ctx->enum_alias_count )
+		   && dl_internal_unborrow_array( ctx, &ctx->typedata_strings, ctx->typedata_strings_size )
+		   && dl_internal_unborrow_array( ctx, &ctx->default_data,     ctx->default_data_size )
+		   && dl_internal_unborrow_array( ctx, &ctx->patch_ops,        ctx->patch_op_count );
+	for( int i = 0; ok && i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+		ok = dl_internal_unborrow_array( ctx, &maps[i]->entries, maps[i]->capacity );
+	if( !ok )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	ctx->borrowed_lib      = 0x0;
+	ctx->borrowed_lib_size = 0;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_context_load_type_library( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_TYPELIB_LOAD, "dl_context_load_type_library", 0x0, lib_data_size );
+	dl_error_t err = dl_internal_load_type_library( dl_ctx, lib_data, lib_data_size );
+	if( err == DL_ERROR_OK )
+		stats.bytes( lib_data_size, 0 );
+	return err;
+}
+
+dl_error_t dl_context_load_type_library_borrowed( dl_ctx_t dl_ctx, const unsigned char* lib_data, size_t lib_data_size )
+{
+	dl_stats_scope stats( dl_ctx, DL_STATS_OP_TYPELIB_LOAD, "dl_context_load_type_library_borrowed", 0x0, lib_data_size );
+	dl_error_t err = dl_internal_load_type_library_borrowed( dl_ctx, lib_data, lib_data_size );
+	if( err == DL_ERROR_OK )
+		stats.bytes( lib_data_size, 0 );
+	return err;
 }
@@ -3,6 +3,8 @@
 #include "dl_types.h"
 #include "dl_alloc.h"
 #include "dl_txt_read.h"
+#include "dl_patch_ptr.h"
+#include "dl_stats.h"
 
 #include <stdlib.h> // strtoul
 #include <ctype.h>
@@ -31,12 +33,14 @@ static uint32_t dl_alloc_string( dl_ctx_t ctx, dl_txt_read_substr* str )
 	return pos;
 }
 
-static dl_type_desc* dl_alloc_type( dl_ctx_t ctx, dl_typeid_t tid )
+static dl_type_desc* dl_alloc_type( dl_ctx_t ctx, dl_txt_read_ctx* read_state, dl_typeid_t tid, dl_txt_read_substr* name )
 {
 	if( ctx->type_capacity <= ctx->type_count )
 	{
 		size_t cap = ctx->type_capacity;
 		ctx->type_ids   = dl_grow_array( &ctx->alloc, ctx->type_ids, &cap, 0 );
+		cap = ctx->type_capacity;
+		ctx->type_caches = dl_grow_array( &ctx->alloc, ctx->type_caches, &cap, 0 );
 		ctx->type_descs = dl_grow_array( &ctx->alloc, ctx->type_descs, &ctx->type_capacity, 0 );
 	}
 
@@ -46,10 +50,14 @@ static dl_type_desc* dl_alloc_type( dl_ctx_t ctx, dl_typeid_t tid )
 	ctx->type_ids[ type_index ] = tid;
 	dl_type_desc* type = ctx->type_descs + type_index;
 	memset( type, 0x0, sizeof( dl_type_desc ) );
+	type->name = dl_alloc_string( ctx, name );
 	type->flags = DL_TYPE_FLAG_DEFAULT;
 	type->member_start = ctx->member_count;
 	type->member_count = 0;
 
+	if( dl_internal_index_type( ctx, type_index ) != DL_ERROR_OK )
+		dl_txt_read_failed( ctx, read_state, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory when indexing type \"%.*s\"", name->len, name->str );
+
 	return type;
 }
 
@@ -208,7 +216,9 @@ static void dl_load_txt_build_default_data( dl_ctx_t ctx, dl_txt_read_ctx* read_
 		return;
 
 	// TODO: check that this is not outside the buffers
-	dl_type_desc*   def_type   = dl_alloc_type( ctx, dl_internal_hash_string( "a_type_here" ) );
+	size_t name_start = ctx->typedata_strings_size;
+	dl_txt_read_substr temp = { "a_type_here", 11 };
+	dl_type_desc*   def_type   = dl_alloc_type( ctx, read_state, dl_internal_hash_string( "a_type_here" ), &temp );
 	dl_member_desc* def_member = dl_alloc_member( ctx );
 
 	dl_member_desc* member = &ctx->member_descs[member_index];
@@ -220,9 +230,6 @@ static void dl_load_txt_build_default_data( dl_ctx_t ctx, dl_txt_read_ctx* read_
 
 	// TODO: check that typename do not exist in the ctx!
 
-	size_t name_start = ctx->typedata_strings_size;
-	dl_txt_read_substr temp = { "a_type_here", 11 };
-	def_type->name = dl_alloc_string( ctx, &temp );
 	def_type->size[DL_PTR_SIZE_HOST]      = member->size[DL_PTR_SIZE_HOST];
 	def_type->alignment[DL_PTR_SIZE_HOST] = member->alignment[DL_PTR_SIZE_HOST];
 	def_type->member_count = 1;
@@ -230,6 +237,8 @@ static void dl_load_txt_build_default_data( dl_ctx_t ctx, dl_txt_read_ctx* read_
 	memcpy( def_member, member, sizeof( dl_member_desc ) );
 	def_member->offset[0] = 0;
 	def_member->offset[1] = 0;
+	if( dl_internal_index_type_members( ctx, (uint32_t)( def_type - ctx->type_descs ) ) != DL_ERROR_OK )
+		dl_txt_read_failed( ctx, read_state, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory when indexing members of default value" );
 
 	dl_internal_str_format( def_buffer, sizeof(def_buffer), "{\"a_type_here\":{\"%s\":%.*s}}", dl_internal_member_name( ctx, member ), (int)def_len, read_state->start + def_start );
 
@@ -260,6 +269,7 @@ static void dl_load_txt_build_default_data( dl_ctx_t ctx, dl_txt_read_ctx* read_
 
 	--ctx->type_count;
 	--ctx->member_count;
+	dl_internal_unindex_type( ctx, ctx->type_count );
 	ctx->typedata_strings_size = name_start;
 }
 
@@ -621,6 +631,9 @@ static void dl_context_load_txt_type_library_read_enum( dl_ctx_t ctx, dl_txt_rea
 	edesc->value_start = value_start;
 	edesc->alias_count = ctx->enum_alias_count - alias_start; /// number of aliases for this enum, always at least 1. Alias 0 is consider the "main name" of the value and need to be a valid c enum name.
 	edesc->alias_start = alias_start; /// offset into alias list where aliases for this enum-value start.
+
+	if( dl_internal_index_enum( ctx, (uint32_t)( edesc - ctx->enum_descs ) ) != DL_ERROR_OK )
+		dl_txt_read_failed( ctx, read_state, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory when indexing enum \"%.*s\"", name->len, name->str );
 }
 
 static void dl_context_load_txt_type_library_read_enums( dl_ctx_t ctx, dl_txt_read_ctx* read_state )
@@ -907,8 +920,7 @@ static void dl_context_load_txt_type_library_read_type( dl_ctx_t ctx, dl_txt_rea
 	if( member_count == 0 )
 		dl_txt_read_failed( ctx, read_state, DL_ERROR_TYPELIB_MISSING_MEMBERS_IN_TYPE, "types without members are not allowed" );
 
-	dl_type_desc* type = dl_alloc_type( ctx, tid );
-	type->name = dl_alloc_string( ctx, name );
+	dl_type_desc* type = dl_alloc_type( ctx, read_state, tid, name );
 	type->flags = 0;
 	type->size[ DL_PTR_SIZE_32BIT ] = 0;
 	type->size[ DL_PTR_SIZE_64BIT ] = 0;
@@ -996,6 +1008,10 @@ static void dl_context_load_txt_type_library_inner( dl_ctx_t ctx, dl_txt_read_ct
 		for( unsigned int i = type_start; i < ctx->type_count; ++i )
 			dl_load_txt_calc_type_size_and_align( ctx, read_state, ctx->type_descs + i );
 
+		for( unsigned int i = type_start; i < ctx->type_count; ++i )
+			if( dl_internal_index_type_members( ctx, i ) != DL_ERROR_OK )
+				dl_txt_read_failed( ctx, read_state, DL_ERROR_OUT_OF_LIBRARY_MEMORY, "out of memory when indexing members of type \"%s\"", dl_internal_type_name( ctx, ctx->type_descs + i ) );
+
 		// fixup members
 		for( uint32_t member_index = member_start; member_index < ctx->member_count; ++member_index )
 		{
@@ -1022,6 +1038,8 @@ static void dl_context_load_txt_type_library_inner( dl_ctx_t ctx, dl_txt_read_ct
 
 		for( unsigned int i = type_start; i < ctx->type_count; ++i )
 			dl_context_load_txt_type_set_flags( ctx, ctx->type_descs + i );
+
+		dl_internal_build_patch_programs( ctx );
 	}
 	else
 	{
@@ -1031,15 +1049,22 @@ static void dl_context_load_txt_type_library_inner( dl_ctx_t ctx, dl_txt_read_ct
 
 dl_error_t dl_context_load_txt_type_library( dl_ctx_t ctx, const char* lib_data, size_t lib_data_size )
 {
-	(void)lib_data_size;
+	dl_stats_scope stats( ctx, DL_STATS_OP_TYPELIB_LOAD, "dl_context_load_txt_type_library", 0x0, lib_data_size );
 
 	dl_txt_read_ctx read_state;
 	read_state.start = lib_data;
 	read_state.end   = lib_data + lib_data_size;
 	read_state.iter  = lib_data;
+	read_state.index = 0x0;
 	read_state.err   = DL_ERROR_OK;
 
+	read_state.err = dl_internal_unborrow_type_library( ctx );
+	if( read_state.err != DL_ERROR_OK )
+		return read_state.err;
+
 	dl_context_load_txt_type_library_inner( ctx, &read_state );
 
+	if( read_state.err == DL_ERROR_OK )
+		stats.bytes( lib_data_size, 0 );
 	return read_state.err;
 }
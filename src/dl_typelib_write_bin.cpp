@@ -1,11 +1,9 @@
 #include <dl/dl_typelib.h>
 #include "dl_binary_writer.h"
+#include "dl_patch_ptr.h"
 
-dl_error_t dl_context_write_type_library( dl_ctx_t dl_ctx, unsigned char* out_lib, size_t out_lib_size, size_t* produced_bytes )
+static void dl_internal_write_type_library_sections( dl_ctx_t dl_ctx, dl_binary_writer* writer )
 {
-	dl_binary_writer writer;
-	dl_binary_writer_init( &writer, out_lib, out_lib_size, out_lib == 0x0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_32BIT );
-
 	// ... write header ...
 	// TODO: handle endianness!
 	dl_typelib_header header;
@@ -19,22 +17,83 @@ dl_error_t dl_context_write_type_library( dl_ctx_t dl_ctx, unsigned char* out_li
 	header.default_value_size = (uint32_t)dl_ctx->default_data_size;
 	header.typeinfo_strings_size = (uint32_t)dl_ctx->typedata_strings_size;
 
-	dl_binary_writer_write( &writer, &header, sizeof( dl_typelib_header ) );
-	dl_binary_writer_write( &writer, dl_ctx->type_ids, sizeof( dl_typeid_t ) * dl_ctx->type_count );
-	dl_binary_writer_write( &writer, dl_ctx->enum_ids, sizeof( dl_typeid_t ) * dl_ctx->enum_count );
-	dl_binary_writer_write( &writer, dl_ctx->type_descs, sizeof( dl_type_desc ) * dl_ctx->type_count );
-	dl_binary_writer_write( &writer, dl_ctx->enum_descs, sizeof( dl_enum_desc ) * dl_ctx->enum_count );
-	dl_binary_writer_write( &writer, dl_ctx->member_descs, sizeof( dl_member_desc ) * dl_ctx->member_count );
-	dl_binary_writer_write( &writer, dl_ctx->enum_value_descs, sizeof( dl_enum_value_desc ) * dl_ctx->enum_value_count );
-	dl_binary_writer_write( &writer, dl_ctx->enum_alias_descs, sizeof( dl_enum_alias_desc ) * dl_ctx->enum_alias_count );
-	dl_binary_writer_write( &writer, dl_ctx->default_data, dl_ctx->default_data_size );
-	dl_binary_writer_write( &writer, dl_ctx->typedata_strings, dl_ctx->typedata_strings_size );
+	dl_binary_writer_write( writer, &header, sizeof( dl_typelib_header ) );
+	dl_binary_writer_write( writer, dl_ctx->type_ids, sizeof( dl_typeid_t ) * dl_ctx->type_count );
+	dl_binary_writer_write( writer, dl_ctx->enum_ids, sizeof( dl_typeid_t ) * dl_ctx->enum_count );
+	dl_binary_writer_write( writer, dl_ctx->type_descs, sizeof( dl_type_desc ) * dl_ctx->type_count );
+	dl_binary_writer_write( writer, dl_ctx->enum_descs, sizeof( dl_enum_desc ) * dl_ctx->enum_count );
+	dl_binary_writer_write( writer, dl_ctx->member_descs, sizeof( dl_member_desc ) * dl_ctx->member_count );
+	dl_binary_writer_write( writer, dl_ctx->enum_value_descs, sizeof( dl_enum_value_desc ) * dl_ctx->enum_value_count );
+	dl_binary_writer_write( writer, dl_ctx->enum_alias_descs, sizeof( dl_enum_alias_desc ) * dl_ctx->enum_alias_count );
+	dl_binary_writer_write( writer, dl_ctx->default_data, dl_ctx->default_data_size );
+	dl_binary_writer_write( writer, dl_ctx->typedata_strings, dl_ctx->typedata_strings_size );
+}
+
+static void dl_internal_write_type_library_lookup( dl_ctx_t lib_ctx, dl_binary_writer* writer )
+{
+	dl_index_map* maps[DL_TYPELIB_LOOKUP_MAP_COUNT];
+	dl_internal_lookup_maps( lib_ctx, maps );
+
+	dl_typelib_lookup_header header;
+	header.id             = DL_TYPELIB_LOOKUP_ID;
+	header.ptr_size       = (uint8_t)sizeof(void*);
+	header.endian         = (uint8_t)DL_ENDIAN_HOST;
+	header.pad[0]         = header.pad[1] = 0;
+	header.patch_op_count = lib_ctx->patch_op_count;
+	for( int i = 0; i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+	{
+		header.map_capacity[i] = maps[i]->capacity;
+		header.map_count[i]    = maps[i]->count;
+	}
+
+	dl_binary_writer_align( writer, 4 );
+	dl_binary_writer_write( writer, &header, sizeof( dl_typelib_lookup_header ) );
+	dl_binary_writer_write( writer, lib_ctx->type_caches, sizeof( dl_type_cache ) * lib_ctx->type_count );
+	dl_binary_writer_write( writer, lib_ctx->patch_ops, sizeof( dl_patch_op ) * lib_ctx->patch_op_count );
+	for( int i = 0; i < DL_TYPELIB_LOOKUP_MAP_COUNT; ++i )
+		dl_binary_writer_write( writer, maps[i]->entries, sizeof( dl_index_map_entry ) * maps[i]->capacity );
+}
+
+dl_error_t dl_context_write_type_library( dl_ctx_t dl_ctx, unsigned char* out_lib, size_t out_lib_size, size_t* produced_bytes )
+{
+	// ... the lookup-section is built by loading the sections into a new context, that way it is exactly what
+	//     dl_context_load_type_library() would build and do not depend on in what order types was added to dl_ctx ...
+	dl_binary_writer sections;
+	dl_binary_writer_init_grow( &sections, dl_allocator_grow, &dl_ctx->alloc, 0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_32BIT );
+	dl_internal_write_type_library_sections( dl_ctx, &sections );
+	if( sections.out_of_memory )
+	{
+		dl_binary_writer_free( &sections );
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT( p );
+	p.alloc_func   = dl_ctx->alloc.alloc;
+	p.realloc_func = dl_ctx->alloc.realloc;
+	p.free_func    = dl_ctx->alloc.free;
+	p.alloc_ctx    = dl_ctx->alloc.ctx;
+
+	dl_ctx_t lib_ctx;
+	dl_error_t err = dl_context_create( &lib_ctx, &p );
+	if( err == DL_ERROR_OK )
+	{
+		err = dl_context_load_type_library( lib_ctx, sections.data, dl_binary_writer_needed_size( &sections ) );
+		if( err == DL_ERROR_OK )
+		{
+			dl_binary_writer writer;
+			dl_binary_writer_init( &writer, out_lib, out_lib_size, out_lib == 0x0, DL_ENDIAN_HOST, DL_ENDIAN_HOST, DL_PTR_SIZE_32BIT );
+			dl_binary_writer_write( &writer, sections.data, dl_binary_writer_needed_size( &sections ) );
+			dl_internal_write_type_library_lookup( lib_ctx, &writer );
 
-	// ... write default data ...
+			if( produced_bytes )
+				*produced_bytes = dl_binary_writer_needed_size( &writer );
+		}
+		dl_context_destroy( lib_ctx );
+	}
 
-	if( produced_bytes )
-		*produced_bytes = dl_binary_writer_needed_size( &writer );
+	dl_binary_writer_free( &sections );
 
 	// TODO: should write buffer to small on error.
-	return DL_ERROR_OK;
+	return err;
 }
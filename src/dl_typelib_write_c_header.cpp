@@ -377,6 +377,223 @@ static void dl_context_write_c_header_types( dl_binary_writer* writer, dl_ctx_t
 	free( type_info );
 }
 
+static void dl_context_write_c_header_relative_begin( dl_binary_writer* writer )
+{
+	dl_binary_writer_write_string_fmt( writer,
+									   "#if defined( DL_RELATIVE_ACCESSORS )\n\n"
+									   "#ifndef __DL_AUTOGEN_HEADER_DL_REL_DEFINED\n"
+									   "#define __DL_AUTOGEN_HEADER_DL_REL_DEFINED\n"
+									   "#  include <string.h> // for memcpy\n"
+									   "#  if defined( _MSC_VER ) && !defined( __cplusplus )\n"
+									   "#    define DL_REL_INLINE static __inline\n"
+									   "#  elif defined( __GNUC__ ) && !defined( __cplusplus )\n"
+									   "#    define DL_REL_INLINE static __inline__\n"
+									   "#  else\n"
+									   "#    define DL_REL_INLINE static inline\n"
+									   "#  endif\n"
+									   "// ... resolve a ref in an instance converted with dl_convert_to_relative(), 0 is null since a ref never points to itself ...\n"
+									   "DL_REL_INLINE const void* dl_rel_ref32( const void* ref ) { int32_t o; memcpy( &o, ref, sizeof(o) ); return o == 0 ? 0 : (const char*)ref + o; }\n"
+									   "DL_REL_INLINE const void* dl_rel_ref64( const void* ref ) { int64_t o; memcpy( &o, ref, sizeof(o) ); return o == 0 ? 0 : (const char*)ref + o; }\n"
+									   "DL_REL_INLINE const void* dl_rel_ref( const void* ref )   { return sizeof(void*) == 8 ? dl_rel_ref64( ref ) : dl_rel_ref32( ref ); }\n"
+									   "#endif // __DL_AUTOGEN_HEADER_DL_REL_DEFINED\n\n" );
+}
+
+static void dl_context_write_c_header_relative_end( dl_binary_writer* writer )
+{
+	dl_binary_writer_write_string_fmt( writer, "#endif // defined( DL_RELATIVE_ACCESSORS )\n\n" );
+}
+
+/**
+ * Write name of struct used to read sub-type of 4 byte refs, extern types are used as is.
+ */
+static void dl_context_write_c_header_ref32_struct( dl_binary_writer* writer, dl_ctx_t ctx, dl_typeid_t tid )
+{
+	dl_type_info_t sub_type;
+	dl_reflect_get_type_info( ctx, tid, &sub_type );
+	if( sub_type.is_extern )
+		dl_binary_writer_write_string_fmt( writer, "struct %s", sub_type.name );
+	else
+		dl_binary_writer_write_string_fmt( writer, "struct %s_ref32", sub_type.name );
+}
+
+static void dl_context_write_c_header_ref32_member( dl_binary_writer* writer, dl_ctx_t ctx, dl_member_info_t* member, bool* last_was_bf )
+{
+	dl_type_t atom    = (dl_type_t)(DL_TYPE_ATOM_MASK & member->type);
+	dl_type_t storage = (dl_type_t)(DL_TYPE_STORAGE_MASK & member->type);
+
+	switch( atom )
+	{
+		case DL_TYPE_ATOM_POD:
+		case DL_TYPE_ATOM_INLINE_ARRAY:
+			switch( storage )
+			{
+				case DL_TYPE_STORAGE_STRUCT:
+					dl_binary_writer_write_string_fmt( writer, "    " );
+					dl_context_write_c_header_ref32_struct( writer, ctx, member->type_id );
+					break;
+				case DL_TYPE_STORAGE_STR:
+				case DL_TYPE_STORAGE_PTR:
+					dl_binary_writer_write_string_fmt( writer, "    int32_t" );
+					break;
+				default:
+					// ... no refs, same as in the ordinary struct ...
+					dl_context_write_c_header_member( writer, ctx, member, last_was_bf );
+					return;
+			}
+			if( atom == DL_TYPE_ATOM_INLINE_ARRAY )
+				dl_binary_writer_write_string_fmt( writer, " %s[%u];\n", member->name, member->array_count );
+			else
+				dl_binary_writer_write_string_fmt( writer, " %s;\n", member->name );
+			break;
+		case DL_TYPE_ATOM_ARRAY:
+			dl_binary_writer_write_string_fmt( writer, "    struct { int32_t data; uint32_t count; } %s;\n", member->name );
+			break;
+		default:
+			dl_context_write_c_header_member( writer, ctx, member, last_was_bf );
+			return;
+	}
+
+	*last_was_bf = false;
+}
+
+/**
+ * Write accessor that resolve a ref-member, ref32 selects if it is for the struct with 4 byte refs or with refs of
+ * the size of a ptr.
+ */
+static void dl_context_write_c_header_ref_accessor( dl_binary_writer* writer, dl_ctx_t ctx, dl_type_info_t* type, dl_member_info_t* member, bool ref32 )
+{
+	dl_type_t atom    = (dl_type_t)(DL_TYPE_ATOM_MASK & member->type);
+	dl_type_t storage = (dl_type_t)(DL_TYPE_STORAGE_MASK & member->type);
+
+	const char* suffix   = ref32 ? "_ref32" : "";
+	const char* resolve  = ref32 ? "dl_rel_ref32" : "dl_rel_ref";
+	const char* ref_type = ref32 ? "int32_t" : "intptr_t";
+	const char* path     = type->is_union ? "value." : "";
+
+	bool is_ref_elem = storage == DL_TYPE_STORAGE_STR || storage == DL_TYPE_STORAGE_PTR;
+	if( atom == DL_TYPE_ATOM_INLINE_ARRAY && !is_ref_elem )
+		return;
+	if( atom != DL_TYPE_ATOM_POD && atom != DL_TYPE_ATOM_ARRAY && atom != DL_TYPE_ATOM_INLINE_ARRAY )
+		return;
+	if( atom == DL_TYPE_ATOM_POD && !is_ref_elem )
+		return;
+
+	// ... return-type, a resolved str or ptr or, for arrays of other types, the first element ...
+	dl_binary_writer_write_string_fmt( writer, "DL_REL_INLINE const " );
+	switch( storage )
+	{
+		case DL_TYPE_STORAGE_STR:
+			dl_binary_writer_write_string_fmt( writer, "char" );
+			break;
+		case DL_TYPE_STORAGE_PTR:
+		case DL_TYPE_STORAGE_STRUCT:
+			if( ref32 )
+				dl_context_write_c_header_ref32_struct( writer, ctx, member->type_id );
+			else
+				dl_context_write_type( ctx, DL_TYPE_STORAGE_STRUCT, member->type_id, writer );
+			break;
+		default:
+			dl_context_write_operator_array_access_type( ctx, storage, member->type_id, writer );
+			break;
+	}
+	dl_binary_writer_write_string_fmt( writer, "* %s%s_get_%s( const struct %s%s* s%s )\n{\n",
+											   type->name, suffix, member->name, type->name, suffix,
+											   atom == DL_TYPE_ATOM_POD || !is_ref_elem ? "" : ", uint32_t index" );
+
+	dl_binary_writer_write_string_fmt( writer, "    return (const " );
+	switch( storage )
+	{
+		case DL_TYPE_STORAGE_STR:
+			dl_binary_writer_write_string_fmt( writer, "char" );
+			break;
+		case DL_TYPE_STORAGE_PTR:
+		case DL_TYPE_STORAGE_STRUCT:
+			if( ref32 )
+				dl_context_write_c_header_ref32_struct( writer, ctx, member->type_id );
+			else
+				dl_context_write_type( ctx, DL_TYPE_STORAGE_STRUCT, member->type_id, writer );
+			break;
+		default:
+			dl_context_write_operator_array_access_type( ctx, storage, member->type_id, writer );
+			break;
+	}
+
+	switch( atom )
+	{
+		case DL_TYPE_ATOM_POD:
+			dl_binary_writer_write_string_fmt( writer, "*)%s( &s->%s%s );\n", resolve, path, member->name );
+			break;
+		case DL_TYPE_ATOM_INLINE_ARRAY:
+			dl_binary_writer_write_string_fmt( writer, "*)%s( &s->%s%s[index] );\n", resolve, path, member->name );
+			break;
+		default:
+			if( is_ref_elem )
+				dl_binary_writer_write_string_fmt( writer, "*)%s( (const %s*)%s( &s->%s%s.data ) + index );\n", resolve, ref_type, resolve, path, member->name );
+			else
+				dl_binary_writer_write_string_fmt( writer, "*)%s( &s->%s%s.data );\n", resolve, path, member->name );
+			break;
+	}
+	dl_binary_writer_write_string_fmt( writer, "}\n\n" );
+}
+
+/**
+ * Write structs and accessors used to read instances converted with dl_convert_to_relative(). Accessors for
+ * "struct <type>" read refs of the size of a ptr on the platform, "struct <type>_ref32" is the layout with 4 byte
+ * refs and is used to read such instances on 64-bit platforms.
+ */
+static void dl_context_write_c_header_relative( dl_binary_writer* writer, dl_ctx_t ctx )
+{
+	dl_context_write_c_header_relative_begin( writer );
+
+	dl_type_context_info_t ctx_info;
+	dl_reflect_context_info( ctx, &ctx_info );
+
+	dl_type_info_t* type_info = (dl_type_info_t*)malloc( ctx_info.num_types * sizeof( dl_type_info_t ) );
+	dl_reflect_loaded_types( ctx, type_info, ctx_info.num_types );
+
+	for( unsigned int type_index = 0; type_index < ctx_info.num_types; ++type_index )
+	{
+		dl_type_info_t* type = &type_info[type_index];
+		if( type->is_extern )
+			continue;
+
+		dl_member_info_t* members = (dl_member_info_t*)malloc( type->member_count * sizeof( dl_member_info_t ) );
+		dl_reflect_get_type_members( ctx, type->tid, members, type->member_count );
+
+		unsigned int max_align = 0;
+		for( unsigned int member_index = 0; member_index < type->member_count; ++member_index )
+			max_align = members[member_index].alignment > max_align ? members[member_index].alignment : max_align;
+
+		if( max_align < type->alignment )
+			dl_binary_writer_write_string_fmt( writer, "struct DL_ALIGN( %u ) %s_ref32\n{\n", type->alignment, type->name );
+		else
+			dl_binary_writer_write_string_fmt( writer, "struct %s_ref32\n{\n", type->name );
+
+		bool last_was_bf = false;
+		if( type->is_union )
+			dl_binary_writer_write_string_fmt( writer, "    union\n"
+													   "    {\n" );
+		for( unsigned int member_index = 0; member_index < type->member_count; ++member_index )
+			dl_context_write_c_header_ref32_member( writer, ctx, members + member_index, &last_was_bf );
+		if( type->is_union )
+			dl_binary_writer_write_string_fmt( writer, "    } value;\n"
+													   "    enum %s_type type;\n", type->name );
+		dl_binary_writer_write_string_fmt( writer, "};\n\n" );
+
+		for( unsigned int member_index = 0; member_index < type->member_count; ++member_index )
+		{
+			dl_context_write_c_header_ref_accessor( writer, ctx, type, members + member_index, false );
+			dl_context_write_c_header_ref_accessor( writer, ctx, type, members + member_index, true );
+		}
+
+		free( members );
+	}
+
+	free( type_info );
+
+	dl_context_write_c_header_relative_end( writer );
+}
+
 dl_error_t dl_context_write_type_library_c_header( dl_ctx_t dl_ctx, const char* module_name, char* out_header, size_t out_header_size, size_t* produced_bytes )
 {
 	char MODULE_NAME[128];
@@ -401,6 +618,8 @@ dl_error_t dl_context_write_type_library_c_header( dl_ctx_t dl_ctx, const char*
 
 	dl_context_write_c_header_types( &writer, dl_ctx );
 
+	dl_context_write_c_header_relative( &writer, dl_ctx );
+
 	dl_context_write_c_header_end( &writer, MODULE_NAME );
 
 	if( produced_bytes )
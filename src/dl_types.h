@@ -14,6 +14,7 @@
 #include "dl_alloc.h"
 #include "dl_swap.h"
 #include "dl_assert.h"
+#include "dl_index_map.h"
 
 #include <stdarg.h> // for va_list
 
@@ -40,12 +41,14 @@
 #endif
 
 static const uint32_t DL_UNUSED DL_TYPELIB_VERSION         = 4; // format version for type-libraries.
-static const uint32_t DL_UNUSED DL_INSTANCE_VERSION        = 1; // format version for instances.
+static const uint32_t DL_UNUSED DL_INSTANCE_VERSION        = 2; // format version for instances.
 static const uint32_t DL_UNUSED DL_INSTANCE_VERSION_SWAPED = dl_swap_endian_uint32( DL_INSTANCE_VERSION );
+static const uint32_t DL_UNUSED DL_INSTANCE_VERSION_1      = 1; // oldest format version for instances that can still be read, 32-bit instance_size.
 static const uint32_t DL_UNUSED DL_TYPELIB_ID              = ('D'<< 24) | ('L' << 16) | ('T' << 8) | 'L';
 static const uint32_t DL_UNUSED DL_TYPELIB_ID_SWAPED       = dl_swap_endian_uint32( DL_TYPELIB_ID );
 static const uint32_t DL_UNUSED DL_INSTANCE_ID             = ('D'<< 24) | ('L' << 16) | ('D' << 8) | 'L';
 static const uint32_t DL_UNUSED DL_INSTANCE_ID_SWAPED      = dl_swap_endian_uint32( DL_INSTANCE_ID );
+static const uint32_t DL_UNUSED DL_TYPELIB_LOOKUP_ID       = ('D'<< 24) | ('L' << 16) | ('L' << 8) | '2'; // changed when dl_typelib_lookup_header changes.
 
 #undef DL_UNUSED
 
@@ -70,13 +73,57 @@ struct dl_typelib_header
 	uint32_t typeinfo_strings_size;
 };
 
+/**
+ * Number of dl_index_map:s stored in the lookup-section of a type-library, see dl_typelib_lookup_header.
+ */
+#define DL_TYPELIB_LOOKUP_MAP_COUNT 6
+
+/**
+ * Header of the optional lookup-section stored after the strings of a type-library, aligned to 4 bytes. The section
+ * holds everything that dl_context_load_type_library() calculates from the type-library so that a context can
+ * reference it as is, see dl_context_load_type_library_borrowed().
+ *
+ * The header is followed by:
+ *   dl_type_cache[type_count]
+ *   dl_patch_op[patch_op_count]
+ *   dl_index_map_entry[map_capacity[i]] for each map in the order returned by dl_internal_lookup_maps().
+ *
+ * The section is stored in the endianness of the platform that wrote it and the patch-ops has the offsets of its
+ * ptr-size, a section written by a platform with another ptr-size or endianness is ignored.
+ */
+struct dl_typelib_lookup_header
+{
+	uint32_t id;
+	uint8_t  ptr_size; ///< sizeof(void*) of the platform that wrote the section.
+	uint8_t  endian;   ///< dl_endian_t of the platform that wrote the section.
+	uint8_t  pad[2];
+	uint32_t patch_op_count;
+	uint32_t map_capacity[DL_TYPELIB_LOOKUP_MAP_COUNT];
+	uint32_t map_count[DL_TYPELIB_LOOKUP_MAP_COUNT];
+};
+
 struct dl_data_header
 {
 	uint32_t    id;
 	uint32_t    version;
 	dl_typeid_t root_instance_type;
-	uint32_t    instance_size;
 	uint8_t     is_64_bit_ptr; // currently uses uint8 instead of bitfield to be compiler-compliant.
+	uint8_t     is_relative_ptr; // ptrs, strings and arrays are stored as offsets from the ptr itself, see dl_convert_to_relative().
+	uint8_t     pad[2];
+	uint64_t    instance_size;
+};
+
+/**
+ * Header of instances stored with DL_INSTANCE_VERSION_1, only read. pad was never written by the code that wrote this
+ * version and might hold anything, so instances of this version are never relative.
+ */
+struct dl_data_header_v1
+{
+	uint32_t    id;
+	uint32_t    version;
+	dl_typeid_t root_instance_type;
+	uint32_t    instance_size;
+	uint8_t     is_64_bit_ptr;
 	uint8_t     pad[3];
 };
 
@@ -183,6 +230,21 @@ struct dl_type_desc
 	uint32_t member_start;
 };
 
+/**
+ * Data calculated for each type at load-time, not stored in the type-library.
+ */
+struct dl_type_cache
+{
+	uint32_t largest_member_size[2]; ///< size of the largest member of the type, per ptr-size. Used to find the type-tag of unions.
+	uint32_t patch_op_start;         ///< index of first op of the patch-program of this type in dl_context::patch_ops, DL_PATCH_PROGRAM_NOT_BUILT if not built.
+	uint32_t patch_op_count;         ///< number of ops in the patch-program of this type.
+};
+
+static const uint32_t DL_PATCH_PROGRAM_NOT_BUILT = 0xFFFFFFFF;
+
+struct dl_patch_op;   // defined in dl_patch_ptr.h
+struct dl_convert_op; // defined in dl_convert_plan.h
+
 struct dl_enum_value_desc
 {
 	uint32_t main_alias;
@@ -206,11 +268,16 @@ struct dl_enum_alias_desc
 
 struct dl_context
 {
-	dl_allocator alloc;
+	dl_allocator alloc;          ///< allocator for memory owned by the context, wraps instance_alloc to track allocations when collecting stats.
+	dl_allocator instance_alloc; ///< allocator passed to dl_context_create(), used for buffers returned to the caller.
 
 	dl_error_msg_handler error_msg_func;
 	void*                error_msg_ctx;
 
+	dl_trace_func trace_begin_func; ///< see dl_trace_scope.
+	dl_trace_func trace_end_func;
+	void*         trace_ctx;
+
 	unsigned int type_count;
 	unsigned int enum_count;
 	unsigned int member_count;
@@ -227,6 +294,7 @@ struct dl_context
 	dl_typeid_t* enum_ids; ///< list of all loaded typeid:s for enums in the same order they appear in enum_descs
 
 	dl_type_desc*       type_descs;    ///< list of all loaded descriptors for types.
+	dl_type_cache*      type_caches;   ///< cached data for each type in type_descs, in the same order.
 	dl_member_desc*     member_descs; ///< list of all loaded descriptors for members in types.
 	dl_enum_desc*       enum_descs;
 	dl_enum_value_desc* enum_value_descs;
@@ -238,6 +306,29 @@ struct dl_context
 
 	uint8_t* default_data;
 	size_t   default_data_size;
+
+	dl_index_map type_lookup;       ///< typeid -> index in type_descs, kept in sync with type_ids.
+	dl_index_map type_name_lookup;  ///< hash of type name -> index in type_descs.
+	dl_index_map member_lookup;     ///< dl_internal_scoped_key() of type index and member name hash -> index in member_descs.
+	dl_index_map enum_lookup;       ///< enum typeid -> index in enum_descs.
+	dl_index_map enum_alias_lookup; ///< hash of alias name -> index in enum_alias_descs.
+	dl_index_map enum_value_lookup; ///< dl_internal_scoped_key() of enum index and value -> index in enum_value_descs.
+
+	dl_patch_op* patch_ops;         ///< patch-programs for all types, see dl_internal_build_patch_programs().
+	uint32_t     patch_op_count;
+	uint32_t     patch_op_capacity;
+
+	dl_convert_op* convert_ops;         ///< conversion-plans built so far, see dl_internal_convert_plan().
+	uint32_t       convert_op_count;
+	uint32_t       convert_op_capacity;
+	dl_index_map   convert_plan_lookup; ///< dl_internal_scoped_key() of type index and plan-variant -> index in convert_ops.
+
+	const uint8_t* borrowed_lib;      ///< type-library loaded with dl_context_load_type_library_borrowed(), arrays pointing into it are not owned by the context.
+	size_t         borrowed_lib_size;
+
+	dl_stats_mode_t    stats_mode;
+	uint32_t           stats_depth; ///< number of nested operations currently running, see dl_stats_scope.
+	dl_context_stats_t stats;
 };
 
 #if defined( __GNUC__ )
@@ -272,14 +363,59 @@ inline unsigned int dl_bf_offset( dl_endian_t endian, unsigned int bf_size, unsi
 
 DL_FORCEINLINE dl_endian_t dl_other_endian( dl_endian_t endian ) { return endian == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE; }
 
+/**
+ * Return true if ptr points into the type-library borrowed by the context and should not be written to or freed.
+ */
+static inline bool dl_internal_is_borrowed( dl_ctx_t ctx, const void* ptr )
+{
+	return ctx->borrowed_lib != 0x0 && (const uint8_t*)ptr >= ctx->borrowed_lib && (const uint8_t*)ptr < ctx->borrowed_lib + ctx->borrowed_lib_size;
+}
+
+/**
+ * Copy all arrays of the context that reference a borrowed type-library to memory owned by the context, needs to be
+ * done before anything is added to the context.
+ *
+ * @return DL_ERROR_OUT_OF_LIBRARY_MEMORY if the copies could not be allocated.
+ */
+dl_error_t dl_internal_unborrow_type_library( dl_ctx_t ctx );
+
+/**
+ * Read the header of a packed instance stored with any supported format-version and endian.
+ *
+ * @param packed_instance packed instance to read header from.
+ * @param packed_instance_size size of packed_instance.
+ * @param header set to the header, converted to the current version and host-endian.
+ * @param header_size set to the size of the header as stored in packed_instance, i.e. where the instance-data starts.
+ * @param endian set to the endian the instance is stored in.
+ *
+ * @return DL_ERROR_OK on success, DL_ERROR_MALFORMED_DATA if packed_instance is not a packed instance or
+ *         DL_ERROR_VERSION_MISMATCH if it is stored with an unsupported version.
+ */
+dl_error_t dl_internal_read_instance_header( const unsigned char* packed_instance, size_t packed_instance_size,
+											 dl_data_header* header, size_t* header_size, dl_endian_t* endian );
+
+/**
+ * Get all lookup-maps of the context, in the order they are stored in the lookup-section of a type-library.
+ */
+static inline void dl_internal_lookup_maps( dl_ctx_t ctx, dl_index_map* maps[DL_TYPELIB_LOOKUP_MAP_COUNT] )
+{
+	maps[0] = &ctx->type_lookup;
+	maps[1] = &ctx->type_name_lookup;
+	maps[2] = &ctx->member_lookup;
+	maps[3] = &ctx->enum_lookup;
+	maps[4] = &ctx->enum_alias_lookup;
+	maps[5] = &ctx->enum_value_lookup;
+}
+
 static inline const dl_type_desc* dl_internal_find_type(dl_ctx_t dl_ctx, dl_typeid_t type_id)
 {
-	// linear search right now!
-    for(unsigned int i = 0; i < dl_ctx->type_count; ++i)
-    	if( dl_ctx->type_ids[i] == type_id )
-    		return &dl_ctx->type_descs[i];
+	if( dl_ctx->stats_mode != DL_STATS_NONE )
+		++dl_ctx->stats.type_lookups;
 
-    return 0x0;
+	uint32_t type_index = dl_index_map_find( &dl_ctx->type_lookup, type_id );
+	if( type_index == DL_INDEX_MAP_EMPTY )
+		return 0x0;
+	return &dl_ctx->type_descs[type_index];
 }
 
 static inline const char* dl_internal_type_name      ( dl_ctx_t ctx, const dl_type_desc*       type   ) { return &ctx->typedata_strings[type->name]; }
@@ -287,12 +423,31 @@ static inline const char* dl_internal_member_name    ( dl_ctx_t ctx, const dl_me
 static inline const char* dl_internal_enum_name      ( dl_ctx_t ctx, const dl_enum_desc*       enum_  ) { return &ctx->typedata_strings[enum_->name]; }
 static inline const char* dl_internal_enum_alias_name( dl_ctx_t ctx, const dl_enum_alias_desc* alias  ) { return &ctx->typedata_strings[alias->name]; }
 
-static inline const dl_type_desc* dl_internal_find_type_by_name( dl_ctx_t dl_ctx, const char* name )
+static inline uint32_t dl_internal_hash_name( const char* name, size_t name_len )
+{
+	return dl_internal_hash_buffer( (const uint8_t*)name, name_len );
+}
+
+/**
+ * Return true if the zero-terminated str is equal to the name-substring name, name_len.
+ */
+static inline bool dl_internal_name_equal( const char* str, const char* name, size_t name_len )
+{
+	return strncmp( str, name, name_len ) == 0 && str[name_len] == '\0';
+}
+
+static inline const dl_type_desc* dl_internal_find_type_by_name( dl_ctx_t dl_ctx, const char* name, size_t name_len )
 {
-	for(unsigned int i = 0; i < dl_ctx->type_count; ++i)
+	if( dl_ctx->stats_mode != DL_STATS_NONE )
+		++dl_ctx->stats.type_lookups;
+
+	uint32_t iter = 0;
+	uint32_t type_index;
+	uint32_t name_hash = dl_internal_hash_name( name, name_len );
+	while( ( type_index = dl_index_map_find_next( &dl_ctx->type_name_lookup, name_hash, &iter ) ) != DL_INDEX_MAP_EMPTY )
 	{
-		dl_type_desc* desc = &dl_ctx->type_descs[i];
-		if( strcmp( name, dl_internal_type_name( dl_ctx, desc ) ) == 0 )
+		const dl_type_desc* desc = &dl_ctx->type_descs[type_index];
+		if( dl_internal_name_equal( dl_internal_type_name( dl_ctx, desc ), name, name_len ) )
 			return desc;
 	}
 	return 0x0;
@@ -341,11 +496,10 @@ static inline dl_typeid_t dl_internal_typeid_of( dl_ctx_t dl_ctx, const dl_type_
 
 static inline const dl_enum_desc* dl_internal_find_enum( dl_ctx_t dl_ctx, dl_typeid_t type_id )
 {
-	for( unsigned int i = 0; i < dl_ctx->enum_count; ++i )
-		if( dl_ctx->enum_ids[i] == type_id )
-			return &dl_ctx->enum_descs[i];
-
-	return 0x0;
+	uint32_t enum_index = dl_index_map_find( &dl_ctx->enum_lookup, type_id );
+	if( enum_index == DL_INDEX_MAP_EMPTY )
+		return 0x0;
+	return &dl_ctx->enum_descs[enum_index];
 }
 
 static inline const dl_member_desc* dl_get_type_member( dl_ctx_t ctx, const dl_type_desc* type, unsigned int member_index )
@@ -355,28 +509,42 @@ static inline const dl_member_desc* dl_get_type_member( dl_ctx_t ctx, const dl_t
 
 static inline uint32_t dl_internal_largest_member_size( dl_ctx_t ctx, const dl_type_desc* type, dl_ptr_size_t ptr_size )
 {
-	uint32_t max_member_size = 0; // TODO: calc and store this in type?
-	for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
+	return ctx->type_caches[ type - ctx->type_descs ].largest_member_size[ptr_size];
+}
+
+/**
+ * Build a key for the lookup-maps in ctx from a hash or value that is only unique within one type or enum.
+ */
+static inline uint32_t dl_internal_scoped_key( uint32_t scope_index, uint32_t key )
+{
+	return key ^ ( scope_index * 2654435761u );
+}
+
+/**
+ * Find index of member in type by the hash of its name.
+ *
+ * @return index of the member in type or type->member_count + 1 if not found.
+ */
+static inline unsigned int dl_internal_find_member( dl_ctx_t ctx, const dl_type_desc* type, uint32_t name_hash )
+{
+	uint32_t iter = 0;
+	uint32_t member_index;
+	uint32_t key = dl_internal_scoped_key( (uint32_t)( type - ctx->type_descs ), name_hash );
+	while( ( member_index = dl_index_map_find_next( &ctx->member_lookup, key, &iter ) ) != DL_INDEX_MAP_EMPTY )
 	{
-		const dl_member_desc* member = dl_get_type_member( ctx, type, member_index );
-		max_member_size = member->size[ptr_size] > max_member_size ? member->size[ptr_size] : max_member_size;
+		// ... keys are unique within a type, so a member in the range of type is the one searched for ...
+		if( member_index >= type->member_start && member_index < type->member_start + type->member_count )
+			return member_index - type->member_start;
 	}
-	return max_member_size;
+	return type->member_count + 1;
 }
 
 static inline const dl_member_desc* dl_internal_find_member_desc_by_name_hash( dl_ctx_t dl_ctx, const dl_type_desc* type, uint32_t name_hash )
 {
-	for( uint32_t member_index = 0; member_index < type->member_count; ++member_index )
-	{
-		const dl_member_desc* member = dl_get_type_member( dl_ctx, type, member_index );
-		const char* member_name = dl_internal_member_name( dl_ctx, member );
-
-		// TODO: cache hashed name in ctx, this needs to be done not to depend on saving the string-names in the ctx.
-		uint32_t member_name_hash = dl_internal_hash_string( member_name );
-		if( member_name_hash == name_hash )
-			return member;
-	}
-	return 0x0;
+	unsigned int member_index = dl_internal_find_member( dl_ctx, type, name_hash );
+	if( member_index >= type->member_count )
+		return 0x0;
+	return dl_get_type_member( dl_ctx, type, member_index );
 }
 
 static inline const dl_enum_value_desc* dl_get_enum_value( dl_ctx_t ctx, const dl_enum_desc* e, unsigned int value_index )
@@ -389,41 +557,42 @@ static inline const dl_enum_alias_desc* dl_get_enum_alias( dl_ctx_t ctx, const d
 	return &ctx->enum_alias_descs[ e->alias_start + alias_index ];
 }
 
-static inline unsigned int dl_internal_find_member( dl_ctx_t ctx, const dl_type_desc* type, dl_typeid_t name_hash )
+/**
+ * Find alias with name in the range [alias_start, alias_end) in the enum_alias_descs of the context.
+ */
+static inline const dl_enum_alias_desc* dl_internal_find_enum_alias( dl_ctx_t ctx, uint32_t alias_start, uint32_t alias_end, const char* name, size_t name_len )
 {
-	for(unsigned int i = 0; i < type->member_count; ++i)
-		if( dl_internal_hash_string( dl_internal_member_name( ctx, dl_get_type_member( ctx, type, i ) ) ) == name_hash )
-			return i;
+	uint32_t iter = 0;
+	uint32_t alias_index;
+	uint32_t name_hash = dl_internal_hash_name( name, name_len );
+	while( ( alias_index = dl_index_map_find_next( &ctx->enum_alias_lookup, name_hash, &iter ) ) != DL_INDEX_MAP_EMPTY )
+	{
+		if( alias_index < alias_start || alias_index >= alias_end )
+			continue;
 
-	return type->member_count + 1;
+		const dl_enum_alias_desc* a = &ctx->enum_alias_descs[alias_index];
+		if( dl_internal_name_equal( dl_internal_enum_alias_name( ctx, a ), name, name_len ) )
+			return a;
+	}
+	return 0x0;
 }
 
 static inline bool dl_internal_find_enum_value( dl_ctx_t ctx, const dl_enum_desc* e, const char* name, size_t name_len, uint32_t* value )
 {
-	for( unsigned int j = 0; j < e->alias_count; ++j )
-	{
-		const dl_enum_alias_desc* a = dl_get_enum_alias( ctx, e, j );
-		if( strncmp( dl_internal_enum_alias_name( ctx, a ), name, name_len ) == 0 )
-		{
-			*value = ctx->enum_value_descs[ a->value_index ].value;
-			return true;
-		}
-	}
-	return false;
+	const dl_enum_alias_desc* a = dl_internal_find_enum_alias( ctx, e->alias_start, e->alias_start + e->alias_count, name, name_len );
+	if( a == 0x0 )
+		return false;
+	*value = ctx->enum_value_descs[ a->value_index ].value;
+	return true;
 }
 
 static inline bool dl_internal_find_enum_value_from_name( dl_ctx_t ctx, const char* name, size_t name_len, uint32_t* value )
 {
-	for( unsigned int i = 0; i < ctx->enum_alias_count; ++i )
-	{
-		const char* alias_name = dl_internal_enum_alias_name( ctx, &ctx->enum_alias_descs[i] );
-		if( strncmp( alias_name, name, name_len ) == 0 )
-		{
-			*value = ctx->enum_value_descs[ctx->enum_alias_descs[i].value_index].value;
-			return true;
-		}
-	}
-	return false;
+	const dl_enum_alias_desc* a = dl_internal_find_enum_alias( ctx, 0, ctx->enum_alias_count, name, name_len );
+	if( a == 0x0 )
+		return false;
+	*value = ctx->enum_value_descs[ a->value_index ].value;
+	return true;
 }
 
 static inline const char* dl_internal_find_enum_name( dl_ctx_t dl_ctx, dl_typeid_t type_id, uint32_t value )
@@ -433,14 +602,101 @@ static inline const char* dl_internal_find_enum_name( dl_ctx_t dl_ctx, dl_typeid
 	if( e == 0x0 )
 		return "UnknownEnum!";
 
-	for( unsigned int j = 0; j < e->value_count; ++j )
+	uint32_t iter = 0;
+	uint32_t value_index;
+	uint32_t key = dl_internal_scoped_key( (uint32_t)( e - dl_ctx->enum_descs ), value );
+	while( ( value_index = dl_index_map_find_next( &dl_ctx->enum_value_lookup, key, &iter ) ) != DL_INDEX_MAP_EMPTY )
 	{
-		const dl_enum_value_desc* v = dl_get_enum_value( dl_ctx, e, j );
-		if( v->value == value )
+		const dl_enum_value_desc* v = &dl_ctx->enum_value_descs[value_index];
+		if( value_index >= e->value_start && value_index < e->value_start + e->value_count && v->value == value )
 			return dl_internal_enum_alias_name( dl_ctx, &dl_ctx->enum_alias_descs[v->main_alias] );
 	}
 
 	return "UnknownEnum!";
 }
 
+/**
+ * Add type at type_index to the lookup-tables of the context, should be called when the type is fully loaded
+ * and its name set.
+ */
+static inline dl_error_t dl_internal_index_type( dl_ctx_t ctx, uint32_t type_index )
+{
+	dl_error_t err = dl_index_map_insert( &ctx->alloc, &ctx->type_lookup, ctx->type_ids[type_index], type_index );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	const char* name = dl_internal_type_name( ctx, &ctx->type_descs[type_index] );
+	return dl_index_map_insert( &ctx->alloc, &ctx->type_name_lookup, dl_internal_hash_name( name, strlen( name ) ), type_index );
+}
+
+/**
+ * Add the members of type at type_index to the member-lookup of the context and calculate its dl_type_cache, should
+ * be called when sizes of all members of the type is known.
+ */
+static inline dl_error_t dl_internal_index_type_members( dl_ctx_t ctx, uint32_t type_index )
+{
+	const dl_type_desc* type = &ctx->type_descs[type_index];
+	dl_type_cache* cache = &ctx->type_caches[type_index];
+	cache->largest_member_size[DL_PTR_SIZE_32BIT] = 0;
+	cache->largest_member_size[DL_PTR_SIZE_64BIT] = 0;
+	cache->patch_op_start = DL_PATCH_PROGRAM_NOT_BUILT;
+	cache->patch_op_count = 0;
+
+	for( uint32_t i = 0; i < type->member_count; ++i )
+	{
+		const dl_member_desc* member = dl_get_type_member( ctx, type, i );
+		for( int ptr_size = DL_PTR_SIZE_32BIT; ptr_size <= DL_PTR_SIZE_64BIT; ++ptr_size )
+			if( member->size[ptr_size] > cache->largest_member_size[ptr_size] )
+				cache->largest_member_size[ptr_size] = member->size[ptr_size];
+
+		uint32_t key = dl_internal_scoped_key( type_index, dl_internal_hash_string( dl_internal_member_name( ctx, member ) ) );
+		dl_error_t err = dl_index_map_insert( &ctx->alloc, &ctx->member_lookup, key, type->member_start + i );
+		if( err != DL_ERROR_OK )
+			return err;
+	}
+	return DL_ERROR_OK;
+}
+
+static inline void dl_internal_unindex_type( dl_ctx_t ctx, uint32_t type_index )
+{
+	const dl_type_desc* type = &ctx->type_descs[type_index];
+	for( uint32_t i = 0; i < type->member_count; ++i )
+	{
+		uint32_t key = dl_internal_scoped_key( type_index, dl_internal_hash_string( dl_internal_member_name( ctx, dl_get_type_member( ctx, type, i ) ) ) );
+		dl_index_map_remove( &ctx->member_lookup, key, type->member_start + i );
+	}
+
+	const char* name = dl_internal_type_name( ctx, &ctx->type_descs[type_index] );
+	dl_index_map_remove( &ctx->type_lookup, ctx->type_ids[type_index], type_index );
+	dl_index_map_remove( &ctx->type_name_lookup, dl_internal_hash_name( name, strlen( name ) ), type_index );
+}
+
+/**
+ * Add enum at enum_index, together with its values and aliases, to the lookup-tables of the context.
+ */
+static inline dl_error_t dl_internal_index_enum( dl_ctx_t ctx, uint32_t enum_index )
+{
+	const dl_enum_desc* e = &ctx->enum_descs[enum_index];
+	dl_error_t err = dl_index_map_insert( &ctx->alloc, &ctx->enum_lookup, ctx->enum_ids[enum_index], enum_index );
+	if( err != DL_ERROR_OK )
+		return err;
+
+	for( uint32_t i = 0; i < e->value_count; ++i )
+	{
+		const dl_enum_value_desc* v = dl_get_enum_value( ctx, e, i );
+		err = dl_index_map_insert( &ctx->alloc, &ctx->enum_value_lookup, dl_internal_scoped_key( enum_index, v->value ), e->value_start + i );
+		if( err != DL_ERROR_OK )
+			return err;
+	}
+
+	for( uint32_t i = 0; i < e->alias_count; ++i )
+	{
+		const char* name = dl_internal_enum_alias_name( ctx, dl_get_enum_alias( ctx, e, i ) );
+		err = dl_index_map_insert( &ctx->alloc, &ctx->enum_alias_lookup, dl_internal_hash_name( name, strlen( name ) ), e->alias_start + i );
+		if( err != DL_ERROR_OK )
+			return err;
+	}
+	return DL_ERROR_OK;
+}
+
 #endif // DL_DL_TYPES_H_INCLUDED
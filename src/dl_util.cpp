@@ -3,29 +3,149 @@
 #include <dl/dl_util.h>
 #include <dl/dl_txt.h>
 #include <dl/dl_convert.h>
+#include <dl/dl_archive.h>
 
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined( _WIN32 )
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+/**
+ * Read the rest of file, the returned buffer is always at least one byte larger than out_size to make room for a
+ * terminating '\0'.
+ */
 static unsigned char* dl_read_entire_stream( FILE* file, size_t* out_size )
 {
-	const unsigned int CHUNK_SIZE = 1024;
-	size_t         total_size = 0;
-	size_t         chunk_size = 0;
-	unsigned char* out_buffer = 0;
+	// ... read everything in one go if the size of the stream can be found, otherwise grow until all is read ...
+	size_t capacity = 4096;
+	long start = ftell( file );
+	if( start >= 0 && fseek( file, 0, SEEK_END ) == 0 )
+	{
+		long end = ftell( file );
+		fseek( file, start, SEEK_SET );
+		if( end > start )
+			capacity = (size_t)( end - start ) + 1;
+	}
 
-	do
+	size_t         total_size = 0;
+	unsigned char* out_buffer = (unsigned char*)malloc( capacity );
+	while( out_buffer != 0x0 )
 	{
-		out_buffer = (unsigned char*)realloc( out_buffer, CHUNK_SIZE + total_size );
-		chunk_size = fread( out_buffer + total_size, 1, CHUNK_SIZE, file );
-		total_size += chunk_size;
+		total_size += fread( out_buffer + total_size, 1, capacity - total_size, file );
+		if( total_size < capacity )
+			break;
+
+		capacity *= 2;
+		unsigned char* new_buffer = (unsigned char*)realloc( out_buffer, capacity );
+		if( new_buffer == 0x0 )
+			free( out_buffer );
+		out_buffer = new_buffer;
 	}
-	while( chunk_size >= CHUNK_SIZE );
 
 	*out_size = total_size;
 	return out_buffer;
 }
 
+/**
+ * Map entire file copy-on-write.
+ */
+static dl_error_t dl_util_map_raw( const char* filename, unsigned int map_flags, unsigned char** out_data, size_t* out_size )
+{
+#if defined( _WIN32 )
+	(void)map_flags;
+	HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, 0x0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0x0 );
+	if( file == INVALID_HANDLE_VALUE )
+		return DL_ERROR_UTIL_FILE_NOT_FOUND;
+
+	LARGE_INTEGER file_size;
+	if( !GetFileSizeEx( file, &file_size ) || file_size.QuadPart == 0 )
+	{
+		CloseHandle( file );
+		return DL_ERROR_MALFORMED_DATA;
+	}
+
+	// ... the view keeps the mapping and file open, no need to keep the handles around ...
+	HANDLE mapping = CreateFileMappingA( file, 0x0, PAGE_WRITECOPY, 0, 0, 0x0 );
+	CloseHandle( file );
+	if( mapping == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	void* data = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+	CloseHandle( mapping );
+	if( data == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	*out_data = (unsigned char*)data;
+	*out_size = (size_t)file_size.QuadPart;
+#else
+	int fd = open( filename, O_RDONLY );
+	if( fd < 0 )
+		return DL_ERROR_UTIL_FILE_NOT_FOUND;
+
+	struct stat file_stat;
+	if( fstat( fd, &file_stat ) != 0 || file_stat.st_size == 0 )
+	{
+		close( fd );
+		return DL_ERROR_MALFORMED_DATA;
+	}
+	size_t size = (size_t)file_stat.st_size;
+
+	int flags = MAP_PRIVATE;
+#  if defined( MAP_POPULATE )
+	if( map_flags & DL_UTIL_MAP_FLAG_POPULATE )
+		flags |= MAP_POPULATE;
+#  endif
+	void* data = mmap( 0x0, size, PROT_READ | PROT_WRITE, flags, fd, 0 );
+	close( fd );
+	if( data == MAP_FAILED )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+
+	if( map_flags & DL_UTIL_MAP_FLAG_WILL_NEED )
+		madvise( data, size, MADV_WILLNEED );
+
+	*out_data = (unsigned char*)data;
+	*out_size = size;
+#endif
+	return DL_ERROR_OK;
+}
+
+static void dl_util_unmap_raw( unsigned char* data, size_t size )
+{
+#if defined( _WIN32 )
+	(void)size;
+	UnmapViewOfFile( data );
+#else
+	munmap( data, size );
+#endif
+}
+
+/**
+ * Instances returned from dl_util are allocated with malloc(), grow single-pass output with realloc() to match.
+ */
+static void* dl_util_grow( void* ptr, size_t size, size_t old_size, void* grow_ctx )
+{
+	(void)old_size; (void)grow_ctx;
+	if( size == 0 )
+	{
+		free( ptr );
+		return 0x0;
+	}
+	return realloc( ptr, size );
+}
+
+static dl_error_t dl_util_write_to_stream( const void* data, size_t size, void* write_ctx )
+{
+	return fwrite( data, size, 1, (FILE*)write_ctx ) == 1 ? DL_ERROR_OK : DL_ERROR_UTIL_FILE_WRITE_FAILED;
+}
+
 dl_error_t dl_util_load_from_file( dl_ctx_t    dl_ctx,       dl_typeid_t         type,
                                    const char* filename,     dl_util_file_type_t filetype,
                                    void**      out_instance, dl_typeid_t*        out_type )
@@ -43,6 +163,35 @@ dl_error_t dl_util_load_from_file( dl_ctx_t    dl_ctx,       dl_typeid_t
 	return error;
 }
 
+/**
+ * Pack text-instance in file_content to a packed instance in host-format allocated with malloc. file_content is owned
+ * by this function.
+ */
+static dl_error_t dl_util_pack_txt( dl_ctx_t        dl_ctx,     dl_typeid_t* type,
+									unsigned char*  file_content,
+									unsigned char** out_packed, size_t*      out_packed_size )
+{
+	unsigned char* packed = 0x0;
+	size_t packed_size = 0;
+	dl_error_t error = dl_txt_pack_alloc( dl_ctx, (char*)file_content, dl_util_grow, 0x0, &packed, &packed_size );
+
+	free( file_content );
+
+	if( error != DL_ERROR_OK )
+		return error;
+
+	if( *type == 0 ) // autodetect type
+	{
+		dl_instance_info_t info;
+		dl_instance_get_info( packed, packed_size, &info );
+		*type = info.root_type;
+	}
+
+	*out_packed      = packed;
+	*out_packed_size = packed_size;
+	return DL_ERROR_OK;
+}
+
 dl_error_t dl_util_load_from_stream( dl_ctx_t dl_ctx,       dl_typeid_t         type,
 									 FILE*    stream,       dl_util_file_type_t filetype,
 									 void**   out_instance, dl_typeid_t*        out_type,
@@ -54,15 +203,13 @@ dl_error_t dl_util_load_from_stream( dl_ctx_t dl_ctx,       dl_typeid_t
 
 	size_t file_size;
 	unsigned char* file_content = dl_read_entire_stream( stream, &file_size );
+	if( file_content == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
 
 	file_content[file_size] = '\0';
 
-	dl_error_t error = DL_ERROR_OK;
 	dl_instance_info_t info;
-
-	error = dl_instance_get_info( file_content, file_size, &info );
-
-	dl_util_file_type_t in_file_type = error == DL_ERROR_OK ? DL_UTIL_FILE_TYPE_BINARY : DL_UTIL_FILE_TYPE_TEXT;
+	dl_util_file_type_t in_file_type = dl_instance_get_info( file_content, file_size, &info ) == DL_ERROR_OK ? DL_UTIL_FILE_TYPE_BINARY : DL_UTIL_FILE_TYPE_TEXT;
 
 	if( ( in_file_type & filetype ) == 0 )
 	{
@@ -70,84 +217,347 @@ dl_error_t dl_util_load_from_stream( dl_ctx_t dl_ctx,       dl_typeid_t
 		return DL_ERROR_UTIL_FILE_TYPE_MISMATCH;
 	}
 
-	unsigned char* load_instance = 0x0;
-	size_t         load_size = 0;
-
-	switch(in_file_type)
+	dl_error_t error;
+	unsigned char* packed      = file_content;
+	size_t         packed_size = file_size;
+	if( in_file_type == DL_UTIL_FILE_TYPE_BINARY )
 	{
-		case DL_UTIL_FILE_TYPE_BINARY:
+		if( type == 0 ) // autodetect type
+			type = info.root_type;
+
+		// ... ptrs that grow can not be loaded in place, convert and load into a new buffer in one go ...
+		if( info.ptrsize < sizeof(void*) )
 		{
-			if( type == 0 ) // autodetect filetype
-				type = info.root_type;
+			void* instance = 0x0;
+			error = dl_instance_load_any_alloc( dl_ctx, type, file_content, file_size, dl_util_grow, 0x0, &instance, 0x0 );
+			free( file_content );
+			if( error != DL_ERROR_OK )
+				return error;
+
+			*out_instance = instance;
+			if( out_type != 0x0 )
+				*out_type = type;
+			return DL_ERROR_OK;
+		}
+	}
+	else
+	{
+		error = dl_util_pack_txt( dl_ctx, &type, file_content, &packed, &packed_size );
+		if( error != DL_ERROR_OK )
+			return error;
+	}
 
-			error = dl_convert( dl_ctx, type, file_content, file_size, 0x0, 0, DL_ENDIAN_HOST, sizeof(void*), &load_size );
+	// ... load in place with the instance placed at the start of the buffer so that the user can free it ...
+	void* instance = 0x0;
+	error = dl_instance_load_any( dl_ctx, type, packed, packed_size, packed, packed_size, &instance, 0x0 );
+	if( error != DL_ERROR_OK )
+	{
+		free( packed );
+		return error;
+	}
 
-			if( error != DL_ERROR_OK ) { free( file_content ); return error; }
+	*out_instance = instance;
 
-			// convert if needed
-			if( load_size > file_size || info.ptrsize < sizeof(void*) )
-			{
-				load_instance = (unsigned char*)malloc(load_size);
+	if( out_type != 0x0 )
+		*out_type = type;
 
-				error = dl_convert( dl_ctx, type, file_content, file_size, load_instance, load_size, DL_ENDIAN_HOST, sizeof(void*), 0x0 );
+	return DL_ERROR_OK;
+}
 
-				free( file_content );
-			}
-			else
+dl_error_t dl_util_load_from_file_inplace( dl_ctx_t     dl_ctx,       dl_typeid_t         type,
+										   const char*  filename,     dl_util_file_type_t filetype,
+										   void*        out_instance, size_t              out_instance_size,
+										   dl_typeid_t* out_type )
+{
+	dl_error_t error;
+
+	// ... binary instances, in any format, are loaded straight from the mapped file into out_instance ...
+	if( filetype & DL_UTIL_FILE_TYPE_BINARY )
+	{
+		unsigned char* mapped      = 0x0;
+		size_t         mapped_size = 0;
+		error = dl_util_map_raw( filename, 0, &mapped, &mapped_size );
+		if( error == DL_ERROR_UTIL_FILE_NOT_FOUND )
+			return error;
+
+		if( error == DL_ERROR_OK )
+		{
+			dl_instance_info_t info;
+			if( dl_instance_get_info( mapped, mapped_size, &info ) == DL_ERROR_OK )
 			{
-				load_instance = file_content;
-				load_size     = file_size;
-				error = dl_convert_inplace( dl_ctx, type, load_instance, load_size, DL_ENDIAN_HOST, sizeof(void*), 0x0 );
-			}
+				if( type == 0 )
+					type = info.root_type;
 
-			if( error != DL_ERROR_OK ) { free( load_instance ); return error; }
+				void* instance = 0x0;
+				error = dl_instance_load_any( dl_ctx, type, out_instance, out_instance_size, mapped, mapped_size, &instance, 0x0 );
+				dl_util_unmap_raw( mapped, mapped_size );
+
+				if( error == DL_ERROR_OK && out_type != 0x0 )
+					*out_type = type;
+				return error;
+			}
+			dl_util_unmap_raw( mapped, mapped_size );
 		}
-		break;
-		case DL_UTIL_FILE_TYPE_TEXT:
-		{
-			// calc needed space
-			size_t packed_size = 0;
-			error = dl_txt_pack( dl_ctx, (char*)file_content, 0x0, 0, &packed_size );
+	}
 
-			if(error != DL_ERROR_OK) { free(file_content); return error; }
+	if( ( filetype & DL_UTIL_FILE_TYPE_TEXT ) == 0 )
+		return DL_ERROR_UTIL_FILE_TYPE_MISMATCH;
 
-			load_instance = (unsigned char*)malloc(packed_size);
+	FILE* in_file = fopen( filename, "rb" );
+	if( in_file == 0x0 )
+		return DL_ERROR_UTIL_FILE_NOT_FOUND;
+
+	size_t file_size;
+	unsigned char* file_content = dl_read_entire_stream( in_file, &file_size );
+	fclose( in_file );
+	if( file_content == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
 
-			error = dl_txt_pack(dl_ctx, (char*)file_content, load_instance, packed_size, 0x0);
+	file_content[file_size] = '\0';
 
-			load_size = packed_size;
+	dl_instance_info_t info;
+	if( dl_instance_get_info( file_content, file_size, &info ) == DL_ERROR_OK )
+	{
+		free( file_content );
+		return DL_ERROR_UTIL_FILE_TYPE_MISMATCH;
+	}
 
-			free(file_content);
+	unsigned char* packed = 0x0;
+	size_t         packed_size = 0;
+	error = dl_util_pack_txt( dl_ctx, &type, file_content, &packed, &packed_size );
+	if( error != DL_ERROR_OK )
+		return error;
 
-			if(error != DL_ERROR_OK) { free(load_instance); return error; }
+	error = dl_instance_load( dl_ctx, type, out_instance, out_instance_size, packed, packed_size, 0x0 );
+	free( packed );
 
-			if( type == 0 ) // autodetect type
-			{
-				dl_instance_get_info( load_instance, packed_size, &info);
-				type = info.root_type;
-			}
-		}
-		break;
-		default:
-			return DL_ERROR_INTERNAL_ERROR;
+	if( error == DL_ERROR_OK && out_type != 0x0 )
+		*out_type = type;
+	return error;
+}
+
+struct dl_util_archive_instance
+{
+	void*          instance;  ///< loaded instance or 0x0 if not loaded yet.
+	unsigned char* converted; ///< loaded instance allocated with malloc if ptrs needed to grow to load it.
+};
+
+struct dl_util_mapped_file
+{
+	unsigned char*            data;      ///< mapped file or, if ptrs needed to grow, the loaded instance allocated with malloc.
+	size_t                    size;
+	bool                      is_mapped;
+	dl_util_archive_instance* archive_instances; ///< one per entry if an archive is mapped, otherwise 0x0.
+};
+
+dl_error_t dl_util_map_file( dl_ctx_t               dl_ctx,     dl_typeid_t  type,
+							 const char*            filename,   unsigned int map_flags,
+							 dl_util_mapped_file_t* out_mapped, void**       out_instance,
+							 dl_typeid_t*           out_type )
+{
+	unsigned char* data = 0x0;
+	size_t         size = 0;
+	dl_error_t error = dl_util_map_raw( filename, map_flags, &data, &size );
+	if( error != DL_ERROR_OK )
+		return error;
+
+	dl_instance_info_t info;
+	if( dl_instance_get_info( data, size, &info ) != DL_ERROR_OK )
+	{
+		dl_util_unmap_raw( data, size );
+		return DL_ERROR_UTIL_FILE_TYPE_MISMATCH;
 	}
 
-	error = dl_instance_load( dl_ctx, type, load_instance, load_size, load_instance, load_size, 0x0 );
+	if( type == 0 )
+		type = info.root_type;
+
+	dl_util_mapped_file* mapped = (dl_util_mapped_file*)malloc( sizeof(dl_util_mapped_file) );
+	if( mapped == 0x0 )
+	{
+		dl_util_unmap_raw( data, size );
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+	mapped->data              = data;
+	mapped->size              = size;
+	mapped->is_mapped         = true;
+	mapped->archive_instances = 0x0;
+
+	if( info.relative )
+	{
+		// ... relative instances are never written to, the pages of the mapping stay shared with the file ...
+		const void* instance = 0x0;
+		error = dl_instance_load_relative( dl_ctx, type, mapped->data, mapped->size, &instance, 0x0 );
+		*out_instance = (void*)instance;
+	}
+	else if( info.ptrsize < sizeof(void*) )
+	{
+		// ... ptrs that grow can not be loaded in the mapping, load into a separate buffer instead ...
+		void*  converted = 0x0;
+		size_t load_size = 0;
+		error = dl_instance_load_any_alloc( dl_ctx, type, data, size, dl_util_grow, 0x0, &converted, &load_size );
+		if( error == DL_ERROR_OK )
+		{
+			dl_util_unmap_raw( data, size );
+			mapped->data      = (unsigned char*)converted;
+			mapped->size      = load_size;
+			mapped->is_mapped = false;
+			*out_instance     = converted;
+		}
+	}
+	else
+		// ... the mapping is private so converting in it will not touch the file ...
+		error = dl_instance_load_any( dl_ctx, type, 0x0, 0, data, size, out_instance, 0x0 );
 
-	*out_instance = load_instance;
+	if( error != DL_ERROR_OK )
+	{
+		dl_util_unmap_file( mapped );
+		return error;
+	}
 
+	*out_mapped = mapped;
 	if( out_type != 0x0 )
 		*out_type = type;
+	return DL_ERROR_OK;
+}
 
-	return error;
+void dl_util_unmap_file( dl_util_mapped_file_t mapped )
+{
+	if( mapped == 0x0 )
+		return;
+
+	if( mapped->archive_instances )
+	{
+		unsigned int entry_count = 0;
+		dl_archive_entry_count( mapped->data, mapped->size, &entry_count );
+		for( unsigned int i = 0; i < entry_count; ++i )
+			free( mapped->archive_instances[i].converted );
+		free( mapped->archive_instances );
+	}
+
+	if( mapped->is_mapped )
+		dl_util_unmap_raw( mapped->data, mapped->size );
+	else
+		free( mapped->data );
+	free( mapped );
 }
 
-dl_error_t dl_util_load_from_file_inplace( dl_ctx_t    dl_ctx,       dl_typeid_t         type,
-                                           const char* filename,     dl_util_file_type_t filetype,
-                                           void*       out_instance, size_t              out_instance_size )
+dl_error_t dl_util_map_type_library( dl_ctx_t dl_ctx, const char* filename, dl_util_mapped_file_t* out_mapped )
 {
-	(void)dl_ctx; (void)filename; (void)type; (void)filetype; (void)out_instance; (void)out_instance_size;
-	return DL_ERROR_INTERNAL_ERROR; // TODO: Build me
+	dl_util_mapped_file* mapped = (dl_util_mapped_file*)malloc( sizeof( dl_util_mapped_file ) );
+	if( mapped == 0x0 )
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	mapped->is_mapped         = true;
+	mapped->archive_instances = 0x0;
+
+	dl_error_t error = dl_util_map_raw( filename, 0, &mapped->data, &mapped->size );
+	if( error != DL_ERROR_OK )
+	{
+		free( mapped );
+		return error;
+	}
+
+	error = dl_context_load_type_library_borrowed( dl_ctx, mapped->data, mapped->size );
+	if( error != DL_ERROR_OK )
+	{
+		dl_util_unmap_file( mapped );
+		return error;
+	}
+
+	*out_mapped = mapped;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_util_map_archive( const char* filename, unsigned int map_flags, dl_util_mapped_file_t* out_mapped )
+{
+	unsigned char* data = 0x0;
+	size_t         size = 0;
+	dl_error_t error = dl_util_map_raw( filename, map_flags, &data, &size );
+	if( error != DL_ERROR_OK )
+		return error;
+
+	unsigned int entry_count = 0;
+	error = dl_archive_entry_count( data, size, &entry_count );
+	if( error != DL_ERROR_OK )
+	{
+		dl_util_unmap_raw( data, size );
+		return error;
+	}
+
+	dl_util_mapped_file* mapped = (dl_util_mapped_file*)malloc( sizeof( dl_util_mapped_file ) );
+	dl_util_archive_instance* instances = (dl_util_archive_instance*)calloc( entry_count > 0 ? entry_count : 1, sizeof( dl_util_archive_instance ) );
+	if( mapped == 0x0 || instances == 0x0 )
+	{
+		free( mapped );
+		free( instances );
+		dl_util_unmap_raw( data, size );
+		return DL_ERROR_OUT_OF_LIBRARY_MEMORY;
+	}
+	mapped->data              = data;
+	mapped->size              = size;
+	mapped->is_mapped         = true;
+	mapped->archive_instances = instances;
+
+	*out_mapped = mapped;
+	return DL_ERROR_OK;
+}
+
+dl_error_t dl_util_load_from_archive( dl_ctx_t              dl_ctx, dl_util_mapped_file_t mapped,
+									  dl_typeid_t           type,   const char*           key,
+									  void**                out_instance,
+									  dl_typeid_t*          out_type )
+{
+	if( mapped->archive_instances == 0x0 )
+		return DL_ERROR_INVALID_PARAMETER;
+
+	dl_archive_entry_t entry;
+	dl_error_t error = dl_archive_find( mapped->data, mapped->size, key, &entry );
+	if( error != DL_ERROR_OK )
+		return error;
+
+	unsigned char* packed = mapped->data + entry.offset;
+	dl_instance_info_t info;
+	error = dl_instance_get_info( packed, entry.size, &info );
+	if( error != DL_ERROR_OK )
+		return error;
+
+	if( type == 0 )
+		type = info.root_type;
+	else if( type != info.root_type )
+		return DL_ERROR_TYPE_MISMATCH;
+
+	dl_util_archive_instance* cached = &mapped->archive_instances[entry.index];
+	if( cached->instance == 0x0 )
+	{
+		void* instance = 0x0;
+		if( info.relative )
+		{
+			const void* relative_instance = 0x0;
+			error = dl_instance_load_relative( dl_ctx, type, packed, entry.size, &relative_instance, 0x0 );
+			if( error != DL_ERROR_OK )
+				return error;
+			instance = (void*)relative_instance;
+		}
+		else if( info.ptrsize < sizeof(void*) )
+		{
+			// ... pointers need to grow, that can not be done in the mapping ...
+			error = dl_instance_load_any_alloc( dl_ctx, type, packed, entry.size, dl_util_grow, 0x0, &instance, 0x0 );
+			if( error != DL_ERROR_OK )
+				return error;
+			cached->converted = (unsigned char*)instance;
+		}
+		else
+		{
+			error = dl_instance_load_any( dl_ctx, type, 0x0, 0, packed, entry.size, &instance, 0x0 );
+			if( error != DL_ERROR_OK )
+				return error;
+		}
+		cached->instance = instance;
+	}
+
+	*out_instance = cached->instance;
+	if( out_type != 0x0 )
+		*out_type = type;
+	return DL_ERROR_OK;
 }
 
 dl_error_t dl_util_store_to_file( dl_ctx_t    dl_ctx,     dl_typeid_t         type,
@@ -176,21 +586,18 @@ dl_error_t dl_util_store_to_stream( dl_ctx_t    dl_ctx,     dl_typeid_t
 	if( filetype == DL_UTIL_FILE_TYPE_AUTO )
 		return DL_ERROR_INVALID_PARAMETER;
 
-	size_t packed_size = 0;
-
-	// calculate pack-size
-	dl_error_t error = dl_instance_store( dl_ctx, type, instance, 0x0, 0, &packed_size );
+	// ... no conversion needed, stream directly to file without building the whole instance in memory ...
+	if( filetype == DL_UTIL_FILE_TYPE_BINARY && out_endian == DL_ENDIAN_HOST && out_ptr_size == sizeof(void*) )
+		return dl_instance_store_stream( dl_ctx, type, instance, dl_util_write_to_stream, stream, 0x0 );
 
-	if( error != DL_ERROR_OK)
-		return error;
-
-	// alloc memory
-	unsigned char* packed_instance = (unsigned char*)malloc(packed_size);
+	size_t         packed_size     = 0;
+	unsigned char* packed_instance = 0x0;
 
 	// pack data
-	error = dl_instance_store( dl_ctx, type, instance, packed_instance, packed_size, 0x0 );
+	dl_error_t error = dl_instance_store_alloc( dl_ctx, type, instance, dl_util_grow, 0x0, &packed_instance, &packed_size );
 
-	if( error != DL_ERROR_OK ) { free(packed_instance); return error; }
+	if( error != DL_ERROR_OK )
+		return error;
 
 	size_t         out_size = 0;
 	unsigned char* out_data = 0x0;
@@ -228,27 +635,22 @@ dl_error_t dl_util_store_to_stream( dl_ctx_t    dl_ctx,     dl_typeid_t
 		break;
 		case DL_UTIL_FILE_TYPE_TEXT:
 		{
-			// calculate pack-size
-			error = dl_txt_unpack( dl_ctx, type, packed_instance, packed_size, 0x0, 0, &out_size );
-
-			if( error != DL_ERROR_OK ) { free(packed_instance); return error; }
-
-			// alloc data
-			out_data = (unsigned char*)malloc(out_size);
-
-			// pack data
-			error = dl_txt_unpack( dl_ctx, type, packed_instance, packed_size, (char*)out_data, out_size, 0x0 );
+			char* txt_data = 0x0;
+			error = dl_txt_unpack_alloc( dl_ctx, type, packed_instance, packed_size, dl_util_grow, 0x0, &txt_data, &out_size );
 
 			free(packed_instance);
 
-			if( error != DL_ERROR_OK ) { free(out_data); return error; }
+			if( error != DL_ERROR_OK ) return error;
+
+			out_data = (unsigned char*)txt_data;
 		}
 		break;
 		default:
 			return DL_ERROR_INTERNAL_ERROR;
 	}
 
-	fwrite( out_data, out_size, 1, stream );
+	if( fwrite( out_data, out_size, 1, stream ) != 1 )
+		error = DL_ERROR_UTIL_FILE_WRITE_FAILED;
 	free( out_data );
 
 	return error;
@@ -50,6 +50,11 @@ const char* ArrayToString(T* arr, unsigned int _Count, char* buff, size_t buff_s
 		EXPECT_TRUE(WasEq) << Err; \
 	}
 
+/**
+ * Set when dl_tests is run with --dl_large_tests, see the test_large job in bam.lua.
+ */
+extern bool dl_test_large_enabled;
+
 static void test_log_error( const char* msg, void* )
 {
 	printf( "%s\n", msg );
@@ -1,10 +1,15 @@
+// ... make sure that accessors for relative instances are valid c as well ...
+#define DL_RELATIVE_ACCESSORS
+
 #include "generated/unittest.h"
 #include "dl_test_included.h" // TODO: this should be included in unittest2.h someway.
 #include "generated/unittest2.h"
 
 #include <dl/dl.h>
+#include <dl/dl_archive.h>
 #include <dl/dl_convert.h>
 #include <dl/dl_reflect.h>
+#include <dl/dl_trace.h>
 #include <dl/dl_txt.h>
 #include <dl/dl_typelib.h>
 #include <dl/dl_util.h>
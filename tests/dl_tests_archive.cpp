@@ -0,0 +1,239 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <gtest/gtest.h>
+
+#include <dl/dl.h>
+#include <dl/dl_archive.h>
+#include <dl/dl_convert.h>
+#include <dl/dl_util.h>
+
+#include "dl_test_common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const char* TEMP_ARCHIVE_FILE_NAME = "temp_dl_archive.dla";
+
+struct archive_buffer
+{
+	unsigned char* data;
+	size_t         size;
+};
+
+static dl_error_t archive_buffer_write( const void* data, size_t size, void* write_ctx )
+{
+	archive_buffer* buf = (archive_buffer*)write_ctx;
+	buf->data = (unsigned char*)realloc( buf->data, buf->size + size );
+	memcpy( buf->data + buf->size, data, size );
+	buf->size += size;
+	return DL_ERROR_OK;
+}
+
+class DLArchive : public DL
+{
+public:
+	dl_archive_writer_t writer;
+	archive_buffer      archive;
+
+	virtual void SetUp()
+	{
+		DL::SetUp();
+		archive.data = 0x0;
+		archive.size = 0;
+		EXPECT_DL_ERR_OK( dl_archive_writer_create( Ctx, &writer ) );
+	}
+
+	virtual void TearDown()
+	{
+		dl_archive_writer_destroy( writer );
+		free( archive.data );
+		remove( TEMP_ARCHIVE_FILE_NAME );
+		DL::TearDown();
+	}
+
+	dl_error_t add( const char* key, dl_typeid_t type, void* instance, size_t alignment, dl_endian_t endian = DL_ENDIAN_HOST, size_t ptr_size = sizeof(void*) )
+	{
+		size_t size = 0;
+		EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, type, instance, &size ) );
+		unsigned char* packed = (unsigned char*)malloc( size );
+		EXPECT_DL_ERR_OK( dl_instance_store( Ctx, type, instance, packed, size, 0x0 ) );
+		if( endian != DL_ENDIAN_HOST || ptr_size != sizeof(void*) )
+			EXPECT_DL_ERR_OK( dl_convert_inplace( Ctx, type, packed, size, endian, ptr_size, &size ) );
+
+		dl_error_t err = dl_archive_writer_add( writer, key, packed, size, alignment );
+		free( packed );
+		return err;
+	}
+
+	void finish()
+	{
+		size_t produced = 0;
+		EXPECT_DL_ERR_OK( dl_archive_writer_finish( writer, archive_buffer_write, &archive, &produced ) );
+		EXPECT_EQ( archive.size, produced );
+	}
+};
+
+TEST_F( DLArchive, round_trip )
+{
+	const unsigned int NUM_ENTRIES = 200;
+	const size_t alignments[] = { 0, 4, 8, 16, 64 };
+
+	for( unsigned int i = 0; i < NUM_ENTRIES; ++i )
+	{
+		char key[64];
+		snprintf( key, sizeof(key), "pods/%u", i );
+		Pods p = { (int8_t)i, 2, 3, (int64_t)i * 1000, 5, 6, 7, 8, 9.0f, (double)i };
+		EXPECT_DL_ERR_OK( add( key, Pods::TYPE_ID, &p, alignments[i % DL_ARRAY_LENGTH( alignments )] ) );
+	}
+	finish();
+
+	unsigned int entry_count = 0;
+	EXPECT_DL_ERR_OK( dl_archive_entry_count( archive.data, archive.size, &entry_count ) );
+	EXPECT_EQ( NUM_ENTRIES, entry_count );
+
+	for( unsigned int i = 0; i < NUM_ENTRIES; ++i )
+	{
+		char key[64];
+		snprintf( key, sizeof(key), "pods/%u", i );
+
+		dl_archive_entry_t by_index;
+		EXPECT_DL_ERR_OK( dl_archive_get_entry( archive.data, archive.size, i, &by_index ) );
+		EXPECT_STREQ( key, by_index.key );
+		EXPECT_EQ( i, by_index.index );
+
+		dl_archive_entry_t entry;
+		EXPECT_DL_ERR_OK( dl_archive_find( archive.data, archive.size, key, &entry ) );
+		EXPECT_STREQ( key, entry.key );
+		EXPECT_EQ( by_index.offset, entry.offset );
+		EXPECT_EQ( by_index.size,   entry.size );
+
+		void* instance = 0x0;
+		EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, Pods::TYPE_ID, archive.data + entry.offset, entry.size, &instance, 0x0 ) );
+		size_t alignment = alignments[i % DL_ARRAY_LENGTH( alignments )];
+		if( alignment > 8 ) // ... the archive is only allocated with malloc-alignment ...
+			alignment = 8;
+		EXPECT_EQ( 0u, (size_t)instance % ( alignment == 0 ? 8 : alignment ) );
+
+		Pods* loaded = (Pods*)instance;
+		EXPECT_EQ( (int8_t)i,        loaded->i8 );
+		EXPECT_EQ( (int64_t)i * 1000, loaded->i64 );
+		EXPECT_EQ( (double)i,        loaded->f64 );
+	}
+
+	dl_archive_entry_t entry;
+	EXPECT_DL_ERR_EQ( DL_ERROR_ARCHIVE_KEY_NOT_FOUND, dl_archive_find( archive.data, archive.size, "pods/1337", &entry ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_ARCHIVE_KEY_NOT_FOUND, dl_archive_find( archive.data, archive.size, "", &entry ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_INVALID_PARAMETER, dl_archive_get_entry( archive.data, archive.size, NUM_ENTRIES, &entry ) );
+}
+
+TEST_F( DLArchive, empty )
+{
+	finish();
+
+	unsigned int entry_count = 1;
+	EXPECT_DL_ERR_OK( dl_archive_entry_count( archive.data, archive.size, &entry_count ) );
+	EXPECT_EQ( 0u, entry_count );
+
+	dl_archive_entry_t entry;
+	EXPECT_DL_ERR_EQ( DL_ERROR_ARCHIVE_KEY_NOT_FOUND, dl_archive_find( archive.data, archive.size, "a", &entry ) );
+}
+
+TEST_F( DLArchive, writer_errors )
+{
+	Pods p = { 1, 2, 3, 4, 5, 6, 7, 8, 9.0f, 10.0 };
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	EXPECT_DL_ERR_OK( add( "a", Pods::TYPE_ID, &p, 0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_ARCHIVE_DUPLICATE_KEY, add( "a", Pods::TYPE_ID, &p, 0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_ENDIAN_MISMATCH,       add( "b", Pods::TYPE_ID, &p, 0, other_endian ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_INVALID_PARAMETER,     add( "b", Pods::TYPE_ID, &p, 3 ) );
+
+	unsigned char not_an_instance[64] = { 0 };
+	EXPECT_NE( DL_ERROR_OK, dl_archive_writer_add( writer, "b", not_an_instance, sizeof(not_an_instance), 0 ) );
+
+	finish();
+	unsigned int entry_count = 0;
+	EXPECT_DL_ERR_OK( dl_archive_entry_count( archive.data, archive.size, &entry_count ) );
+	EXPECT_EQ( 1u, entry_count );
+}
+
+TEST_F( DLArchive, reader_errors )
+{
+	Pods p = { 1, 2, 3, 4, 5, 6, 7, 8, 9.0f, 10.0 };
+	EXPECT_DL_ERR_OK( add( "a", Pods::TYPE_ID, &p, 0 ) );
+	finish();
+
+	unsigned int entry_count;
+	dl_archive_entry_t entry;
+	EXPECT_DL_ERR_EQ( DL_ERROR_BAD_ALIGNMENT,   dl_archive_entry_count( archive.data + 1, archive.size - 1, &entry_count ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA,  dl_archive_entry_count( archive.data, 8, &entry_count ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA,  dl_archive_find( archive.data, 24, "a", &entry ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA,  dl_archive_find( archive.data, archive.size - 1, "a", &entry ) );
+
+	// ... a packed instance is not an archive ...
+	size_t size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, Pods::TYPE_ID, &p, &size ) );
+	unsigned char* packed = (unsigned char*)malloc( size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, Pods::TYPE_ID, &p, packed, size, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA, dl_archive_entry_count( packed, size, &entry_count ) );
+	free( packed );
+}
+
+TEST_F( DLArchive, other_endian )
+{
+	Pods p = { 1, 2, 3, 4, 5, 6, 7, 8, 9.0f, 10.0 };
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	EXPECT_DL_ERR_OK( add( "a", Pods::TYPE_ID, &p, 0, other_endian ) );
+	finish();
+
+	// ... the index is stored in the endianness of the instances, it can only be read on such a platform ...
+	dl_archive_entry_t entry;
+	EXPECT_DL_ERR_EQ( DL_ERROR_ENDIAN_MISMATCH, dl_archive_find( archive.data, archive.size, "a", &entry ) );
+}
+
+TEST_F( DLArchive, util_map_and_load )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr ptrs = { &pods, &pods };
+	EXPECT_DL_ERR_OK( add( "pods", Pods::TYPE_ID, &pods, 0 ) );
+	EXPECT_DL_ERR_OK( add( "ptrs", SimplePtr::TYPE_ID, &ptrs, 16 ) );
+	// ... 4 byte ptrs need to be converted into a separate buffer on 64-bit hosts ...
+	EXPECT_DL_ERR_OK( add( "ptrs_other_size", SimplePtr::TYPE_ID, &ptrs, 0, DL_ENDIAN_HOST, sizeof(void*) == 8 ? 4 : 8 ) );
+
+	finish();
+
+	FILE* f = fopen( TEMP_ARCHIVE_FILE_NAME, "wb" );
+	EXPECT_EQ( archive.size, fwrite( archive.data, 1, archive.size, f ) );
+	fclose( f );
+
+	dl_util_mapped_file_t mapped = 0x0;
+	EXPECT_DL_ERR_OK( dl_util_map_archive( TEMP_ARCHIVE_FILE_NAME, DL_UTIL_MAP_FLAG_WILL_NEED, &mapped ) );
+
+	const char* ptr_keys[] = { "ptrs", "ptrs_other_size" };
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( ptr_keys ); ++i )
+	{
+		void* instance = 0x0;
+		dl_typeid_t type = 0;
+		EXPECT_DL_ERR_OK( dl_util_load_from_archive( Ctx, mapped, 0, ptr_keys[i], &instance, &type ) );
+		EXPECT_EQ( (dl_typeid_t)SimplePtr::TYPE_ID, type );
+		SimplePtr* loaded = (SimplePtr*)instance;
+		EXPECT_EQ( loaded->Ptr1, loaded->Ptr2 );
+		EXPECT_EQ( pods.i64, loaded->Ptr1->i64 );
+		EXPECT_EQ( pods.f64, loaded->Ptr1->f64 );
+
+		// ... already patched instance should not be loaded again ...
+		void* instance2 = 0x0;
+		EXPECT_DL_ERR_OK( dl_util_load_from_archive( Ctx, mapped, SimplePtr::TYPE_ID, ptr_keys[i], &instance2, 0x0 ) );
+		EXPECT_EQ( instance, instance2 );
+	}
+
+	void* instance = 0x0;
+	EXPECT_DL_ERR_OK( dl_util_load_from_archive( Ctx, mapped, Pods::TYPE_ID, "pods", &instance, 0x0 ) );
+	EXPECT_EQ( pods.u32, ( (Pods*)instance )->u32 );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_MISMATCH,         dl_util_load_from_archive( Ctx, mapped, SimplePtr::TYPE_ID, "pods", &instance, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_ARCHIVE_KEY_NOT_FOUND, dl_util_load_from_archive( Ctx, mapped, 0, "whobb", &instance, 0x0 ) );
+	dl_util_unmap_file( mapped );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_NOT_FOUND, dl_util_map_archive( "whobb whobb whoob", 0, &mapped ) );
+}
@@ -112,6 +112,54 @@ TYPED_TEST(DLBase, array_struct)
 	EXPECT_EQ(original.Array[3].Int2, loaded[0].Array[3].Int2);
 }
 
+TYPED_TEST(DLBase, array_pod_widths)
+{
+	// odd counts to get both full vectors and a tail when swapping endian on convert.
+	uint16_t     u16[37];
+	uint64_t     u64[13];
+	float        f32[19];
+	double       f64[11];
+	Pod2InStruct structs[5];
+	for( uint16_t i = 0; i < DL_ARRAY_LENGTH( u16 ); ++i ) u16[i] = (uint16_t)( 0x0102 * ( i + 1 ) );
+	for( uint64_t i = 0; i < DL_ARRAY_LENGTH( u64 ); ++i ) u64[i] = 0x0102030405060708ULL * ( i + 1 );
+	for( size_t   i = 0; i < DL_ARRAY_LENGTH( f32 ); ++i ) f32[i] = (float)i * 1.25f;
+	for( size_t   i = 0; i < DL_ARRAY_LENGTH( f64 ); ++i ) f64[i] = (double)i * -3.5;
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( structs ); ++i )
+	{
+		structs[i].Pod1.Int1 = 0x01020304 + i;
+		structs[i].Pod1.Int2 = 0x05060708 + i;
+		structs[i].Pod2.Int1 = 0x090A0B0C + i;
+		structs[i].Pod2.Int2 = 0x0D0E0F10 + i;
+	}
+
+	PodArrayWidths original;
+	original.u16_arr.data    = u16;     original.u16_arr.count    = DL_ARRAY_LENGTH( u16 );
+	original.u64_arr.data    = u64;     original.u64_arr.count    = DL_ARRAY_LENGTH( u64 );
+	original.f32_arr.data    = f32;     original.f32_arr.count    = DL_ARRAY_LENGTH( f32 );
+	original.f64_arr.data    = f64;     original.f64_arr.count    = DL_ARRAY_LENGTH( f64 );
+	original.struct_arr.data = structs; original.struct_arr.count = DL_ARRAY_LENGTH( structs );
+	PodArrayWidths loaded[16];
+
+	this->do_the_round_about( PodArrayWidths::TYPE_ID, &original, loaded, sizeof(loaded) );
+
+	EXPECT_EQ( original.u16_arr.count,    loaded[0].u16_arr.count );
+	EXPECT_EQ( original.u64_arr.count,    loaded[0].u64_arr.count );
+	EXPECT_EQ( original.f32_arr.count,    loaded[0].f32_arr.count );
+	EXPECT_EQ( original.f64_arr.count,    loaded[0].f64_arr.count );
+	EXPECT_EQ( original.struct_arr.count, loaded[0].struct_arr.count );
+	EXPECT_ARRAY_EQ( original.u16_arr.count, original.u16_arr.data, loaded[0].u16_arr.data );
+	EXPECT_ARRAY_EQ( original.u64_arr.count, original.u64_arr.data, loaded[0].u64_arr.data );
+	EXPECT_ARRAY_EQ( original.f32_arr.count, original.f32_arr.data, loaded[0].f32_arr.data );
+	EXPECT_ARRAY_EQ( original.f64_arr.count, original.f64_arr.data, loaded[0].f64_arr.data );
+	for( uint32_t i = 0; i < original.struct_arr.count; ++i )
+	{
+		EXPECT_EQ( original.struct_arr[i].Pod1.Int1, loaded[0].struct_arr[i].Pod1.Int1 );
+		EXPECT_EQ( original.struct_arr[i].Pod1.Int2, loaded[0].struct_arr[i].Pod1.Int2 );
+		EXPECT_EQ( original.struct_arr[i].Pod2.Int1, loaded[0].struct_arr[i].Pod2.Int1 );
+		EXPECT_EQ( original.struct_arr[i].Pod2.Int2, loaded[0].struct_arr[i].Pod2.Int2 );
+	}
+}
+
 TYPED_TEST(DLBase, array_enum)
 {
 	TestEnum2 array_data[8] = { TESTENUM2_VALUE1, TESTENUM2_VALUE2, TESTENUM2_VALUE3, TESTENUM2_VALUE4, TESTENUM2_VALUE4, TESTENUM2_VALUE3, TESTENUM2_VALUE2, TESTENUM2_VALUE1 } ;
@@ -163,3 +211,26 @@ TYPED_TEST(DLBase, array_string_empty)
 	EXPECT_EQ(0u,  loaded.Strings.count);
 	EXPECT_EQ(0x0, loaded.Strings.data);
 }
+
+TEST_F(DL, array_str_with_more_than_255_elements)
+{
+	// capturing bug where only the lowest byte of the array count was read when patching pointers on load.
+	const char* strings[300];
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( strings ); ++i )
+		strings[i] = ( i % 2 ) ? "cow" : "bells";
+	StringArray original = { { strings, DL_ARRAY_LENGTH( strings ) } };
+
+	size_t store_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, StringArray::TYPE_ID, &original, &store_size ) );
+	unsigned char* store_buffer = (unsigned char*)malloc( store_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, StringArray::TYPE_ID, &original, store_buffer, store_size, 0x0 ) );
+
+	StringArray* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, StringArray::TYPE_ID, store_buffer, store_size, (void**)(void*)&loaded, 0x0 ) );
+
+	EXPECT_EQ( original.Strings.count, loaded->Strings.count );
+	for( uint32_t i = 0; i < loaded->Strings.count; ++i )
+		EXPECT_STREQ( original.Strings[i], loaded->Strings[i] );
+
+	free( store_buffer );
+}
@@ -43,10 +43,93 @@ void inplace_load_test::do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
 	EXPECT_EQ( (unsigned char)0xFE, (unsigned char)inplace_buffer[store_size + 1] ); // no overwrite by inplace load!
 
 	// store to out-buffer
+	// ... zero so that padding compare equal between stores ...
 	EXPECT_DL_ERR_OK( dl_instance_calc_size( dl_ctx, type, loaded_instance, out_size ) );
+	memset( out_buffer, 0x0, *out_size );
 	EXPECT_DL_ERR_OK( dl_instance_store( dl_ctx, type, loaded_instance, out_buffer, *out_size, 0x0 ) );
 }
 
+void single_pass_test::do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
+							  unsigned char* store_buffer, size_t      store_size,
+							  unsigned char* out_buffer,   size_t*     out_size )
+{
+	unsigned char inplace_buffer[4096];
+	memcpy( inplace_buffer, store_buffer, store_size );
+	void* loaded_instance = 0x0;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( dl_ctx, type, inplace_buffer, store_size, &loaded_instance, 0x0 ));
+
+	// ... single pass store should give the same result as a two pass store to a zeroed buffer ...
+	unsigned char two_pass_buffer[2048];
+	memset( two_pass_buffer, 0x0, sizeof(two_pass_buffer) );
+	size_t two_pass_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( dl_ctx, type, loaded_instance, &two_pass_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_store( dl_ctx, type, loaded_instance, two_pass_buffer, two_pass_size, 0x0 ) );
+
+	unsigned char* stored = 0x0;
+	size_t stored_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_store_alloc( dl_ctx, type, loaded_instance, 0x0, 0x0, &stored, &stored_size ) );
+	EXPECT_EQ( two_pass_size, stored_size );
+	EXPECT_EQ( 0, memcmp( two_pass_buffer, stored, stored_size ) );
+
+	// ... and the same for txt ...
+	char two_pass_text[2048];
+	size_t two_pass_text_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack( dl_ctx, type, stored, stored_size, two_pass_text, sizeof(two_pass_text), &two_pass_text_size ) );
+
+	char* text = 0x0;
+	size_t text_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack_alloc( dl_ctx, type, stored, stored_size, 0x0, 0x0, &text, &text_size ) );
+	EXPECT_EQ( two_pass_text_size, text_size );
+	EXPECT_STREQ( two_pass_text, text );
+	free( stored );
+
+	unsigned char* packed = 0x0;
+	EXPECT_DL_ERR_OK( dl_txt_pack_alloc( dl_ctx, text, 0x0, 0x0, &packed, out_size ) );
+	memcpy( out_buffer, packed, *out_size );
+	free( packed );
+	free( text );
+}
+
+struct stream_store_test_sink
+{
+	unsigned char* buffer;
+	size_t         buffer_size;
+	size_t         written;
+};
+
+static dl_error_t stream_store_test_write( const void* data, size_t size, void* write_ctx )
+{
+	stream_store_test_sink* sink = (stream_store_test_sink*)write_ctx;
+	if( sink->written + size > sink->buffer_size )
+		return DL_ERROR_BUFFER_TO_SMALL;
+	memcpy( sink->buffer + sink->written, data, size );
+	sink->written += size;
+	return DL_ERROR_OK;
+}
+
+void stream_store_test::do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
+							   unsigned char* store_buffer, size_t      store_size,
+							   unsigned char* out_buffer,   size_t*     out_size )
+{
+	unsigned char inplace_buffer[4096];
+	memcpy( inplace_buffer, store_buffer, store_size );
+	void* loaded_instance = 0x0;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( dl_ctx, type, inplace_buffer, store_size, &loaded_instance, 0x0 ));
+
+	// ... streamed store should give the same result as a two pass store to a zeroed buffer ...
+	unsigned char two_pass_buffer[2048];
+	memset( two_pass_buffer, 0x0, sizeof(two_pass_buffer) );
+	size_t two_pass_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( dl_ctx, type, loaded_instance, &two_pass_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_store( dl_ctx, type, loaded_instance, two_pass_buffer, two_pass_size, 0x0 ) );
+
+	stream_store_test_sink sink = { out_buffer, OUT_BUFFER_SIZE, 0 };
+	EXPECT_DL_ERR_OK( dl_instance_store_stream( dl_ctx, type, loaded_instance, stream_store_test_write, &sink, out_size ) );
+	EXPECT_EQ( sink.written, *out_size );
+	EXPECT_EQ( two_pass_size, *out_size );
+	EXPECT_EQ( 0, memcmp( two_pass_buffer, out_buffer, *out_size ) );
+}
+
 void convert_test_do_it( dl_ctx_t       dl_ctx,        dl_typeid_t type,
 						 unsigned char* store_buffer,  size_t      store_size,
 						 unsigned char* out_buffer,    size_t*     out_size,
@@ -127,3 +210,72 @@ void convert_inplace_test_do_it( dl_ctx_t       dl_ctx,        dl_typeid_t type,
 		memset( out_buffer + *out_size, 0xFE, OUT_BUFFER_SIZE - *out_size );
 	}
 }
+
+/**
+ * Store loaded instance to out_buffer and unpack it to text in out_txt, padding may differ between loaded instances
+ * so they are compared as text.
+ */
+static void load_any_test_store( dl_ctx_t dl_ctx, dl_typeid_t type, void* loaded_instance, unsigned char* out_buffer, size_t* out_size, char* out_txt, size_t out_txt_size )
+{
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( dl_ctx, type, loaded_instance, out_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_store( dl_ctx, type, loaded_instance, out_buffer, *out_size, 0x0 ) );
+	EXPECT_DL_ERR_OK( dl_txt_unpack( dl_ctx, type, out_buffer, *out_size, out_txt, out_txt_size, 0x0 ) );
+}
+
+void load_any_test_do_it( dl_ctx_t       dl_ctx,        dl_typeid_t type,
+						  unsigned char* store_buffer,  size_t      store_size,
+						  unsigned char* out_buffer,    size_t*     out_size,
+						  unsigned int   conv_ptr_size, dl_endian_t conv_endian )
+{
+	union { uint64_t align; unsigned char data[2048]; } convert_buffer;
+	size_t convert_size = 0;
+	EXPECT_DL_ERR_OK( dl_convert_calc_size( dl_ctx, type, store_buffer, store_size, conv_ptr_size, &convert_size ) );
+	EXPECT_DL_ERR_OK( dl_convert( dl_ctx, type, store_buffer, store_size, convert_buffer.data, convert_size, conv_endian, conv_ptr_size, 0x0 ) );
+
+	// ... load into buffer allocated by dl ...
+	void*  alloc_loaded = 0x0;
+	size_t alloc_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_load_any_alloc( dl_ctx, type, convert_buffer.data, convert_size, 0x0, 0x0, &alloc_loaded, &alloc_size ) );
+	char alloc_txt[4096];
+	load_any_test_store( dl_ctx, type, alloc_loaded, out_buffer, out_size, alloc_txt, sizeof(alloc_txt) );
+	free( alloc_loaded );
+
+	// ... load into separate buffer ...
+	union { uint64_t align; unsigned char data[2048]; } load_buffer;
+	memset( load_buffer.data, 0xFE, sizeof(load_buffer.data) );
+	void*  loaded = 0x0;
+	size_t consumed = 0;
+	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL, dl_instance_load_any( dl_ctx, type, load_buffer.data, alloc_size - 1, convert_buffer.data, convert_size, &loaded, 0x0 ) );
+	EXPECT_DL_ERR_OK( dl_instance_load_any( dl_ctx, type, load_buffer.data, sizeof(load_buffer.data), convert_buffer.data, convert_size, &loaded, &consumed ) );
+	EXPECT_EQ( load_buffer.data, loaded );
+
+	unsigned char stored[2048];
+	size_t stored_size = 0;
+	char   txt[4096];
+	load_any_test_store( dl_ctx, type, loaded, stored, &stored_size, txt, sizeof(txt) );
+	EXPECT_STREQ( alloc_txt, txt );
+
+	// ... load in place, both after the header and at the start of the buffer ...
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( convert_buffer.data, convert_size, &info ) );
+	EXPECT_GE( convert_size, consumed );
+	size_t header_size = consumed - info.load_size;
+
+	for( int at_start = 0; at_start < 2; ++at_start )
+	{
+		union { uint64_t align; unsigned char data[2048]; } inplace_buffer;
+		memcpy( inplace_buffer.data, convert_buffer.data, convert_size );
+		void* inplace_instance = at_start ? inplace_buffer.data : 0x0;
+		if( conv_ptr_size < sizeof(void*) )
+		{
+			EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_instance_load_any( dl_ctx, type, inplace_instance, convert_size, inplace_buffer.data, convert_size, &loaded, 0x0 ) );
+			continue;
+		}
+
+		EXPECT_DL_ERR_OK( dl_instance_load_any( dl_ctx, type, inplace_instance, convert_size, inplace_buffer.data, convert_size, &loaded, 0x0 ) );
+		EXPECT_EQ( at_start ? inplace_buffer.data : inplace_buffer.data + header_size, (unsigned char*)loaded );
+
+		load_any_test_store( dl_ctx, type, loaded, stored, &stored_size, txt, sizeof(txt) );
+		EXPECT_STREQ( alloc_txt, txt );
+	}
+}
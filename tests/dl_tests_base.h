@@ -29,6 +29,20 @@ struct inplace_load_test
 					   unsigned char* out_buffer,   size_t*     out_size );
 };
 
+struct single_pass_test
+{
+	static void do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
+					   unsigned char* store_buffer, size_t      store_size,
+					   unsigned char* out_buffer,   size_t*     out_size );
+};
+
+struct stream_store_test
+{
+	static void do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
+					   unsigned char* store_buffer, size_t      store_size,
+					   unsigned char* out_buffer,   size_t*     out_size );
+};
+
 void convert_test_do_it( dl_ctx_t       dl_ctx,        dl_typeid_t type,
 						 unsigned char* store_buffer,  size_t      store_size,
 						 unsigned char* out_buffer,    size_t*     out_size,
@@ -62,6 +76,22 @@ struct convert_inplace_test
 	}
 };
 
+void load_any_test_do_it( dl_ctx_t       dl_ctx,        dl_typeid_t type,
+						  unsigned char* store_buffer,  size_t      store_size,
+						  unsigned char* out_buffer,    size_t*     out_size,
+						  unsigned int   conv_ptr_size, dl_endian_t conv_endian );
+
+template<unsigned int conv_ptr_size, dl_endian_t conv_endian>
+struct load_any_test
+{
+	static void do_it( dl_ctx_t       dl_ctx,       dl_typeid_t type,
+					   unsigned char* store_buffer, size_t      store_size,
+					   unsigned char* out_buffer,   size_t*     out_size )
+	{
+		load_any_test_do_it( dl_ctx, type, store_buffer, store_size, out_buffer, out_size, conv_ptr_size, conv_endian );
+	}
+};
+
 template <typename T>
 struct DLBase : public DL
 {
@@ -108,6 +138,8 @@ struct DLBase : public DL
 typedef ::testing::Types<
 	 pack_text_test
 	,inplace_load_test
+	,single_pass_test
+	,stream_store_test
 	,convert_test<4, DL_ENDIAN_LITTLE>
 	,convert_test<8, DL_ENDIAN_LITTLE>
 	,convert_test<4, DL_ENDIAN_BIG>
@@ -116,6 +148,10 @@ typedef ::testing::Types<
 	,convert_inplace_test<8, DL_ENDIAN_LITTLE>
 	,convert_inplace_test<4, DL_ENDIAN_BIG>
 	,convert_inplace_test<8, DL_ENDIAN_BIG>
+	,load_any_test<4, DL_ENDIAN_LITTLE>
+	,load_any_test<8, DL_ENDIAN_LITTLE>
+	,load_any_test<4, DL_ENDIAN_BIG>
+	,load_any_test<8, DL_ENDIAN_BIG>
 > DLBaseTypes;
 TYPED_TEST_CASE(DLBase, DLBaseTypes);
 
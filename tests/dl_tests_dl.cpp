@@ -15,6 +15,7 @@
 #include "dl_test_common.h"
 
 #include <float.h>
+#include <string.h>
 
 #include "dl_tests_base.h"
 
@@ -287,9 +288,182 @@ TEST_F( DL, bug_with_substring_and_inplace_load )
 	EXPECT_STREQ( t1.sub.str, loaded->sub.str );
 }
 
+TEST_F( DL, convert_twice_with_cached_plan )
+{
+	// conversion-plans are built on the first convert and reused, converting again should give the same result.
+
+	BugTest1_InArray array_data[3] = { { 1337, 1338, 18 }, { 7331, 8331, 19 }, { 31337, 73313, 20 } } ;
+	BugTest1 original = { { array_data, DL_ARRAY_LENGTH(array_data) } };
+
+	unsigned char packed[256];
+	unsigned char swapped1[256];
+	unsigned char swapped2[256];
+	unsigned char swapped_back[256];
+	memset( swapped1, 0xFE, sizeof(swapped1) );
+	memset( swapped2, 0xFE, sizeof(swapped2) );
+
+	size_t pack_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( this->Ctx, BugTest1::TYPE_ID, &original, packed, sizeof( packed ), &pack_size ) );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	size_t size1, size2, size_back;
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, BugTest1::TYPE_ID, packed,   pack_size, swapped1,     sizeof( swapped1 ),     other_endian,   sizeof(void*), &size1 ) );
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, BugTest1::TYPE_ID, packed,   pack_size, swapped2,     sizeof( swapped2 ),     other_endian,   sizeof(void*), &size2 ) );
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, BugTest1::TYPE_ID, swapped2, size2,     swapped_back, sizeof( swapped_back ), DL_ENDIAN_HOST, sizeof(void*), &size_back ) );
+
+	EXPECT_EQ( size1, size2 );
+	EXPECT_EQ( 0, memcmp( swapped1, swapped2, size1 ) );
+	EXPECT_EQ( pack_size, size_back );
+
+	BugTest1 loaded[10];
+	EXPECT_DL_ERR_OK( dl_instance_load( this->Ctx, BugTest1::TYPE_ID, loaded, sizeof(loaded), swapped_back, size_back, 0x0 ) );
+	EXPECT_EQ( original.Arr.count, loaded[0].Arr.count );
+	for( uint32_t i = 0; i < original.Arr.count; ++i )
+	{
+		EXPECT_EQ( array_data[i].u64_1, loaded[0].Arr[i].u64_1 );
+		EXPECT_EQ( array_data[i].u64_2, loaded[0].Arr[i].u64_2 );
+		EXPECT_EQ( array_data[i].u16,   loaded[0].Arr[i].u16 );
+	}
+}
+
+TEST_F( DL, load_and_convert_instance_version_1 )
+{
+	// instances stored with version 1 of the format has a smaller header with a 32-bit instance-size, they should
+	// still be possible to read and are converted to the current version.
+
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( this->Ctx, SimplePtr::TYPE_ID, &original, packed, sizeof( packed ), &packed_size ) );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( packed, packed_size, &info ) );
+	EXPECT_EQ( 2u, info.version );
+	size_t instance_size = info.load_size;
+
+	struct
+	{
+		uint32_t id;
+		uint32_t version;
+		uint32_t root_instance_type;
+		uint32_t instance_size;
+		uint8_t  is_64_bit_ptr;
+		uint8_t  pad[3];
+	} header_v1;
+	memcpy( &header_v1.id, packed, sizeof( uint32_t ) );
+	header_v1.version            = 1;
+	header_v1.root_instance_type = SimplePtr::TYPE_ID;
+	header_v1.instance_size      = (uint32_t)instance_size;
+	header_v1.is_64_bit_ptr      = sizeof(void*) == 8 ? 1 : 0;
+	header_v1.pad[0] = header_v1.pad[1] = header_v1.pad[2] = 0;
+
+	union { uint64_t align; unsigned char data[256]; } v1;
+	memcpy( v1.data, &header_v1, sizeof( header_v1 ) );
+	memcpy( v1.data + sizeof( header_v1 ), packed + packed_size - instance_size, instance_size );
+	size_t v1_size = sizeof( header_v1 ) + instance_size;
+
+	EXPECT_DL_ERR_OK( dl_instance_get_info( v1.data, v1_size, &info ) );
+	EXPECT_EQ( 1u, info.version );
+	EXPECT_EQ( instance_size, info.load_size );
+	EXPECT_EQ( (dl_typeid_t)SimplePtr::TYPE_ID, info.root_type );
+
+	union { uint64_t align; unsigned char data[256]; } loaded;
+	size_t consumed;
+	EXPECT_DL_ERR_OK( dl_instance_load( this->Ctx, SimplePtr::TYPE_ID, loaded.data, sizeof( loaded.data ), v1.data, v1_size, &consumed ) );
+	EXPECT_EQ( v1_size, consumed );
+	SimplePtr* loaded_ptr = (SimplePtr*)loaded.data;
+	EXPECT_EQ( loaded_ptr->Ptr1, loaded_ptr->Ptr2 );
+	EXPECT_EQ( pods.i64, loaded_ptr->Ptr1->i64 );
+	EXPECT_EQ( pods.f64, loaded_ptr->Ptr1->f64 );
+
+	// ... converted data is stored with the current version ...
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	unsigned char swapped[256];
+	unsigned char swapped_back[256];
+	size_t swapped_size, swapped_back_size;
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, SimplePtr::TYPE_ID, v1.data, v1_size, swapped, sizeof( swapped ), other_endian, sizeof(void*), &swapped_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_get_info( swapped, swapped_size, &info ) );
+	EXPECT_EQ( 2u, info.version );
+	EXPECT_EQ( other_endian, info.endian );
+
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, SimplePtr::TYPE_ID, v1.data, v1_size, swapped_back, sizeof( swapped_back ), DL_ENDIAN_HOST, sizeof(void*), &swapped_back_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_get_info( swapped_back, swapped_back_size, &info ) );
+	EXPECT_EQ( 2u, info.version );
+	EXPECT_EQ( packed_size, swapped_back_size );
+
+	EXPECT_DL_ERR_OK( dl_convert( this->Ctx, SimplePtr::TYPE_ID, swapped, swapped_size, swapped_back, sizeof( swapped_back ), DL_ENDIAN_HOST, sizeof(void*), &swapped_back_size ) );
+	EXPECT_DL_ERR_OK( dl_instance_load( this->Ctx, SimplePtr::TYPE_ID, loaded.data, sizeof( loaded.data ), swapped_back, swapped_back_size, 0x0 ) );
+	EXPECT_EQ( loaded_ptr->Ptr1, loaded_ptr->Ptr2 );
+	EXPECT_EQ( pods.i64, loaded_ptr->Ptr1->i64 );
+	EXPECT_EQ( pods.f64, loaded_ptr->Ptr1->f64 );
+
+	// ... the bigger header of the current version do not fit in place ...
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_convert_inplace( this->Ctx, SimplePtr::TYPE_ID, v1.data, v1_size, other_endian, sizeof(void*), 0x0 ) );
+}
+
+TEST_F( DL, load_instance_version_1_with_garbage_in_pad )
+{
+	// the pad-bytes of a version 1 header was never written as 0, they must not be read as the relative-flag of
+	// version 2.
+
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( this->Ctx, SimplePtr::TYPE_ID, &original, packed, sizeof( packed ), &packed_size ) );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( packed, packed_size, &info ) );
+	size_t instance_size = info.load_size;
+
+	struct
+	{
+		uint32_t id;
+		uint32_t version;
+		uint32_t root_instance_type;
+		uint32_t instance_size;
+		uint8_t  is_64_bit_ptr;
+		uint8_t  pad[3];
+	} header_v1;
+	memcpy( &header_v1.id, packed, sizeof( uint32_t ) );
+	header_v1.version            = 1;
+	header_v1.root_instance_type = SimplePtr::TYPE_ID;
+	header_v1.instance_size      = (uint32_t)instance_size;
+	header_v1.is_64_bit_ptr      = sizeof(void*) == 8 ? 1 : 0;
+	header_v1.pad[0] = header_v1.pad[1] = header_v1.pad[2] = 0xCD;
+
+	union { uint64_t align; unsigned char data[256]; } v1;
+	memcpy( v1.data, &header_v1, sizeof( header_v1 ) );
+	memcpy( v1.data + sizeof( header_v1 ), packed + packed_size - instance_size, instance_size );
+	size_t v1_size = sizeof( header_v1 ) + instance_size;
+
+	EXPECT_DL_ERR_OK( dl_instance_get_info( v1.data, v1_size, &info ) );
+	EXPECT_EQ( 1u, info.version );
+	EXPECT_EQ( 0u, info.relative );
+	EXPECT_EQ( sizeof(void*), (size_t)info.ptrsize );
+
+	union { uint64_t align; unsigned char data[256]; } loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load( this->Ctx, SimplePtr::TYPE_ID, loaded.data, sizeof( loaded.data ), v1.data, v1_size, 0x0 ) );
+	SimplePtr* loaded_ptr = (SimplePtr*)loaded.data;
+	EXPECT_EQ( loaded_ptr->Ptr1, loaded_ptr->Ptr2 );
+	EXPECT_EQ( pods.i64, loaded_ptr->Ptr1->i64 );
+	EXPECT_EQ( pods.f64, loaded_ptr->Ptr1->f64 );
+
+	const void* relative = 0x0;
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_instance_load_relative( this->Ctx, SimplePtr::TYPE_ID, v1.data, v1_size, &relative, 0x0 ) );
+}
+
+bool dl_test_large_enabled = false;
+
 int main(int argc, char **argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
 	::testing::GTEST_FLAG(catch_exceptions) = 0;
+	for( int i = 1; i < argc; ++i )
+		if( strcmp( argv[i], "--dl_large_tests" ) == 0 )
+			dl_test_large_enabled = true;
 	return RUN_ALL_TESTS();
 }
@@ -12,7 +12,7 @@ class DLError : public DL {};
 
 TEST_F(DLError, all_errors_defined_in_error_to_string)
 {
-	for(dl_error_t Err = DL_ERROR_OK; Err < DL_ERROR_INTERNAL_ERROR; Err = (dl_error_t)((unsigned int)Err + 1))
+	for(dl_error_t Err = DL_ERROR_OK; Err <= DL_ERROR_ARCHIVE_DUPLICATE_KEY; Err = (dl_error_t)((unsigned int)Err + 1))
 		EXPECT_STRNE("Unknown error!", dl_error_to_string(Err));
 }
 
@@ -23,7 +23,38 @@ TEST_F(DLError, buffer_to_small_returned)
 
 	EXPECT_DL_ERR_EQ( DL_ERROR_OK,              dl_instance_store( Ctx, Pods::TYPE_ID, &p, packed,  0, 0x0 ) ); // pack to 0-size out_buffer is ok, calculating size
 	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL, dl_instance_store( Ctx, Pods::TYPE_ID, &p, packed, 10, 0x0 ) ); // test buffer smaller than header
-	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL, dl_instance_store( Ctx, Pods::TYPE_ID, &p, packed, 21, 0x0 ) ); // test buffer to small
+	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL, dl_instance_store( Ctx, Pods::TYPE_ID, &p, packed, 25, 0x0 ) ); // test buffer to small
+}
+
+static void* dl_error_test_failing_grow( void* ptr, size_t size, size_t old_size, void* grow_ctx )
+{
+	(void)old_size;
+	unsigned int* grows_left = (unsigned int*)grow_ctx;
+	if( size == 0 )
+	{
+		free( ptr );
+		return 0x0;
+	}
+	if( *grows_left == 0 )
+		return 0x0;
+	--*grows_left;
+	return realloc( ptr, size );
+}
+
+TEST_F(DLError, out_of_instance_memory_returned_from_store_alloc)
+{
+	const char* strings[64];
+	for( unsigned int i = 0; i < DL_ARRAY_LENGTH(strings); ++i )
+		strings[i] = "a string long enough to make the output buffer grow a few times";
+	StringArray arr = { { strings, DL_ARRAY_LENGTH(strings) } };
+
+	for( unsigned int grows = 0; grows < 3; ++grows )
+	{
+		unsigned int grows_left = grows;
+		unsigned char* stored = (unsigned char*)&arr;
+		EXPECT_DL_ERR_EQ( DL_ERROR_OUT_OF_INSTANCE_MEMORY, dl_instance_store_alloc( Ctx, StringArray::TYPE_ID, &arr, dl_error_test_failing_grow, &grows_left, &stored, 0x0 ) );
+		EXPECT_EQ( (unsigned char*)0x0, stored );
+	}
 }
 
 TEST_F(DLError, type_mismatch_returned)
@@ -122,11 +153,11 @@ TEST_F(DLError, version_mismatch_returned)
 	conv.instance = packed;
 	unsigned int* instance_version;
 	instance_version = conv.instance_version + 1;
-	EXPECT_EQ(1u, *instance_version);
+	EXPECT_EQ(2u, *instance_version);
 	*instance_version = 0xFFFFFFFF;
 	conv.instance = swaped;
 	instance_version = conv.instance_version + 1;
-	EXPECT_EQ(0x01000000u, *instance_version);
+	EXPECT_EQ(0x02000000u, *instance_version);
 	*instance_version = 0xFFFFFFFF;
 
 	// test all functions in...
@@ -0,0 +1,139 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <gtest/gtest.h>
+
+#include <dl/dl.h>
+#include <dl/dl_util.h>
+#include <dl/dl_convert.h>
+
+#include "dl_test_common.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char* LARGE_TEMP_FILE_NAME = "temp_dl_large.packed";
+
+/**
+ * Tests of instances of several GB. They need as much address-space and disk, so they are only run when dl_tests is
+ * started with --dl_large_tests, as by the test_large job in bam.lua.
+ */
+class DLLarge : public DL
+{
+public:
+	virtual void TearDown()
+	{
+		remove( LARGE_TEMP_FILE_NAME );
+		DL::TearDown();
+	}
+
+	/**
+	 * Report that the running test is not run, the bundled gtest has no way to mark a test as skipped.
+	 */
+	void skip( const char* reason )
+	{
+		printf( "[  SKIPPED ] %s\n", reason );
+		RecordProperty( "skipped", reason );
+	}
+
+	/**
+	 * Return true if large tests should be run on this host, report the test as skipped otherwise.
+	 */
+	bool should_run()
+	{
+		if( !dl_test_large_enabled )
+		{
+			skip( "large tests are only run with --dl_large_tests" );
+			return false;
+		}
+		// ... instances larger than 4GB can only be addressed on 64-bit hosts ...
+		if( sizeof(void*) < 8 )
+		{
+			skip( "large tests need a 64-bit host" );
+			return false;
+		}
+		return true;
+	}
+};
+
+TEST_F( DLLarge, store_map_instance_larger_than_4gb )
+{
+	if( !should_run() )
+		return;
+
+	// ... 4.25 GB, calloc:ed pages that are only read are usually not backed by memory ...
+	const uint32_t count = 0x44000000;
+	uint32_t* data = (uint32_t*)calloc( count, sizeof(uint32_t) );
+	if( data == 0x0 )
+	{
+		skip( "could not allocate 4.25GB of test-data" );
+		return;
+	}
+	data[0]         = 1;
+	data[count / 2] = 2;
+	data[count - 1] = 3;
+
+	PodArray1 original = { { data, count } };
+	dl_error_t store_err = dl_util_store_to_file( Ctx, PodArray1::TYPE_ID, LARGE_TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, DL_ENDIAN_HOST, sizeof(void*), &original );
+	free( data );
+	EXPECT_DL_ERR_OK( store_err );
+	if( store_err != DL_ERROR_OK )
+		return;
+
+	unsigned char header[64];
+	FILE* file = fopen( LARGE_TEMP_FILE_NAME, "rb" );
+	ASSERT_TRUE( file != 0x0 );
+	size_t header_size = fread( header, 1, sizeof( header ), file );
+	fclose( file );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( header, header_size, &info ) );
+	EXPECT_EQ( 2u, info.version );
+	EXPECT_LT( (size_t)count * sizeof(uint32_t), info.load_size );
+
+	dl_util_mapped_file_t mapped = 0x0;
+	void* instance = 0x0;
+	EXPECT_DL_ERR_OK( dl_util_map_file( Ctx, PodArray1::TYPE_ID, LARGE_TEMP_FILE_NAME, 0, &mapped, &instance, 0x0 ) );
+	PodArray1* loaded = (PodArray1*)instance;
+	if( loaded != 0x0 )
+	{
+		EXPECT_EQ( count, loaded->u32_arr.count );
+		EXPECT_EQ( 1u, loaded->u32_arr[0] );
+		EXPECT_EQ( 0u, loaded->u32_arr[count / 2 - 1] );
+		EXPECT_EQ( 2u, loaded->u32_arr[count / 2] );
+		EXPECT_EQ( 3u, loaded->u32_arr[count - 1] );
+	}
+	dl_util_unmap_file( mapped );
+}
+
+TEST_F( DLLarge, convert_to_relative_larger_than_2gb )
+{
+	if( !should_run() )
+		return;
+
+	// ... 2.25 GB, small enough for 32-bit offsets but not for signed 32-bit relative refs ...
+	const uint32_t count = 0x24000000;
+	uint32_t* data = (uint32_t*)calloc( count, sizeof(uint32_t) );
+	size_t packed_size = 0;
+	PodArray1 original = { { data, count } };
+	unsigned char* packed = 0x0;
+	if( data != 0x0 )
+	{
+		EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, PodArray1::TYPE_ID, &original, &packed_size ) );
+		packed = (unsigned char*)malloc( packed_size );
+	}
+	if( packed == 0x0 )
+	{
+		free( data );
+		skip( "could not allocate 4.5GB of test-data" );
+		return;
+	}
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, PodArray1::TYPE_ID, &original, packed, packed_size, 0x0 ) );
+	free( data );
+
+	size_t out_size;
+	EXPECT_DL_ERR_OK( dl_convert( Ctx, PodArray1::TYPE_ID, packed, packed_size, 0x0, 0, DL_ENDIAN_HOST, 4, &out_size ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_convert_to_relative( Ctx, PodArray1::TYPE_ID, packed, packed_size, 0x0, 0, DL_ENDIAN_HOST, 4, &out_size ) );
+	EXPECT_DL_ERR_OK( dl_convert_to_relative( Ctx, PodArray1::TYPE_ID, packed, packed_size, 0x0, 0, DL_ENDIAN_HOST, 8, &out_size ) );
+
+	free( packed );
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "dl_tests_base.h"
+#include <dl/dl_convert.h>
 
 TYPED_TEST(DLBase, ptr)
 {
@@ -117,6 +118,25 @@ TYPED_TEST(DLBase, array_struct_with_ptr_holder)
 	EXPECT_EQ( loaded[0].arr[1].ptr, loaded[0].arr[2].ptr );
 }
 
+TYPED_TEST(DLBase, ptr_to_array_element)
+{
+	// ... arrays are not tracked as written ptrs so p1 will be stored separately from arr, p2 should still refer to
+	//     the same instance as p1 ...
+	Pods2 arr[] = { { 1, 2 }, { 3, 4 } };
+	PtrIntoArray original = { &arr[0], { arr, DL_ARRAY_LENGTH( arr ) }, &arr[0] };
+
+	PtrIntoArray loaded[16];
+
+	this->do_the_round_about( PtrIntoArray::TYPE_ID, &original, &loaded, sizeof(loaded) );
+
+	EXPECT_EQ( original.arr.count, loaded[0].arr.count );
+	EXPECT_EQ( 1u, loaded[0].arr[0].Int1 );
+	EXPECT_EQ( 4u, loaded[0].arr[1].Int2 );
+	EXPECT_EQ( 1u, loaded[0].p1->Int1 );
+	EXPECT_EQ( 2u, loaded[0].p1->Int2 );
+	EXPECT_EQ( loaded[0].p1, loaded[0].p2 );
+}
+
 TYPED_TEST(DLBase, array_struct_circular_ptr_holder_array)
 {
 	// long name!
@@ -208,3 +228,199 @@ TYPED_TEST(DLBase, ptr_array)
 	EXPECT_NE( loaded[0].arr[0], loaded[0].arr[1] );
 	EXPECT_EQ( loaded[0].arr[0], loaded[0].arr[2] );
 }
+
+TEST_F(DL, ptr_array_with_more_than_128_unique_ptrs)
+{
+	// capturing bug where only 128 pointers could be tracked when storing and loading an instance.
+	Pods2 pods[1000];
+	Pods2* arr[1000];
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( pods ); ++i )
+	{
+		pods[i].Int1 = i;
+		pods[i].Int2 = i * 2;
+		arr[i] = &pods[i];
+	}
+	ptr_array all_unique = { { arr, DL_ARRAY_LENGTH( arr ) } };
+
+	size_t all_unique_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, ptr_array::TYPE_ID, &all_unique, &all_unique_size ) );
+
+	// ... point second half of the array to the first half, these should not be written again ...
+	for( uint32_t i = 500; i < DL_ARRAY_LENGTH( arr ); ++i )
+		arr[i] = &pods[i - 500];
+
+	size_t half_unique_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, ptr_array::TYPE_ID, &all_unique, &half_unique_size ) );
+
+	EXPECT_EQ( 500 * sizeof( Pods2 ), all_unique_size - half_unique_size );
+
+	unsigned char* store_buffer = (unsigned char*)malloc( half_unique_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, ptr_array::TYPE_ID, &all_unique, store_buffer, half_unique_size, 0x0 ) );
+
+	ptr_array* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, ptr_array::TYPE_ID, store_buffer, half_unique_size, (void**)(void*)&loaded, 0x0 ) );
+
+	EXPECT_EQ( DL_ARRAY_LENGTH( arr ), loaded->arr.count );
+	for( uint32_t i = 0; i < loaded->arr.count; ++i )
+	{
+		EXPECT_EQ( arr[i]->Int1, loaded->arr[i]->Int1 );
+		EXPECT_EQ( arr[i]->Int2, loaded->arr[i]->Int2 );
+	}
+	for( uint32_t i = 500; i < loaded->arr.count; ++i )
+		EXPECT_EQ( loaded->arr[i - 500], loaded->arr[i] );
+
+	free( store_buffer );
+}
+
+TEST_F(DL, ptr_graph_with_more_than_128_shared_nodes)
+{
+	// ... every node points to an earlier node, all nodes need to be tracked to only get patched once ...
+	DoublePtrChain nodes[1000];
+	nodes[0].Int  = 0;
+	nodes[0].Next = 0x0;
+	nodes[0].Prev = 0x0;
+	for( uint32_t i = 1; i < DL_ARRAY_LENGTH( nodes ); ++i )
+	{
+		nodes[i].Int  = i;
+		nodes[i].Next = 0x0;
+		nodes[i].Prev = &nodes[i - 1];
+		nodes[i - 1].Next = &nodes[i];
+	}
+
+	size_t store_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, DoublePtrChain::TYPE_ID, &nodes[0], &store_size ) );
+	unsigned char* store_buffer = (unsigned char*)malloc( store_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, DoublePtrChain::TYPE_ID, &nodes[0], store_buffer, store_size, 0x0 ) );
+
+	DoublePtrChain* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, DoublePtrChain::TYPE_ID, store_buffer, store_size, (void**)(void*)&loaded, 0x0 ) );
+
+	const DoublePtrChain* node = loaded;
+	EXPECT_EQ( 0x0, node->Prev );
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( nodes ) - 1; ++i )
+	{
+		EXPECT_EQ( i, node->Int );
+		EXPECT_EQ( node, node->Next->Prev );
+		node = node->Next;
+	}
+	EXPECT_EQ( 0x0, node->Next );
+
+	free( store_buffer );
+}
+
+TEST_F(DL, ptr_graph_with_more_than_256_ptrs_convert)
+{
+	// capturing bug where only 128 instances and 256 pointers could be tracked when converting an instance.
+	DoublePtrChain nodes[1000];
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( nodes ); ++i )
+	{
+		nodes[i].Int  = i;
+		nodes[i].Next = i == DL_ARRAY_LENGTH( nodes ) - 1 ? 0x0 : &nodes[i + 1];
+		nodes[i].Prev = i == 0 ? 0x0 : &nodes[i - 1];
+	}
+
+	size_t store_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, DoublePtrChain::TYPE_ID, &nodes[0], &store_size ) );
+	unsigned char* store_buffer = (unsigned char*)malloc( store_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, DoublePtrChain::TYPE_ID, &nodes[0], store_buffer, store_size, 0x0 ) );
+
+	// ... convert to other endian and ptr-size and back again ...
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	size_t other_ptr_size = sizeof(void*) == 8 ? 4 : 8;
+
+	size_t converted_size = 0;
+	EXPECT_DL_ERR_OK( dl_convert_calc_size( Ctx, DoublePtrChain::TYPE_ID, store_buffer, store_size, other_ptr_size, &converted_size ) );
+	unsigned char* converted = (unsigned char*)malloc( converted_size );
+	EXPECT_DL_ERR_OK( dl_convert( Ctx, DoublePtrChain::TYPE_ID, store_buffer, store_size, converted, converted_size, other_endian, other_ptr_size, 0x0 ) );
+
+	size_t back_size = 0;
+	EXPECT_DL_ERR_OK( dl_convert_calc_size( Ctx, DoublePtrChain::TYPE_ID, converted, converted_size, sizeof(void*), &back_size ) );
+	EXPECT_EQ( store_size, back_size );
+	unsigned char* back = (unsigned char*)malloc( back_size );
+	EXPECT_DL_ERR_OK( dl_convert( Ctx, DoublePtrChain::TYPE_ID, converted, converted_size, back, back_size, DL_ENDIAN_HOST, sizeof(void*), 0x0 ) );
+
+	DoublePtrChain* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, DoublePtrChain::TYPE_ID, back, back_size, (void**)(void*)&loaded, 0x0 ) );
+
+	const DoublePtrChain* node = loaded;
+	EXPECT_EQ( 0x0, node->Prev );
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( nodes ) - 1; ++i )
+	{
+		EXPECT_EQ( i, node->Int );
+		EXPECT_EQ( node, node->Next->Prev );
+		node = node->Next;
+	}
+	EXPECT_EQ( 0x0, node->Next );
+
+	free( back );
+	free( converted );
+	free( store_buffer );
+}
+
+struct ptr_test_stream_sink
+{
+	unsigned char* buffer;
+	size_t         buffer_size;
+	size_t         written;
+	size_t         chunks;
+	size_t         max_chunk;
+};
+
+static dl_error_t ptr_test_stream_write( const void* data, size_t size, void* write_ctx )
+{
+	ptr_test_stream_sink* sink = (ptr_test_stream_sink*)write_ctx;
+	if( sink->written + size > sink->buffer_size )
+		return DL_ERROR_BUFFER_TO_SMALL;
+	memcpy( sink->buffer + sink->written, data, size );
+	sink->written += size;
+	sink->chunks  += 1;
+	sink->max_chunk = size > sink->max_chunk ? size : sink->max_chunk;
+	return DL_ERROR_OK;
+}
+
+TEST_F(DL, ptr_graph_store_stream_in_multiple_chunks)
+{
+	// ... a wide array is big enough that the output do not fit in one chunk, without a deep ptr-chain that would make
+	//     store recurse ...
+	const uint32_t NUM_ELEMS = 20000;
+	Pods2* arr = (Pods2*)malloc( NUM_ELEMS * sizeof(Pods2) );
+	for( uint32_t i = 0; i < NUM_ELEMS; ++i )
+	{
+		arr[i].Int1 = i;
+		arr[i].Int2 = i * 2;
+	}
+	PtrIntoArray original = { &arr[10], { arr, NUM_ELEMS }, &arr[NUM_ELEMS - 1] };
+
+	size_t store_size = 0;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, PtrIntoArray::TYPE_ID, &original, &store_size ) );
+	unsigned char* store_buffer = (unsigned char*)calloc( 1, store_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( Ctx, PtrIntoArray::TYPE_ID, &original, store_buffer, store_size, 0x0 ) );
+
+	ptr_test_stream_sink sink = { (unsigned char*)malloc( store_size ), store_size, 0, 0, 0 };
+	size_t produced = 0;
+	EXPECT_DL_ERR_OK( dl_instance_store_stream( Ctx, PtrIntoArray::TYPE_ID, &original, ptr_test_stream_write, &sink, &produced ) );
+	EXPECT_EQ( store_size, produced );
+	EXPECT_EQ( store_size, sink.written );
+	EXPECT_GT( sink.chunks, 1u );
+	EXPECT_LT( sink.max_chunk, store_size );
+	EXPECT_EQ( 0, memcmp( store_buffer, sink.buffer, store_size ) );
+
+	PtrIntoArray* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, PtrIntoArray::TYPE_ID, sink.buffer, store_size, (void**)(void*)&loaded, 0x0 ) );
+	EXPECT_EQ( NUM_ELEMS, loaded->arr.count );
+	for( uint32_t i = 0; i < NUM_ELEMS; ++i )
+	{
+		EXPECT_EQ( i,     loaded->arr[i].Int1 );
+		EXPECT_EQ( i * 2, loaded->arr[i].Int2 );
+	}
+	EXPECT_EQ( 10u,            loaded->p1->Int1 );
+	EXPECT_EQ( NUM_ELEMS - 1, loaded->p2->Int1 );
+
+	// ... errors from the callback are returned as is ...
+	ptr_test_stream_sink small_sink = { sink.buffer, store_size / 2, 0, 0, 0 };
+	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL, dl_instance_store_stream( Ctx, PtrIntoArray::TYPE_ID, &original, ptr_test_stream_write, &small_sink, 0x0 ) );
+
+	free( sink.buffer );
+	free( store_buffer );
+	free( arr );
+}
@@ -0,0 +1,240 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#define DL_RELATIVE_ACCESSORS
+
+#include <gtest/gtest.h>
+
+#include <dl/dl.h>
+#include <dl/dl_convert.h>
+#include <dl/dl_txt.h>
+#include <dl/dl_typelib.h>
+#include <dl/dl_reflect.h>
+
+#include "dl_test_common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STRINGIFY( ... ) #__VA_ARGS__
+
+class DLRelative : public DL
+{
+public:
+	unsigned char* packed;
+	size_t         packed_size;
+	unsigned char* relative;
+	size_t         relative_size;
+
+	virtual void SetUp()
+	{
+		DL::SetUp();
+		packed   = 0x0;
+		relative = 0x0;
+	}
+
+	virtual void TearDown()
+	{
+		free( packed );
+		free( relative );
+		DL::TearDown();
+	}
+
+	/**
+	 * Store instance and convert it to the relative format with refs of ref_size, returns the loaded instance.
+	 */
+	const void* store_relative( dl_typeid_t type, void* instance, size_t ref_size, dl_endian_t endian = DL_ENDIAN_HOST )
+	{
+		free( packed );
+		free( relative );
+
+		EXPECT_DL_ERR_OK( dl_instance_calc_size( Ctx, type, instance, &packed_size ) );
+		packed = (unsigned char*)malloc( packed_size );
+		EXPECT_DL_ERR_OK( dl_instance_store( Ctx, type, instance, packed, packed_size, 0x0 ) );
+
+		EXPECT_DL_ERR_OK( dl_convert_to_relative( Ctx, type, packed, packed_size, 0x0, 0, endian, ref_size, &relative_size ) );
+		relative = (unsigned char*)malloc( relative_size );
+		size_t produced = 0;
+		EXPECT_DL_ERR_OK( dl_convert_to_relative( Ctx, type, packed, packed_size, relative, relative_size, endian, ref_size, &produced ) );
+		EXPECT_EQ( relative_size, produced );
+
+		if( endian != DL_ENDIAN_HOST )
+			return 0x0;
+
+		// ... nothing should be written while loading ...
+		unsigned char* copy = (unsigned char*)malloc( relative_size );
+		memcpy( copy, relative, relative_size );
+
+		const void* loaded = 0x0;
+		size_t consumed = 0;
+		EXPECT_DL_ERR_OK( dl_instance_load_relative( Ctx, type, relative, relative_size, &loaded, &consumed ) );
+		EXPECT_EQ( relative_size, consumed );
+		EXPECT_EQ( 0, memcmp( copy, relative, relative_size ) );
+		free( copy );
+		return loaded;
+	}
+};
+
+TEST_F( DLRelative, ptr )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, 0x0 };
+
+	const SimplePtr* loaded = (const SimplePtr*)store_relative( SimplePtr::TYPE_ID, &original, sizeof(void*) );
+	EXPECT_EQ( 0x0, SimplePtr_get_Ptr2( loaded ) );
+	EXPECT_EQ( 0x0, loaded->Ptr2 ); // ... null is stored as 0 ...
+	const Pods* p = SimplePtr_get_Ptr1( loaded );
+	EXPECT_EQ( pods.i64, p->i64 );
+	EXPECT_EQ( pods.f64, p->f64 );
+
+	original.Ptr2 = &pods;
+	const SimplePtr_ref32* loaded32 = (const SimplePtr_ref32*)store_relative( SimplePtr::TYPE_ID, &original, 4 );
+	EXPECT_EQ( SimplePtr_ref32_get_Ptr1( loaded32 ), SimplePtr_ref32_get_Ptr2( loaded32 ) );
+	const Pods_ref32* p32 = SimplePtr_ref32_get_Ptr1( loaded32 );
+	EXPECT_EQ( pods.i8,  p32->i8 );
+	EXPECT_EQ( pods.u64, p32->u64 );
+	EXPECT_EQ( pods.f32, p32->f32 );
+}
+
+TEST_F( DLRelative, ptr_chain_back_references )
+{
+	// ... back-references are stored as negative offsets, the root is referenced from its own member ...
+	DoublePtrChain d[3];
+	d[0].Int = 1; d[0].Next = &d[1]; d[0].Prev = &d[0];
+	d[1].Int = 2; d[1].Next = &d[2]; d[1].Prev = &d[0];
+	d[2].Int = 3; d[2].Next = 0x0;   d[2].Prev = &d[1];
+
+	size_t ref_sizes[] = { sizeof(void*), 4 };
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( ref_sizes ); ++i )
+	{
+		const void* loaded = store_relative( DoublePtrChain::TYPE_ID, &d[0], ref_sizes[i] );
+		if( ref_sizes[i] == sizeof(void*) )
+		{
+			const DoublePtrChain* c0 = (const DoublePtrChain*)loaded;
+			const DoublePtrChain* c1 = DoublePtrChain_get_Next( c0 );
+			const DoublePtrChain* c2 = DoublePtrChain_get_Next( c1 );
+			EXPECT_EQ( c0, DoublePtrChain_get_Prev( c0 ) );
+			EXPECT_EQ( c0, DoublePtrChain_get_Prev( c1 ) );
+			EXPECT_EQ( c1, DoublePtrChain_get_Prev( c2 ) );
+			EXPECT_EQ( 0x0, DoublePtrChain_get_Next( c2 ) );
+			EXPECT_EQ( 3u, c2->Int );
+		}
+		else
+		{
+			const DoublePtrChain_ref32* c0 = (const DoublePtrChain_ref32*)loaded;
+			const DoublePtrChain_ref32* c1 = DoublePtrChain_ref32_get_Next( c0 );
+			const DoublePtrChain_ref32* c2 = DoublePtrChain_ref32_get_Next( c1 );
+			EXPECT_EQ( c0, DoublePtrChain_ref32_get_Prev( c0 ) );
+			EXPECT_EQ( c0, DoublePtrChain_ref32_get_Prev( c1 ) );
+			EXPECT_EQ( c1, DoublePtrChain_ref32_get_Prev( c2 ) );
+			EXPECT_EQ( 0x0, DoublePtrChain_ref32_get_Next( c2 ) );
+			EXPECT_EQ( 2u, c1->Int );
+		}
+	}
+}
+
+TEST_F( DLRelative, strings )
+{
+	Strings original = { "cow", "bells are cool" };
+	const Strings* loaded = (const Strings*)store_relative( Strings::TYPE_ID, &original, sizeof(void*) );
+	EXPECT_STREQ( original.Str1, Strings_get_Str1( loaded ) );
+	EXPECT_STREQ( original.Str2, Strings_get_Str2( loaded ) );
+
+	const Strings_ref32* loaded32 = (const Strings_ref32*)store_relative( Strings::TYPE_ID, &original, 4 );
+	EXPECT_EQ( 8u, sizeof(Strings_ref32) );
+	EXPECT_STREQ( original.Str1, Strings_ref32_get_Str1( loaded32 ) );
+	EXPECT_STREQ( original.Str2, Strings_ref32_get_Str2( loaded32 ) );
+}
+
+TEST_F( DLRelative, arrays )
+{
+	const char* strs[] = { "cow", "bells", "are", "cool" };
+	StringArray str_arr = { { strs, DL_ARRAY_LENGTH( strs ) } };
+
+	const StringArray* loaded_strs = (const StringArray*)store_relative( StringArray::TYPE_ID, &str_arr, sizeof(void*) );
+	EXPECT_EQ( DL_ARRAY_LENGTH( strs ), loaded_strs->Strings.count );
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( strs ); ++i )
+		EXPECT_STREQ( strs[i], StringArray_get_Strings( loaded_strs, i ) );
+
+	const StringArray_ref32* loaded_strs32 = (const StringArray_ref32*)store_relative( StringArray::TYPE_ID, &str_arr, 4 );
+	EXPECT_EQ( DL_ARRAY_LENGTH( strs ), loaded_strs32->Strings.count );
+	for( uint32_t i = 0; i < DL_ARRAY_LENGTH( strs ); ++i )
+		EXPECT_STREQ( strs[i], StringArray_ref32_get_Strings( loaded_strs32, i ) );
+
+	uint32_t u32s[] = { 1, 2, 3, 4, 5 };
+	PodArray1 pod_arr = { { u32s, DL_ARRAY_LENGTH( u32s ) } };
+	const PodArray1_ref32* loaded_pods32 = (const PodArray1_ref32*)store_relative( PodArray1::TYPE_ID, &pod_arr, 4 );
+	EXPECT_EQ( DL_ARRAY_LENGTH( u32s ), loaded_pods32->u32_arr.count );
+	EXPECT_ARRAY_EQ( DL_ARRAY_LENGTH( u32s ), u32s, PodArray1_ref32_get_u32_arr( loaded_pods32 ) );
+
+	Pods2 p1 = { 1, 2 };
+	Pods2 p2 = { 3, 4 };
+	Pods2* ptrs[] = { &p1, &p2, &p1 };
+	ptr_array ptr_arr = { { ptrs, DL_ARRAY_LENGTH( ptrs ) } };
+	const ptr_array* loaded_ptrs = (const ptr_array*)store_relative( ptr_array::TYPE_ID, &ptr_arr, sizeof(void*) );
+	EXPECT_EQ( ptr_array_get_arr( loaded_ptrs, 0 ), ptr_array_get_arr( loaded_ptrs, 2 ) );
+	EXPECT_EQ( p1.Int2, ptr_array_get_arr( loaded_ptrs, 0 )->Int2 );
+	EXPECT_EQ( p2.Int1, ptr_array_get_arr( loaded_ptrs, 1 )->Int1 );
+
+	inline_ptr_array inline_ptrs = { { &p2, 0x0, &p1 } };
+	const inline_ptr_array_ref32* loaded_inline32 = (const inline_ptr_array_ref32*)store_relative( inline_ptr_array::TYPE_ID, &inline_ptrs, 4 );
+	EXPECT_EQ( p2.Int2, inline_ptr_array_ref32_get_arr( loaded_inline32, 0 )->Int2 );
+	EXPECT_EQ( 0x0, inline_ptr_array_ref32_get_arr( loaded_inline32, 1 ) );
+	EXPECT_EQ( p1.Int1, inline_ptr_array_ref32_get_arr( loaded_inline32, 2 )->Int1 );
+}
+
+TEST_F( DLRelative, errors )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+	store_relative( SimplePtr::TYPE_ID, &original, sizeof(void*) );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( relative, relative_size, &info ) );
+	EXPECT_EQ( 1u, info.relative );
+	EXPECT_DL_ERR_OK( dl_instance_get_info( packed, packed_size, &info ) );
+	EXPECT_EQ( 0u, info.relative );
+
+	// ... relative instances can only be loaded with dl_instance_load_relative() and vice versa ...
+	const void* loaded = 0x0;
+	void* loaded_inplace = 0x0;
+	SimplePtr loaded_copy[8];
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_instance_load_relative( Ctx, SimplePtr::TYPE_ID, packed, packed_size, &loaded, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_instance_load_inplace( Ctx, SimplePtr::TYPE_ID, relative, relative_size, &loaded_inplace, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_instance_load( Ctx, SimplePtr::TYPE_ID, loaded_copy, sizeof(loaded_copy), relative, relative_size, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_convert( Ctx, SimplePtr::TYPE_ID, relative, relative_size, 0x0, 0, DL_ENDIAN_HOST, 4, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_txt_unpack_calc_size( Ctx, SimplePtr::TYPE_ID, relative, relative_size, 0x0 ) );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_MISMATCH,  dl_instance_load_relative( Ctx, Pods::TYPE_ID, relative, relative_size, &loaded, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA, dl_instance_load_relative( Ctx, SimplePtr::TYPE_ID, relative, relative_size - 1, &loaded, 0x0 ) );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	store_relative( SimplePtr::TYPE_ID, &original, 4, other_endian );
+	EXPECT_DL_ERR_EQ( DL_ERROR_ENDIAN_MISMATCH, dl_instance_load_relative( Ctx, SimplePtr::TYPE_ID, relative, relative_size, &loaded, 0x0 ) );
+	EXPECT_DL_ERR_OK( dl_instance_get_info( relative, relative_size, &info ) );
+	EXPECT_EQ( 1u, info.relative );
+	EXPECT_EQ( 4u, info.ptrsize );
+}
+
+TEST_F( DLRelative, ptr_to_itself_not_supported )
+{
+	// ... 0 is null, so a ptr that is the first member of the struct it points to can not be stored as relative ...
+	static const char typelib[] = STRINGIFY( { "types" : { "self_ref" : { "members" : [ { "name" : "next", "type" : "self_ref*" } ] } } } );
+	dl_ctx_t ctx;
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT( p );
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_txt_type_library( ctx, typelib, sizeof(typelib) - 1 ) );
+
+	dl_typeid_t tid;
+	EXPECT_DL_ERR_OK( dl_reflect_get_type_id( ctx, "self_ref", &tid ) );
+
+	const char txt[] = STRINGIFY( { "self_ref" : { "next" : "n", "__subdata" : { "n" : { "next" : "n" } } } } );
+	unsigned char packed_self[256];
+	size_t packed_self_size;
+	EXPECT_DL_ERR_OK( dl_txt_pack( ctx, txt, packed_self, sizeof(packed_self), &packed_self_size ) );
+
+	unsigned char out[256];
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_convert_to_relative( ctx, tid, packed_self, packed_self_size, out, sizeof(out), DL_ENDIAN_HOST, sizeof(void*), 0x0 ) );
+
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+}
@@ -0,0 +1,247 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <gtest/gtest.h>
+
+#include <dl/dl.h>
+#include <dl/dl_convert.h>
+#include <dl/dl_txt.h>
+
+#include "dl_test_common.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const unsigned char DL_STATS_TEST_LIB1[] =
+{
+	#include "generated/unittest.bin.h"
+};
+
+static const unsigned char DL_STATS_TEST_LIB2[] =
+{
+	#include "generated/unittest2.bin.h"
+};
+
+class DLStats : public DL
+{
+public:
+	dl_ctx_t StatsCtx;
+
+	virtual void SetUp()
+	{
+		DL::SetUp();
+		StatsCtx = create_stats_ctx( DL_STATS_TIMING );
+	}
+
+	virtual void TearDown()
+	{
+		EXPECT_DL_ERR_OK( dl_context_destroy( StatsCtx ) );
+		DL::TearDown();
+	}
+
+	dl_ctx_t create_stats_ctx( dl_stats_mode_t mode )
+	{
+		dl_ctx_t ctx;
+		dl_create_params_t p;
+		DL_CREATE_PARAMS_SET_DEFAULT( p );
+		p.error_msg_func = test_log_error;
+		p.stats_mode     = mode;
+		EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+		EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, DL_STATS_TEST_LIB1, sizeof( DL_STATS_TEST_LIB1 ) ) );
+		EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, DL_STATS_TEST_LIB2, sizeof( DL_STATS_TEST_LIB2 ) ) );
+		return ctx;
+	}
+
+	dl_context_stats_t get_stats()
+	{
+		dl_context_stats_t stats;
+		memset( &stats, 0xFF, sizeof( stats ) );
+		EXPECT_DL_ERR_OK( dl_context_get_stats( StatsCtx, &stats ) );
+		return stats;
+	}
+};
+
+TEST_F( DLStats, not_collected_by_default )
+{
+	dl_context_stats_t stats;
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_context_get_stats( Ctx, &stats ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UNSUPPORTED_OPERATION, dl_context_reset_stats( Ctx ) );
+}
+
+TEST_F( DLStats, typelib_load )
+{
+	dl_context_stats_t stats = get_stats();
+	const dl_stats_op_counters_t* load = &stats.ops[DL_STATS_OP_TYPELIB_LOAD];
+	EXPECT_EQ( 2u, load->calls );
+	EXPECT_EQ( sizeof( DL_STATS_TEST_LIB1 ) + sizeof( DL_STATS_TEST_LIB2 ), load->bytes_in );
+	EXPECT_EQ( 0u, load->bytes_out );
+	EXPECT_LT( 0u, load->nanoseconds );
+
+	// ... the context keep the type-libraries in memory it allocated ...
+	EXPECT_LT( 0u, stats.allocations );
+	EXPECT_LT( 0u, stats.allocated_bytes );
+	EXPECT_LE( stats.allocated_bytes, stats.peak_allocated_bytes );
+
+	for( int op = 0; op < DL_STATS_OP_COUNT; ++op )
+	{
+		if( op != DL_STATS_OP_TYPELIB_LOAD )
+		{
+			EXPECT_EQ( 0u, stats.ops[op].calls );
+		}
+	}
+}
+
+TEST_F( DLStats, store_and_load )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+
+	EXPECT_DL_ERR_OK( dl_context_reset_stats( StatsCtx ) );
+
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( StatsCtx, SimplePtr::TYPE_ID, &original, &packed_size ) );
+	unsigned char packed[256];
+	ASSERT_GE( sizeof( packed ), packed_size );
+	EXPECT_DL_ERR_OK( dl_instance_store( StatsCtx, SimplePtr::TYPE_ID, &original, packed, sizeof( packed ), 0x0 ) );
+
+	union { uint64_t align; unsigned char data[256]; } loaded;
+	size_t consumed;
+	EXPECT_DL_ERR_OK( dl_instance_load( StatsCtx, SimplePtr::TYPE_ID, loaded.data, sizeof( loaded.data ), packed, packed_size, &consumed ) );
+
+	dl_context_stats_t stats = get_stats();
+	const dl_stats_op_counters_t* store = &stats.ops[DL_STATS_OP_STORE];
+	const dl_stats_op_counters_t* load  = &stats.ops[DL_STATS_OP_LOAD];
+
+	// ... dl_instance_calc_size() store through dl_instance_store() but is only counted once ...
+	EXPECT_EQ( 2u, store->calls );
+	EXPECT_EQ( 0u, store->bytes_in );
+	EXPECT_EQ( 2 * packed_size, store->bytes_out );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( packed, packed_size, &info ) );
+	EXPECT_EQ( 1u, load->calls );
+	EXPECT_EQ( consumed, load->bytes_in );
+	EXPECT_EQ( info.load_size, load->bytes_out );
+
+	// ... both ptrs point to the same instance but both need patching ...
+	EXPECT_EQ( 2u, stats.ptrs_patched );
+	EXPECT_LT( 0u, stats.type_lookups );
+	EXPECT_EQ( 0u, stats.ops[DL_STATS_OP_CONVERT].calls );
+}
+
+TEST_F( DLStats, failed_calls_are_counted_without_bytes )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( StatsCtx, Pods::TYPE_ID, &pods, packed, sizeof( packed ), &packed_size ) );
+	EXPECT_DL_ERR_OK( dl_context_reset_stats( StatsCtx ) );
+
+	SimplePtr loaded;
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_MISMATCH, dl_instance_load( StatsCtx, SimplePtr::TYPE_ID, &loaded, sizeof( loaded ), packed, packed_size, 0x0 ) );
+
+	dl_context_stats_t stats = get_stats();
+	EXPECT_EQ( 1u, stats.ops[DL_STATS_OP_LOAD].calls );
+	EXPECT_EQ( 0u, stats.ops[DL_STATS_OP_LOAD].bytes_in );
+	EXPECT_EQ( 0u, stats.ops[DL_STATS_OP_LOAD].bytes_out );
+}
+
+TEST_F( DLStats, convert_and_txt )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( StatsCtx, Pods::TYPE_ID, &pods, packed, sizeof( packed ), &packed_size ) );
+	EXPECT_DL_ERR_OK( dl_context_reset_stats( StatsCtx ) );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	unsigned char converted[256];
+	size_t converted_size;
+	EXPECT_DL_ERR_OK( dl_convert( StatsCtx, Pods::TYPE_ID, packed, packed_size, converted, sizeof( converted ), other_endian, sizeof(void*), &converted_size ) );
+
+	char txt[2048];
+	size_t txt_size;
+	EXPECT_DL_ERR_OK( dl_txt_unpack( StatsCtx, Pods::TYPE_ID, packed, packed_size, txt, sizeof( txt ), &txt_size ) );
+
+	unsigned char repacked[256];
+	size_t repacked_size;
+	EXPECT_DL_ERR_OK( dl_txt_pack( StatsCtx, txt, repacked, sizeof( repacked ), &repacked_size ) );
+
+	dl_context_stats_t stats = get_stats();
+	const dl_stats_op_counters_t* convert = &stats.ops[DL_STATS_OP_CONVERT];
+	const dl_stats_op_counters_t* unpack  = &stats.ops[DL_STATS_OP_TXT_UNPACK];
+	const dl_stats_op_counters_t* pack    = &stats.ops[DL_STATS_OP_TXT_PACK];
+
+	EXPECT_EQ( 1u, convert->calls );
+	EXPECT_EQ( packed_size, convert->bytes_in );
+	EXPECT_EQ( converted_size, convert->bytes_out );
+
+	EXPECT_EQ( 1u, unpack->calls );
+	EXPECT_EQ( packed_size, unpack->bytes_in );
+	EXPECT_EQ( txt_size, unpack->bytes_out );
+
+	EXPECT_EQ( 1u, pack->calls );
+	EXPECT_EQ( strlen( txt ), pack->bytes_in );
+	EXPECT_EQ( repacked_size, pack->bytes_out );
+}
+
+TEST_F( DLStats, allocations_are_tracked )
+{
+	const char* txt = "{ \"Pods\" : { \"i8\" : 1, \"i16\" : 2, \"i32\" : 3, \"i64\" : 4, \"u8\" : 5, \"u16\" : 6, \"u32\" : 7, \"u64\" : 8, \"f32\" : 8.1, \"f64\" : 8.2 } }";
+
+	dl_context_stats_t before = get_stats();
+	EXPECT_DL_ERR_OK( dl_context_reset_stats( StatsCtx ) );
+	dl_context_stats_t reset = get_stats();
+	EXPECT_EQ( before.allocated_bytes, reset.allocated_bytes );
+	EXPECT_EQ( before.allocated_bytes, reset.peak_allocated_bytes );
+	EXPECT_EQ( 0u, reset.allocations );
+	EXPECT_EQ( 0u, reset.type_lookups );
+	EXPECT_EQ( 0u, reset.ops[DL_STATS_OP_TYPELIB_LOAD].calls );
+
+	// ... temporary memory used by txt pack is freed when done and buffers returned to the caller are not counted ...
+	unsigned char* packed = 0x0;
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_txt_pack_alloc( StatsCtx, txt, 0x0, 0x0, &packed, &packed_size ) );
+	free( packed );
+
+	dl_context_stats_t after = get_stats();
+	EXPECT_LT( 0u, after.allocations );
+	EXPECT_EQ( reset.allocated_bytes, after.allocated_bytes );
+	EXPECT_LT( after.allocated_bytes, after.peak_allocated_bytes );
+}
+
+TEST_F( DLStats, convert_prepare_builds_plans_up_front )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( StatsCtx, SimplePtr::TYPE_ID, &original, packed, sizeof( packed ), &packed_size ) );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	unsigned char converted[256];
+	size_t converted_size;
+
+	// ... plans are kept in the context after the first convert ...
+	dl_context_stats_t before = get_stats();
+	EXPECT_DL_ERR_OK( dl_convert( StatsCtx, SimplePtr::TYPE_ID, packed, packed_size, converted, sizeof( converted ), other_endian, 4, &converted_size ) );
+	EXPECT_LT( before.allocated_bytes, get_stats().allocated_bytes );
+
+	// ... converting between prepared formats do not add anything to the context ...
+	EXPECT_DL_ERR_OK( dl_convert_prepare( StatsCtx, DL_ENDIAN_HOST, sizeof(void*), other_endian, sizeof(void*) ) );
+	before = get_stats();
+	EXPECT_DL_ERR_OK( dl_convert( StatsCtx, SimplePtr::TYPE_ID, packed, packed_size, converted, sizeof( converted ), other_endian, sizeof(void*), &converted_size ) );
+	EXPECT_EQ( before.allocated_bytes, get_stats().allocated_bytes );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_INVALID_PARAMETER, dl_convert_prepare( StatsCtx, DL_ENDIAN_HOST, 3, other_endian, sizeof(void*) ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_INVALID_PARAMETER, dl_convert_prepare( StatsCtx, DL_ENDIAN_HOST, sizeof(void*), other_endian, 0 ) );
+}
+
+TEST_F( DLStats, timing_is_optional )
+{
+	dl_ctx_t ctx = create_stats_ctx( DL_STATS_COUNTERS );
+	dl_context_stats_t stats;
+	EXPECT_DL_ERR_OK( dl_context_get_stats( ctx, &stats ) );
+	EXPECT_EQ( 2u, stats.ops[DL_STATS_OP_TYPELIB_LOAD].calls );
+	EXPECT_EQ( 0u, stats.ops[DL_STATS_OP_TYPELIB_LOAD].nanoseconds );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+}
@@ -0,0 +1,272 @@
+/* copyright (c) 2010 Fredrik Kihlander, see LICENSE for more info */
+
+#include <gtest/gtest.h>
+
+#include <dl/dl.h>
+#include <dl/dl_convert.h>
+#include <dl/dl_txt.h>
+#include <dl/dl_trace.h>
+
+#include "dl_test_common.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+static const unsigned char DL_TRACE_TEST_LIB1[] =
+{
+	#include "generated/unittest.bin.h"
+};
+
+static const unsigned char DL_TRACE_TEST_LIB2[] =
+{
+	#include "generated/unittest2.bin.h"
+};
+
+struct dl_test_trace_event
+{
+	char        phase;
+	std::string name;
+	std::string type_name;
+	size_t      bytes_in;
+	size_t      bytes_out;
+};
+
+static void dl_test_trace_record( std::vector<dl_test_trace_event>* events, const dl_trace_event_t* event, char phase )
+{
+	dl_test_trace_event e;
+	e.phase     = phase;
+	e.name      = event->name;
+	e.type_name = event->type_name ? event->type_name : "";
+	e.bytes_in  = event->bytes_in;
+	e.bytes_out = event->bytes_out;
+	events->push_back( e );
+}
+
+static void dl_test_trace_begin( const dl_trace_event_t* event, void* trace_ctx ) { dl_test_trace_record( (std::vector<dl_test_trace_event>*)trace_ctx, event, 'B' ); }
+static void dl_test_trace_end  ( const dl_trace_event_t* event, void* trace_ctx ) { dl_test_trace_record( (std::vector<dl_test_trace_event>*)trace_ctx, event, 'E' ); }
+
+class DLTrace : public DL
+{
+public:
+	dl_ctx_t                         TraceCtx;
+	std::vector<dl_test_trace_event> events;
+
+	virtual void SetUp()
+	{
+		DL::SetUp();
+
+		dl_create_params_t p;
+		DL_CREATE_PARAMS_SET_DEFAULT( p );
+		p.error_msg_func   = test_log_error;
+		p.trace_begin_func = dl_test_trace_begin;
+		p.trace_end_func   = dl_test_trace_end;
+		p.trace_ctx        = &events;
+		EXPECT_DL_ERR_OK( dl_context_create( &TraceCtx, &p ) );
+		EXPECT_DL_ERR_OK( dl_context_load_type_library( TraceCtx, DL_TRACE_TEST_LIB1, sizeof( DL_TRACE_TEST_LIB1 ) ) );
+		EXPECT_DL_ERR_OK( dl_context_load_type_library( TraceCtx, DL_TRACE_TEST_LIB2, sizeof( DL_TRACE_TEST_LIB2 ) ) );
+	}
+
+	virtual void TearDown()
+	{
+		EXPECT_DL_ERR_OK( dl_context_destroy( TraceCtx ) );
+		DL::TearDown();
+	}
+
+	/// return the recorded events as "B:name E:name ...", and check that all events are properly nested.
+	std::string event_names()
+	{
+		std::string names;
+		std::vector<std::string> open;
+		for( size_t i = 0; i < events.size(); ++i )
+		{
+			if( events[i].phase == 'B' )
+				open.push_back( events[i].name );
+			else
+			{
+				EXPECT_FALSE( open.empty() );
+				if( !open.empty() )
+				{
+					EXPECT_EQ( open.back(), events[i].name );
+					open.pop_back();
+				}
+			}
+			if( !names.empty() )
+				names += " ";
+			names += events[i].phase;
+			names += ":" + events[i].name;
+		}
+		EXPECT_TRUE( open.empty() );
+		return names;
+	}
+};
+
+TEST_F( DLTrace, typelib_load )
+{
+	EXPECT_EQ( "B:dl_context_load_type_library E:dl_context_load_type_library B:dl_context_load_type_library E:dl_context_load_type_library", event_names() );
+	EXPECT_EQ( sizeof( DL_TRACE_TEST_LIB1 ), events[0].bytes_in );
+	EXPECT_EQ( sizeof( DL_TRACE_TEST_LIB1 ), events[1].bytes_in );
+	EXPECT_EQ( 0u, events[1].bytes_out );
+	EXPECT_EQ( sizeof( DL_TRACE_TEST_LIB2 ), events[3].bytes_in );
+}
+
+TEST_F( DLTrace, store_and_load )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( TraceCtx, SimplePtr::TYPE_ID, &original, packed, sizeof( packed ), &packed_size ) );
+
+	union { uint64_t align; unsigned char data[256]; } loaded;
+	events.clear();
+	EXPECT_DL_ERR_OK( dl_instance_load( TraceCtx, SimplePtr::TYPE_ID, loaded.data, sizeof( loaded.data ), packed, packed_size, 0x0 ) );
+
+	EXPECT_EQ( "B:dl_instance_load B:load.patch E:load.patch E:dl_instance_load", event_names() );
+	for( size_t i = 0; i < events.size(); ++i )
+		EXPECT_EQ( "SimplePtr", events[i].type_name );
+
+	dl_instance_info_t info;
+	EXPECT_DL_ERR_OK( dl_instance_get_info( packed, packed_size, &info ) );
+	EXPECT_EQ( packed_size,      events[0].bytes_in );
+	EXPECT_EQ( info.load_size,   events[2].bytes_out );
+	EXPECT_EQ( packed_size,      events[3].bytes_in );
+	EXPECT_EQ( info.load_size,   events[3].bytes_out );
+
+	// ... dl_instance_calc_size() is done by dl_instance_store() ...
+	events.clear();
+	size_t calc_size;
+	EXPECT_DL_ERR_OK( dl_instance_calc_size( TraceCtx, SimplePtr::TYPE_ID, &original, &calc_size ) );
+	EXPECT_EQ( "B:dl_instance_store E:dl_instance_store", event_names() );
+	EXPECT_EQ( "SimplePtr", events[1].type_name );
+	EXPECT_EQ( packed_size, events[1].bytes_out );
+}
+
+TEST_F( DLTrace, convert_phases )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( TraceCtx, Pods::TYPE_ID, &pods, packed, sizeof( packed ), &packed_size ) );
+
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	unsigned char converted[256];
+	size_t converted_size;
+	events.clear();
+	EXPECT_DL_ERR_OK( dl_convert( TraceCtx, Pods::TYPE_ID, packed, packed_size, converted, sizeof( converted ), other_endian, sizeof(void*), &converted_size ) );
+
+	EXPECT_EQ( "B:dl_convert B:convert.collect E:convert.collect B:convert.write E:convert.write E:dl_convert", event_names() );
+	for( size_t i = 0; i < events.size(); ++i )
+		EXPECT_EQ( "Pods", events[i].type_name );
+	// ... the write-phase produce the instance without the header ...
+	EXPECT_LT( 0u, events[4].bytes_out );
+	EXPECT_GT( converted_size, events[4].bytes_out );
+	EXPECT_EQ( packed_size,    events[5].bytes_in );
+	EXPECT_EQ( converted_size, events[5].bytes_out );
+}
+
+TEST_F( DLTrace, txt_pack_phases )
+{
+	const char* txt = "{ \"SimplePtr\" : { \"Ptr1\" : \"a\", \"Ptr2\" : \"a\", \"__subdata\" : { \"a\" : { \"i8\" : 1, \"i16\" : 2, \"i32\" : 3, \"i64\" : 4, \"u8\" : 5, \"u16\" : 6, \"u32\" : 7, \"u64\" : 8, \"f32\" : 8.1, \"f64\" : 8.2 } } } }";
+
+	unsigned char packed[256];
+	size_t packed_size;
+	events.clear();
+	EXPECT_DL_ERR_OK( dl_txt_pack( TraceCtx, txt, packed, sizeof( packed ), &packed_size ) );
+
+	EXPECT_EQ( "B:dl_txt_pack B:txt_pack.parse E:txt_pack.parse B:txt_pack.finalize_subdata E:txt_pack.finalize_subdata E:dl_txt_pack", event_names() );
+
+	// ... the type is not known until the text is read ...
+	EXPECT_EQ( "",          events[0].type_name );
+	EXPECT_EQ( "",          events[1].type_name );
+	EXPECT_EQ( "SimplePtr", events[2].type_name );
+	EXPECT_EQ( "SimplePtr", events[3].type_name );
+	EXPECT_EQ( "SimplePtr", events[5].type_name );
+
+	EXPECT_EQ( strlen( txt ), events[1].bytes_in );
+	EXPECT_EQ( strlen( txt ), events[5].bytes_in );
+	EXPECT_EQ( packed_size,   events[5].bytes_out );
+}
+
+TEST_F( DLTrace, failed_txt_pack_ends_all_phases )
+{
+	unsigned char packed[256];
+	events.clear();
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_NOT_FOUND, dl_txt_pack( TraceCtx, "{ \"not_a_type\" : {} }", packed, sizeof( packed ), 0x0 ) );
+
+	EXPECT_EQ( "B:dl_txt_pack B:txt_pack.parse E:txt_pack.parse E:dl_txt_pack", event_names() );
+	EXPECT_EQ( 0u, events[2].bytes_out );
+	EXPECT_EQ( 0u, events[3].bytes_out );
+}
+
+static dl_error_t dl_test_trace_write_string( const void* data, size_t size, void* write_ctx )
+{
+	( (std::string*)write_ctx )->append( (const char*)data, size );
+	return DL_ERROR_OK;
+}
+
+static dl_error_t dl_test_trace_write_fail( const void* data, size_t size, void* write_ctx )
+{
+	(void)data; (void)size;
+	++*(int*)write_ctx;
+	return DL_ERROR_UTIL_FILE_WRITE_FAILED;
+}
+
+static size_t dl_test_trace_count( const std::string& str, const char* substr )
+{
+	size_t count = 0;
+	for( size_t pos = str.find( substr ); pos != std::string::npos; pos = str.find( substr, pos + 1 ) )
+		++count;
+	return count;
+}
+
+TEST_F( DLTrace, chrome_trace )
+{
+	std::string json;
+	dl_trace_chrome_t trace;
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT( p );
+	EXPECT_DL_ERR_OK( dl_trace_chrome_start( &trace, dl_test_trace_write_string, &json, &p ) );
+
+	dl_ctx_t ctx;
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, DL_TRACE_TEST_LIB1, sizeof( DL_TRACE_TEST_LIB1 ) ) );
+
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	unsigned char packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_instance_store( ctx, Pods::TYPE_ID, &pods, packed, sizeof( packed ), &packed_size ) );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+	EXPECT_DL_ERR_OK( dl_trace_chrome_finish( &trace ) );
+
+	EXPECT_EQ( '[', json[0] );
+	EXPECT_EQ( "\n]\n", json.substr( json.size() - 3 ) );
+	EXPECT_EQ( 2u, dl_test_trace_count( json, "\"ph\":\"B\"" ) );
+	EXPECT_EQ( 2u, dl_test_trace_count( json, "\"ph\":\"E\"" ) );
+	EXPECT_EQ( 3u, dl_test_trace_count( json, "},\n{" ) );
+	EXPECT_EQ( 2u, dl_test_trace_count( json, "\"name\":\"dl_instance_store\"" ) );
+	EXPECT_EQ( 2u, dl_test_trace_count( json, "\"type\":\"Pods\"" ) );
+
+	char bytes_out[64];
+	snprintf( bytes_out, sizeof( bytes_out ), "\"bytes_out\":%u}}", (unsigned int)packed_size );
+	EXPECT_EQ( 1u, dl_test_trace_count( json, bytes_out ) );
+}
+
+TEST_F( DLTrace, chrome_trace_stops_writing_on_error )
+{
+	int writes = 0;
+	dl_trace_chrome_t trace;
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT( p );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_WRITE_FAILED, dl_trace_chrome_start( &trace, dl_test_trace_write_fail, &writes, &p ) );
+
+	dl_ctx_t ctx;
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, DL_TRACE_TEST_LIB1, sizeof( DL_TRACE_TEST_LIB1 ) ) );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_WRITE_FAILED, dl_trace_chrome_finish( &trace ) );
+	EXPECT_EQ( 1, writes );
+}
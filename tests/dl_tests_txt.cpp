@@ -7,6 +7,9 @@
 
 #include "dl_test_common.h"
 
+#include <string>
+#include <vector>
+
 // TODO: add test for default values for uint*[] with true/false.
 
 #define STRINGIFY( ... ) #__VA_ARGS__
@@ -643,3 +646,361 @@ TEST_F( DLText, multi_line_comments )
 	unsigned char out_text_data[1024];
 	EXPECT_DL_ERR_EQ( DL_ERROR_OK, dl_txt_pack( Ctx, test_text, out_text_data, DL_ARRAY_LENGTH(out_text_data), 0x0 ) );
 }
+
+TEST_F( DLText, more_than_256_subdata )
+{
+	// capturing bug where only 256 pointers and subdata-instances could be used in a text-instance.
+	std::string text = "{ \"ptr_array\" : { \"arr\" : [";
+	for( unsigned int i = 0; i < 1000; ++i )
+	{
+		char ptr[32];
+		snprintf( ptr, sizeof(ptr), "%s\"p%u\"", i == 0 ? "" : ", ", i % 500 );
+		text += ptr;
+	}
+	text += "], \"__subdata\" : {";
+	for( unsigned int i = 0; i < 500; ++i )
+	{
+		char sub[128];
+		snprintf( sub, sizeof(sub), "%s\"p%u\" : { \"Int1\" : %u, \"Int2\" : %u }", i == 0 ? "" : ", ", i, i, i * 2 );
+		text += sub;
+	}
+	text += "} } }";
+
+	size_t packed_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_pack_calc_size( Ctx, text.c_str(), &packed_size ) );
+	std::vector<unsigned char> packed( packed_size );
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, text.c_str(), &packed[0], packed_size, 0x0 ) );
+
+	// ... unpack and pack again, should give the same result ...
+	size_t text_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack_calc_size( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, &text_size ) );
+	std::vector<char> unpacked( text_size );
+	EXPECT_DL_ERR_OK( dl_txt_unpack( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, &unpacked[0], text_size, 0x0 ) );
+
+	size_t repacked_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_pack_calc_size( Ctx, &unpacked[0], &repacked_size ) );
+	EXPECT_EQ( packed_size, repacked_size );
+	std::vector<unsigned char> repacked( repacked_size );
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, &unpacked[0], &repacked[0], repacked_size, 0x0 ) );
+
+	ptr_array* loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, ptr_array::TYPE_ID, &repacked[0], repacked_size, (void**)(void*)&loaded, 0x0 ) );
+
+	EXPECT_EQ( 1000u, loaded->arr.count );
+	for( uint32_t i = 0; i < loaded->arr.count; ++i )
+	{
+		EXPECT_EQ( i % 500,         loaded->arr[i]->Int1 );
+		EXPECT_EQ( ( i % 500 ) * 2, loaded->arr[i]->Int2 );
+		EXPECT_EQ( loaded->arr[i % 500], loaded->arr[i] );
+	}
+}
+
+TEST_F( DLText, float_parsing_correctly_rounded )
+{
+	const char* values[] = {
+		"0", "-0", "1", "-1.5", ".5", "1e10", "1E-10", "0.1", "0.3", "3.14159265358979323846",
+		"1e23", "9007199254740993", "16777217", "33554435.000001",
+		"2.2250738585072011e-308", "4.9e-324", "1.7976931348623157e308", "1e-400", "1e400",
+		"3.4028235e38", "3.4028236e38", "1.17549435e-38", "1.4e-45", "7.006492321624086e-46",
+		"123456789012345678901234567890", "0.000000000000000000000000000000001234",
+
+		// ... halfway between two floats with more than 19 digits, needs exact decimal arithmetic ...
+		"1.00000000000000011102230246251565404236316680908203125", "1.00000000000000011102230246251565404236316680908203126",
+		"2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886e-324",
+		"179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497792",
+		"3.40282356779733661637539395458142568448e38", "16777217.0000000000000000000001",
+
+		"inf", "-inf", "INF", "Infinity", "nan", "-nan",
+		"0x1.8p3", "-0X1P+4", "0x.8", "0x1p-1074", "0x1.fffffffffffff8p1023", "0x1.00000000000008p0", "0x1.00000000000018p0"
+	};
+
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( values ) + 1; ++i )
+	{
+		// ... last value has more digits than are stored exactly, the trailing 1 still needs to round it up ...
+		std::string value = i < DL_ARRAY_LENGTH( values )
+						  ? std::string( values[i] )
+						  : std::string( "1.00000000000000011102230246251565404236316680908203125" ).append( 1000, '0' ).append( "1" );
+
+		std::string text = "{ \"PodsDefaults\" : { \"f32\" : " + value + ", \"f64\" : " + value + " } }";
+
+		unsigned char packed[1024];
+		EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, text.c_str(), packed, sizeof(packed), 0x0 ) );
+
+		PodsDefaults loaded;
+		EXPECT_DL_ERR_OK( dl_instance_load( Ctx, PodsDefaults::TYPE_ID, &loaded, sizeof(loaded), packed, sizeof(packed), 0x0 ) );
+
+		float  expect_f32 = strtof( value.c_str(), 0x0 );
+		double expect_f64 = strtod( value.c_str(), 0x0 );
+		EXPECT_EQ( 0, memcmp( &expect_f32, &loaded.f32, sizeof(float) ) )  << value;
+		EXPECT_EQ( 0, memcmp( &expect_f64, &loaded.f64, sizeof(double) ) ) << value;
+	}
+}
+
+TEST_F( DLText, float_parsing_nan_payload )
+{
+	// ... "nan(...)" is consumed as a whole but the payload is ignored ...
+	const char* text = "{ \"PodsDefaults\" : { \"f32\" : nan(123), \"f64\" : -NaN(abc_1) } }";
+
+	unsigned char packed[1024];
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, text, packed, sizeof(packed), 0x0 ) );
+
+	PodsDefaults loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load( Ctx, PodsDefaults::TYPE_ID, &loaded, sizeof(loaded), packed, sizeof(packed), 0x0 ) );
+
+	uint32_t bits32;
+	uint64_t bits64;
+	memcpy( &bits32, &loaded.f32, sizeof(bits32) );
+	memcpy( &bits64, &loaded.f64, sizeof(bits64) );
+	EXPECT_EQ( 0x7FC00000u, bits32 );
+	EXPECT_EQ( 0xFFF8000000000000ULL, bits64 );
+}
+
+static void dl_txt_test_unpack_pods( dl_ctx_t ctx, const Pods* pods, char* text, size_t text_size )
+{
+	unsigned char packed[1024];
+	EXPECT_DL_ERR_OK( dl_instance_store( ctx, Pods::TYPE_ID, pods, packed, sizeof(packed), 0x0 ) );
+	EXPECT_DL_ERR_OK( dl_txt_unpack( ctx, Pods::TYPE_ID, packed, sizeof(packed), text, text_size, 0x0 ) );
+}
+
+TEST_F( DLText, unpack_number_formatting )
+{
+	Pods pods = { INT8_MIN, INT16_MIN, INT32_MIN, INT64_MIN, UINT8_MAX, UINT16_MAX, UINT32_MAX, UINT64_MAX, 3.14159265358979323846f, 3.14159265358979323846 };
+
+	char text[2048];
+	dl_txt_test_unpack_pods( Ctx, &pods, text, sizeof(text) );
+
+	EXPECT_NE( (char*)0x0, strstr( text, "\"i8\" : -128" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"i16\" : -32768" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"i32\" : -2147483648" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"i64\" : -9223372036854775808" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"u8\" : 255" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"u16\" : 65535" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"u32\" : 4294967295" ) );
+	EXPECT_NE( (char*)0x0, strstr( text, "\"u64\" : 18446744073709551615" ) );
+
+	// ... floats are written with as many digits as needed to round-trip ...
+	EXPECT_NE( (char*)0x0, strstr( text, "\"f32\" : 3.1415927" ) ) << text;
+	EXPECT_NE( (char*)0x0, strstr( text, "\"f64\" : 3.141592653589793" ) ) << text;
+}
+
+TEST_F( DLText, unpack_float_round_trip )
+{
+	// ... values that round-trip with "%g" should be written exactly as "%g" would ...
+	const double values[] = { 0.0, -0.0, 1.0, -1.5, 0.1, 0.3, 100000, 1e6, 123456, 0.0001, 0.00001, 1e-10, 1e23, 1e300,
+							  1234567, 0.1234567, 16777216, 9007199254740993.0, 1.17549435e-38, 1.4e-45, 4.9e-324,
+							  2.2250738585072014e-308, 1.7976931348623157e308, 3.4028234663852886e38, 5.960464477539063e-08 };
+
+	uint32_t seed = 1337;
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( values ) + 1000; ++i )
+	{
+		Pods pods;
+		memset( &pods, 0, sizeof(pods) );
+		if( i < DL_ARRAY_LENGTH( values ) )
+		{
+			pods.f32 = (float)values[i];
+			pods.f64 = values[i];
+		}
+		else
+		{
+			// ... random bit-patterns, skipping nan and inf ...
+			uint64_t bits = 0;
+			for( int b = 0; b < 4; ++b )
+			{
+				seed = seed * 1664525u + 1013904223u;
+				bits = ( bits << 16 ) | ( seed >> 16 );
+			}
+			uint32_t bits32 = (uint32_t)bits;
+			if( ( bits32 & 0x7F800000 ) == 0x7F800000 )
+				bits32 &= 0xBFFFFFFF;
+			if( ( bits & 0x7FF0000000000000ULL ) == 0x7FF0000000000000ULL )
+				bits &= 0xBFFFFFFFFFFFFFFFULL;
+			memcpy( &pods.f32, &bits32, sizeof(float) );
+			memcpy( &pods.f64, &bits, sizeof(double) );
+		}
+
+		char text[2048];
+		dl_txt_test_unpack_pods( Ctx, &pods, text, sizeof(text) );
+
+		char g32[64], g64[64];
+		snprintf( g32, sizeof(g32), "\"f32\" : %g,", (double)pods.f32 );
+		snprintf( g64, sizeof(g64), "\"f64\" : %g\n", pods.f64 );
+		if( strtof( strchr( g32, ':' ) + 1, 0x0 ) == pods.f32 )
+		{
+			EXPECT_NE( (char*)0x0, strstr( text, g32 ) ) << text;
+		}
+		if( strtod( strchr( g64, ':' ) + 1, 0x0 ) == pods.f64 )
+		{
+			EXPECT_NE( (char*)0x0, strstr( text, g64 ) ) << text;
+		}
+
+		unsigned char packed[1024];
+		EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, text, packed, sizeof(packed), 0x0 ) );
+
+		Pods loaded;
+		EXPECT_DL_ERR_OK( dl_instance_load( Ctx, Pods::TYPE_ID, &loaded, sizeof(loaded), packed, sizeof(packed), 0x0 ) );
+		EXPECT_EQ( 0, memcmp( &pods.f32, &loaded.f32, sizeof(float) ) )  << text;
+		EXPECT_EQ( 0, memcmp( &pods.f64, &loaded.f64, sizeof(double) ) ) << text;
+	}
+}
+
+TEST_F( DLText, array_length_with_comments_and_escapes )
+{
+	// ... long enough arrays to span multiple blocks of the structural index, with structural chars in comments and strings ...
+	std::string u32_text = "{ \"PodArray1\" : { \"u32_arr\" : [";
+	std::string str_text = "{ \"StringArray\" : { \"Strings\" : [";
+	std::string struct_text = "{ \"StructArray1\" : { \"Array\" : [";
+	for( unsigned int i = 0; i < 100; ++i )
+	{
+		char elem[256];
+		const char* sep = i == 0 ? "" : ",";
+		snprintf( elem, sizeof(elem), "%s /* %u, ] } */ %u // , ]\n", sep, i, i );
+		u32_text += elem;
+		snprintf( elem, sizeof(elem), "%s \"s%u, \\\"{]\\\\\" // \"\n", sep, i );
+		str_text += elem;
+		snprintf( elem, sizeof(elem), "%s { \"Int1\" : %u, /* } , { */ \"Int2\" : %u }", sep, i, i * 2 );
+		struct_text += elem;
+	}
+	u32_text += "] } }";
+	str_text += "] } }";
+	struct_text += "] } }";
+
+	unsigned char packed[16 * 1024];
+
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, u32_text.c_str(), packed, sizeof(packed), 0x0 ) );
+	PodArray1* u32_loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, PodArray1::TYPE_ID, packed, sizeof(packed), (void**)(void*)&u32_loaded, 0x0 ) );
+	EXPECT_EQ( 100u, u32_loaded->u32_arr.count );
+	for( uint32_t i = 0; i < u32_loaded->u32_arr.count; ++i )
+		EXPECT_EQ( i, u32_loaded->u32_arr[i] );
+
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, str_text.c_str(), packed, sizeof(packed), 0x0 ) );
+	StringArray* str_loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, StringArray::TYPE_ID, packed, sizeof(packed), (void**)(void*)&str_loaded, 0x0 ) );
+	EXPECT_EQ( 100u, str_loaded->Strings.count );
+	for( uint32_t i = 0; i < str_loaded->Strings.count; ++i )
+	{
+		char expect[64];
+		snprintf( expect, sizeof(expect), "s%u, \"{]\\", i );
+		EXPECT_STREQ( expect, str_loaded->Strings[i] );
+	}
+
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, struct_text.c_str(), packed, sizeof(packed), 0x0 ) );
+	StructArray1* struct_loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load_inplace( Ctx, StructArray1::TYPE_ID, packed, sizeof(packed), (void**)(void*)&struct_loaded, 0x0 ) );
+	EXPECT_EQ( 100u, struct_loaded->Array.count );
+	for( uint32_t i = 0; i < struct_loaded->Array.count; ++i )
+	{
+		EXPECT_EQ( i,     struct_loaded->Array[i].Int1 );
+		EXPECT_EQ( i * 2, struct_loaded->Array[i].Int2 );
+	}
+}
+
+struct dl_txt_test_grow_ctx
+{
+	unsigned int calls;
+	unsigned int fail_after;
+	size_t       allocated;
+};
+
+static void* dl_txt_test_grow( void* ptr, size_t size, size_t old_size, void* grow_ctx )
+{
+	dl_txt_test_grow_ctx* ctx = (dl_txt_test_grow_ctx*)grow_ctx;
+	if( size == 0 )
+	{
+		ctx->allocated -= old_size;
+		free( ptr );
+		return 0x0;
+	}
+	if( ctx->calls++ == ctx->fail_after )
+		return 0x0;
+	ctx->allocated += size - old_size;
+	return realloc( ptr, size );
+}
+
+TEST_F( DLText, pack_and_unpack_alloc )
+{
+	// ... enough data to grow the buffer many times and subdata that is patched while the buffer grows ...
+	std::string text = "{ \"ptr_array\" : { \"arr\" : [";
+	for( unsigned int i = 0; i < 1000; ++i )
+	{
+		char ptr[32];
+		snprintf( ptr, sizeof(ptr), "%s\"p%u\"", i == 0 ? "" : ", ", i % 500 );
+		text += ptr;
+	}
+	text += "], \"__subdata\" : {";
+	for( unsigned int i = 0; i < 500; ++i )
+	{
+		char sub[128];
+		snprintf( sub, sizeof(sub), "%s\"p%u\" : { \"Int1\" : %u, \"Int2\" : %u }", i == 0 ? "" : ", ", i, i, i * 2 );
+		text += sub;
+	}
+	text += "} } }";
+
+	size_t packed_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_pack_calc_size( Ctx, text.c_str(), &packed_size ) );
+	std::vector<unsigned char> packed( packed_size );
+	EXPECT_DL_ERR_OK( dl_txt_pack( Ctx, text.c_str(), &packed[0], packed_size, 0x0 ) );
+
+	// ... single pass should produce exactly the same result, both with the context allocator and a grow callback ...
+	unsigned char* packed_alloc = 0x0;
+	size_t packed_alloc_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_pack_alloc( Ctx, text.c_str(), 0x0, 0x0, &packed_alloc, &packed_alloc_size ) );
+	EXPECT_EQ( packed_size, packed_alloc_size );
+	EXPECT_EQ( 0, memcmp( &packed[0], packed_alloc, packed_size ) );
+	free( packed_alloc );
+
+	dl_txt_test_grow_ctx grow_ctx = { 0, UINT32_MAX, 0 };
+	EXPECT_DL_ERR_OK( dl_txt_pack_alloc( Ctx, text.c_str(), dl_txt_test_grow, &grow_ctx, &packed_alloc, &packed_alloc_size ) );
+	EXPECT_EQ( packed_size, packed_alloc_size );
+	EXPECT_EQ( 0, memcmp( &packed[0], packed_alloc, packed_size ) );
+	EXPECT_GT( grow_ctx.calls, 1u );
+	free( packed_alloc );
+
+	size_t text_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack_calc_size( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, &text_size ) );
+	std::vector<char> unpacked( text_size );
+	EXPECT_DL_ERR_OK( dl_txt_unpack( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, &unpacked[0], text_size, 0x0 ) );
+
+	char* unpacked_alloc = 0x0;
+	size_t unpacked_alloc_size = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack_alloc( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, 0x0, 0x0, &unpacked_alloc, &unpacked_alloc_size ) );
+	EXPECT_EQ( text_size, unpacked_alloc_size );
+	EXPECT_STREQ( &unpacked[0], unpacked_alloc );
+	free( unpacked_alloc );
+
+	grow_ctx.calls = 0;
+	EXPECT_DL_ERR_OK( dl_txt_unpack_alloc( Ctx, ptr_array::TYPE_ID, &packed[0], packed_size, dl_txt_test_grow, &grow_ctx, &unpacked_alloc, &unpacked_alloc_size ) );
+	EXPECT_EQ( text_size, unpacked_alloc_size );
+	EXPECT_STREQ( &unpacked[0], unpacked_alloc );
+	EXPECT_GT( grow_ctx.calls, 1u );
+	free( unpacked_alloc );
+}
+
+TEST_F( DLText, pack_and_unpack_alloc_grow_fail )
+{
+	std::string text = "{ \"StringArray\" : { \"Strings\" : [";
+	for( unsigned int i = 0; i < 1000; ++i )
+		text += i == 0 ? "\"a string long enough to make the buffer grow\"" : ", \"a string long enough to make the buffer grow\"";
+	text += "] } }";
+
+	unsigned char* packed = 0x0;
+	size_t packed_size = 0;
+	for( unsigned int fail_after = 0; fail_after < 3; ++fail_after )
+	{
+		dl_txt_test_grow_ctx grow_ctx = { 0, fail_after, 0 };
+		EXPECT_DL_ERR_EQ( DL_ERROR_OUT_OF_INSTANCE_MEMORY, dl_txt_pack_alloc( Ctx, text.c_str(), dl_txt_test_grow, &grow_ctx, &packed, &packed_size ) );
+		EXPECT_EQ( (unsigned char*)0x0, packed );
+		EXPECT_EQ( 0u, grow_ctx.allocated );
+	}
+
+	EXPECT_DL_ERR_OK( dl_txt_pack_alloc( Ctx, text.c_str(), 0x0, 0x0, &packed, &packed_size ) );
+	for( unsigned int fail_after = 0; fail_after < 3; ++fail_after )
+	{
+		dl_txt_test_grow_ctx grow_ctx = { 0, fail_after, 0 };
+		char* unpacked = 0x0;
+		EXPECT_DL_ERR_EQ( DL_ERROR_OUT_OF_INSTANCE_MEMORY, dl_txt_unpack_alloc( Ctx, StringArray::TYPE_ID, packed, packed_size, dl_txt_test_grow, &grow_ctx, &unpacked, 0x0 ) );
+		EXPECT_EQ( (char*)0x0, unpacked );
+		EXPECT_EQ( 0u, grow_ctx.allocated );
+	}
+	free( packed );
+}
@@ -317,3 +317,278 @@ TEST_F( DLTypeLib, enum_in_2_tlds )
 	free(tl1);
 	free(tl2);
 }
+
+TEST_F( DLTypeLib, find_types_from_many_tlds )
+{
+	// load a few typelibs with enough types to force the type-lookup in the ctx to grow several times.
+	const unsigned int TL_COUNT = 4;
+	const unsigned int TYPES_PER_TL = 100;
+
+	for( unsigned int tl = 0; tl < TL_COUNT; ++tl )
+	{
+		char typelib[TYPES_PER_TL * 128];
+		int pos = snprintf( typelib, sizeof(typelib), "{ \"module\" : \"tl%u\", \"types\" : {", tl );
+		for( unsigned int type = 0; type < TYPES_PER_TL; ++type )
+			pos += snprintf( typelib + pos, sizeof(typelib) - (size_t)pos, "%s\"tl%u_type%u\" : { \"members\" : [ { \"name\" : \"m\", \"type\" : \"uint32\" } ] }", type == 0 ? "" : ",", tl, type );
+		pos += snprintf( typelib + pos, sizeof(typelib) - (size_t)pos, "} }" );
+
+		// ... load every other typelib as binary to test both paths ...
+		if( tl % 2 == 0 )
+		{
+			EXPECT_DL_ERR_OK( dl_context_load_txt_type_library( ctx, typelib, (size_t)pos ) );
+		}
+		else
+		{
+			size_t tl_size;
+			uint8_t* tl_bin = test_pack_txt_type_lib( typelib, (size_t)pos, &tl_size );
+			EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, tl_bin, tl_size ) );
+			free( tl_bin );
+		}
+	}
+
+	for( unsigned int tl = 0; tl < TL_COUNT; ++tl )
+		for( unsigned int type = 0; type < TYPES_PER_TL; ++type )
+		{
+			char type_name[64];
+			snprintf( type_name, sizeof(type_name), "tl%u_type%u", tl, type );
+
+			dl_typeid_t tid;
+			EXPECT_DL_ERR_OK( dl_reflect_get_type_id( ctx, type_name, &tid ) );
+
+			dl_type_info_t info;
+			EXPECT_DL_ERR_OK( dl_reflect_get_type_info( ctx, tid, &info ) );
+			EXPECT_STREQ( type_name, info.name );
+		}
+
+	dl_type_info_t info;
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_NOT_FOUND, dl_reflect_get_type_info( ctx, 0x12345678, &info ) );
+}
+
+TEST_F( DLTypeLib, enum_aliases_in_2_tlds )
+{
+	// enums with aliases in the first tld would offset alias- and value-indices of enums in the second one.
+	const char typelib1[] = STRINGIFY({ "module" : "tl1", "enums" : { "e1" : { "e1_v1" : { "value" : 1, "aliases" : [ "e1_a1", "e1_a2" ] }, "e1_v2" : 2 } }, "types" : { "tl1_type" : { "members" : [ { "name" : "m1", "type" : "e1" } ] } } });
+	const char typelib2[] = STRINGIFY({ "module" : "tl2", "enums" : { "e2" : { "e2_v1" : 3, "e2_v2" : { "value" : 4, "aliases" : [ "e2_a1" ] } } }, "types" : { "tl2_type" : { "members" : [ { "name" : "m2", "type" : "e2" } ] } } });
+
+	size_t tl1_size;
+	size_t tl2_size;
+	uint8_t* tl1 = test_pack_txt_type_lib( typelib1, sizeof(typelib1)-1, &tl1_size );
+	uint8_t* tl2 = test_pack_txt_type_lib( typelib2, sizeof(typelib2)-1, &tl2_size );
+
+	EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, tl1, tl1_size ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library( ctx, tl2, tl2_size ) );
+
+	uint8_t outbuf[256];
+	size_t packed_size;
+	const char test1[] = STRINGIFY( { "tl2_type" : { "m2" : "e2_a1" } } );
+	EXPECT_DL_ERR_OK( dl_txt_pack( ctx, test1, outbuf, sizeof(outbuf), &packed_size ) );
+
+	// ... unpack should give back the main name of the value ...
+	char txt_out[256];
+	dl_typeid_t tid;
+	EXPECT_DL_ERR_OK( dl_reflect_get_type_id( ctx, "tl2_type", &tid ) );
+	EXPECT_DL_ERR_OK( dl_txt_unpack( ctx, tid, outbuf, packed_size, txt_out, sizeof(txt_out), 0x0 ) );
+	EXPECT_NE( (const char*)0x0, strstr( txt_out, "e2_v2" ) );
+
+	// ... only full names should match ...
+	const char test2[] = STRINGIFY( { "tl1_type" : { "m1" : "e1_v" } } );
+	EXPECT_DL_ERR_EQ( DL_ERROR_TXT_INVALID_ENUM_VALUE, dl_txt_pack( ctx, test2, outbuf, sizeof(outbuf), 0x0 ) );
+
+	// ... and not match aliases in other enums ...
+	const char test3[] = STRINGIFY( { "tl1_type" : { "m1" : "e2_a1" } } );
+	EXPECT_DL_ERR_EQ( DL_ERROR_TXT_INVALID_ENUM_VALUE, dl_txt_pack( ctx, test3, outbuf, sizeof(outbuf), 0x0 ) );
+
+	free(tl1);
+	free(tl2);
+}
+
+static const char borrowed_typelib[] = STRINGIFY({
+	"module" : "borrowed",
+	"enums" : { "b_enum" : { "b_v1" : 1, "b_v2" : { "value" : 2, "aliases" : [ "b_a2" ] } } },
+	"types" : {
+		"b_node" : { "members" : [
+			{ "name" : "e",    "type" : "b_enum" },
+			{ "name" : "next", "type" : "b_node*" },
+			{ "name" : "def",  "type" : "uint32", "default" : 7 }
+		] }
+	}
+});
+
+/**
+ * Layout of b_node in borrowed_typelib, at namespace-scope since it is used as a template argument.
+ */
+struct b_node { uint32_t e; b_node* next; uint32_t def; };
+
+/**
+ * Pack and load an instance of b_node from borrowed_typelib in ctx.
+ */
+static void test_borrowed_typelib_in_use( dl_ctx_t ctx )
+{
+	dl_typeid_t tid;
+	EXPECT_DL_ERR_OK( dl_reflect_get_type_id( ctx, "b_node", &tid ) );
+
+	const char txt[] = STRINGIFY( { "b_node" : { "e" : "b_a2", "next" : "n1", "__subdata" : { "n1" : { "e" : "b_v1", "next" : null, "def" : 8 } } } } );
+	uint8_t packed[256];
+	size_t packed_size;
+	EXPECT_DL_ERR_OK( dl_txt_pack( ctx, txt, packed, sizeof(packed), &packed_size ) );
+
+	union { uint8_t buffer[256]; b_node node; } loaded;
+	EXPECT_DL_ERR_OK( dl_instance_load( ctx, tid, loaded.buffer, sizeof(loaded.buffer), packed, packed_size, 0x0 ) );
+	EXPECT_EQ( 2u, loaded.node.e );
+	EXPECT_EQ( 7u, loaded.node.def );
+	ASSERT_NE( (b_node*)0x0, loaded.node.next );
+	EXPECT_EQ( 1u, loaded.node.next->e );
+	EXPECT_EQ( 8u, loaded.node.next->def );
+	EXPECT_EQ( (b_node*)0x0, loaded.node.next->next );
+
+	char txt_out[512];
+	EXPECT_DL_ERR_OK( dl_txt_unpack( ctx, tid, packed, packed_size, txt_out, sizeof(txt_out), 0x0 ) );
+	EXPECT_NE( (const char*)0x0, strstr( txt_out, "b_v2" ) );
+}
+
+TEST_F( DLTypeLib, load_borrowed )
+{
+	size_t tl_size;
+	uint8_t* tl = test_pack_txt_type_lib( borrowed_typelib, sizeof(borrowed_typelib)-1, &tl_size );
+
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, tl, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+
+	// ... writing the borrowed typelib should give back the same data ...
+	size_t written_size;
+	EXPECT_DL_ERR_OK( dl_context_write_type_library( ctx, 0x0, 0, &written_size ) );
+	EXPECT_EQ( tl_size, written_size );
+	uint8_t* written = (uint8_t*)malloc( written_size );
+	EXPECT_DL_ERR_OK( dl_context_write_type_library( ctx, written, written_size, 0x0 ) );
+	EXPECT_EQ( 0, memcmp( tl, written, tl_size ) );
+	free( written );
+
+	// ... only into an empty context ...
+	EXPECT_DL_ERR_EQ( DL_ERROR_INVALID_PARAMETER, dl_context_load_type_library_borrowed( ctx, tl, tl_size ) );
+
+	// ... loading more types should copy the borrowed typelib, after that it is not referenced anymore ...
+	const char typelib2[] = STRINGIFY({ "module" : "tl2", "types" : { "tl2_type" : { "members" : [ { "name" : "m", "type" : "b_node" } ] } } });
+	EXPECT_DL_ERR_OK( dl_context_load_txt_type_library( ctx, typelib2, sizeof(typelib2)-1 ) );
+	memset( tl, 0xFF, tl_size );
+	free( tl );
+
+	test_borrowed_typelib_in_use( ctx );
+	dl_typeid_t tid;
+	EXPECT_DL_ERR_OK( dl_reflect_get_type_id( ctx, "tl2_type", &tid ) );
+}
+
+/**
+ * Find the start of the lookup-section in a packed type-library, identified by its id 'DLL2'.
+ */
+static size_t test_find_typelib_lookup( const uint8_t* tl, size_t tl_size )
+{
+	const uint32_t lookup_id = ('D'<< 24) | ('L' << 16) | ('L' << 8) | '2';
+	size_t lookup_start = tl_size;
+	for( size_t pos = 0; pos + sizeof(uint32_t) <= tl_size; pos += sizeof(uint32_t) )
+		if( memcmp( tl + pos, &lookup_id, sizeof(uint32_t) ) == 0 )
+			lookup_start = pos;
+	EXPECT_LT( lookup_start, tl_size );
+	return lookup_start;
+}
+
+TEST_F( DLTypeLib, load_borrowed_without_lookup )
+{
+	size_t tl_size;
+	uint8_t* tl = test_pack_txt_type_lib( borrowed_typelib, sizeof(borrowed_typelib)-1, &tl_size );
+
+	// ... cut the typelib before the lookup-section, the lookup-tables then has to be built ...
+	size_t lookup_start = test_find_typelib_lookup( tl, tl_size );
+
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, tl, lookup_start ) );
+	test_borrowed_typelib_in_use( ctx );
+
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+	free( tl );
+
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT(p);
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+}
+
+TEST_F( DLTypeLib, load_borrowed_ignores_invalid_lookup )
+{
+	// the lookup-section is laid out as
+	//   header:         id, ptr_size, endian, pad[2], patch_op_count, map_capacity[6], map_count[6]
+	//   type-caches:    largest_member_size[2], patch_op_start, patch_op_count for the only type, b_node
+	//   patch-ops:      op, offset, count, type_index for b_node::next
+	const size_t header_size = sizeof(uint32_t) * 15;
+	const size_t op_start    = header_size + sizeof(uint32_t) * 4;
+
+	size_t tl_size;
+	uint8_t* tl = test_pack_txt_type_lib( borrowed_typelib, sizeof(borrowed_typelib)-1, &tl_size );
+	size_t lookup = test_find_typelib_lookup( tl, tl_size );
+	uint8_t* copy = (uint8_t*)malloc( tl_size );
+
+	// ... written by a platform with another ptr-size, patch-ops would point to b_node::e if used ...
+	memcpy( copy, tl, tl_size );
+	copy[lookup + 4] = (uint8_t)( sizeof(void*) == 8 ? 4 : 8 );
+	memset( copy + lookup + op_start + sizeof(uint32_t), 0, sizeof(uint32_t) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, copy, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+
+	dl_create_params_t p;
+	DL_CREATE_PARAMS_SET_DEFAULT(p);
+
+	// ... written by a platform with another endian ...
+	memcpy( copy, tl, tl_size );
+	copy[lookup + 5] = (uint8_t)( DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE );
+	memset( copy + lookup + op_start + sizeof(uint32_t), 0, sizeof(uint32_t) );
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, copy, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+
+	// ... patch-op referencing a type out of range ...
+	memcpy( copy, tl, tl_size );
+	memset( copy + lookup + op_start + sizeof(uint32_t) * 3, 0x7F, sizeof(uint32_t) );
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, copy, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+
+	// ... patch-op outside of the type ...
+	memcpy( copy, tl, tl_size );
+	memset( copy + lookup + op_start + sizeof(uint32_t), 0x7F, sizeof(uint32_t) );
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, copy, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+	EXPECT_DL_ERR_OK( dl_context_destroy( ctx ) );
+
+	// ... map-values out of range, the maps are last in the section ...
+	memcpy( copy, tl, tl_size );
+	for( size_t pos = lookup + op_start + sizeof(uint32_t) * 4; pos + sizeof(uint32_t) * 2 <= tl_size; pos += sizeof(uint32_t) * 2 )
+	{
+		uint32_t value;
+		memcpy( &value, copy + pos + sizeof(uint32_t), sizeof(uint32_t) );
+		if( value != 0xFFFFFFFF )
+			memset( copy + pos + sizeof(uint32_t), 0x7F, sizeof(uint32_t) );
+	}
+	EXPECT_DL_ERR_OK( dl_context_create( &ctx, &p ) );
+	EXPECT_DL_ERR_OK( dl_context_load_type_library_borrowed( ctx, copy, tl_size ) );
+	test_borrowed_typelib_in_use( ctx );
+
+	free( copy );
+	free( tl );
+}
+
+TEST_F( DLTypeLib, load_borrowed_errors )
+{
+	size_t tl_size;
+	uint8_t* tl = test_pack_txt_type_lib( borrowed_typelib, sizeof(borrowed_typelib)-1, &tl_size );
+	uint8_t* unaligned = (uint8_t*)malloc( tl_size + 1 );
+	memcpy( unaligned + 1, tl, tl_size );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_BAD_ALIGNMENT,   dl_context_load_type_library_borrowed( ctx, unaligned + 1, tl_size ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA,  dl_context_load_type_library_borrowed( ctx, tl, 40 ) );
+	tl[0] = (uint8_t)~tl[0];
+	EXPECT_DL_ERR_EQ( DL_ERROR_MALFORMED_DATA,  dl_context_load_type_library_borrowed( ctx, tl, tl_size ) );
+
+	free( unaligned );
+	free( tl );
+}
@@ -4,6 +4,7 @@
 
 #include <dl/dl.h>
 #include <dl/dl_util.h>
+#include <dl/dl_typelib.h>
 
 #include "dl_test_common.h"
 
@@ -213,4 +214,180 @@ TEST_F( DLUtil, dl_util_load_non_existing_file )
 					  dl_util_load_from_file( Ctx, 0, "whobb whobb whoob", DL_UTIL_FILE_TYPE_AUTO, 0, 0 ) );
 }
 
+TEST_F( DLUtil, store_to_unwritable_stream )
+{
+	// ... create the file and open it read-only so that all writes fail ...
+	FILE* f = fopen( TEMP_FILE_NAME, "wb" );
+	ASSERT_NE( (FILE*)0x0, f );
+	fclose( f );
+
+	f = fopen( TEMP_FILE_NAME, "rb" );
+	ASSERT_NE( (FILE*)0x0, f );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_WRITE_FAILED,
+					  dl_util_store_to_stream( Ctx, Pods::TYPE_ID, f, DL_UTIL_FILE_TYPE_BINARY, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_WRITE_FAILED,
+					  dl_util_store_to_stream( Ctx, Pods::TYPE_ID, f, DL_UTIL_FILE_TYPE_TEXT, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+	fclose( f );
+}
+
 // store in other endian and load!
+
+TEST_F( DLUtil, load_from_file_inplace )
+{
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+
+	Pods loaded;
+	dl_typeid_t stored_type = 0;
+	EXPECT_DL_ERR_OK( dl_util_load_from_file_inplace( Ctx, 0, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_AUTO, &loaded, sizeof(loaded), &stored_type ) );
+	EXPECT_EQ( (dl_typeid_t)Pods::TYPE_ID, stored_type );
+	check_loaded( &loaded );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_BUFFER_TO_SMALL,
+					  dl_util_load_from_file_inplace( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, &loaded, sizeof(loaded) - 1, 0x0 ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_TYPE_MISMATCH,
+					  dl_util_load_from_file_inplace( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_TEXT, &loaded, sizeof(loaded), 0x0 ) );
+}
+
+TEST_F( DLUtil, load_from_file_inplace_text_and_converted )
+{
+	// ... text need to be packed first, binary in other endian and ptr-size is converted while loading from the file ...
+	Pods loaded;
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_TEXT, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+	EXPECT_DL_ERR_OK( dl_util_load_from_file_inplace( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_AUTO, &loaded, sizeof(loaded), 0x0 ) );
+	check_loaded( &loaded );
+
+	memset( &loaded, 0x0, sizeof(loaded) );
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, other_endian, sizeof(void*) == 8 ? 4 : 8, &p ) );
+	EXPECT_DL_ERR_OK( dl_util_load_from_file_inplace( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, &loaded, sizeof(loaded), 0x0 ) );
+	check_loaded( &loaded );
+}
+
+TEST_F( DLUtil, load_converted_from_file )
+{
+	// ... both ptrs that shrink, loaded in the read buffer, and ptrs that grow, loaded into a new buffer ...
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+	size_t ptr_sizes[] = { 4, 8 };
+
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( ptr_sizes ); ++i )
+	{
+		EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, other_endian, ptr_sizes[i], &original ) );
+
+		union { SimplePtr* loaded; void* vp; } conv;
+		conv.loaded = 0x0;
+		EXPECT_DL_ERR_OK( dl_util_load_from_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, &conv.vp, 0x0 ) );
+		EXPECT_EQ( conv.loaded->Ptr1, conv.loaded->Ptr2 );
+		EXPECT_EQ( pods.i64, conv.loaded->Ptr1->i64 );
+		EXPECT_EQ( pods.f64, conv.loaded->Ptr1->f64 );
+		free( conv.loaded );
+	}
+}
+
+TEST_F( DLUtil, map_file )
+{
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, DL_ENDIAN_HOST, sizeof(void*), &original ) );
+
+	dl_util_mapped_file_t mapped = 0x0;
+	void* instance = 0x0;
+	dl_typeid_t stored_type = 0;
+	EXPECT_DL_ERR_OK( dl_util_map_file( Ctx, 0, TEMP_FILE_NAME, DL_UTIL_MAP_FLAG_POPULATE | DL_UTIL_MAP_FLAG_WILL_NEED, &mapped, &instance, &stored_type ) );
+	SimplePtr* loaded = (SimplePtr*)instance;
+	EXPECT_EQ( (dl_typeid_t)SimplePtr::TYPE_ID, stored_type );
+	EXPECT_EQ( loaded->Ptr1, loaded->Ptr2 );
+	EXPECT_EQ( pods.i64, loaded->Ptr1->i64 );
+	EXPECT_EQ( pods.f64, loaded->Ptr1->f64 );
+
+	// ... the mapping is private, the file should not be changed by patching or writing to the instance ...
+	( (Pods*)loaded->Ptr1 )->i64 = 1337;
+
+	dl_util_mapped_file_t mapped2 = 0x0;
+	void* instance2 = 0x0;
+	EXPECT_DL_ERR_OK( dl_util_map_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, 0, &mapped2, &instance2, 0x0 ) );
+	SimplePtr* loaded2 = (SimplePtr*)instance2;
+	EXPECT_EQ( pods.i64, loaded2->Ptr1->i64 );
+	EXPECT_EQ( 1337, loaded->Ptr1->i64 );
+
+	dl_util_unmap_file( mapped2 );
+	dl_util_unmap_file( mapped );
+}
+
+TEST_F( DLUtil, map_file_converted )
+{
+	// ... grows when converted to 64 bit ptrs, shrinks or stays in mapping otherwise ...
+	Pods pods = { 1, 2, 3, 4, 5, 6, 7, 8, 8.1f, 8.2 };
+	SimplePtr original = { &pods, &pods };
+	dl_endian_t other_endian = DL_ENDIAN_HOST == DL_ENDIAN_LITTLE ? DL_ENDIAN_BIG : DL_ENDIAN_LITTLE;
+
+	dl_endian_t endians[]   = { DL_ENDIAN_HOST, other_endian, other_endian };
+	size_t      ptr_sizes[] = { sizeof(void*) == 8 ? 4 : 8, sizeof(void*), sizeof(void*) == 8 ? 4 : 8 };
+
+	for( size_t i = 0; i < DL_ARRAY_LENGTH( endians ); ++i )
+	{
+		EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, endians[i], ptr_sizes[i], &original ) );
+
+		dl_util_mapped_file_t mapped = 0x0;
+		void* instance = 0x0;
+		EXPECT_DL_ERR_OK( dl_util_map_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, 0, &mapped, &instance, 0x0 ) );
+		SimplePtr* loaded = (SimplePtr*)instance;
+		if( loaded != 0x0 )
+		{
+			EXPECT_EQ( loaded->Ptr1, loaded->Ptr2 );
+			EXPECT_EQ( pods.i16, loaded->Ptr1->i16 );
+			EXPECT_EQ( pods.u64, loaded->Ptr1->u64 );
+			EXPECT_EQ( pods.f32, loaded->Ptr1->f32 );
+		}
+		dl_util_unmap_file( mapped );
+	}
+}
+
+TEST_F( DLUtil, map_file_errors )
+{
+	dl_util_mapped_file_t mapped = 0x0;
+	void* loaded = 0x0;
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_NOT_FOUND, dl_util_map_file( Ctx, 0, "whobb whobb whoob", 0, &mapped, &loaded, 0x0 ) );
+
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_TEXT, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_TYPE_MISMATCH, dl_util_map_file( Ctx, 0, TEMP_FILE_NAME, 0, &mapped, &loaded, 0x0 ) );
+
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_BINARY, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+	EXPECT_DL_ERR_EQ( DL_ERROR_TYPE_MISMATCH, dl_util_map_file( Ctx, SimplePtr::TYPE_ID, TEMP_FILE_NAME, 0, &mapped, &loaded, 0x0 ) );
+}
+
+TEST_F( DLUtil, map_type_library )
+{
+	size_t tl_size;
+	EXPECT_DL_ERR_OK( dl_context_write_type_library( Ctx, 0x0, 0, &tl_size ) );
+	unsigned char* tl = (unsigned char*)malloc( tl_size );
+	EXPECT_DL_ERR_OK( dl_context_write_type_library( Ctx, tl, tl_size, 0x0 ) );
+	// ... the typelib may not be modified while it is mapped, so it can not share file with the instance ...
+	const char* TEMP_TL_FILE_NAME = "temp_dl_typelib.bin";
+	FILE* f = fopen( TEMP_TL_FILE_NAME, "wb" );
+	EXPECT_EQ( tl_size, fwrite( tl, 1, tl_size, f ) );
+	fclose( f );
+	free( tl );
+
+	dl_ctx_t mapped_ctx;
+	dl_create_params_t params;
+	DL_CREATE_PARAMS_SET_DEFAULT( params );
+	EXPECT_DL_ERR_OK( dl_context_create( &mapped_ctx, &params ) );
+
+	dl_util_mapped_file_t mapped_tl = 0x0;
+	EXPECT_DL_ERR_OK( dl_util_map_type_library( mapped_ctx, TEMP_TL_FILE_NAME, &mapped_tl ) );
+
+	// ... store with one context, load with the one using the mapped typelib ...
+	EXPECT_DL_ERR_OK( dl_util_store_to_file( Ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_TEXT, DL_ENDIAN_HOST, sizeof(void*), &p ) );
+
+	Pods loaded;
+	EXPECT_DL_ERR_OK( dl_util_load_from_file_inplace( mapped_ctx, Pods::TYPE_ID, TEMP_FILE_NAME, DL_UTIL_FILE_TYPE_AUTO, &loaded, sizeof(loaded), 0x0 ) );
+	check_loaded( &loaded );
+
+	EXPECT_DL_ERR_OK( dl_context_destroy( mapped_ctx ) );
+	dl_util_unmap_file( mapped_tl );
+	remove( TEMP_TL_FILE_NAME );
+
+	EXPECT_DL_ERR_EQ( DL_ERROR_UTIL_FILE_NOT_FOUND, dl_util_map_type_library( Ctx, "whobb whobb whoob", &mapped_tl ) );
+}
@@ -2,6 +2,9 @@
 #include <dl/dl.h>
 #include <dl/dl_util.h>
 #include <dl/dl_reflect.h>
+#include <dl/dl_archive.h>
+#include <dl/dl_convert.h>
+#include <dl/dl_trace.h>
 
 #include "getopt/getopt.h"
 
@@ -18,11 +21,17 @@
 */
 
 int g_Verbose = 0;
+int g_Stats   = 0;
+
+const char*       g_trace_file_path = "";
+FILE*             g_trace_file      = 0x0;
+dl_trace_chrome_t g_trace;
 
 enum
 {
 	MAX_LIB_PATHS = 128,
-	MAX_LIBS      = 128
+	MAX_LIBS      = 128,
+	MAX_INPUTS    = 1024
 };
 
 unsigned int g_num_lib_paths = 0;
@@ -49,6 +58,9 @@ bool add_lib( const char* lib )
 	return true;
 }
 
+unsigned int g_num_inputs = 0;
+const char*  g_inputs[MAX_INPUTS];
+
 void error_report_function( const char* msg, void* ctx )
 {
 	(void)ctx;
@@ -58,7 +70,8 @@ void error_report_function( const char* msg, void* ctx )
 void print_help( getopt_context_t* ctx )
 {
 	char buffer[2048];
-	printf("usage: dl_pack.exe [options] file_to_pack\n\n");
+	printf("usage: dl_pack.exe [options] file_to_pack\n");
+	printf("       dl_pack.exe [options] -a file_to_pack [file_to_pack ...]\n\n");
 	printf("%s", getopt_create_help_string( ctx, buffer, sizeof(buffer) ) );
 }
 
@@ -81,12 +94,27 @@ unsigned char* read_file(FILE* file, size_t* out_size)
 	return out_buffer;
 }
 
+dl_error_t write_to_file( const void* data, size_t size, void* write_ctx )
+{
+	return fwrite( data, size, 1, (FILE*)write_ctx ) == 1 ? DL_ERROR_OK : DL_ERROR_UTIL_FILE_WRITE_FAILED;
+}
+
 dl_ctx_t create_ctx()
 {
 	dl_ctx_t dl_ctx;
 	dl_create_params_t p;
 	DL_CREATE_PARAMS_SET_DEFAULT(p);
 	p.error_msg_func = error_report_function;
+	p.stats_mode     = g_Stats ? DL_STATS_TIMING : DL_STATS_NONE;
+
+	if( g_trace_file_path[0] != '\0' )
+	{
+		g_trace_file = fopen( g_trace_file_path, "wb" );
+		if( g_trace_file == 0x0 )
+			M_ERROR_AND_FAIL( "Could not open trace file: %s", g_trace_file_path );
+		dl_trace_chrome_start( &g_trace, write_to_file, g_trace_file, &p );
+	}
+
 	dl_error_t err = dl_context_create( &dl_ctx, &p );
 	if(err != DL_ERROR_OK)
 		M_ERROR_AND_FAIL( "DL error while creating context: %s", dl_error_to_string(err) );
@@ -126,22 +154,189 @@ dl_ctx_t create_ctx()
 	return dl_ctx;
 }
 
+/*
+	Print statistics collected in dl_ctx to stderr, stdout might be the output.
+*/
+void print_stats( dl_ctx_t dl_ctx )
+{
+	dl_context_stats_t stats;
+	if( !g_Stats || dl_context_get_stats( dl_ctx, &stats ) != DL_ERROR_OK )
+		return;
+
+	static const char* op_names[DL_STATS_OP_COUNT] = { "store", "load", "convert", "txt pack", "txt unpack", "typelib load" };
+
+	fprintf( stderr, "%-14s %8s %12s %12s %12s\n", "operation", "calls", "bytes in", "bytes out", "time (us)" );
+	for( int op = 0; op < DL_STATS_OP_COUNT; ++op )
+	{
+		const dl_stats_op_counters_t* counters = &stats.ops[op];
+		fprintf( stderr, "%-14s %8llu %12llu %12llu %12.1f\n", op_names[op], counters->calls, counters->bytes_in, counters->bytes_out, (double)counters->nanoseconds / 1000.0 );
+	}
+	fprintf( stderr, "ptrs patched:   %llu\n", stats.ptrs_patched );
+	fprintf( stderr, "type lookups:   %llu\n", stats.type_lookups );
+	fprintf( stderr, "allocations:    %llu\n", stats.allocations );
+	fprintf( stderr, "peak allocated: %llu bytes\n", stats.peak_allocated_bytes );
+}
+
+/*
+	Print stats, finish the trace and destroy dl_ctx.
+*/
+void destroy_ctx( dl_ctx_t dl_ctx )
+{
+	print_stats( dl_ctx );
+	dl_context_destroy( dl_ctx );
+
+	if( g_trace_file != 0x0 )
+	{
+		dl_error_t err = dl_trace_chrome_finish( &g_trace );
+		if( err != DL_ERROR_OK )
+			fprintf( stderr, "Error: DL error while writing trace file %s: %s\n", g_trace_file_path, dl_error_to_string( err ) );
+		fclose( g_trace_file );
+	}
+}
+
+/*
+	Store instance into a buffer allocated with malloc in the requested format.
+*/
+dl_error_t pack_instance( dl_ctx_t dl_ctx, dl_typeid_t type, void* instance, dl_endian_t out_endian, unsigned int out_ptr_size, bool out_relative,
+						  unsigned char** out_packed, size_t* out_packed_size )
+{
+	size_t packed_size = 0;
+	dl_error_t err = dl_instance_calc_size( dl_ctx, type, instance, &packed_size );
+	unsigned char* packed = (unsigned char*)malloc( packed_size );
+	if( err == DL_ERROR_OK )
+		err = dl_instance_store( dl_ctx, type, instance, packed, packed_size, 0x0 );
+
+	if( err == DL_ERROR_OK && ( out_relative || out_endian != DL_ENDIAN_HOST || out_ptr_size != sizeof(void*) ) )
+	{
+		size_t converted_size = 0;
+		if( out_relative )
+			err = dl_convert_to_relative( dl_ctx, type, packed, packed_size, 0x0, 0, out_endian, out_ptr_size, &converted_size );
+		else
+			err = dl_convert( dl_ctx, type, packed, packed_size, 0x0, 0, out_endian, out_ptr_size, &converted_size );
+
+		unsigned char* converted = (unsigned char*)malloc( converted_size );
+		if( err == DL_ERROR_OK && out_relative )
+			err = dl_convert_to_relative( dl_ctx, type, packed, packed_size, converted, converted_size, out_endian, out_ptr_size, 0x0 );
+		else if( err == DL_ERROR_OK )
+			err = dl_convert( dl_ctx, type, packed, packed_size, converted, converted_size, out_endian, out_ptr_size, 0x0 );
+		free( packed );
+		packed      = converted;
+		packed_size = converted_size;
+	}
+
+	if( err != DL_ERROR_OK )
+	{
+		free( packed );
+		return err;
+	}
+
+	*out_packed      = packed;
+	*out_packed_size = packed_size;
+	return DL_ERROR_OK;
+}
+
+/*
+	Pack all input-files into one archive, each instance is stored with its path as key.
+*/
+int pack_archive( dl_ctx_t dl_ctx, FILE* out_file, dl_endian_t out_endian, unsigned int out_ptr_size, bool out_relative )
+{
+	dl_archive_writer_t writer;
+	dl_error_t err = dl_archive_writer_create( dl_ctx, &writer );
+	if( err != DL_ERROR_OK )
+		M_ERROR_AND_QUIT( "DL error creating archive: %s", dl_error_to_string( err ) );
+
+	for( unsigned int i = 0; i < g_num_inputs && err == DL_ERROR_OK; ++i )
+	{
+		M_VERBOSE_OUTPUT( "Adding %s to archive", g_inputs[i] );
+
+		dl_typeid_t type;
+		void* instance = 0x0;
+		err = dl_util_load_from_file( dl_ctx, 0, g_inputs[i], DL_UTIL_FILE_TYPE_AUTO, &instance, &type );
+		if( err != DL_ERROR_OK )
+		{
+			fprintf( stderr, "Error: DL error reading %s: %s\n", g_inputs[i], dl_error_to_string( err ) );
+			break;
+		}
+
+		size_t packed_size = 0;
+		unsigned char* packed = 0x0;
+		err = pack_instance( dl_ctx, type, instance, out_endian, out_ptr_size, out_relative, &packed, &packed_size );
+		free( instance );
+
+		if( err == DL_ERROR_OK )
+			err = dl_archive_writer_add( writer, g_inputs[i], packed, packed_size, 0 );
+		free( packed );
+
+		if( err != DL_ERROR_OK )
+			fprintf( stderr, "Error: DL error adding %s to archive: %s\n", g_inputs[i], dl_error_to_string( err ) );
+	}
+
+	if( err == DL_ERROR_OK )
+	{
+		err = dl_archive_writer_finish( writer, write_to_file, out_file, 0x0 );
+		if( err != DL_ERROR_OK )
+			fprintf( stderr, "Error: DL error writing archive: %s\n", dl_error_to_string( err ) );
+	}
+
+	dl_archive_writer_destroy( writer );
+	return err == DL_ERROR_OK ? 0 : 1;
+}
+
+/*
+	Print key, type and size of all entries in archive.
+*/
+void show_archive_info( dl_ctx_t dl_ctx, const unsigned char* archive, size_t archive_size, unsigned int entry_count )
+{
+	printf( "archive info:\n" );
+	printf( "entries:  %u\n", entry_count );
+
+	for( unsigned int i = 0; i < entry_count; ++i )
+	{
+		dl_archive_entry_t entry;
+		dl_instance_info_t info;
+		if( dl_archive_get_entry( archive, archive_size, i, &entry ) != DL_ERROR_OK ||
+			dl_instance_get_info( archive + entry.offset, entry.size, &info ) != DL_ERROR_OK )
+		{
+			printf( "  %u: <malformed>\n", i );
+			continue;
+		}
+
+		dl_type_info_t tinfo;
+		if( dl_reflect_get_type_info( dl_ctx, info.root_type, &tinfo ) != DL_ERROR_OK )
+			tinfo.name = "<unknown>";
+
+		printf( "  %s: %s (0x%8X), %u bytes, ptr size %u, %s endian\n",
+				entry.key,
+				tinfo.name,
+				info.root_type,
+				(unsigned int)entry.size,
+				info.ptrsize,
+				info.endian == DL_ENDIAN_LITTLE ? "little" : "big" );
+	}
+}
+
 int main( int argc, const char** argv )
 {
 	int show_info = 0;
 	int do_unpack = 0;
+	int do_archive = 0;
+	int do_relative = 0;
 
 	static const getopt_option_t option_list[] =
 	{
-		{ "help",    'h', GETOPT_OPTION_TYPE_NO_ARG,   0x0,        'h', "displays this help-message", 0x0 },
-		{ "libpath", 'L', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'L', "add type-library include path", "path" },
-		{ "lib",     'l', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'l', "add type-library", "path" },
-		{ "output",  'o', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'o', "output to file", "file" },
-		{ "endian",  'e', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'e', "endianness of output data, if not specified pack-platform is assumed", "little,big" },
-		{ "ptrsize", 'p', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'p', "ptr-size of output data, if not specified pack-platform is assumed", "4,8" },
-		{ "unpack",  'u', GETOPT_OPTION_TYPE_FLAG_SET, &do_unpack,   1, "force dl_pack to treat input data as a packed instance that should be unpacked.", 0x0 },
-		{ "info",    'i', GETOPT_OPTION_TYPE_FLAG_SET, &show_info,   1, "make dl_pack show info about a packed instance.", 0x0 },
-		{ "verbose", 'v', GETOPT_OPTION_TYPE_FLAG_SET, &g_Verbose,   1, "verbose output", 0x0 },
+		{ "help",     'h', GETOPT_OPTION_TYPE_NO_ARG,   0x0,        'h', "displays this help-message", 0x0 },
+		{ "libpath",  'L', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'L', "add type-library include path", "path" },
+		{ "lib",      'l', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'l', "add type-library", "path" },
+		{ "output",   'o', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'o', "output to file", "file" },
+		{ "endian",   'e', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'e', "endianness of output data, if not specified pack-platform is assumed", "little,big" },
+		{ "ptrsize",  'p', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        'p', "ptr-size of output data, if not specified pack-platform is assumed", "4,8" },
+		{ "unpack",   'u', GETOPT_OPTION_TYPE_FLAG_SET, &do_unpack,   1, "force dl_pack to treat input data as a packed instance that should be unpacked.", 0x0 },
+		{ "info",     'i', GETOPT_OPTION_TYPE_FLAG_SET, &show_info,   1, "make dl_pack show info about a packed instance or archive.", 0x0 },
+		{ "relative", 'r', GETOPT_OPTION_TYPE_FLAG_SET, &do_relative, 1, "store ptrs relative to themselves so that the output can be loaded without patching, -p sets size of refs.", 0x0 },
+		{ "archive",  'a', GETOPT_OPTION_TYPE_FLAG_SET, &do_archive,  1, "pack all input files into one archive with the file-paths as keys.", 0x0 },
+		{ "verbose",  'v', GETOPT_OPTION_TYPE_FLAG_SET, &g_Verbose,   1, "verbose output", 0x0 },
+		{ "stats",    's', GETOPT_OPTION_TYPE_FLAG_SET, &g_Stats,     1, "print statistics about what dl did to stderr when done.", 0x0 },
+		{ "trace",    't', GETOPT_OPTION_TYPE_REQUIRED, 0x0,        't', "write a trace of what dl did to file, in chrome trace-event format.", "file" },
 		GETOPT_OPTIONS_END
 	};
 
@@ -168,6 +363,7 @@ int main( int argc, const char** argv )
 
 				out_file_path = go_ctx.current_opt_arg;
 				break;
+			case 't': g_trace_file_path = go_ctx.current_opt_arg; break;
 			case 'e':
 				if(strcmp(go_ctx.current_opt_arg, "little") == 0)
 					out_endian = DL_ENDIAN_LITTLE;
@@ -185,15 +381,39 @@ int main( int argc, const char** argv )
 			case '!': M_ERROR_AND_QUIT("incorrect usage of flag \"%s\"!", go_ctx.current_opt_arg); break;
 			case '?': M_ERROR_AND_QUIT("unrecognized flag \"%s\"!", go_ctx.current_opt_arg); break;
 			case '+':
-				if(in_file_path[0] != '\0')
-					M_ERROR_AND_QUIT("input-file already set to: \"%s\", trying to set it to \"%s\"", in_file_path, go_ctx.current_opt_arg);
+				if( g_num_inputs >= MAX_INPUTS )
+					M_ERROR_AND_QUIT( "dl_pack only supports %u input files!", MAX_INPUTS );
 
-				in_file_path = go_ctx.current_opt_arg;
+				g_inputs[g_num_inputs++] = go_ctx.current_opt_arg;
 				break;
 			case 0: break; // ignore, flag was set!
 		}
 	}
 
+	if( do_archive == 1 )
+	{
+		if( g_num_inputs == 0 )
+			M_ERROR_AND_QUIT( "archive need at least one input file!" );
+
+		FILE* out_file = out_file_path[0] == '\0' ? stdout : fopen( out_file_path, "wb" );
+		if( out_file == 0x0 ) M_ERROR_AND_QUIT( "Could not open output file: %s", out_file_path );
+
+		dl_ctx_t dl_ctx = create_ctx();
+		if( dl_ctx == 0x0 )
+			return 1;
+
+		int res = pack_archive( dl_ctx, out_file, out_endian, out_ptr_size, do_relative == 1 );
+
+		if( out_file_path[0] != '\0' ) fclose( out_file );
+		destroy_ctx( dl_ctx );
+		return res;
+	}
+
+	if( g_num_inputs > 1 )
+		M_ERROR_AND_QUIT( "input-file already set to: \"%s\", trying to set it to \"%s\", use -a to pack multiple files", g_inputs[0], g_inputs[1] );
+	if( g_num_inputs == 1 )
+		in_file_path = g_inputs[0];
+
 	FILE* in_file  = in_file_path[0]  == '\0' ? stdin  : fopen( in_file_path, "rb" );
 	FILE* out_file = out_file_path[0] == '\0' ? stdout : fopen( out_file_path, "wb" );
 	if( in_file  == 0x0 ) M_ERROR_AND_QUIT( "Could not open input file: %s", in_file_path );
@@ -208,16 +428,25 @@ int main( int argc, const char** argv )
 		size_t         size;
 		unsigned char* data = read_file( in_file, &size );
 
-		dl_instance_info_t info;
-		dl_instance_get_info( data, size, &info );
-
-		dl_type_info_t tinfo;
-		dl_reflect_get_type_info( dl_ctx, info.root_type, &tinfo );
-
-		printf( "instance info:\n" );
-		printf( "ptr size: %u\n",         info.ptrsize );
-		printf( "endian:   %s\n",         info.endian == DL_ENDIAN_LITTLE ? "little" : "big" );
-		printf( "type:     %s (0x%8X)\n", tinfo.name, info.root_type );
+		unsigned int entry_count;
+		if( dl_archive_entry_count( data, size, &entry_count ) == DL_ERROR_OK )
+			show_archive_info( dl_ctx, data, size, entry_count );
+		else
+		{
+			dl_instance_info_t info;
+			dl_instance_get_info( data, size, &info );
+
+			dl_type_info_t tinfo;
+			dl_reflect_get_type_info( dl_ctx, info.root_type, &tinfo );
+
+			printf( "instance info:\n" );
+			printf( "ptr size: %u\n",         info.ptrsize );
+			printf( "endian:   %s\n",         info.endian == DL_ENDIAN_LITTLE ? "little" : "big" );
+			printf( "type:     %s (0x%8X)\n", tinfo.name, info.root_type );
+			printf( "refs:     %s\n",         info.relative ? "relative" : "absolute" );
+			printf( "version:  %u\n",         info.version );
+			printf( "size:     %llu\n",       (unsigned long long)info.load_size );
+		}
 
 		free( data );
 	}
@@ -230,13 +459,23 @@ int main( int argc, const char** argv )
 		if( err != DL_ERROR_OK )
 			M_ERROR_AND_QUIT( "DL error reading stream: %s", dl_error_to_string( err ) );
 
-		err = dl_util_store_to_stream( dl_ctx,
-									   type,
-									   out_file,
-									   do_unpack == 1 ? DL_UTIL_FILE_TYPE_TEXT : DL_UTIL_FILE_TYPE_BINARY,
-									   out_endian,
-									   out_ptr_size,
-									   instance );
+		if( do_relative == 1 && do_unpack == 0 )
+		{
+			unsigned char* packed = 0x0;
+			size_t packed_size = 0;
+			err = pack_instance( dl_ctx, type, instance, out_endian, out_ptr_size, true, &packed, &packed_size );
+			if( err == DL_ERROR_OK )
+				err = write_to_file( packed, packed_size, out_file );
+			free( packed );
+		}
+		else
+			err = dl_util_store_to_stream( dl_ctx,
+										   type,
+										   out_file,
+										   do_unpack == 1 ? DL_UTIL_FILE_TYPE_TEXT : DL_UTIL_FILE_TYPE_BINARY,
+										   out_endian,
+										   out_ptr_size,
+										   instance );
 
 		if( err != DL_ERROR_OK )
 			M_ERROR_AND_QUIT( "DL error writing stream: %s", dl_error_to_string( err ) );
@@ -247,7 +486,7 @@ int main( int argc, const char** argv )
 	if( in_file_path[0]  != '\0' ) fclose( in_file );
 	if( out_file_path[0] != '\0' ) fclose( out_file );
 
-	dl_context_destroy( dl_ctx );
+	destroy_ctx( dl_ctx );
 
 	return 0;
 }